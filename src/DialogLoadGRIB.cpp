@@ -31,13 +31,19 @@ DialogLoadGRIB *globalDial = NULL;
 
 //-------------------------------------------------------------------------------
 QString DialogLoadGRIB::getFile (QNetworkAccessManager *netManager, QWidget *parent,
-						double x0, double y0, double x1, double y1)
+						double x0, double y0, double x1, double y1,
+						GribReader **reader)
 {
 	if (!globalDial)
 		globalDial = new DialogLoadGRIB(netManager,parent);
 	globalDial->setZone (x0, y0, x1, y1);
 	globalDial->exec ();
 	globalDial->saveParametersSettings ();
+	if (reader != NULL)
+		*reader = globalDial->streamReader;
+	else
+		delete globalDial->streamReader;
+	globalDial->streamReader = NULL;
 	return globalDial->savedFileName;
 }
 
@@ -65,6 +71,7 @@ DialogLoadGRIB::DialogLoadGRIB (QNetworkAccessManager *netManager, QWidget *pare
     loadgrib = NULL;
 	networkManager = netManager;
 	savedFileName = "";
+	streamReader = NULL;
     setWindowTitle(tr("Download - GRIB"));
     loadInProgress = false;
     QFrame * frameButtonsZone = createFrameButtonsZone(this);
@@ -177,6 +184,7 @@ void DialogLoadGRIB::slotFnmocWW3_All ()
 //-------------------------------------------------------------------------------
 DialogLoadGRIB::~DialogLoadGRIB()
 {
+	delete streamReader;
 }
 
 //----------------------------------------------------
@@ -195,6 +203,8 @@ void DialogLoadGRIB::slotGribDataReceived (QByteArray *content, QString fileName
 	else
 		path += "/";
 	savedFileName = "";
+	delete streamReader;
+	streamReader = NULL;
 	QFileInfo fi (fileName + ".bz2");
     fileName = Util::getSaveFileName (NULL,
                  tr("Save GRIB file"), path+fi.fileName());
@@ -203,20 +213,31 @@ void DialogLoadGRIB::slotGribDataReceived (QByteArray *content, QString fileName
         QFile saveFile (fileName);
         bool ok;
         qint64 nb = 0;
-        ok = saveFile.open(QIODevice::WriteOnly);
-        if (ok) {
-            nb = saveFile.write(*content);
-            if (nb > 0) {
-            	QFileInfo info(saveFile);
-				Util::setSetting("gribFilePath", info.absolutePath() );
-                saveFile.close();
-            }
-        }
+        // the file was written while downloaded: just rename it
+        QString partName = loadgrib->getPartFileName ();
+        if (partName != "") {
+			QFile::remove (fileName);
+			ok = QFile::rename (partName, fileName);
+			nb = ok ? content->size() : 0;
+		}
+		else {
+			ok = false;
+		}
+		if (!ok) {
+			ok = saveFile.open(QIODevice::WriteOnly);
+			if (ok) {
+				nb = saveFile.write(*content);
+				saveFile.close();
+			}
+		}
         if (ok && nb>0) {
+			QFileInfo info(saveFile);
+			Util::setSetting("gribFilePath", info.absolutePath() );
             loadInProgress = false;
             btCancel->setText(tr("Cancel"));
             btOK->setEnabled(true);
 			savedFileName = fileName;
+			streamReader = loadgrib->takeStreamReader ();
             accept();
         }
         else {
@@ -43,8 +43,10 @@ class DialogLoadGRIB : public DialogBoxBase
         
         void setZone (double x0, double y0, double x1, double y1);
 		
+		// reader: the file decoded while downloaded, if possible
 		static QString getFile (QNetworkAccessManager *manager, QWidget *parent,
-						double x0, double y0, double x1, double y1);
+						double x0, double y0, double x1, double y1,
+						GribReader **reader = NULL);
 
     public slots:
         void slotBtOK();
@@ -65,6 +67,7 @@ class DialogLoadGRIB : public DialogBoxBase
         FileLoaderGRIB    *loadgrib;
 		QNetworkAccessManager *networkManager;
 		QString  savedFileName;
+		GribReader *streamReader;
 		
         bool     loadInProgress;
         QTime    timeLoad;
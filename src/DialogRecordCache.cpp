@@ -0,0 +1,133 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <QFrame>
+
+#include "DialogRecordCache.h"
+#include "GribRecordCache.h"
+#include "Util.h"
+
+//-------------------------------------------------------------------------------
+DialogRecordCache::DialogRecordCache (QWidget *parent) : DialogBoxBase (parent)
+{
+    QLabel *label;
+    QFrame *ftmp;
+    setWindowTitle (tr("Memory of GRIB data"));
+    layout = new QGridLayout(this);
+    int lig=0;
+    //-------------------------
+    QFont font;
+    font.setBold(true);
+    label = new QLabel(tr("Memory used by the GRIB data"), this);
+    label->setFont(font);
+    layout->addWidget( label,    lig,0, 1,-1, Qt::AlignCenter);
+    lig ++;
+    ftmp = new QFrame(this); ftmp->setFrameShape(QFrame::HLine); layout->addWidget( ftmp, lig,0, 1, -1);
+    //-------------------------
+    lig ++;
+    sbBudget = new QSpinBox (this);
+    sbBudget->setRange (16, 65536);
+    sbBudget->setSingleStep (64);
+    sbBudget->setSuffix (" "+tr("MB"));
+    layout->addWidget( new QLabel(tr("Maximum size :"), this), lig,0, Qt::AlignRight);
+    layout->addWidget( sbBudget, lig,1);
+    lig ++;
+    lbRecords = new QLabel (this);
+    layout->addWidget( new QLabel(tr("Records :"), this), lig,0, Qt::AlignRight);
+    layout->addWidget( lbRecords, lig,1);
+    lig ++;
+    lbLoaded = new QLabel (this);
+    layout->addWidget( new QLabel(tr("In memory :"), this), lig,0, Qt::AlignRight);
+    layout->addWidget( lbLoaded, lig,1);
+    lig ++;
+    lbPyramids = new QLabel (this);
+    layout->addWidget( new QLabel(tr("Levels of detail :"), this), lig,0, Qt::AlignRight);
+    layout->addWidget( lbPyramids, lig,1);
+    lig ++;
+    lbHits = new QLabel (this);
+    layout->addWidget( new QLabel(tr("Hits :"), this), lig,0, Qt::AlignRight);
+    layout->addWidget( lbHits, lig,1);
+    lig ++;
+    lbMisses = new QLabel (this);
+    layout->addWidget( new QLabel(tr("Decoded again :"), this), lig,0, Qt::AlignRight);
+    layout->addWidget( lbMisses, lig,1);
+    lig ++;
+    lbEvictions = new QLabel (this);
+    layout->addWidget( new QLabel(tr("Released :"), this), lig,0, Qt::AlignRight);
+    layout->addWidget( lbEvictions, lig,1);
+    lig ++;
+    btRefresh    = new QPushButton(tr("Refresh"), this);
+    btResetStats = new QPushButton(tr("Reset counters"), this);
+    layout->addWidget( btRefresh,    lig,0);
+    layout->addWidget( btResetStats, lig,1);
+    //-------------------------
+    lig ++;
+    ftmp = new QFrame(this); ftmp->setFrameShape(QFrame::HLine); layout->addWidget( ftmp, lig,0, 1, -1);
+    lig ++;
+    btOK     = new QPushButton(tr("Ok"), this);
+    btCancel = new QPushButton(tr("Cancel"), this);
+    layout->addWidget( btOK,    lig,0);
+    layout->addWidget( btCancel, lig,1);
+
+	//===============================================================
+    connect(btRefresh, SIGNAL(clicked()), this, SLOT(slotRefresh()));
+    connect(btResetStats, SIGNAL(clicked()), this, SLOT(slotResetStats()));
+    connect(btCancel, SIGNAL(clicked()), this, SLOT(slotBtCancel()));
+    connect(btOK, SIGNAL(clicked()), this, SLOT(slotBtOK()));
+}
+//-------------------------------------------------------------------------------
+int DialogRecordCache::exec ()
+{
+    sbBudget->setValue (GribRecordCache::getBudgetMB());
+    slotRefresh ();
+    return QDialog::exec ();
+}
+//-------------------------------------------------------------------------------
+void DialogRecordCache::slotRefresh ()
+{
+    GribRecordCacheStats stats = GribRecordCache::getStats ();
+    double mb = stats.loadedSize / (1024.0*1024.0);
+    long nbreq = stats.hits + stats.misses;
+    lbRecords->setText (QString("%1").arg(stats.nbRecords));
+    lbLoaded->setText (tr("%1 records, %2 MB")
+						.arg(stats.nbLoaded).arg(mb, 0, 'f', 1));
+    lbPyramids->setText (tr("%1 MB")
+						.arg(stats.pyramidsSize/(1024.0*1024.0), 0, 'f', 1));
+    lbHits->setText (QString("%1 (%2 %)").arg(stats.hits)
+						.arg(nbreq>0 ? 100.0*stats.hits/nbreq : 0, 0, 'f', 1));
+    lbMisses->setText (QString("%1").arg(stats.misses));
+    lbEvictions->setText (QString("%1").arg(stats.evictions));
+}
+//-------------------------------------------------------------------------------
+void DialogRecordCache::slotResetStats ()
+{
+    GribRecordCache::resetStats ();
+    slotRefresh ();
+}
+//-------------------------------------------------------------------------------
+void DialogRecordCache::slotBtOK ()
+{
+    GribRecordCache::setBudgetMB (sbBudget->value());
+    Util::setSetting ("recordCacheBudgetMB", sbBudget->value());
+    accept();
+}
+//-------------------------------------------------------------------------------
+void DialogRecordCache::slotBtCancel ()
+{
+    reject();
+}
@@ -0,0 +1,61 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef DIALOGRECORDCACHE_H
+#define DIALOGRECORDCACHE_H
+
+#include <QDialog>
+#include <QGridLayout>
+#include <QLabel>
+#include <QSpinBox>
+#include <QPushButton>
+
+#include "DialogBoxBase.h"
+
+//===================================================================
+// Memory budget and statistics of the GRIB record cache
+//===================================================================
+class DialogRecordCache : public DialogBoxBase
+{ Q_OBJECT
+    public:
+        DialogRecordCache (QWidget *parent=NULL);
+
+    public slots:
+        int  exec ();
+        void slotBtOK ();
+        void slotBtCancel ();
+        void slotRefresh ();
+        void slotResetStats ();
+
+    private:
+        QGridLayout *layout;
+        QSpinBox    *sbBudget;
+        QLabel      *lbRecords;
+        QLabel      *lbLoaded;
+        QLabel      *lbPyramids;
+        QLabel      *lbHits;
+        QLabel      *lbMisses;
+        QLabel      *lbEvictions;
+
+        QPushButton *btRefresh;
+        QPushButton *btResetStats;
+        QPushButton *btOK;
+        QPushButton *btCancel;
+};
+
+#endif
@@ -107,7 +107,7 @@ void DialogSelectMetar::slotBtOK()
 //-------------------------------------------------------------------------------
 void DialogSelectMetar::make_metar_tree ()
 {
-	MetarWidgetFactory factory;
+	MetarMarkerFactory factory;
 	
 	QSet <QString> allExpanded = 
 		QSet <QString>::fromList
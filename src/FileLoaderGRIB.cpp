@@ -28,15 +28,94 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Util.h"
 #include "Version.h"
 
+//========================================================================
+GribStreamDecoder::GribStreamDecoder (const QString &fileName)
+{
+	reader = new GribReader ();
+	assert (reader);
+	reader->beginStream (qPrintable(fileName));
+	readerOk = true;
+	ended = aborted = false;
+}
+//-------------------------------------------------------------------------------
+GribStreamDecoder::~GribStreamDecoder ()
+{
+	abort ();
+	wait ();
+	delete reader;
+}
+//-------------------------------------------------------------------------------
+void GribStreamDecoder::addData (const char *data, int size)
+{
+	QMutexLocker lock (&mutex);
+	if (aborted)
+		return;
+	pending.append (data, size);
+	wakeUp.wakeOne ();
+}
+//-------------------------------------------------------------------------------
+void GribStreamDecoder::finish ()
+{
+	QMutexLocker lock (&mutex);
+	ended = true;
+	wakeUp.wakeOne ();
+}
+//-------------------------------------------------------------------------------
+void GribStreamDecoder::abort ()
+{
+	QMutexLocker lock (&mutex);
+	aborted = true;
+	wakeUp.wakeOne ();
+}
+//-------------------------------------------------------------------------------
+GribReader *GribStreamDecoder::takeReader ()
+{
+	if (! isFinished())
+		return NULL;
+	GribReader *res = readerOk ? reader : NULL;
+	if (res != NULL)
+		reader = NULL;
+	return res;
+}
+//-------------------------------------------------------------------------------
+void GribStreamDecoder::run ()
+{
+	QByteArray data;
+	while (true)
+	{
+		mutex.lock ();
+		while (pending.isEmpty() && !ended && !aborted)
+			wakeUp.wait (&mutex);
+		bool stop = aborted;
+		bool last = ended;
+		data.clear ();
+		data.swap (pending);
+		mutex.unlock ();
+		if (stop) {
+			readerOk = false;
+			break;
+		}
+		if (readerOk && !data.isEmpty())
+			readerOk = reader->addStreamData (data.constData(), data.size());
+		if (last) {
+			readerOk = readerOk && reader->endStream ();
+			break;
+		}
+	}
+}
+
 //========================================================================
 FileLoaderGRIB::FileLoaderGRIB (QNetworkAccessManager *manager, QWidget *parent)
-			: FileLoader (manager)
+			: FileLoader (manager),
+			  hashContent (QCryptographicHash::Sha1)
 {
 	this->parent = parent;
     step = 0;
 	downloadError = false;
 	reply_step1 = NULL;
 	reply_step2 = NULL;
+	streamPos = 0;
+	decoder = NULL;
 	scriptpath = "/noaa/";
 	scriptstock = "313O562/";
     zygriblog = "a07622b82b18524d2088c9b272bb3feeb0eb1737";
@@ -53,6 +132,30 @@ FileLoaderGRIB::~FileLoaderGRIB ()
 		reply_step2->deleteLater ();
 		reply_step2 = NULL;
 	}
+	deleteDecoder ();
+	if (partFile.fileName() != "") {	// not renamed
+		partFile.close ();
+		partFile.remove ();
+	}
+}
+//-------------------------------------------------------------------------------
+QString FileLoaderGRIB::getPartFileName ()
+{
+	return partFile.fileName ();
+}
+//-------------------------------------------------------------------------------
+GribReader *FileLoaderGRIB::takeStreamReader ()
+{
+	return decoder ? decoder->takeReader () : NULL;
+}
+//-------------------------------------------------------------------------------
+void FileLoaderGRIB::deleteDecoder ()
+{
+	if (decoder != NULL) {
+		disconnect (decoder, SIGNAL(finished()), this, SLOT(slotStreamDecoded()));
+		delete decoder;
+		decoder = NULL;
+	}
 }
 
 //-------------------------------------------------------------------------------
@@ -66,6 +169,8 @@ void FileLoaderGRIB::stop ()
 		reply_step2->close ();
 		downloadError = true;
 	}
+	if (decoder)
+		decoder->abort ();
 }
 
 //-------------------------------------------------------------------------------
@@ -289,11 +394,32 @@ void FileLoaderGRIB::slotFinished_step1 ()
             QTextStream(&page) << scriptpath
 			<<"313O562/"<<fileName;
             emit signalGribStartLoadData();            
+			//-------------------------------------------------------------
+			// The file is checked, written and decoded while received
+			//-------------------------------------------------------------
+			arrayContent.clear ();
+			streamPos = 0;
+			hashContent.reset ();
+			QString path = Util::getSetting("gribFilePath", "").toString();
+			if (path == "")
+				path = ".";
+			partFile.setFileName (path+"/"
+						+QString(fileName).replace("%20",".grb.bz2")+".part");
+			if (! partFile.open (QIODevice::WriteOnly))
+				partFile.setFileName ("");
+			deleteDecoder ();
+			decoder = new GribStreamDecoder (partFile.fileName());
+			assert (decoder);
+			connect (decoder, SIGNAL(finished()), this, SLOT(slotStreamDecoded()));
+			decoder->start ();
+			
 			QNetworkRequest request;
 			request.setUrl (QUrl("http://"+Util::getServerName()+page) );
 			reply_step2 = networkManager->get (request);
 			connect (reply_step2, SIGNAL(downloadProgress (qint64,qint64)), 
 					 this, SLOT(downloadProgress (qint64,qint64)));
+			connect (reply_step2, SIGNAL(readyRead()),
+					 this, SLOT(slotReadyRead_step2 ()));
 			connect (reply_step2, SIGNAL(error(QNetworkReply::NetworkError)),
 					 this, SLOT(slotNetworkError (QNetworkReply::NetworkError)));
 			connect (reply_step2, SIGNAL(finished()),
@@ -305,27 +431,73 @@ void FileLoaderGRIB::slotFinished_step1 ()
 	}
 }
 //-------------------------------------------------------------------------------
+void FileLoaderGRIB::slotReadyRead_step2 ()
+{
+	if (!downloadError) {
+		arrayContent.append (reply_step2->readAll ());
+		useReceivedData ();
+	}
+}
+//-------------------------------------------------------------------------------
+// Checksum, file and records are updated with the new bytes
+//-------------------------------------------------------------------------------
+void FileLoaderGRIB::useReceivedData ()
+{
+	int pos = xserv[0]-32;
+	if (arrayContent.size() <= pos)
+		return;			// wait for the masked byte
+	if (streamPos == 0)
+		arrayContent[pos] = arrayContent[pos]^xserv[1];
+	int nb = arrayContent.size() - streamPos;
+	if (nb <= 0)
+		return;
+	const char *data = arrayContent.constData() + streamPos;
+	hashContent.addData (data, nb);
+	if (partFile.isOpen() && partFile.write (data, nb) != nb) {
+		partFile.close ();
+		partFile.remove ();
+		partFile.setFileName ("");
+	}
+	if (decoder != NULL)
+		decoder->addData (data, nb);	// decoded in the decoder thread
+	streamPos += nb;
+}
+//-------------------------------------------------------------------------------
 void FileLoaderGRIB::slotFinished_step2 ()
 {
 // DBG("slotFinished_step2");		
 	if (!downloadError) {
 		step = 1000;
-		arrayContent = reply_step2->readAll ();
+		arrayContent.append (reply_step2->readAll ());
 		if (arrayContent.size() < 80) {
 			emit signalGribLoadError (tr("Empty file."));
 			return;
 		}
-		arrayContent[xserv[0]-32]=arrayContent[xserv[0]-32]^xserv[1];
+		useReceivedData ();
+		partFile.close ();
 		emit signalGribSendMessage(tr("CheckSum control"));
-		if (Util::sha1 (arrayContent) == checkSumSHA1)
+		if (hashContent.result().toHex() == checkSumSHA1)
 		{
-			emit signalGribSendMessage(tr("Finish")
-							+ QString(" %1 ko").arg(arrayContent.size()/1024.0,0,'f',1));
-			emit signalGribDataReceived(&arrayContent, fileName.replace("%20",".grb"));
+			if (decoder != NULL) {
+				decoder->finish ();		// continued in slotStreamDecoded
+				return;
+			}
+			slotStreamDecoded ();
 		}
 		else {
+			deleteDecoder ();		// the reader is not used
 			emit signalGribLoadError (tr("Bad checksum."));
 		}
 	}
 }
-
+//-------------------------------------------------------------------------------
+// The decoder thread has read the last records (or was not used)
+//-------------------------------------------------------------------------------
+void FileLoaderGRIB::slotStreamDecoded ()
+{
+	if (downloadError || step != 1000)
+		return;
+	emit signalGribSendMessage(tr("Finish")
+					+ QString(" %1 ko").arg(arrayContent.size()/1024.0,0,'f',1));
+	emit signalGribDataReceived(&arrayContent, QString(fileName).replace("%20",".grb"));
+}
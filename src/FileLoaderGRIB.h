@@ -28,10 +28,47 @@ Download GRIB File on zygrib server
 #include <QObject>
 #include <QtNetwork>
 #include <QBuffer>
+#include <QFile>
+#include <QCryptographicHash>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 
 #include "FileLoader.h"
+#include "GribReader.h"
 #include "Util.h"
 
+//===================================================================
+// Records decoded from the received data in a worker thread.
+// The GUI thread gives the data by pieces (copied), then finish:
+// the thread ends (finished signal) when the reader is complete.
+//===================================================================
+class GribStreamDecoder : public QThread
+{
+	public:
+		GribStreamDecoder (const QString &fileName);
+		~GribStreamDecoder ();		// waits for the thread
+
+		void  addData (const char *data, int size);
+		void  finish ();			// no more data
+		void  abort ();
+		// Once the thread is finished: the reader (NULL if the data
+		// could not be decoded). The caller becomes its owner.
+		GribReader *takeReader ();
+
+	protected:
+		void  run ();
+
+	private:
+		GribReader *reader;
+		bool        readerOk;
+		QMutex      mutex;			// members below
+		QWaitCondition wakeUp;
+		QByteArray  pending;
+		bool        ended, aborted;
+};
+
 class FileLoaderGRIB : public QObject, FileLoader
 { Q_OBJECT
     public:
@@ -61,6 +98,13 @@ class FileLoaderGRIB : public QObject, FileLoader
 			);
         void stop();
         
+        // File written while downloaded ("" if it could not be written)
+        QString     getPartFileName ();
+        // Records decoded while downloaded (NULL if not possible),
+        // once signalGribDataReceived is emitted.
+        // The caller becomes the owner of the reader.
+        GribReader *takeStreamReader ();
+        
     private:
 		QString scriptpath;
 		QString scriptname;
@@ -81,12 +125,21 @@ class FileLoaderGRIB : public QObject, FileLoader
 		QNetworkReply *reply_step1;
 		QNetworkReply *reply_step2;
 		bool downloadError;
+		
+		int      streamPos;		// bytes of arrayContent already used
+		QCryptographicHash hashContent;
+		QFile    partFile;
+		GribStreamDecoder *decoder;
+		void  useReceivedData ();
+		void  deleteDecoder ();
 
     public slots:
         void downloadProgress (qint64 done, qint64 total);
 		void slotNetworkError (QNetworkReply::NetworkError);
 		void slotFinished_step1 ();
+		void slotReadyRead_step2 ();
 		void slotFinished_step2 ();
+		void slotStreamDecoded ();
 
     signals:
         void signalGribDataReceived (QByteArray *content, QString);
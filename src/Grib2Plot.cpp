@@ -35,7 +35,7 @@ Grib2Plot::~Grib2Plot ()
 
 //----------------------------------------------------
 void Grib2Plot::loadFile (QString fileName,
-						 LongTaskProgress * taskProgress, int nbrecs)
+						 LongTaskProgress * taskProgress)
 {
 	this->fileName = fileName;
 	listDates.clear();
@@ -48,7 +48,7 @@ void Grib2Plot::loadFile (QString fileName,
 	gribReader = new Grib2Reader ();
     if (gribReader != NULL)
     {
-		gribReader->openFile (qPrintable(fileName), taskProgress, nbrecs);
+		openReaderFiles (taskProgress);
 		if (gribReader->isOk())
 		{
 			listDates = gribReader->getListDates();
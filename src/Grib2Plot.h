@@ -35,7 +35,7 @@ class Grib2Plot : public GribPlot
         virtual ~Grib2Plot ();
         
 		virtual void  loadFile (QString fileName,
-						LongTaskProgress *taskProgress=NULL, int nbrecs=0);
+						LongTaskProgress *taskProgress=NULL);
 
 };
 
@@ -29,17 +29,20 @@ Grib2Reader::~Grib2Reader ()
 }
 //-------------------------------------------------------------------------------
 void Grib2Reader::openFile (const std::string fname,
-							LongTaskProgress *taskProgress, int nbrecs)
+							LongTaskProgress *taskProgress)
 {
 	allUnknownRecords.clear();
 	this->taskProgress = taskProgress;
-	taskProgress->continueDownload = true;
+	previewDone = false;
+	previewDate = 0;
 	setAllDataCenterModel.clear();
 	setAllDates.clear ();
 	setAllDataCode.clear ();
 	
     if (fname != "") {
-        openFilePriv (fname, nbrecs);
+        openFilePriv (fname);
+		previewDone = true;
+		taskProgress->setMessage (LTASK_PREPARE_MAPS);
 		createListDates ();
 		ok = getNumberOfDates() > 0;
 		if (ok) {
@@ -52,7 +55,22 @@ void Grib2Reader::openFile (const std::string fname,
     }
 }
 //-------------------------------------------------------------------------------
-void Grib2Reader::openFilePriv (const std::string fname, int nbrecs)
+void Grib2Reader::openFiles (const std::vector<std::string> &fnames,
+							 LongTaskProgress *taskProgress)
+{
+	allUnknownRecords.clear();
+	GribReader::openFiles (fnames, taskProgress);
+	if (ok) {
+		analyseRecords ();
+	}
+}
+//-------------------------------------------------------------------------------
+void Grib2Reader::readDatasetFile ()
+{
+	readGrib2FileContent (file->type == ZU_COMPRESS_NONE);
+}
+//-------------------------------------------------------------------------------
+void Grib2Reader::openFilePriv (const std::string fname)
 {
 //     debug("Open file: %s", fname.c_str());
     fileName = fname;
@@ -68,75 +86,28 @@ void Grib2Reader::openFilePriv (const std::string fname, int nbrecs)
     }
 	taskProgress->setMessage (LTASK_OPEN_FILE);
 	taskProgress->setValue (0);
-	//DBG("nbrecs=%d", nbrecs);
-    if (nbrecs > 0) {
-		taskProgress->setMessage (LTASK_PREPARE_MAPS);
-		taskProgress->setValue (0);
-		readGrib2FileContent (nbrecs);
-	}
-	else {
-		ok = false;
-	}
+	readGrib2FileContent ();
 	zu_close (file);
 }
-//-------------------------------------------------------------------------
-void Grib2Reader::seekgb_zu (ZUFILE *lugb,g2int iseek,g2int mseek,g2int *lskip,g2int *lgrib)
-{    // g2clib function modified to use zuFile
-	g2int k,k4,ipos,nread,lim, lengrib;
-	uint32_t end;
-	unsigned char *cbuf = (unsigned char *) malloc (mseek);
-	*lgrib = 0;
-	nread=mseek;
-	ipos=iseek;
-	while (*lgrib==0 && nread==mseek) {
-		zu_seek (lugb, ipos, SEEK_SET);
-		nread = zu_read (lugb, cbuf, mseek);
-		lim = nread-8;
-		//Util::dumpchars(cbuf,0,16);
-		for (k=0; k<lim; k++) {
-			// search GRIB...2
-			if (cbuf[k]=='G' && cbuf[k+1]=='R' && cbuf[k+2]=='I' && cbuf[k+3]=='B'
-				&& cbuf[k+7]==2   // version 2
-			) {
-				//  LOOK FOR '7777' AT END OF GRIB MESSAGE
-				lengrib = (g2int)(cbuf[k+12]<<24)+(cbuf[k+13]<<16)+(cbuf[k+14]<<8)+(cbuf[k+15]);
-				zu_seek (lugb, ipos+k+lengrib-4, SEEK_SET);
-				k4 = zu_read (lugb, &end, 4);
-				if (k4 == 4 && end == 926365495) {      // "7777" found
-					//DBG("FOUND GRIB2 FIELD lengrib=%ld", lengrib);
-					*lskip=ipos+k;
-					*lgrib=lengrib;
-					break;
-				}
-			}
-        }
-        ipos=ipos+lim;
-	}
-	free(cbuf);
-}
 //---------------------------------------------------------------------------------
-void Grib2Reader::readGrib2FileContent (int nbrecs)
+void Grib2Reader::readGrib2FileContent (bool headersOnly)
 {
     fileSize = zu_filesize(file);
 	
     unsigned char *cgrib;
     g2int  listsec0[3],listsec1[13],numlocal,numfields;
-    g2int  n, lskip=0,lgrib=0,iseek=0;
+    g2int  n;
     int    unpack=1, ierr=0;
     gribfield  *gfld;
     g2int expand=1;
 	int idrec=0;
-    while (ierr==0 && taskProgress->continueDownload) {
-		qApp->processEvents ();
-		seekgb_zu (file, iseek, 64*1024, &lskip, &lgrib);
-		taskProgress->setValue ((int)(100.0*idrec/nbrecs));
-		//DBG("READ FIELD : idrec=%d lskip=%ld lgrib=%ld", idrec, lskip, lgrib);
-		if (lgrib == 0) break;    // end loop at EOF or problem
-		iseek = lskip + lgrib;
-
-		cgrib = (unsigned char *) malloc (lgrib);
-		zu_seek (file, lskip, SEEK_SET);
-		if (zu_read(file, cgrib, lgrib) == lgrib) {
+	bool origin = file->type == ZU_COMPRESS_NONE;	// fast seek
+	GribFramer framer (file);	// messages read forward, in one pass
+    while (ierr==0 && !taskProgress->isCanceled() && framer.nextMessage()) {
+		setFileProgress (framer.getProgress());
+		// g2clib only reads the message
+		cgrib = const_cast <unsigned char *> (framer.getMessage());
+		if (framer.getEdition() == 2) {
 			numfields = 0;
 			numlocal = 0;
 			ierr = g2_info (cgrib,listsec0,listsec1,&numfields,&numlocal);
@@ -155,30 +126,61 @@ void Grib2Reader::readGrib2FileContent (int nbrecs)
 				// 				idGrid
 				// extract fields
 				for (n=0; n<numfields; n++) {
+					// 1st pass: sections 3 and 4 only (product identification)
 					gfld = NULL;
-					ierr = g2_getfld (cgrib, n+1, unpack, expand, &gfld);
+					ierr = g2_getfld (cgrib, n+1, 0, 0, &gfld);
 					if (ierr == 0) {
 						idrec++;
-						//DBG("LOAD FIELD idrec=%d/%d field=%ld/%ld numlocal=%ld",idrec,nbrecs, n+1,numfields, numlocal);
-						Grib2Record *rec = new Grib2Record (gfld, idrec, idCenter, refDate);
-						if (rec->isOk()) {
-							//DBG("storeRecordInMap %d", rec->getId());
-							storeRecordInMap (rec);
-						}
-						else {
-							Grib2RecordMarker mark = rec->getGrib2RecordMarker();
+						// with headersOnly, the probe is kept as the record
+						// (values decoded on first use)
+						Grib2Record *probe = new Grib2Record (gfld, idrec, idCenter, refDate);
+						assert (probe);
+						g2_free (gfld);
+						gfld = NULL;
+						if (! probe->isOk()) {
+							Grib2RecordMarker mark = probe->getGrib2RecordMarker();
 							if (!allUnknownRecords.contains(mark)) {
 								allUnknownRecords << mark;
 								mark.dbgRec();
 							}
 						}
+						else if (isDataCodeWanted (probe->getDataCode())
+								&& subset.isDateWanted (probe->getRecordCurrentDate())) {
+							Grib2Record *rec = NULL;
+							if (headersOnly) {
+								rec = probe;
+								probe = NULL;
+							}
+							else {
+								// 2nd pass: unpack bitmap and data (sections 5 to 7)
+								ierr = g2_getfld (cgrib, n+1, unpack, expand, &gfld);
+								if (ierr == 0) {
+									//DBG("LOAD FIELD idrec=%d field=%ld/%ld numlocal=%ld",idrec, n+1,numfields, numlocal);
+									rec = new Grib2Record (gfld, idrec, idCenter, refDate);
+								}
+							}
+							if (rec != NULL) {
+								if (rec->isOk() && cropToSubset(rec)) {
+									if (origin)
+										rec->setFileOrigin (fileName,
+												framer.getMessageOffset(),
+												framer.getMessageSize(), n+1);
+									//DBG("storeRecordInMap %d", rec->getId());
+									storeRecordInMap (rec);
+								}
+								else {
+									delete rec;
+								}
+							}
+						}
+						if (probe)
+							delete probe;
 					}
 					if (gfld)
 						g2_free(gfld);
 				}
 			}
 		}
-		free(cgrib);
     }
 }
 //---------------------------------------------------------------------------------
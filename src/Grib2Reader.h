@@ -38,16 +38,20 @@ class Grib2Reader : public GribReader
         ~Grib2Reader ();
 		
         virtual void  openFile (const std::string fname,
-						LongTaskProgress *taskProgress, int nbrecs);
+						LongTaskProgress *taskProgress);
+		virtual void  openFiles (const std::vector<std::string> &fnames,
+						LongTaskProgress *taskProgress);
 		
+	protected:
+		virtual void readDatasetFile ();
+
 	private:
-        void openFilePriv (const std::string fname, int nbrecs);
-		void readGrib2FileContent (int nbrecs);
+        void openFilePriv (const std::string fname);
+		// headersOnly: the fields are not unpacked (uncompressed file)
+		void readGrib2FileContent (bool headersOnly=false);
 
 		void analyseRecords ();
 		QList<Grib2RecordMarker> allUnknownRecords;
-		
-		void seekgb_zu (ZUFILE *lugb,g2int iseek,g2int mseek,g2int *lskip,g2int *lgrib);
 
 };
 
@@ -115,6 +115,18 @@ Grib2Record::Grib2Record (gribfield  *gfld, int id, int idCenter, time_t refDate
 	// Product
 	//----------------------------------------
 	analyseProductDefinitionTemplate (gfld);
+	if (! gfld->unpacked) {
+		// product identification only (data not read): the values
+		// are decoded on first use if the record has a file origin
+		released.storeRelease (1);
+		checkOrientation ();
+		if (ok) {
+			translateDataType ();
+			setDataType (dataType);
+			entireWorldInLongitude = (fabs(xmax-xmin)>=360.0)||(fabs(xmax-360.0+Di-xmin) < fabs(Di/20));
+		}
+		return;
+	}
 	//----------------------------------------
 	// Data
 	//----------------------------------------
@@ -511,7 +523,16 @@ void Grib2Record::print (const char *title)
 		fprintf(stderr,"====== ERROR : GribRecord %d : %s\n", id, title);
 	}
 }
-
-
-
-
+//-------------------------------------------------------------------------------
+GribRecord * Grib2Record::decodeMessage (const uint8_t *msg, long /*size*/) const
+{
+	// g2clib only reads the message
+	unsigned char *cgrib = const_cast <unsigned char *> (msg);
+	gribfield *gfld = NULL;
+	GribRecord *rec = NULL;
+	if (g2_getfld (cgrib, originField, 1, 1, &gfld) == 0)
+		rec = new Grib2Record (gfld, id, idCenter, refDate);
+	if (gfld)
+		g2_free (gfld);
+	return rec;
+}
@@ -64,6 +64,9 @@ class Grib2Record : public GribRecord
 {
 	public:
 		Grib2Record ();
+		// If the field is not unpacked (gfld->unpacked==0), only the
+		// product is identified (no data).
+		// The values are then decoded on first use (setFileOrigin).
 		Grib2Record (gribfield  *gfld, int id, int idCenter, time_t refDate);
 		~Grib2Record ();
 		
@@ -72,6 +75,9 @@ class Grib2Record : public GribRecord
 
         virtual void  print (const char *title);
 	
+	protected:
+		virtual GribRecord * decodeMessage (const uint8_t *msg, long size) const;
+	
 	private:
 		//gribfield  *gfld;
 		void analyseProductDefinitionTemplate (gribfield  *gfld);
@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ImageWriter.h"
 #include "Font.h"
 #include "Util.h"
+#include "GribRecordCache.h"
 
 
 //=========================================================================================
@@ -40,7 +41,8 @@ AnimImage::~AnimImage ()
 }
 
 //=========================================================================================
-AnimCommand::AnimCommand(int nbImages, int speed, bool autoLoop, QWidget *parent)
+AnimCommand::AnimCommand(int nbImages, int speed, bool autoLoop,
+							int nbInterpolated, QWidget *parent)
 	: QToolBar(parent)
 {
 	this->nbImages = nbImages;
@@ -110,6 +112,21 @@ AnimCommand::AnimCommand(int nbImages, int speed, bool autoLoop, QWidget *parent
     sliderCurrentImage->setToolTip (tr("Current image"));
     this->addWidget(sliderCurrentImage);
 	connect(sliderCurrentImage, SIGNAL(valueChanged(int)), this, SLOT(actionsCommonSlot()));
+
+    this->addSeparator();
+
+	spinInterpolated = new QSpinBox(this);
+	spinInterpolated->setRange(0, 5);
+	spinInterpolated->setValue(nbInterpolated);
+    spinInterpolated->setToolTip (tr("Interpolated images between 2 forecasts"));
+    this->addWidget(spinInterpolated);
+	connect(spinInterpolated, SIGNAL(valueChanged(int)), this, SLOT(actionsCommonSlot()));
+}
+//---------------------------------------------------
+void AnimCommand::setNbImages(int nbImages)
+{
+	this->nbImages = nbImages;
+	sliderCurrentImage->setRange(1, nbImages);
 }
 //---------------------------------------------------
 void AnimCommand::actionsCommonSlot()
@@ -140,6 +157,9 @@ void AnimCommand::actionsCommonSlot()
 	else if (sender() == acAutoLoop) {
 		emit setAutoLoop(acAutoLoop->isChecked());
 	}
+	else if (sender() == spinInterpolated) {
+		emit setInterpolatedImages(spinInterpolated->value());
+	}
 }
 //---------------------------------------------------
 int AnimCommand::speedSlider_ValueToSpeed()
@@ -182,6 +202,13 @@ void CreateAnimProgressBar::setCurrentValue(int n)
 {
 	progressBar->setValue(n);
 }
+//---------------------------------------------------------
+void CreateAnimProgressBar::setNbImages(int nbImages)
+{
+	this->nbImages = nbImages;
+	progressBar->setRange(1, nbImages-1);
+	progressBar->setValue(1);
+}
 
 //=========================================================================================
 //-------------------------------------------------------------------------------
@@ -235,6 +262,25 @@ void GribAnimator::setAutoLoop(bool auto_)
  	autoLoop = auto_;
 }
 //---------------------------------------
+void GribAnimator::setInterpolatedImages(int nb)
+{
+	Util::setSetting("animInterpolatedImages", nb);
+	if (nb == nbInterpolated)
+		return;
+	nbInterpolated = nb;
+	// images are made again with the new dates
+	timerLoop->stop();
+	timerPause->stop();
+	Util::cleanVectorPointers (vectorImages);
+	makeFrameDates ();
+	nbImages = frameDates.size();
+	vectorImages.reserve (nbImages);
+	animCommand->setNbImages (nbImages);
+	createAnimProgressBar->setNbImages (nbImages);
+	createImages ();
+	rewindAnim ();
+}
+//---------------------------------------
 void GribAnimator::exitAnim()
 {
 closestatus=2;
@@ -274,21 +320,43 @@ void GribAnimator::timerPauseOut()
 }
 
 
+//===================================================================
+// Dates of the file, and for GRIB data, interpolated dates between them
+// (only the instantaneous parameters are interpolated by the reader).
+void GribAnimator::makeFrameDates()
+{
+	frameDates.clear();
+	std::set<time_t> *lsdates = gribplot->getListDates();
+	bool interp = nbInterpolated > 0
+			&& gribplot->getReader() != NULL
+			&& gribplot->getReader()->getReaderFileDataType() == DATATYPE_GRIB;
+	std::set<time_t>::iterator iter;
+	time_t prev = 0;
+	for (iter=lsdates->begin(); iter!=lsdates->end(); iter++)
+	{
+		time_t date = *iter;
+		if (interp && iter != lsdates->begin()) {
+			for (int k=1; k<=nbInterpolated; k++)
+				frameDates.push_back (prev + (date-prev)*k/(nbInterpolated+1));
+		}
+		frameDates.push_back (date);
+		prev = date;
+	}
+}
+
 //===================================================================
 void GribAnimator::createImages()
 {
 	QPainter pnt;
-	std::set<time_t>::iterator iter;
 	int num=0;
 
 	stackWidgets->setCurrentWidget(createAnimProgressBar);
     lbmessage->setFont(Font::getFont(FONT_StatusBar));
 	closestatus=0;
 	bool isEarthMapValid = false;
-	for (iter=gribplot->getListDates()->begin();
-				iter!=gribplot->getListDates()->end();   iter++, num++)
+	for (num=0; num < (int)frameDates.size(); num++)
 	{
-		time_t date = *iter;
+		time_t date = frameDates[num];
 		
 //  		qApp->processEvents (); 
 		if (closestatus != 0) break;
@@ -308,11 +376,15 @@ void GribAnimator::createImages()
 		assert(img);
 		
 		img->date = date;
+		terre->lockData ();		// plotter is shared with the map thread
 		img->pixmap = drawer->createPixmap_GriddedData ( 
 								date, isEarthMapValid, 
 								gribplot,
 								proj,
 								lspois );
+		if (! terre->isLoadingFile())
+			GribRecordCache::trim ();
+		terre->unlockData ();
 		isEarthMapValid = true;
 		
  		if (img->pixmap == NULL) {
@@ -384,19 +456,20 @@ GribAnimator::GribAnimator (Terrain *terre)
 	
 	this->proj     = terre->getProjection()->clone();
 	this->drawer   = new MapDrawer (* terre->getDrawer());
-	this->lspois   = terre->getListPOIs();
+	this->lspois   = terre->getListShownPOIs();
 
     W = proj->getW();
     H = proj->getH();
-	nbImages = gribplot->getListDates()->size();
+	speed = Util::getSetting("animSpeed", 200).toInt();
+	autoLoop = Util::getSetting("animAutoLoop", false).toBool();
+	nbInterpolated = Util::getSetting("animInterpolatedImages", 0).toInt();
+	makeFrameDates ();
+	nbImages = frameDates.size();
 	
 	vectorImages.reserve (nbImages);
 	currentImage = 0;
-	
-	speed = Util::getSetting("animSpeed", 200).toInt();
-	autoLoop = Util::getSetting("animAutoLoop", false).toBool();
 
-	animCommand  = new AnimCommand(nbImages, speed, autoLoop, this);
+	animCommand  = new AnimCommand(nbImages, speed, autoLoop, nbInterpolated, this);
 	assert(animCommand);
 
 	timerLoop = new QTimer(this);
@@ -418,6 +491,7 @@ GribAnimator::GribAnimator (Terrain *terre)
  	connect(animCommand, SIGNAL(setSpeed(int)), this, SLOT(setSpeed(int)));
  	connect(animCommand, SIGNAL(setCurrentImage(int)), this, SLOT(showImage(int)));
  	connect(animCommand, SIGNAL(setAutoLoop(bool)), this, SLOT(setAutoLoop(bool)));
+ 	connect(animCommand, SIGNAL(setInterpolatedImages(int)), this, SLOT(setInterpolatedImages(int)));
 	
 	show();
 	createImages();
@@ -30,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QStackedWidget>
 #include <QAction>
 #include <QSlider>
+#include <QSpinBox>
 #include <vector>
 
 #include "DialogBoxColumn.h"
@@ -53,7 +54,9 @@ class AnimImage
 class AnimCommand : public QToolBar
 { Q_OBJECT
     public:
-		AnimCommand(int nbImages, int speed, bool autoLoop, QWidget *parent);
+		AnimCommand(int nbImages, int speed, bool autoLoop,
+					int nbInterpolated, QWidget *parent);
+		void setNbImages(int nbImages);
 	
 	signals:
 		void exitAnim();
@@ -64,6 +67,7 @@ class AnimCommand : public QToolBar
 		void setSpeed(int);
 		void setCurrentImage(int);
 		void setAutoLoop(bool);
+		void setInterpolatedImages(int);
 	
 	private:
 		int nbImages;
@@ -79,6 +83,7 @@ class AnimCommand : public QToolBar
 
 		QSlider *sliderSpeed;
 		QSlider *sliderCurrentImage;
+		QSpinBox *spinInterpolated;
 		
 		int speedSlider_ValueToSpeed();
 		int speedSlider_SpeedToValue(int speed);
@@ -95,6 +100,7 @@ class CreateAnimProgressBar : public QWidget
     public:
 		CreateAnimProgressBar(int nbImages, QWidget *parent);
 		void setCurrentValue(int n);
+		void setNbImages(int nbImages);
 
 	private:
 		int nbImages;
@@ -122,6 +128,7 @@ class GribAnimator : public QDialog
 		void saveAnimFile();
 		void rewindAnim();
 		void setAutoLoop(bool);
+		void setInterpolatedImages(int nb);
 		void timerPauseOut();
 		    
     private:
@@ -134,11 +141,14 @@ class GribAnimator : public QDialog
 		
 		volatile int 	closestatus;		
         std::vector <AnimImage *> vectorImages;
+        std::vector <time_t>      frameDates;
+		void	makeFrameDates();
 		void	createImages();
         unsigned int		currentImage;
         int 	nbImages;
         int		speed;
         bool	autoLoop;
+        int		nbInterpolated;		// images between 2 dates of the file
         
         QFrame 			*frameGui;
         QVBoxLayout 	*frameLayout;
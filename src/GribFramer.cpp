@@ -0,0 +1,235 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <cstring>
+#include <algorithm>
+
+#include "GribFramer.h"
+
+#define FRAMER_READ_SIZE   (256*1024)
+#define FRAMER_MIN_SIZE    16		// size of section 0 in GRIB2
+#define FRAMER_MAX_SIZE    (1L<<30)
+#define FRAMER_HEAD_READ   4096		// bytes by read for the headers
+#define FRAMER_PROBE_SIZE  (64*1024)	// isGribFile: start of the first message
+
+//---------------------------------------------------------------------
+GribFramer::GribFramer (ZUFILE *file)
+{
+	this->file = file;
+	fileSize = zu_filesize (file);
+	eof = false;
+	buf.resize (FRAMER_READ_SIZE);
+	bufOffset = zu_tell (file);
+	begin = end = 0;
+	msgStart = 0;
+	msgOffset = 0;
+	msgSize = msgReadSize = 0;
+	msgEdition = 0;
+	readLimit = 0;
+	searchLimit = 0;
+}
+GribFramer::GribFramer ()
+{
+	file = NULL;
+	fileSize = 0;
+	eof = false;
+	bufOffset = 0;
+	begin = end = 0;
+	msgStart = 0;
+	msgOffset = 0;
+	msgSize = msgReadSize = 0;
+	msgEdition = 0;
+	readLimit = 0;
+	searchLimit = 0;
+}
+//---------------------------------------------------------------------
+void GribFramer::compact ()
+{
+	if (begin > 0) {
+		memmove (&buf[0], &buf[begin], end-begin);
+		bufOffset += begin;
+		end -= begin;
+		if (msgStart >= begin)
+			msgStart -= begin;
+		begin = 0;
+	}
+}
+//---------------------------------------------------------------------
+void GribFramer::addData (const uint8_t *data, size_t size)
+{
+	compact ();
+	if (buf.size() < end+size)
+		buf.resize (std::max (end+size, 2*buf.size()));
+	memcpy (&buf[end], data, size);
+	end += size;
+}
+//---------------------------------------------------------------------
+bool GribFramer::fill (size_t need)
+{
+	if (file == NULL)
+		return end-begin >= need;
+	while (end-begin < need && !eof)
+	{
+		compact ();
+		if (buf.size() < need)
+			buf.resize (need);
+		if (buf.size()-end < FRAMER_READ_SIZE/4)
+			buf.resize (end+FRAMER_READ_SIZE);
+		size_t nbmax = buf.size()-end;
+		if (readLimit > 0)
+			nbmax = std::min (nbmax, std::max (readLimit, need-(end-begin)));
+		int nb = zu_read (file, &buf[end], nbmax);
+		if (nb <= 0)
+			eof = true;
+		else
+			end += nb;
+	}
+	return end-begin >= need;
+}
+//---------------------------------------------------------------------
+long GribFramer::findMessageStart ()
+{
+	while ((searchLimit==0 || bufOffset+(long)begin <= searchLimit)
+				&& fill (FRAMER_MIN_SIZE))
+	{
+		// search 'GRIB'
+		size_t p = begin;
+		size_t lim = end - FRAMER_MIN_SIZE;
+		while (p <= lim && !(buf[p]=='G' && buf[p+1]=='R'
+								&& buf[p+2]=='I' && buf[p+3]=='B'))
+			p ++;
+		if (searchLimit > 0 && bufOffset+(long)p > searchLimit)
+			return 0;
+		if (p > lim) {
+			begin = lim+1;		// keep the end of a truncated 'GRIB'
+			if (eof)
+				return 0;
+			continue;
+		}
+		begin = p;
+		const uint8_t *b = &buf[p];
+		int edition = b[7];
+		long size = 0;
+		if (edition == 1) {
+			size = (b[4]<<16) + (b[5]<<8) + b[6];
+		}
+		else if (edition == 2) {
+			size = ((long)b[12]<<24) + (b[13]<<16) + (b[14]<<8) + b[15];
+			if (b[8] || b[9] || b[10] || b[11])
+				size = 0;		// > 4GB
+		}
+		if (size < FRAMER_MIN_SIZE || size > FRAMER_MAX_SIZE) {
+			begin ++;			// not a message
+			continue;
+		}
+		return size;
+	}
+	return 0;
+}
+//---------------------------------------------------------------------
+bool GribFramer::nextMessage ()
+{
+	long size;
+	while ((size = findMessageStart ()) > 0)
+	{
+		if (! fill (size)) {
+			if (! eof)
+				return false;	// wait for the end of the message
+			begin ++;
+			continue;
+		}
+		const uint8_t *b = &buf[begin];
+		if (memcmp (b+size-4, "7777", 4) != 0) {
+			begin ++;
+			continue;
+		}
+		msgStart = begin;
+		msgOffset = bufOffset+begin;
+		msgSize = msgReadSize = size;
+		msgEdition = b[7];
+		begin += size;
+		return true;
+	}
+	return false;
+}
+//---------------------------------------------------------------------
+bool GribFramer::nextMessageHeader ()
+{
+	readLimit = FRAMER_HEAD_READ;		// don't read the values
+	long size;
+	while ((size = findMessageStart ()) > 0)
+	{
+		long offset = bufOffset+begin;
+		if (offset+size > fileSize) {
+			begin ++;			// truncated message
+			continue;
+		}
+		// sections 0 to 2 of GRIB1 (lengths of the PDS and the GDS),
+		// the whole message otherwise
+		long head = size;
+		if (buf[begin+7] == 1) {		// 16 bytes are in the buffer
+			const uint8_t *b = &buf[begin];
+			bool hasGDS = (b[8+7] & 128) != 0;
+			head = 8 + (b[8]<<16) + (b[9]<<8) + b[10];
+			if (hasGDS && head+3 <= size && fill (head+3)) {
+				b = &buf[begin];		// the buffer may be moved by fill
+				head += (b[head]<<16) + (b[head+1]<<8) + b[head+2];
+			}
+			head = std::min (head, size);
+		}
+		if (! fill (head)) {
+			begin ++;
+			continue;
+		}
+		msgStart = begin;
+		msgOffset = offset;
+		msgSize = size;
+		msgReadSize = head;
+		msgEdition = buf[begin+7];
+		if (begin+size <= end) {
+			begin += size;
+		}
+		else {
+			// the header stays in the buffer until the next call
+			if (zu_seek (file, offset+size, SEEK_SET) != 0)
+				eof = true;
+			bufOffset = offset+size-end;
+			begin = end;
+		}
+		return true;
+	}
+	return false;
+}
+//---------------------------------------------------------------------
+double GribFramer::getProgress () const
+{
+	if (fileSize <= 0)
+		return 0;
+	double p = (double) zu_rawtell (file) / fileSize;
+	return p < 1 ? p : 1;
+}
+//---------------------------------------------------------------------
+bool GribFramer::isGribFile (ZUFILE *file)
+{
+	GribFramer framer (file);
+	framer.searchLimit = FRAMER_PROBE_SIZE;		// not the whole file
+	framer.readLimit = FRAMER_PROBE_SIZE;
+	bool res = framer.nextMessage ();
+	zu_rewind (file);
+	return res;
+}
@@ -0,0 +1,88 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef GRIBFRAMER_H
+#define GRIBFRAMER_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "zuFile.h"
+
+//====================================================================
+// Splits a GRIB file (edition 1 or 2) in complete messages.
+// The file is read strictly forward through one buffer, so a
+// compressed file is decompressed only once.
+// Bytes between messages are skipped.
+// Without file, data are given by pieces with addData
+// (download in progress).
+//====================================================================
+class GribFramer
+{
+	public:
+		GribFramer (ZUFILE *file);
+		GribFramer ();
+
+		void  addData (const uint8_t *data, size_t size);
+		void  setEndOfData ()   {eof = true;}
+
+		// Next complete message (false at the end of the file,
+		// or if more data is needed).
+		// The message stays valid until the next call or addData.
+		bool  nextMessage ();
+		// Same, but only sections 0 to 2 of a GRIB1 message are read
+		// (sizes given by their headers): the end of the message is
+		// skipped with a seek. Uncompressed file only.
+		bool  nextMessageHeader ();
+
+		const uint8_t *getMessage () const  {return &buf[msgStart];}
+		long  getMessageSize () const       {return msgSize;}
+		long  getMessageOffset () const     {return msgOffset;}
+		// Bytes of the message in the buffer (< size for a header)
+		long  getMessageReadSize () const   {return msgReadSize;}
+		int   getEdition () const           {return msgEdition;}
+
+		// Fraction of the file already read (0..1)
+		double getProgress () const;
+
+		// Does the file contain a GRIB message starting in its
+		// first bytes (FRAMER_PROBE_SIZE) ?
+		static bool isGribFile (ZUFILE *file);
+
+	private:
+		ZUFILE *file;
+		long   fileSize;
+		bool   eof;
+		std::vector <uint8_t> buf;
+		long   bufOffset;	// position of buf[0] in the file
+		size_t begin, end;	// unread bytes
+		size_t msgStart;
+		long   msgOffset;
+		long   msgSize;
+		long   msgReadSize;
+		int    msgEdition;
+		size_t readLimit;		// max bytes by read (0: buffer size)
+		long   searchLimit;		// messages start before (0: no limit)
+
+		void  compact ();			// drop the bytes already used
+		bool  fill (size_t need);	// at least need unread bytes
+		// Moves begin to the next message, returns its size (0 if none)
+		long  findMessageStart ();
+};
+
+#endif
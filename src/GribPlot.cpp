@@ -32,11 +32,28 @@ GribPlot::GribPlot (const GribPlot &model)
 	: RegularGridPlot ()
 {
 	initNewGribPlot (model.mustInterpolateValues, model.drawWindArrowsOnGrid, model.drawCurrentArrowsOnGrid);	
+	loadSubset = model.loadSubset;
+	datasetFiles = model.datasetFiles;
 	loadFile (model.fileName);
+	enableRecordCache ();
 	duplicateFirstCumulativeRecord (model.mustDuplicateFirstCumulativeRecord);
 	duplicateMissingWaveRecords (model.mustDuplicateMissingWaveRecords);
 }
 //----------------------------------------------------
+void GribPlot::openReaderFiles (LongTaskProgress *taskProgress)
+{
+	gribReader->setSubset (loadSubset);
+	if (datasetFiles.size() > 1) {
+		std::vector<std::string> fnames;
+		for (int i=0; i<datasetFiles.size(); i++)
+			fnames.push_back (qPrintable(datasetFiles[i]));
+		gribReader->openFiles (fnames, taskProgress);
+	}
+	else {
+		gribReader->openFile (qPrintable(fileName), taskProgress);
+	}
+}
+//----------------------------------------------------
 GribPlot::~GribPlot() {
     if (gribReader != NULL) {
     	delete gribReader;
@@ -54,7 +71,7 @@ void GribPlot::initNewGribPlot(bool interpolateValues, bool windArrowsOnGribGrid
 }
 //----------------------------------------------------
 void GribPlot::loadFile (QString fileName,
-						 LongTaskProgress * taskProgress, int nbrecs)
+						 LongTaskProgress * taskProgress)
 {
 	this->fileName = fileName;
 	listDates.clear();
@@ -67,7 +84,7 @@ void GribPlot::loadFile (QString fileName,
 	gribReader = new GribReader ();
     if (gribReader != NULL)
     {
-		gribReader->openFile (qPrintable(fileName), taskProgress, nbrecs);
+		openReaderFiles (taskProgress);
 		if (gribReader->isOk())
 		{
 			listDates = gribReader->getListDates();
@@ -75,6 +92,30 @@ void GribPlot::loadFile (QString fileName,
 		}
 	}
 }
+//----------------------------------------------------
+void GribPlot::loadReader (GribReader *reader, QString fileName)
+{
+	this->fileName = fileName;
+	listDates.clear();
+    
+    if (gribReader != NULL) {
+    	delete gribReader;
+    }
+	gribReader = reader;
+	if (gribReader != NULL && gribReader->isOk())
+	{
+		// records decoded from the .part file, renamed since
+		gribReader->renameFile (qPrintable(fileName));
+		listDates = gribReader->getListDates();
+		setCurrentDate ( listDates.size()>0 ? *(listDates.begin()) : 0);
+	}
+}
+//----------------------------------------------------
+void GribPlot::enableRecordCache ()
+{
+	if (gribReader != NULL && gribReader->isOk())
+		gribReader->enableRecordCache ();
+}
 
 //----------------------------------------------------
 void GribPlot::duplicateFirstCumulativeRecord ( bool mustDuplicate )
@@ -110,6 +151,8 @@ void GribPlot::duplicateMissingWaveRecords ( bool mustDuplicate )
 void GribPlot::setCurrentDate (time_t t)
 {
     currentDate = t;
+    if (gribReader != NULL)
+		gribReader->pinRecordsAroundDate (t);
 }
  
 
@@ -129,27 +172,51 @@ void GribPlot::draw_GridPoints (const DataCode &dtc, QPainter &pnt, const Projec
 	else
 		dd = dtc;
 		
-    GribRecord *rec = gribReader->getRecord (dd, getCurrentDate());
+    GribRecord *rec = gribReader->getRecordAtDate (dd, getCurrentDate());
 	if (! rec)
 			return;
-	int deltaI, deltaJ;
-	analyseVisibleGridDensity (proj, rec, 6, &deltaI, &deltaJ);
-    int px,py, i,j, dl=2;
-    for (i=0; i<rec->getNi(); i+=deltaI)
-        for (j=0; j<rec->getNj(); j+=deltaJ)
+	// Visible points of the grid, one in 2^level when they are too dense
+	int step = 1;
+	GridPyramidPtr pyr = rec->getPyramid (dd);
+	if (pyr)
+		step = 1 << getVisibleGridLevel (proj, pyr, 6);
+	std::vector <int> cols, rows;
+	getVisibleGridIndexes (rec, proj, 2, cols, rows);
+    int px,py, dl=2;
+    int W = proj->getW();
+    for (size_t ki=0; ki<cols.size(); ki++)
+    {
+		if (cols[ki]%step != 0)
+			continue;
+		double x = rec->getX(cols[ki]);
+		if (! rec->isXInMap(x))
+			x += 360.0;   // tour du monde ?
+        for (size_t kj=0; kj<rows.size(); kj++)
         {
-            //if (rec->hasValue(i,j))
-            {
-                proj->map2screen(rec->getX(i), rec->getY(j), &px,&py);
-                pnt.drawLine(px-dl,py, px+dl,py);
-                pnt.drawLine(px,py-dl, px,py+dl);
-                proj->map2screen(rec->getX(i)-360.0, rec->getY(j), &px,&py);
-                pnt.drawLine(px-dl,py, px+dl,py);
-                pnt.drawLine(px,py-dl, px,py+dl);
-            }
+			if (rows[kj]%step != 0)
+				continue;
+			proj->map2screen(x, rec->getY(rows[kj]), &px,&py);
+			if (px > W)
+				proj->map2screen(x-360.0, rec->getY(rows[kj]), &px,&py);
+			pnt.drawLine(px-dl,py, px+dl,py);
+			pnt.drawLine(px,py-dl, px,py+dl);
         }
+    }
 }
 
+//---------------------------------------------------------------------
+// Mean vector of a cell of a coarse level, scaled to the mean speed
+//---------------------------------------------------------------------
+static void setMeanSpeed (double *vx, double *vy, double speed)
+{
+	if (*vx == GRIB_NOTDEF || *vy == GRIB_NOTDEF || speed == GRIB_NOTDEF)
+		return;
+	double norm = sqrt ((*vx)*(*vx) + (*vy)*(*vy));
+	if (norm > 0) {
+		*vx *= speed/norm;
+		*vy *= speed/norm;
+	}
+}
 
 //==================================================================================
 // Flèches de direction du vent
@@ -164,9 +231,9 @@ void GribPlot::draw_WIND_Arrows (
     }
 	windAltitude = altitude;
     windArrowColor = arrowsColor;
-    GribRecord *recx = gribReader->getRecord
+    GribRecord *recx = gribReader->getRecordAtDate
 								(DataCode(GRB_WIND_VX,altitude),currentDate);
-    GribRecord *recy = gribReader->getRecord 
+    GribRecord *recy = gribReader->getRecordAtDate
 								(DataCode(GRB_WIND_VY,altitude),currentDate);
     if (recx == NULL || recy == NULL)
         return;        
@@ -183,13 +250,26 @@ void GribPlot::draw_WIND_Arrows (
 	    space =  drawWindArrowsOnGrid ? windArrowSpaceOnGrid : windArrowSpace;
     
     if (drawWindArrowsOnGrid)
-    {	// Flèches uniquement sur les points de la grille
-    	for (int gi=0; gi<recx->getNi(); gi++)
+    {	// Flèches uniquement sur les points visibles de la grille
+		// Dense grid : one arrow by cell of a coarser level
+		// (direction of the mean wind, mean of the speeds)
+		GridPyramidPtr pyrx = recx->getPyramid (recx->getDataCode());
+		GridPyramidPtr pyry = recy->getPyramid (recy->getDataCode());
+		GridPyramidPtr pyrn = recx->getNormPyramid (recx->getDataCode(),
+											recy, recy->getDataCode());
+		if (!pyrx || !pyry || !pyrn)
+			return;
+		int level = getVisibleGridLevel (proj, pyrx, space);
+		std::vector <int> cols, rows;
+		getVisibleGridIndexes (recx, pyrx, level, proj, space, cols, rows);
+    	for (size_t ki=0; ki<cols.size(); ki++)
     	{
-			for (int gj=0; gj<recx->getNj(); gj++)
+			int gi = cols[ki];
+			for (size_t kj=0; kj<rows.size(); kj++)
 			{
-				x = recx->getX(gi);
-				y = recx->getY(gj);
+				int gj = rows[kj];
+				x = pyrx->getX(level, gi);
+				y = pyrx->getY(level, gj);
 				
 					//----------------------------------------------------------------------
 					if (! recx->isXInMap(x))
@@ -199,12 +279,14 @@ void GribPlot::draw_WIND_Arrows (
 					proj->map2screen(x-360,y, &i,&j);
 				
 					if (recx->isPointInMap(x,y)) {
-						vx = recx->getInterpolatedValue(x, y, mustInterpolateValues);
-						vy = recy->getInterpolatedValue(x, y, mustInterpolateValues);
+						vx = pyrx->getMean (level, gi, gj);
+						vy = pyry->getMean (level, gi, gj);
+						if (level > 0)
+							setMeanSpeed (&vx, &vy, pyrn->getMean (level, gi, gj));
 						if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF)
 						{
 							if (barbules)
-								drawWindArrowWithBarbs(pnt, i,j, vx,vy, (y<0), arrowsColor);
+								drawWindArrowWithBarbs_sprite(pnt, i,j, vx,vy, (y<0), arrowsColor);
 							else
 								drawWindArrow(pnt, i,j, vx,vy);
 						}
@@ -250,7 +332,7 @@ void GribPlot::draw_WIND_Arrows (
 					if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF)
 					{
 						if (barbules)
-							drawWindArrowWithBarbs(pnt, i,j, vx,vy, (y<0), arrowsColor);
+							drawWindArrowWithBarbs_sprite(pnt, i,j, vx,vy, (y<0), arrowsColor);
 						else
 							drawWindArrow(pnt, i,j, vx,vy);
 					}
@@ -279,9 +361,9 @@ void GribPlot::draw_CURRENT_Arrows (
 	currentAltitude = altitude;
     currentArrowColor = arrowsColor;
 
-    GribRecord *recx = gribReader->getRecord
+    GribRecord *recx = gribReader->getRecordAtDate
 								(DataCode(GRB_CUR_VX,altitude),currentDate);
-    GribRecord *recy = gribReader->getRecord 
+    GribRecord *recy = gribReader->getRecordAtDate
 								(DataCode(GRB_CUR_VY,altitude),currentDate);
     if (recx == NULL || recy == NULL)
         return;        
@@ -294,20 +376,33 @@ void GribPlot::draw_CURRENT_Arrows (
 	    space =  drawCurrentArrowsOnGrid ? currentArrowSpaceOnGrid : currentArrowSpace;
     
     if (drawCurrentArrowsOnGrid)
-    {	// Flèches uniquement sur les points de la grille
+    {	// Flèches uniquement sur les points visibles de la grille
+		// Dense grid : one arrow by cell of a coarser level
+		// (direction of the mean current, mean of the speeds)
+		GridPyramidPtr pyrx = recx->getPyramid (recx->getDataCode());
+		GridPyramidPtr pyry = recy->getPyramid (recy->getDataCode());
+		GridPyramidPtr pyrn = recx->getNormPyramid (recx->getDataCode(),
+											recy, recy->getDataCode());
+		if (!pyrx || !pyry || !pyrn)
+			return;
+		int level = getVisibleGridLevel (proj, pyrx, space);
+		std::vector <int> cols, rows;
+		getVisibleGridIndexes (recx, pyrx, level, proj, space, cols, rows);
     	int oldi=-1000, oldj=-1000;
-    	for (int gi=0; gi<recx->getNi(); gi++)
+    	for (size_t ki=0; ki<cols.size(); ki++)
     	{
-			x = recx->getX(gi);
-			y = recx->getY(0);
+			int gi = cols[ki];
+			x = pyrx->getX(level, gi);
+			y = pyrx->getY(level, 0);
 			proj->map2screen(x,y, &i,&j);
 			if (true || abs(i-oldi)>=space)
 			{
 				oldi = i;
-				for (int gj=0; gj<recx->getNj(); gj++)
+				for (size_t kj=0; kj<rows.size(); kj++)
 				{
-					x = recx->getX(gi);
-					y = recx->getY(gj);
+					int gj = rows[kj];
+					x = pyrx->getX(level, gi);
+					y = pyrx->getY(level, gj);
 					proj->map2screen(x,y, &i,&j);
 					
 						//----------------------------------------------------------------------
@@ -318,8 +413,10 @@ void GribPlot::draw_CURRENT_Arrows (
 							if (true || abs(j-oldj)>=space)
 							{
 								oldj = j;
-								vx = recx->getInterpolatedValue(x, y, mustInterpolateValues);
-								vy = recy->getInterpolatedValue(x, y, mustInterpolateValues);
+								vx = pyrx->getMean (level, gi, gj);
+								vy = pyry->getMean (level, gi, gj);
+								if (level > 0)
+									setMeanSpeed (&vx, &vy, pyrn->getMean (level, gi, gj));
 								if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF)
 								{
 									drawCurrentArrow(pnt, i,j, vx,vy);
@@ -463,18 +560,31 @@ void GribPlot::draw_WAVES_Arrows (
 	space =  drawWindArrowsOnGrid ? windArrowSpaceOnGrid : windArrowSpace;
     
     if (drawWindArrowsOnGrid)
-    {	// Flèches uniquement sur les points de la grille
+    {	// Flèches uniquement sur les points visibles de la grille,
+		// un sur 2^level si la grille est dense (pas de moyenne des directions)
+		int step = 1;
+		GridPyramidPtr pyr = recDir->getPyramid (recDir->getDataCode());
+		if (pyr)
+			step = 1 << getVisibleGridLevel (proj, pyr, space);
+		std::vector <int> cols, rows;
+		getVisibleGridIndexes (recDir, proj, space, cols, rows);
     	int oldi=-1000, oldj=-1000;
-    	for (int gi=0; gi<recDir->getNi(); gi++)
+    	for (size_t ki=0; ki<cols.size(); ki++)
     	{
+			int gi = cols[ki];
+			if (gi%step != 0)
+				continue;
 			x = recDir->getX(gi);
 			y = recDir->getY(0);
 			proj->map2screen(x,y, &i,&j);
 			if (true || abs(i-oldi)>=space)
 			{
 				oldi = i;
-				for (int gj=0; gj<recDir->getNj(); gj++)
+				for (size_t kj=0; kj<rows.size(); kj++)
 				{
+					int gj = rows[kj];
+					if (gj%step != 0)
+						continue;
 					x = recDir->getX(gi);
 					y = recDir->getY(gj);
 					proj->map2screen(x,y, &i,&j);
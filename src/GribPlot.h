@@ -23,6 +23,8 @@ Dessin des données GRIB (avec QT)
 #ifndef GRIBPLOT_H
 #define GRIBPLOT_H
 
+#include <QStringList>
+
 #include "RegularGridded.h"
 
 #include "GribReader.h"
@@ -38,7 +40,17 @@ class GribPlot : public RegularGridPlot
         virtual ~GribPlot ();
         
 		virtual void  loadFile (QString fileName,
-						LongTaskProgress *taskProgress=NULL, int nbrecs=0);
+						LongTaskProgress *taskProgress=NULL);
+		// Use a reader already filled (download), which is kept
+		void  loadReader (GribReader *reader, QString fileName);
+		virtual void  enableRecordCache ();
+		// Part of the file read by the next loadFile
+		void  setLoadSubset (const GribSubset &subset)
+						{ loadSubset = subset; }
+		// Files read as one dataset by the next loadFile
+		// (fileName is the first one)
+		void  setDatasetFiles (const QStringList &files)
+						{ datasetFiles = files; }
 		
         GribReader *getReader()  const  {return gribReader;}
 
@@ -87,6 +99,10 @@ class GribPlot : public RegularGridPlot
         
 		GribReader 	*gribReader;        
         QString 	fileName;
+        GribSubset	loadSubset;
+        QStringList	datasetFiles;
+        // Opens fileName, or the files of the dataset
+        void  openReaderFiles (LongTaskProgress *taskProgress);
 };
 
 #endif
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cassert>
 
 #include "GribReader.h"
+#include "GribRecordCache.h"
 #include "Util.h"
 #include "DataQString.h"
 #include "Therm.h"
@@ -34,33 +35,97 @@ GribReader::GribReader()
 	xmax = -1e300;
 	ymin =  1e300;
 	ymax = -1e300;
+	stream = NULL;
+	streamFramer = NULL;
+	streamId = 0;
+	streamOk = false;
+	taskProgress = NULL;
+	previewDone = true;
+	previewDate = 0;
+	datasetIndex = 0;
+	datasetSize = 1;
+	timeInterpUse = 0;
 }
 //-------------------------------------------------------------------------------
 void GribReader::openFile (const std::string fname,
-							LongTaskProgress *taskProgress, int nbrecs)
+							LongTaskProgress *taskProgress)
 {
 	this->taskProgress = taskProgress;
-	taskProgress->continueDownload = true;
+	previewDone = false;
+	previewDate = 0;
 	setAllDataCenterModel.clear();
 	setAllDates.clear ();
 	setAllDataCode.clear ();
 	
     if (fname != "") {
-        openFilePriv (fname, nbrecs);
+        openFilePriv (fname);
     }
     else {
         clean_all_vectors();
     }
 }
 //-------------------------------------------------------------------------------
+void GribReader::openFiles (const std::vector<std::string> &fnames,
+							LongTaskProgress *taskProgress)
+{
+	this->taskProgress = taskProgress;
+	previewDone = false;
+	previewDate = 0;
+	setAllDataCenterModel.clear();
+	setAllDates.clear ();
+	setAllDataCode.clear ();
+	ok = false;
+	clean_all_vectors();
+	taskProgress->setMessage (LTASK_OPEN_FILE);
+	taskProgress->setValue (0);
+	long totalSize = 0;
+	datasetSize = fnames.size();
+	for (datasetIndex=0; datasetIndex<datasetSize
+						&& !taskProgress->isCanceled(); datasetIndex++)
+	{
+		fileName = fnames [datasetIndex];
+		file = zu_open (fileName.c_str(), "rb", ZU_COMPRESS_AUTO);
+		if (file == NULL) {
+			erreur("Can't open file: %s", fileName.c_str());
+			continue;
+		}
+		totalSize += zu_filesize (file);
+		readDatasetFile ();
+		zu_close (file);
+	}
+	datasetIndex = 0;
+	datasetSize = 1;
+	fileName = fnames.size()>0 ? fnames[0] : "";
+	fileSize = totalSize;
+	previewDone = true;
+	taskProgress->setMessage (LTASK_PREPARE_MAPS);
+	createListDates ();
+	ok = getNumberOfDates()>0 && !taskProgress->isCanceled();
+	if (ok)
+		computeMissingData ();   // RH DewPoint ThetaE
+}
+//-------------------------------------------------------------------------------
+void GribReader::readDatasetFile ()
+{
+	readAllGribRecords (file->type == ZU_COMPRESS_NONE);
+}
+//-------------------------------------------------------------------------------
+void GribReader::setFileProgress (double fraction)
+{
+	taskProgress->setValue ((int)(100.0*(datasetIndex+fraction)/datasetSize));
+}
+//-------------------------------------------------------------------------------
 GribReader::~GribReader()
 {
 // 	DBGS("Destroy GribReader");
+	GribRecordCache::unpinRecords (this);
     clean_all_vectors();
+    closeStream ();
 }
 //-------------------------------------------------------------------------------
 void GribReader::clean_all_vectors ()
 {
+	clean_time_interp_cache ();
 	std::map < std::string, std::vector<GribRecord *>* >::iterator it;
 	for (it=mapGribRecords.begin(); it!=mapGribRecords.end(); it++) {
 		std::vector<GribRecord *> *ls = (*it).second;
@@ -70,6 +135,17 @@ void GribReader::clean_all_vectors ()
 	mapGribRecords.clear();
 }
 //-------------------------------------------------------------------------------
+void GribReader::clean_time_interp_cache ()
+{
+	QMutexLocker lock (&timeInterpMutex);
+	std::map < std::pair<std::string,time_t>,
+			   GribRecordTimeInterp * >::iterator it;
+	for (it=mapTimeInterpRecords.begin(); it!=mapTimeInterpRecords.end(); it++) {
+		delete (*it).second;
+	}
+	mapTimeInterpRecords.clear();
+}
+//-------------------------------------------------------------------------------
 void GribReader::clean_vector (std::vector<GribRecord *> &ls)
 {
     std::vector<GribRecord *>::iterator it;
@@ -84,6 +160,7 @@ void GribReader::storeRecordInMap (GribRecord *rec)
 {
 	if (rec==NULL || !rec->isOk())
 		return;
+	clean_time_interp_cache ();   // records around dates may change
 // 	DBG ("%g %g   %g %g", rec->getXmin(),rec->getXmax(), getYmin(),getYmax());
 	
 	std::map <std::string, std::vector<GribRecord *>* >::iterator it;
@@ -109,6 +186,10 @@ void GribReader::storeRecordInMap (GribRecord *rec)
 	setAllDataCode.insert (rec->getDataCode());
 	setAllDataCenterModel.insert (rec->getDataCenterModel());
 	
+	if (! previewDone) {
+		checkPreview (rec->getRecordCurrentDate());
+	}
+	
 	if (rec->getLevelType()==LV_ISOBARIC
 			&& (   rec->getLevelValue()==850
 				|| rec->getLevelValue()==700
@@ -121,30 +202,105 @@ void GribReader::storeRecordInMap (GribRecord *rec)
 	}
 }
 //---------------------------------------------------------------------------------
-void GribReader::readAllGribRecords (int nbrecs)
+// The first date is complete when a record of an other date is read
+// (records are usually sorted by date in GRIB files)
+//---------------------------------------------------------------------------------
+void GribReader::checkPreview (time_t date)
+{
+	if (taskProgress == NULL || !taskProgress->isPreviewWanted()) {
+		previewDone = true;
+		return;
+	}
+	if (previewDate == 0) {
+		previewDate = date;
+	}
+	else if (date != previewDate) {
+		previewDone = true;
+		GribReader *preview = createPreview (previewDate);
+		if (preview != NULL)
+			taskProgress->setPreview (preview);
+	}
+}
+//---------------------------------------------------------------------------------
+// Reader with a copy of the records of one date
+// (values are not shared: the preview is used by an other thread)
+//---------------------------------------------------------------------------------
+GribReader * GribReader::createPreview (time_t date)
+{
+	GribReader *preview = new GribReader ();
+	assert (preview);
+	std::map < std::string, std::vector<GribRecord *>* >::iterator it;
+	for (it=mapGribRecords.begin(); it!=mapGribRecords.end(); it++) {
+		std::vector<GribRecord *> *ls = (*it).second;
+		for (zuint i=0; i<ls->size(); i++) {
+			if (ls->at(i)->getRecordCurrentDate() == date) {
+				GribRecord *rec = new GribRecord (*(ls->at(i)));
+				assert (rec);
+				rec->detachData ();
+				preview->storeRecordInMap (rec);
+			}
+		}
+	}
+	preview->fileName = fileName;
+	preview->createListDates ();
+	preview->ok = preview->getNumberOfDates() > 0;
+	if (! preview->ok) {
+		delete preview;
+		return NULL;
+	}
+	return preview;
+}
+//---------------------------------------------------------------------------------
+void GribReader::readAllGribRecords (bool headersOnly)
 {
     //--------------------------------------------------------
     // Lecture de l'ensemble des GribRecord du fichier
     // et stockage dans les listes appropriées.
+    // Messages are framed while reading the file forward,
+    // then each record is decoded from memory.
     //--------------------------------------------------------
-    GribRecord *rec;
+    GribFramer framer (file);
     int id = 0;
-    time_t firstdate = -1;
+    bool goon = true;
+    bool origin = file->type == ZU_COMPRESS_NONE;	// fast seek
 	ok = false;
-    do {
+    while (goon && !taskProgress->isCanceled()) {
 		if (id%4 == 1)
-			taskProgress->setValue ((int)(100.0*id/nbrecs));
-		
+			setFileProgress (framer.getProgress());
+		if (headersOnly ? !framer.nextMessageHeader() : !framer.nextMessage())
+			break;
 		id ++;
-        rec = new GribRecord(file, id);
-        assert(rec);
-        
+		goon = readGribMessage (framer, id, origin, headersOnly);
+    }
+	if (taskProgress->isCanceled())
+		ok = false;
+}
+//---------------------------------------------------------------------------------
+// Decode the current message of the framer and store the record.
+// Returns false if the message is not a valid GRIB1 record.
+//---------------------------------------------------------------------------------
+bool GribReader::readGribMessage (const GribFramer &framer, int id,
+								  bool origin, bool headersOnly)
+{
+    GribRecord *rec;
+    ZUFILE msgfile;
+	zu_init_memory (&msgfile, framer.getMessage(), 
+					framer.getMessageReadSize(), framer.getMessageOffset());
+	rec = new GribRecord(&msgfile, id, subset.isEmpty() ? NULL : &subset,
+						 !headersOnly);
+	assert(rec);
+	if (rec->isSkipped() || (rec->isOk() && !cropToSubset(rec))) {
+		delete rec;			// not in the subset
+		return true;
+	}
+	if (origin)
+		rec->setFileOrigin (fileName, framer.getMessageOffset(),
+							framer.getMessageSize());
+	
 		if (rec->isOk())
         {
         	if (rec->isDataKnown())
         	{
-				if (firstdate== -1)
-					firstdate = rec->getRecordCurrentDate();
 				//DBG("%d %d %d %d", rec->getDataType(),rec->getLevelType(), rec->getLevelValue(), rec->getRecordCurrentDate()); 
 				if (//-----------------------------------------
 					(rec->getDataType()==GRB_PRESSURE_MSL
@@ -359,14 +515,80 @@ void GribReader::readAllGribRecords (int nbrecs)
         }
         else {    // ! rec-isOk
             delete rec;
-            rec = NULL;
+            return false;
         }
-    } while (taskProgress->continueDownload && rec != NULL &&  !rec->isEof());
-	
-	if (! taskProgress->continueDownload)
-		ok = false;
+	return true;
 }
 
+//---------------------------------------------------------------------------------
+void GribReader::enableRecordCache ()
+{
+	std::map < std::string, std::vector<GribRecord *>* >::iterator it;
+	for (it=mapGribRecords.begin(); it!=mapGribRecords.end(); it++) {
+		std::vector<GribRecord *> *ls = (*it).second;
+		for (zuint i=0; i<ls->size(); i++)
+			GribRecordCache::registerRecord ((*ls)[i]);
+	}
+}
+//---------------------------------------------------------------------------------
+void GribReader::pinRecordsAroundDate (time_t date)
+{
+	// the current date and its neighbours stay in memory
+	std::set<time_t> dates;
+	dates.insert (date);
+	std::set<time_t>::iterator it = setAllDates.lower_bound (date);
+	if (it != setAllDates.end()) {
+		std::set<time_t>::iterator next = it;
+		if (*next == date)
+			next ++;
+		if (next != setAllDates.end())
+			dates.insert (*next);
+	}
+	if (it != setAllDates.begin()) {
+		it --;
+		dates.insert (*it);
+	}
+	// and, for each data, the records interpolated at this date
+	// (their dates may not be neighbours in setAllDates)
+	std::vector <GribRecord *> pinned;
+	std::map < std::string, std::vector<GribRecord *>* >::iterator itmap;
+	for (itmap=mapGribRecords.begin(); itmap!=mapGribRecords.end(); itmap++) {
+		std::vector<GribRecord *> *ls = (*itmap).second;
+		GribRecord *before = NULL;
+		GribRecord *after  = NULL;
+		bool atDate = false;
+		for (zuint i=0; i<ls->size(); i++) {
+			GribRecord *rec = (*ls)[i];
+			time_t t = rec->getRecordCurrentDate();
+			if (dates.count (t) > 0) {
+				pinned.push_back (rec);
+				atDate = atDate || t==date;
+			}
+			if (t < date) {
+				if (before==NULL || t > before->getRecordCurrentDate())
+					before = rec;
+			}
+			else if (t > date) {
+				if (after==NULL || t < after->getRecordCurrentDate())
+					after = rec;
+			}
+		}
+		if (! atDate && before != NULL)
+			pinned.push_back (before);
+		if (! atDate && after != NULL)
+			pinned.push_back (after);
+	}
+	GribRecordCache::pinRecords (this, pinned);
+}
+//---------------------------------------------------------------------------------
+bool GribReader::cropToSubset (GribRecord *rec)
+{
+	if (! subset.hasZone())
+		return true;
+	double x0,y0, x1,y1;
+	subset.getZone (&x0,&y0, &x1,&y1);
+	return rec->cropToZone (x0,y0, x1,y1);
+}
 //---------------------------------------------------------------------------------
 void  GribReader::copyFirstCumulativeRecord ()
 {
@@ -403,7 +625,8 @@ void  GribReader::removeFirstCumulativeRecord (DataCode dtc)
 			for (it=liste->begin(); it!=liste->end() && (*it)!=rec; it++)
 			{
 			}
-			if ((*it) == rec) {
+			if (it!=liste->end() && (*it) == rec) {
+				clean_time_interp_cache ();
 				liste->erase(it);
 			}
 		}
@@ -475,6 +698,7 @@ void  GribReader::copyMissingWaveRecords ()
 //---------------------------------------------------------------------------------
 void  GribReader::removeMissingWaveRecords ()
 {
+	clean_time_interp_cache ();
 	std::map < std::string, std::vector<GribRecord *>* >::iterator it;
 	std::vector<GribRecord *>::iterator itv;
 	for (it=mapGribRecords.begin(); it!=mapGribRecords.end(); it++) {
@@ -495,11 +719,103 @@ void  GribReader::removeMissingWaveRecords ()
 }
 
 //---------------------------------------------------------------------------------
-void GribReader::readGribFileContent (int nbrecs)
+void GribReader::beginStream (const std::string fname)
+{
+	fileName = fname;
+	fileSize = 0;
+	ok = false;
+	clean_all_vectors ();
+	setAllDataCenterModel.clear();
+	setAllDates.clear ();
+	setAllDataCode.clear ();
+	closeStream ();
+	stream = zu_stream_open ();
+	streamFramer = new GribFramer ();
+	assert (streamFramer);
+	streamBuffer.resize (ZU_BUFREADSIZE);
+	streamId = 0;
+	streamOk = (stream != NULL);
+}
+//---------------------------------------------------------------------------------
+bool GribReader::addStreamData (const char *data, long size)
+{
+	if (! streamOk)
+		return false;
+	fileSize += size;
+	if (zu_stream_write (stream, data, size) != 0) {
+		streamOk = false;
+		return false;
+	}
+	long nb;
+	while ((nb = zu_stream_read (stream, &streamBuffer[0], streamBuffer.size())) > 0)
+	{
+		streamFramer->addData (&streamBuffer[0], nb);
+		readStreamMessages ();
+		if (! streamOk)
+			return false;
+	}
+	if (nb < 0)
+		streamOk = false;
+	return streamOk;
+}
+//---------------------------------------------------------------------------------
+void GribReader::readStreamMessages ()
+{
+	// uncompressed data: same offsets as in the written file
+	bool origin = stream->type == ZU_COMPRESS_NONE;
+	while (streamOk && streamFramer->nextMessage ()) {
+		streamId ++;
+		streamOk = readGribMessage (*streamFramer, streamId, origin);
+	}
+}
+//---------------------------------------------------------------------------------
+bool GribReader::endStream ()
+{
+	if (streamOk) {
+		streamFramer->setEndOfData ();
+		readStreamMessages ();
+	}
+	if (streamOk && ok) {
+		createListDates ();
+		computeMissingData ();   // RH DewPoint ThetaE
+	}
+	else {
+		ok = false;
+	}
+	closeStream ();
+	return ok;
+}
+//---------------------------------------------------------------------------------
+void GribReader::renameFile (const std::string &fname)
+{
+	fileName = fname;
+	std::map < std::string, std::vector<GribRecord *>* >::iterator it;
+	for (it=mapGribRecords.begin(); it!=mapGribRecords.end(); it++) {
+		std::vector<GribRecord *> *ls = (*it).second;
+		for (zuint i=0; i<ls->size(); i++)
+			(*ls)[i]->setOriginFile (fname);
+	}
+}
+//---------------------------------------------------------------------------------
+void GribReader::closeStream ()
+{
+	zu_stream_close (stream);
+	stream = NULL;
+	if (streamFramer) {
+		delete streamFramer;
+		streamFramer = NULL;
+	}
+	std::vector <uint8_t>().swap (streamBuffer);
+	streamOk = false;
+}
+//---------------------------------------------------------------------------------
+void GribReader::readGribFileContent ()
 {
     fileSize = zu_filesize(file);
 	
-    readAllGribRecords (nbrecs);
+    readAllGribRecords ();
+	previewDone = true;
+	taskProgress->setMessage (LTASK_PREPARE_MAPS);
     createListDates ();
 	computeMissingData ();   // RH DewPoint ThetaE
 }
@@ -745,6 +1061,9 @@ double  GribReader::getDateInterpolatedValue (
 		GribRecord *rec;
 		if ( (rec = getRecord (dtc, date)) != NULL)
 			return rec->getInterpolatedValue (px, py);
+		// The list of dates gathers all the data types (and all the files
+		// of a dataset): this type may have no record at this date.
+		return get2DatesInterpolatedValue (dtc, px, py, date);
 	}
 	return GRIB_NOTDEF;
 }
@@ -753,9 +1072,95 @@ double  GribReader::getDateInterpolatedValue (
 double  GribReader::get2DatesInterpolatedValue (
 				DataCode dtc, double px, double py, time_t date)
 {
+	if (! isTimeInterpolable (dtc))
+		return GRIB_NOTDEF;
+	GribRecord *before, *after;
+	findGribsAroundDate (dtc, date, &before, &after);
+	if (before==NULL || after==NULL)
+		return GRIB_NOTDEF;
+	GribRecordTimeInterp rti (before, after, date);
+	return rti.getInterpolatedValue (px, py);
+}
+//---------------------------------------------------------------------------
+bool GribReader::isTimeInterpolable (const DataCode &dtc)
+{
+	switch (dtc.dataType) {
+		case GRB_PRESSURE :
+		case GRB_PRESSURE_MSL :
+		case GRB_GEOPOT_HGT :
+		case GRB_TEMP :
+		case GRB_TEMP_POT :
+		case GRB_DEWPOINT :
+		case GRB_PRV_THETA_E :
+		case GRB_WIND_VX :
+		case GRB_WIND_VY :
+		case GRB_CUR_VX :
+		case GRB_CUR_VY :
+		case GRB_HUMID_SPEC :
+		case GRB_HUMID_REL :
+		case GRB_SNOW_DEPTH :
+		case GRB_CIN :
+		case GRB_CAPE :
+			return true;
+		default :
+			return false;
+	}
+}
+//---------------------------------------------------------------------------
+GribRecord * GribReader::getRecordAtDate (DataCode dtc, time_t date)
+{
+	GribRecord *rec = getRecord (dtc, date);
+	if (rec==NULL && isTimeInterpolable (dtc)) {
+		QMutexLocker lock (&timeInterpMutex);
+		GribRecordTimeInterp *rti = findTimeInterpolatedRecord (dtc, date);
+		if (rti != NULL)
+			rec = rti->getBlendedRecord ();
+	}
+	return rec;
+}
+//---------------------------------------------------------------------------
+GribRecordTimeInterp * GribReader::getTimeInterpolatedRecord (
+				DataCode dtc, time_t date)
+{
+	if (! isTimeInterpolable (dtc))
+		return NULL;
+	QMutexLocker lock (&timeInterpMutex);
+	return findTimeInterpolatedRecord (dtc, date);
+}
+//---------------------------------------------------------------------------
+GribRecordTimeInterp * GribReader::findTimeInterpolatedRecord (
+				DataCode dtc, time_t date)
+{
+	std::pair<std::string,time_t> key (
+		GribRecord::makeKey (dtc.dataType,dtc.levelType,dtc.levelValue), date);
+	std::map < std::pair<std::string,time_t>,
+			   GribRecordTimeInterp * >::iterator it;
+	it = mapTimeInterpRecords.find (key);
+	if (it != mapTimeInterpRecords.end()) {
+		(*it).second->setLastUse (++ timeInterpUse);
+		return (*it).second;
+	}
 	GribRecord *before, *after;
 	findGribsAroundDate (dtc, date, &before, &after);
-	return get2GribsInterpolatedValueByDate (px, py, date, before, after);
+	if (before==NULL || after==NULL)
+		return NULL;
+	// the least recently used leaves the cache
+	if (mapTimeInterpRecords.size() >= TIME_INTERP_CACHE_SIZE) {
+		std::map < std::pair<std::string,time_t>,
+				   GribRecordTimeInterp * >::iterator itold;
+		itold = mapTimeInterpRecords.begin();
+		for (it=mapTimeInterpRecords.begin(); it!=mapTimeInterpRecords.end(); it++) {
+			if ((*it).second->getLastUse() < (*itold).second->getLastUse())
+				itold = it;
+		}
+		delete (*itold).second;
+		mapTimeInterpRecords.erase (itold);
+	}
+	GribRecordTimeInterp *rti = new GribRecordTimeInterp (before, after, date);
+	assert (rti);
+	rti->setLastUse (++ timeInterpUse);
+	mapTimeInterpRecords [key] = rti;
+	return rti;
 }
 //------------------------------------------------------------------
 void GribReader::findGribsAroundDate (DataCode dtc, time_t date,
@@ -765,49 +1170,30 @@ void GribReader::findGribsAroundDate (DataCode dtc, time_t date,
 	std::vector<GribRecord *> *ls = getListOfGribRecords (dtc);
 	*before = NULL;
 	*after  = NULL;
+	if (ls == NULL)
+		return;
 	zuint nb = ls->size();
-	for (zuint i=0; i<nb && *before==NULL && *after==NULL; i++)
+	for (zuint i=0; i<nb; i++)
 	{
 		GribRecord *rec = (*ls)[i];
-		if (rec->getRecordCurrentDate() == date) {
-			*before = rec;
-			*after = rec;
-		}
-		else if (rec->getRecordCurrentDate() < date) {
+		time_t t = rec->getRecordCurrentDate();
+		if (t == date) {
 			*before = rec;
-		}
-		else if (rec->getRecordCurrentDate() > date  &&  *before != NULL) {
 			*after = rec;
+			GribRecordCache::touch (rec);
+			return;
 		}
-	}
-}
-//------------------------------------------------------------------
-double 	GribReader::get2GribsInterpolatedValueByDate (
-				double px, double py, time_t date,
-				GribRecord *before, GribRecord *after)
-{
-	double val = GRIB_NOTDEF;
-	if (before!=NULL && after!=NULL) {
-		if (before == after) {
-			val = before->getInterpolatedValue(px, py);
+		else if (t < date) {
+			if (*before==NULL || t > (*before)->getRecordCurrentDate())
+				*before = rec;
 		}
 		else {
-			time_t t1 = before->getRecordCurrentDate();
-			time_t t2 = after->getRecordCurrentDate();
-			if (t1 == t2) {
-				val = before->getInterpolatedValue(px, py);
-			}
-			else {
-				double v1 = before->getInterpolatedValue(px, py);
-				double v2 = after->getInterpolatedValue(px, py);
-				if (v1!=GRIB_NOTDEF && v2!=GRIB_NOTDEF) {
-					double k  = fabs( (double)(date-t1)/(t2-t1) );
-					val = (1.0-k)*v1 + k*v2;
-				}
-			}
+			if (*after==NULL || t < (*after)->getRecordCurrentDate())
+				*after = rec;
 		}
 	}
-	return val;
+	GribRecordCache::touch (*before);
+	GribRecordCache::touch (*after);
 }
 
 //---------------------------------------------------
@@ -865,6 +1251,7 @@ GribRecord * GribReader::getRecord (DataCode dtc, time_t date)
 			}
         }
     }
+	GribRecordCache::touch (res);
     return res;
 }
 
@@ -887,7 +1274,7 @@ void GribReader::createListDates()
 //-------------------------------------------------------------------------------
 // Lecture complète d'un fichier GRIB
 //-------------------------------------------------------------------------------
-void GribReader::openFilePriv (const std::string fname, int nbrecs)
+void GribReader::openFilePriv (const std::string fname)
 {
 //     debug("Open file: %s", fname.c_str());
     fileName = fname;
@@ -904,88 +1291,9 @@ void GribReader::openFilePriv (const std::string fname, int nbrecs)
     
 	taskProgress->setMessage (LTASK_OPEN_FILE);
 	taskProgress->setValue (0);
-    if (nbrecs > 0) {
-		taskProgress->setMessage (LTASK_PREPARE_MAPS);
-		taskProgress->setValue (0);
-		readGribFileContent (nbrecs);
-	}
-	else {
-		ok = false;
-	}
+	readGribFileContent ();
 	zu_close (file);
 }
-//-------------------------------------------------------------------------------
-// int GribReader::countGribRecords (ZUFILE *f, LongTaskProgress *taskProgress)
-// {
-// 	long fsize = zu_filesize(f);
-// 	long i=0;
-// 	int nb=0, j=0;
-// 	char c;
-// 	// count 'GRIB' patterns
-// 	zu_rewind (f);
-// 	while (taskProgress->continueDownload &&  zu_read (f, &c, 1) == 1) {
-// 		i ++;
-// 		if (i%1000 == 1)
-// 			taskProgress->setValue ((int)(100.0*i/fsize));
-// 		
-// 		if (nb==0 && i>4) {
-// 			break;	// not a grib file
-// 		}
-// 		
-// 		if (  (j==0 && c=='G')
-// 			||(j==1 && c=='R')
-// 			||(j==2 && c=='I')
-// 			||(j==3 && c=='B') )
-// 			j ++;
-// 		else
-// 			j = 0;
-// 		if (j == 4) {
-// 			nb ++;
-// 			j = 0;
-// 		}
-// 	}
-// 	if (! taskProgress->continueDownload)
-// 		nb = 0;
-// 	zu_rewind (f);
-// 	return nb;
-// }
-//-------------------------------------------------------------------------------
-int GribReader::countGribRecords (ZUFILE *f, LongTaskProgress *taskProgress)
-{
-	//qint64 fsize = zu_filesize(f);
-	qint64 i=0;
-	qint64 nb=0, j=0;
-	char c;
-	// count 'GRIB' patterns
-	const int sizebuf = 300000;
-	int nblus;
-	char buf[sizebuf];
-	zu_rewind (f);
-	while (taskProgress->continueDownload && (nblus=zu_read(f,buf,sizebuf))>0) {
-		for (i=0; i<nblus; i++) {
-			c = buf[i];
-			if (  (j==0 && c=='G')
-				||(j==1 && c=='R')
-				||(j==2 && c=='I')
-				||(j==3 && c=='B') ) {
-				j ++;
-			}
-			else if (j == 4) {
-				nb ++;
-				j = 0;
-			}
-			else {
-				j = 0;
-			}
-		}
-	}
-	if (! taskProgress->continueDownload)
-		nb = 0;
-	zu_rewind (f);
-	return nb;
-}
-
-
 //---------------------------------------------------------------------------------
 time_t  GribReader::getRefDateForData (const DataCode &dtc)
 {
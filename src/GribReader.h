@@ -24,10 +24,16 @@ Lecture mise en mémoire d'un fichier GRIB
 #ifndef GRIBREADER_H
 #define GRIBREADER_H
 
+#include <QMutex>
+
 #include "RegularGridded.h"
 #include "GribRecord.h"
+#include "GribFramer.h"
+#include "GribSubset.h"
 #include "zuFile.h"
 
+#define TIME_INTERP_CACHE_SIZE  16	// blended records in cache
+
 //===============================================================
 class GribReader : public RegularGridReader
 {
@@ -36,7 +42,14 @@ class GribReader : public RegularGridReader
         ~GribReader ();
 		
         virtual void  openFile (const std::string fname,
-						LongTaskProgress *taskProgress, int nbrecs);
+						LongTaskProgress *taskProgress);
+		
+		// Several files read as one dataset: records of all the files
+		// are merged (a file by date, or by data...).
+		// Only the headers of the messages of uncompressed files are
+		// read, values are decoded from their file on first use.
+		virtual void  openFiles (const std::vector<std::string> &fnames,
+						LongTaskProgress *taskProgress);
 		
 		virtual FileDataType getReaderFileDataType () 
 					{return DATATYPE_GRIB;};
@@ -58,13 +71,31 @@ class GribReader : public RegularGridReader
 		
 		std::vector<GribRecord *> * getListOfGribRecords (DataCode dtc);
         
-		// Value at a point for an existing date
+		// Value at a point for a date (between the 2 records around it
+		// when this data type has no record at this date)
         virtual double getDateInterpolatedValue (
 							DataCode dtc, double px, double py, time_t date);
         
-		// Value at a point for a date between 2 existing dates
+		// Value at a point for a date between 2 existing dates,
+		// interpolated from the 2 records (instantaneous data only)
         double  get2DatesInterpolatedValue (
 							DataCode dtc, double px, double py, time_t date);
+		
+		// Record to draw: record of the date, or record blended
+		// between the 2 records around it (instantaneous data only).
+		// A blended record stays valid until the next call for an other
+		// date: it must be drawn under Terrain::lockData.
+		virtual GribRecord *getRecordAtDate (DataCode dtc, time_t date);
+		
+		// Virtual record between the 2 records around date (NULL if none
+		// or if the data can't be interpolated in time).
+		// The last TIME_INTERP_CACHE_SIZE ones are kept in cache.
+		GribRecordTimeInterp *getTimeInterpolatedRecord (
+							DataCode dtc, time_t date);
+		
+		// Instantaneous data: values of a period (cumulated, min/max,
+		// averaged), categories and wave data aren't interpolated in time.
+		static bool isTimeInterpolable (const DataCode &dtc);
 
 		int	   getDewpointDataStatus (int levelType,int levelValue);
 
@@ -87,15 +118,51 @@ class GribReader : public RegularGridReader
 		virtual bool hasAltitudeData () const  {return hasAltitude;}
 		bool    hasAmbiguousHeader ()  {return ambiguousHeader;}
 		
-		static int countGribRecords (ZUFILE *f, LongTaskProgress *taskProgress);
+		// Values of the records may be released (GribRecordCache)
+		void  enableRecordCache ();
+		// Current date changed: the records of the date and of its
+		// neighbours, and the records around it for each data (time
+		// interpolation), are kept by GribRecordCache::trim
+		void  pinRecordsAroundDate (time_t date);
+		
+		// Load only a part of the file (zone, data, dates), before openFile
+		void  setSubset (const GribSubset &subset)
+						{ this->subset = subset; }
+		const GribSubset & getSubset () const   {return subset;}
+		bool  isDataCodeWanted (const DataCode &dtc) const
+						{ return subset.isDataWanted (dtc); }
+
+		// Reading while the file is downloaded: the data (compressed
+		// or not) are given by pieces and each record is decoded
+		// as soon as its message is complete.
+		void  beginStream (const std::string fname);
+		bool  addStreamData (const char *data, long size); // false on error
+		bool  endStream ();			// true if the file is ok
+		// The file was renamed: name of the reader and of the file
+		// from which released values are decoded again
+		void  renameFile (const std::string &fname);
 
 	protected:
         ZUFILE *file;
 		LongTaskProgress *taskProgress;
+		GribSubset subset;
+		// Crops the grid to the zone of the subset (false if outside)
+		bool  cropToSubset (GribRecord *rec);
+		// Reads the records of file, one of the files of a dataset
+		virtual void readDatasetFile ();
+		int   datasetIndex, datasetSize;	// file being read
+		void  setFileProgress (double fraction);	// of the current file
         void clean_vector(std::vector<GribRecord *> &ls);
         void clean_all_vectors();
+        void clean_time_interp_cache();
         void   createListDates ();
         void storeRecordInMap (GribRecord *rec);
+        // Records of the first date given to taskProgress
+        // as soon as a record of an other date is read
+		bool   previewDone;
+		time_t previewDate;
+		void   checkPreview (time_t date);
+		GribReader * createPreview (time_t date);
         //void removeRecordInMap (GribRecord *rec);
 		void computeMissingData ();   // RH DewPoint ThetaE
 		
@@ -107,20 +174,34 @@ class GribReader : public RegularGridReader
 		
         std::map < std::string,
         		   std::vector<GribRecord *>* >  mapGribRecords;
-
-        void   openFilePriv (const std::string fname, int nbrecs);
-		void   readGribFileContent (int nbrecs);
-		void   readAllGribRecords  (int nbrecs);
+        std::map < std::pair<std::string,time_t>,
+        		   GribRecordTimeInterp * >  mapTimeInterpRecords;
+        QMutex timeInterpMutex;		// mapTimeInterpRecords, timeInterpUse
+        int    timeInterpUse;
+        GribRecordTimeInterp *findTimeInterpolatedRecord (
+							DataCode dtc, time_t date);	// mutex locked
+
+        void   openFilePriv (const std::string fname);
+		void   readGribFileContent ();
+		// headersOnly: the values are not decoded (uncompressed file)
+		void   readAllGribRecords  (bool headersOnly=false);
+		// origin: keep the position of the message (uncompressed file)
+		bool   readGribMessage (const GribFramer &framer, int id,
+								bool origin=false, bool headersOnly=false);
+		
+		ZUSTREAM   *stream;
+		GribFramer *streamFramer;
+		std::vector <uint8_t> streamBuffer;
+		int    streamId;
+		bool   streamOk;
+		void   readStreamMessages ();
+		void   closeStream ();
         
         std::vector<GribRecord *> * getFirstNonEmptyList();
 		
 		double   computeDewPoint (double lon, double lat, time_t date);
 		double   computeHumidRel (double lon, double lat, time_t date);
 
-		// Interpolation entre 2 GribRecord
-		double 	get2GribsInterpolatedValueByDate (
-									double px, double py, time_t date,
-									GribRecord *before, GribRecord *after);
 		// Détermine les GribRecord qui encadrent une date
 		void 	findGribsAroundDate (DataCode dtc, time_t date,
 									GribRecord **before, GribRecord **after);
@@ -17,8 +17,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include <time.h>
+#include <algorithm>
+#include <vector>
+
+#include <QMutex>
 
 #include "GribRecord.h"
+#include "GribSubset.h"
+#include "GribRecordCache.h"
+
+static QMutex GLOB_reloadMutex;		// values decoded again
+static QMutex GLOB_dataRefsMutex;	// first alias of a record
 
 //-------------------------------------------------------------------------------
 // Adjust data type from different meteo center
@@ -330,21 +339,32 @@ fprintf(stderr,"hasBMS=%d isScanIpositive=%d isScanJpositive=%d isAdjacentI=%d\n
 GribRecord::GribRecord ()
 {
 	ok = false;
+	skipped = false;
 	data = NULL;
 	BMSbits = NULL;
 	boolBMStab = NULL;
+	nbDataRefs = NULL;
+	originOffset = originSize = 0;
+	originField = 0;
+	cached = false;
 }
 
 //-------------------------------------------------------------------------------
 // Lecture depuis un fichier
 //-------------------------------------------------------------------------------
-GribRecord::GribRecord (ZUFILE* file, int id_)
+GribRecord::GribRecord (ZUFILE* file, int id_, const GribSubset *subset,
+						bool withValues)
 {
     id = id_;
+	skipped = false;
     seekStart = zu_tell(file);
     data    = NULL;
     BMSbits = NULL;
 	boolBMStab = NULL;
+	nbDataRefs = NULL;
+	originOffset = originSize = 0;
+	originField = 0;
+	cached = false;
     eof     = false;
 	knownData = true;
 	editionNumber = 0;
@@ -362,15 +382,23 @@ GribRecord::GribRecord (ZUFILE* file, int id_)
         ok = readGribSection2_GDS (file);
         zu_seek(file, fileOffset2+sectionSize2, SEEK_SET);
     }
-    if (ok) {
+    if (ok && subset!=NULL && !isInSubset(subset)) {
+		skipped = true;		// the data are not decoded
+		ok = false;
+		return;
+    }
+    if (ok && !withValues) {
+		released.storeRelease (1);	// decoded by needData
+    }
+    if (ok && withValues) {
         ok = readGribSection3_BMS (file);
         zu_seek(file, fileOffset3+sectionSize3, SEEK_SET);
     }
-    if (ok) {
+    if (ok && withValues) {
         ok = readGribSection4_BDS (file);
         zu_seek(file, fileOffset4+sectionSize4, SEEK_SET);
     }
-    if (ok) {
+    if (ok && withValues) {
         ok = readGribSection5_ES (file);
     }
     
@@ -378,7 +406,7 @@ GribRecord::GribRecord (ZUFILE* file, int id_)
 //        zu_seek (file, seekStart+totalSize, SEEK_SET);
     }
 	
-	if (ok && hasBMS) { // replace the BMS bits table with a faster bool table
+	if (ok && hasBMS && withValues) { // replace the BMS bits table with a faster bool table
         boolBMStab = new bool [Ni*Nj];
 		assert (boolBMStab);
 		for (int i=0; i<Ni; i++) {
@@ -406,55 +434,386 @@ GribRecord::GribRecord (ZUFILE* file, int id_)
 // Constructeur de recopie
 //-------------------------------------------------------------------------------
 GribRecord::GribRecord (const GribRecord &rec)
-	: RegularGridRecord ()
+	: RegularGridRecord (rec)
 {
-    *this = rec;
+	rec.needData ();
+	id = rec.id;
+	ok = rec.ok;
+	skipped = rec.skipped;
+	knownData = rec.knownData;
+	waveData = rec.waveData;
+	eof = rec.eof;
+	dataKey = rec.dataKey;
+	memcpy (strRefDate, rec.strRefDate, sizeof(strRefDate));
+	memcpy (strCurDate, rec.strCurDate, sizeof(strCurDate));
+	// SECTION 0
+	fileOffset0 = rec.fileOffset0;
+	seekStart = rec.seekStart;
+	totalSize = rec.totalSize;
+	editionNumber = rec.editionNumber;
+	// SECTION 1
+	fileOffset1 = rec.fileOffset1;
+	sectionSize1 = rec.sectionSize1;
+	tableVersion = rec.tableVersion;
+	memcpy (data1, rec.data1, sizeof(data1));
+	idCenter = rec.idCenter;
+	idModel = rec.idModel;
+	idGrid = rec.idGrid;
+	dataType = rec.dataType;
+	levelType = rec.levelType;
+	levelValue = rec.levelValue;
+	hasGDS = rec.hasGDS;
+	hasBMS = rec.hasBMS;
+	refyear = rec.refyear;
+	refmonth = rec.refmonth;
+	refday = rec.refday;
+	refhour = rec.refhour;
+	refminute = rec.refminute;
+	periodP1 = rec.periodP1;
+	periodP2 = rec.periodP2;
+	timeRange = rec.timeRange;
+	periodsec = rec.periodsec;
+	refDate = rec.refDate;
+	curDate = rec.curDate;
+	decimalFactorD = rec.decimalFactorD;
+	// SECTION 2
+	fileOffset2 = rec.fileOffset2;
+	sectionSize2 = rec.sectionSize2;
+	NV = rec.NV;
+	PV = rec.PV;
+	gridType = rec.gridType;
+	Ni = rec.Ni;
+	Nj = rec.Nj;
+	Di = rec.Di;
+	Dj = rec.Dj;
+	resolFlags = rec.resolFlags;
+	scanFlags = rec.scanFlags;
+	hasDiDj = rec.hasDiDj;
+	isEarthSpheric = rec.isEarthSpheric;
+	isUeastVnorth = rec.isUeastVnorth;
+	isScanIpositive = rec.isScanIpositive;
+	isScanJpositive = rec.isScanJpositive;
+	isAdjacentI = rec.isAdjacentI;
+	// SECTION 3
+	fileOffset3 = rec.fileOffset3;
+	sectionSize3 = rec.sectionSize3;
+	// SECTION 4
+	fileOffset4 = rec.fileOffset4;
+	sectionSize4 = rec.sectionSize4;
+	unusedBitsEndBDS = rec.unusedBitsEndBDS;
+	isGridData = rec.isGridData;
+	isSimplePacking = rec.isSimplePacking;
+	isFloatValues = rec.isFloatValues;
+	hasAdditionalFlags = rec.hasAdditionalFlags;
+	scaleFactorE = rec.scaleFactorE;
+	scaleFactorEpow2 = rec.scaleFactorEpow2;
+	refValue = rec.refValue;
+	nbBitsInPack = rec.nbBitsInPack;
+	
+	savXmin = rec.savXmin;
+	savXmax = rec.savXmax;
+	savYmin = rec.savYmin;
+	savYmax = rec.savYmax;
+	savDi = rec.savDi;
+	savDj = rec.savDj;
+	verticalOrientationIsAmbiguous = rec.verticalOrientationIsAmbiguous;
+	
 	setDuplicated (true);
-    // recopie les champs de bits
-    if (rec.data != NULL) {
-        int size = rec.Ni*rec.Nj;
-        this->data = new double[size];
-		assert (this->data);
+	// the copy is a new record (may be modified), not in the cache
+	originOffset = originSize = 0;
+	originField = 0;
+	cached = false;
+	// share the grid values (already oriented) with rec
+	data = rec.data;
+	BMSbits = rec.BMSbits;
+	boolBMStab = rec.boolBMStab;
+	nbDataRefs = NULL;
+	if (data != NULL) {
+		QMutexLocker lock (&GLOB_dataRefsMutex);
+		if (rec.nbDataRefs == NULL)
+			rec.nbDataRefs = new QAtomicInt (1);
+		nbDataRefs = rec.nbDataRefs;
+		nbDataRefs->ref ();
+	}
+}
+//-------------------------------------------------------------------------------
+void GribRecord::detachData ()
+{
+	needData ();
+	if (! isDataShared())
+		return;
+	int size = Ni*Nj;
+	double *oldData = data;
+	zuchar *oldBMSbits = BMSbits;
+	bool   *oldBoolBMStab = boolBMStab;
+    if (data != NULL) {
+        double *tmp = new double[size];
+		assert (tmp);
         for (int i=0; i<size; i++)
-            this->data[i] = rec.data[i];
+            tmp[i] = data[i];
+		data = tmp;
     }
-    if (rec.BMSbits != NULL) {
-        int size = rec.sectionSize3-6;
-        this->BMSbits = new zuchar[size];
-		assert (this->BMSbits);
-        for (int i=0; i<size; i++)
-            this->BMSbits[i] = rec.BMSbits[i];
+    if (BMSbits != NULL) {
+        int sizebms = sectionSize3-6;
+        zuchar *tmp = new zuchar[sizebms];
+		assert (tmp);
+        for (int i=0; i<sizebms; i++)
+            tmp[i] = BMSbits[i];
+		BMSbits = tmp;
     }
-    if (rec.boolBMStab != NULL) {
-        int size = rec.Ni*rec.Nj;
-        this->boolBMStab = new bool[size];
-		assert (this->boolBMStab);
+    if (boolBMStab != NULL) {
+        bool *tmp = new bool[size];
+		assert (tmp);
         for (int i=0; i<size; i++)
-            this->boolBMStab[i] = rec.boolBMStab[i];
+            tmp[i] = boolBMStab[i];
+		boolBMStab = tmp;
     }
-	checkOrientation ();
+	// the other records may have been deleted in the meantime
+	if (! nbDataRefs->deref()) {
+		delete [] oldData;
+		delete [] oldBMSbits;
+		delete [] oldBoolBMStab;
+		delete nbDataRefs;
+	}
+	nbDataRefs = NULL;
 }
-//--------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
+void GribRecord::releaseData ()
+{
+	// shared values are deleted by the last record using them
+	bool lastRef = (nbDataRefs == NULL || ! nbDataRefs->deref());
+	if (lastRef) {
+		if (data) {
+			delete [] data;
+		}
+		if (BMSbits) {
+			delete [] BMSbits;
+		}
+		if (boolBMStab) {
+			delete [] boolBMStab;
+		}
+		if (nbDataRefs) {
+			delete nbDataRefs;
+		}
+	}
+	data = NULL;
+	BMSbits = NULL;
+	boolBMStab = NULL;
+	nbDataRefs = NULL;
+}
+//-------------------------------------------------------------------------------
 GribRecord::~GribRecord()
 {
-    if (data) {
-        delete [] data;
-        data = NULL;
-    }
-    if (BMSbits) {
-        delete [] BMSbits;
-        BMSbits = NULL;
-    }
-	if (boolBMStab) {
-        delete [] boolBMStab;
-        boolBMStab = NULL;
-    }
+	if (cached)
+		GribRecordCache::unregisterRecord (this);
+	releaseData ();
+}
+//------------------------------------------------------------------------------
+void GribRecord::setFileOrigin (const std::string &fname,
+								long offset, long size, int field)
+{
+	originFile = fname;
+	originOffset = offset;
+	originSize = size;
+	originField = field;
+}
+//------------------------------------------------------------------------------
+long GribRecord::getDataMemorySize () const
+{
+	return (long)Ni*Nj * (sizeof(double) + (boolBMStab ? sizeof(bool) : 0));
+}
+//------------------------------------------------------------------------------
+bool GribRecord::releaseValues ()
+{
+	if (!ok || !hasFileOrigin() || data==NULL || isDataShared())
+		return false;
+	releaseData ();
+	released.storeRelease (1);
+	releasePyramids ();		// users keep their references
+	return true;
+}
+//------------------------------------------------------------------------------
+GribRecord * GribRecord::decodeMessage (const uint8_t *msg, long size) const
+{
+	ZUFILE msgfile;
+	zu_init_memory (&msgfile, msg, size, originOffset);
+	return new GribRecord (&msgfile, id);
+}
+//------------------------------------------------------------------------------
+// The message is decoded again (same corrections) and cropped as this record
+//------------------------------------------------------------------------------
+void GribRecord::reloadData ()
+{
+	if (released.loadAcquire() == 0)
+		return;
+	// The file is read and decoded without lock: 2 threads may decode
+	// the same record at the same time, the first one installs its values.
+	GribRecord *rec = NULL;
+	std::vector <uint8_t> msg (originSize);
+	ZUFILE *file = zu_open (originFile.c_str(), "rb", ZU_COMPRESS_NONE);
+	if (file != NULL) {
+		if (zu_seek (file, originOffset, SEEK_SET) == 0
+				&& zu_read (file, &msg[0], originSize) == originSize) {
+			rec = decodeMessage (&msg[0], originSize);
+		}
+		zu_close (file);
+	}
+	if (rec!=NULL && rec->ok && rec->data!=NULL) {
+		int i0 = (int) floor ((xmin-rec->xmin)/Di + 0.5);
+		int j0 = (int) floor ((ymin-rec->ymin)/Dj + 0.5);
+		if (i0>=0 && j0>=0 && i0+Ni<=rec->Ni && j0+Nj<=rec->Nj)
+			rec->cropGrid (i0, j0, i0+Ni-1, j0+Nj-1);
+	}
 	
+	QMutexLocker lock (&GLOB_reloadMutex);
+	if (released.loadAcquire() == 0) {
+		if (rec != NULL)
+			delete rec;
+		return;				// done by an other thread
+	}
+	GribRecordCache::countMiss ();
+	if (rec!=NULL && rec->ok && rec->data!=NULL
+			&& rec->Ni==Ni && rec->Nj==Nj && (rec->boolBMStab!=NULL)==hasBMS)
+	{
+		data = rec->data;
+		boolBMStab = rec->boolBMStab;
+		rec->data = NULL;
+		rec->boolBMStab = NULL;
+	}
+	if (rec != NULL)
+		delete rec;
+	if (data == NULL) {
+		erreur ("Record %d: can't decode again %s", id, originFile.c_str());
+		originSize = 0;		// keep the missing values
+		data = new double [Ni*Nj];
+		assert (data);
+		for (int k=0; k<Ni*Nj; k++)
+			data[k] = GRIB_NOTDEF;
+		if (hasBMS) {
+			boolBMStab = new bool [Ni*Nj];
+			assert (boolBMStab);
+			for (int k=0; k<Ni*Nj; k++)
+				boolBMStab[k] = false;
+		}
+	}
+	released.storeRelease (0);
+}
+//------------------------------------------------------------------------------
+// Date and data code of the record (the header is already read)
+//------------------------------------------------------------------------------
+bool GribRecord::isInSubset (const GribSubset *subset)
+{
+	if (! subset->isDateWanted (curDate))
+		return false;
+	if (! subset->hasDataCodes ())
+		return true;
+	// data code after the corrections of translateDataType
+	// (no data yet: values are not modified)
+	int savDataType = dataType;
+	int savLevelType = levelType;
+	int savLevelValue = levelValue;
+	translateDataType ();
+	DataCode dtc = getDataCode ();
+	dataType = savDataType;
+	levelType = savLevelType;
+	levelValue = savLevelValue;
+	knownData = true;
+	waveData = false;
+	dataCenterModel = OTHER_DATA_CENTER;
+	return subset->isDataWanted (dtc);
+}
+//------------------------------------------------------------------------------
+bool GribRecord::cropToZone (double x0, double y0, double x1, double y1)
+{
+	if (!ok || (data==NULL && released.loadAcquire()==0))
+		return false;
+	// rows
+	int j0 = std::max ((int) floor ((y0-ymin)/Dj) - 1, 0);
+	int j1 = std::min ((int) ceil  ((y1-ymin)/Dj) + 1, Nj-1);
+	if (j1 <= j0)
+		return false;
+	// columns: the zone is shifted by 360° if needed
+	int i0 = 0;
+	int i1 = Ni-1;
+	double best = -1e300;
+	double shift = 0;
+	for (int k=-1; k<=1; k++) {
+		double overlap = std::min (x1+k*360.0, xmax) - std::max (x0+k*360.0, xmin);
+		if (overlap > best) {
+			best = overlap;
+			shift = k*360.0;
+		}
+	}
+	x0 += shift;
+	x1 += shift;
+	if (! entireWorldInLongitude) {
+		if (best < 0)
+			return false;
+		i0 = std::max ((int) floor ((x0-xmin)/Di) - 1, 0);
+		i1 = std::min ((int) ceil  ((x1-xmin)/Di) + 1, Ni-1);
+	}
+	else if (x0-Di >= xmin && x1+Di <= xmax) {
+		i0 = std::max ((int) floor ((x0-xmin)/Di) - 1, 0);
+		i1 = std::min ((int) ceil  ((x1-xmin)/Di) + 1, Ni-1);
+	}
+	// else: the zone is across the limit of the grid, all columns are kept
+	if (i1 <= i0)
+		return false;
+	if (i0==0 && i1==Ni-1 && j0==0 && j1==Nj-1)
+		return true;
+	
+	cropGrid (i0, j0, i1, j1);
+	return true;
+}
+//------------------------------------------------------------------------------
+void GribRecord::cropGrid (int i0, int j0, int i1, int j1)
+{
+	int ni = i1-i0+1;
+	int nj = j1-j0+1;
+	if (released.loadAcquire() != 0) {
+		// values not in memory: reloadData crops them as the grid
+		xmin = xmin + i0*Di;
+		ymin = ymin + j0*Dj;
+		Ni = ni;
+		Nj = nj;
+		xmax = xmin + (Ni-1)*Di;
+		ymax = ymin + (Nj-1)*Dj;
+		entireWorldInLongitude = (fabs(xmax-xmin)>=360.0)||(fabs(xmax-360.0+Di-xmin) < fabs(Di/20));
+		return;
+	}
+	double *newData = new double [ni*nj];
+	assert (newData);
+	bool *newBMStab = NULL;
+	if (boolBMStab != NULL) {
+		newBMStab = new bool [ni*nj];
+		assert (newBMStab);
+	}
+	for (int j=0; j<nj; j++) {
+		for (int i=0; i<ni; i++) {
+			newData [j*ni+i] = data [(j+j0)*Ni+i+i0];
+			if (newBMStab)
+				newBMStab [j*ni+i] = boolBMStab [(j+j0)*Ni+i+i0];
+		}
+	}
+	releaseData ();			// BMSbits are not used any more
+	data = newData;
+	boolBMStab = newBMStab;
+	xmin = xmin + i0*Di;
+	ymin = ymin + j0*Dj;
+	Ni = ni;
+	Nj = nj;
+	xmax = xmin + (Ni-1)*Di;
+	ymax = ymin + (Nj-1)*Dj;
+	entireWorldInLongitude = (fabs(xmax-xmin)>=360.0)||(fabs(xmax-360.0+Di-xmin) < fabs(Di/20));
+	dataChanged ();
 }
 //------------------------------------------------------------------------------
 void  GribRecord::checkOrientation ()
 {
-	if (!ok || !data || ymin==ymax
+	// values not read yet: only the grid is checked (the values will
+	// be decoded again with the same corrections)
+	bool missingValues = !data && released.loadAcquire()==0;
+	if (!ok || missingValues || ymin==ymax
 		|| Ni<=1 || Nj<=1
 	) {
 		ok = false;
@@ -500,6 +859,10 @@ void GribRecord::reverseData (char orientation) // orientation = 'H' or 'V'
 	int i, j, i1, j1, i2, j2;
 	double v;
 	bool b;
+	if (released.loadAcquire() != 0)
+		return;				// values not in memory, decoded later
+	detachData ();
+	dataChanged ();
 	if (orientation == 'H') 
 	{
 		for (j=0; j<Nj; j++) {
@@ -557,6 +920,10 @@ std::string GribRecord::makeKey(int dataType,int levelType,int levelValue)
 //-------------------------------------------------------------------------------
 void  GribRecord::multiplyAllData(double k)
 {
+	if (!data)
+		return;
+	detachData ();
+	dataChanged ();
 	for (int j=0; j<Nj; j++) {
 		for (int i=0; i<Ni; i++)
 		{
@@ -1267,8 +1634,116 @@ double  GribRecord::getInterpolatedValue (
 	else
 		return getInterpolatedValueUsingRegularGrid (dtc,px,py,interpolate);
 }
+//--------------------------------------------------------------------------
+bool  GribRecord::hasSameGrid (const GribRecord &rec) const
+{
+	return ok && rec.ok
+			&& Ni==rec.Ni && Nj==rec.Nj
+			&& xmin==rec.xmin && ymin==rec.ymin
+			&& Di==rec.Di && Dj==rec.Dj;
+}
+//--------------------------------------------------------------------------
+bool  GribRecord::setBlendedData (const GribRecord &rec1, const GribRecord &rec2,
+								  double k)
+{
+	needData ();
+	rec1.needData ();
+	rec2.needData ();
+	if (!data || !hasSameGrid(rec1) || !hasSameGrid(rec2))
+		return false;
+	detachData ();
+	dataChanged ();
+	int size = Ni*Nj;
+	for (int ind=0; ind<size; ind++)
+	{
+		bool h1 = !rec1.hasBMS || rec1.boolBMStab[ind];
+		bool h2 = !rec2.hasBMS || rec2.boolBMStab[ind];
+		double v1 = rec1.data[ind];
+		double v2 = rec2.data[ind];
+		if (h1 && h2 && v1!=GRIB_NOTDEF && v2!=GRIB_NOTDEF) {
+			data[ind] = (1.0-k)*v1 + k*v2;
+			if (boolBMStab)
+				boolBMStab[ind] = true;
+		}
+		else {
+			data[ind] = GRIB_NOTDEF;
+			if (!boolBMStab) {
+				boolBMStab = new bool [size];
+				assert (boolBMStab);
+				for (int i=0; i<size; i++)
+					boolBMStab[i] = true;
+				hasBMS = true;
+			}
+			boolBMStab[ind] = false;
+		}
+	}
+	return true;
+}
 
-
-
-
+//==========================================================================
+// GribRecordTimeInterp
+//==========================================================================
+GribRecordTimeInterp::GribRecordTimeInterp
+					(GribRecord *before, GribRecord *after, time_t date)
+{
+	this->before = before;
+	this->after  = after;
+	this->date   = date;
+	blended = NULL;
+	blendedDone = false;
+	lastUse = 0;
+	time_t t1 = before->getRecordCurrentDate();
+	time_t t2 = after->getRecordCurrentDate();
+	if (t1 == t2)
+		k = 0;
+	else
+		k = fabs( (double)(date-t1)/(t2-t1) );
+}
+//--------------------------------------------------------------------------
+GribRecordTimeInterp::~GribRecordTimeInterp ()
+{
+	if (blended) {
+		delete blended;
+		blended = NULL;
+	}
+}
+//--------------------------------------------------------------------------
+GribRecord * GribRecordTimeInterp::getBlendedRecord ()
+{
+	if (before == after || k == 0)
+		return before;
+	if (k == 1)
+		return after;
+	if (! blendedDone)
+	{
+		blendedDone = true;
+		if (before->hasSameGrid (*after)) {
+			blended = new GribRecord (*before);
+			assert (blended);
+			if (blended->setBlendedData (*before, *after, k)) {
+				blended->setRecordCurrentDate (date);
+			}
+			else {
+				delete blended;
+				blended = NULL;
+			}
+		}
+	}
+	return blended;
+}
+//--------------------------------------------------------------------------
+double GribRecordTimeInterp::getInterpolatedValue (
+						double px, double py, bool interpolate) const
+{
+	if (before == after || k == 0)
+		return before->getInterpolatedValue (px, py, interpolate);
+	if (k == 1)
+		return after->getInterpolatedValue (px, py, interpolate);
+	// no blended grid for a single point
+	double v1 = before->getInterpolatedValue (px, py, interpolate);
+	double v2 = after->getInterpolatedValue (px, py, interpolate);
+	if (v1!=GRIB_NOTDEF && v2!=GRIB_NOTDEF)
+		return (1.0-k)*v1 + k*v2;
+	return GRIB_NOTDEF;
+}
 
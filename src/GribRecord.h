@@ -23,9 +23,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cmath>
 #include <stdint.h>
 
+#include <QAtomicInt>
+
 #include "zuFile.h"
 #include "RegularGridded.h"
 
+class GribSubset;
+
 #define DEBUG_INFO    false
 #define DEBUG_ERROR   false
 #define debug(format, ...)  {if(DEBUG_INFO)  {fprintf(stderr,format,__VA_ARGS__);fprintf(stderr,"\n");}}
@@ -39,11 +43,16 @@ class GribRecord : public RegularGridRecord
 { 
     public:
         GribRecord ();
-        GribRecord (ZUFILE* file, int id_);
-        GribRecord (const GribRecord &rec);
+        // Messages outside the subset are not decoded (isSkipped).
+        // withValues=false: only the header is read, the values are
+        // decoded from the file origin on first use (setFileOrigin).
+        GribRecord (ZUFILE* file, int id_, const GribSubset *subset=NULL,
+					bool withValues=true);
+        GribRecord (const GribRecord &rec);   // alias: grid values are shared
         ~GribRecord ();
 		
         bool  isOk ()  const   		{return ok;}
+        bool  isSkipped () const 	{return skipped;}
         bool  isDataKnown ()  const {return knownData;}
         int   getId ()  const   	{return id;}
 		bool  isOrientationAmbiguous () const 
@@ -95,7 +104,9 @@ class GribRecord : public RegularGridRecord
 
         // Valeur pour un point de la grille
         double getValue (int i, int j) const 
-							{ return ok ? data[j*Ni+i] : GRIB_NOTDEF;}
+							{ if (!ok) return GRIB_NOTDEF;
+							  needData();
+							  return data[j*Ni+i]; }
 		
         // Valeur pour un point quelconque
         double  getInterpolatedValue (
@@ -111,8 +122,17 @@ class GribRecord : public RegularGridRecord
 						DataCode dtc, int i, int j ) const;
 
         void setValue (int i, int j, double v)
-        		{ if (i>=0 && i<Ni && j>=0 && j<Nj)
-        			data[j*Ni+i] = v; }
+        		{ if (i>=0 && i<Ni && j>=0 && j<Nj) {
+        			needData();
+        			if (isDataShared()) detachData();
+        			dataChanged();
+        			originSize = 0;		// values differ from the file
+        			data[j*Ni+i] = v; } }
+        
+        // Are grid values shared with other records (aliases) ?
+        bool  isDataShared () const
+        		{ return nbDataRefs!=NULL && nbDataRefs->load()>1; }
+        void  detachData ();    // get an own copy before writing values
 
         // La valeur est-elle définie (grille à trous) ?
         inline bool   hasValue (int i, int j) const;
@@ -126,12 +146,42 @@ class GribRecord : public RegularGridRecord
         const char* getStrRecordCurDate () const { return strCurDate; }
         void  setRecordCurrentDate (time_t t);
 		
+		// Same grid (size and position) as an other record ?
+		bool  hasSameGrid (const GribRecord &rec) const;
+		// data = (1-k)*rec1 + k*rec2 (records must have the same grid)
+		bool  setBlendedData (const GribRecord &rec1, const GribRecord &rec2,
+							  double k);
+		// Keeps the part of the grid in the zone, with a margin of 1 cell
+		// (false if the grid is outside the zone)
+		bool  cropToZone (double x0, double y0, double x1, double y1);
+		
         bool  isEof () const   {return eof;};
+		
+		//-----------------------------------------
+		// Position of the message in an uncompressed file: the values
+		// may be released (GribRecordCache) and decoded again later.
+		// field: number of the field in a GRIB2 message.
+		void  setFileOrigin (const std::string &fname,
+							 long offset, long size, int field=0);
+		bool  hasFileOrigin () const   {return originSize > 0;}
+		void  setOriginFile (const std::string &fname)
+						{ if (hasFileOrigin()) originFile = fname; }
+		bool  isDataLoaded () const
+						{ return released.loadAcquire()==0 && data!=NULL; }
+		long  getDataMemorySize () const;	// bytes
+		// false if the values can't be decoded again or are shared
+		bool  releaseValues ();
+		
+		void  setCached (bool b)      {cached = b;}
+		bool  isCached () const       {return cached;}
+		void  setLastUse (int t)      {lastUse.store (t);}
+		int   getLastUse () const     {return lastUse.load ();}
         virtual void  print (const char *title);
 
     protected:
         int    id;    // unique identifiant
         bool   ok;    // validité des données
+        bool   skipped;	// not in the subset asked by the reader
         bool   knownData; 	// type de donnée connu
         bool   waveData;
 		
@@ -198,6 +248,24 @@ class GribRecord : public RegularGridRecord
         double refValue;
         zuint  nbBitsInPack;
         double  *data;
+        // data, BMSbits and boolBMStab are shared between aliased records
+        // (copy on write): number of records using them, NULL if only one.
+        mutable QAtomicInt *nbDataRefs;
+        void   releaseData ();
+		
+		// values released by GribRecordCache
+		std::string originFile;
+		long   originOffset, originSize;
+		int    originField;
+		QAtomicInt released;
+		QAtomicInt lastUse;
+		bool   cached;
+		inline void needData () const;
+		void   reloadData ();
+		// Record made from a message of the file (values only needed)
+		virtual GribRecord * decodeMessage (const uint8_t *msg, long size) const;
+		// Keeps the cells i0..i1 x j0..j1
+		void   cropGrid (int i0, int j0, int i1, int j1);
         // SECTION 5: END SECTION (ES)
 
         //---------------------------------------------
@@ -228,6 +296,7 @@ class GribRecord : public RegularGridRecord
 		zuint  periodSeconds(zuchar unit, zuchar P1, zuchar P2, zuchar range);
         void   multiplyAllData(double k);
 		
+		bool   isInSubset (const GribSubset *subset);
 		void   checkOrientation ();
 		void   reverseData (char orientation); // orientation = 'H' or 'V'
 		bool   verticalDataAreMirrored ();
@@ -236,6 +305,44 @@ class GribRecord : public RegularGridRecord
 		double savXmin,savXmax, savYmin,savYmax;
 		double savDi, savDj;
 		bool   verticalOrientationIsAmbiguous;
+
+    private:
+		// not implemented: aliases are made by the copy constructor only
+		GribRecord & operator= (const GribRecord &);
+};
+
+//----------------------------------------------
+// Virtual record at a date between 2 records of the same type.
+// The blended grid is computed on first request only (drawing),
+// values at a point are interpolated from the 2 records.
+//----------------------------------------------
+class GribRecordTimeInterp
+{
+    public:
+        GribRecordTimeInterp (GribRecord *before, GribRecord *after, time_t date);
+        ~GribRecordTimeInterp ();
+
+        GribRecord *getRecordBefore () const  {return before;}
+        GribRecord *getRecordAfter ()  const  {return after;}
+        time_t  getDate () const    {return date;}
+        double  getWeight () const  {return k;}   // weight of after
+
+        // Record with blended values (NULL if grids are different)
+        GribRecord *getBlendedRecord ();
+
+        double  getInterpolatedValue (double px, double py,
+        							  bool interpolate=true) const;
+
+        void  setLastUse (int t)    {lastUse = t;}
+        int   getLastUse () const   {return lastUse;}
+
+    private:
+        GribRecord *before, *after;
+        GribRecord *blended;
+        bool   blendedDone;
+        time_t date;
+        double k;
+        int    lastUse;
 };
 
 //==========================================================================
@@ -257,9 +364,16 @@ inline bool   GribRecord::hasValue (int i, int j) const
     if (!hasBMS) {
         return true;
     }
+	needData ();
 	return boolBMStab [j*Ni+i];
 }
 //-----------------------------------------------------------------
+inline void GribRecord::needData () const
+{
+	if (released.loadAcquire() != 0)
+		const_cast <GribRecord *> (this)->reloadData ();
+}
+//-----------------------------------------------------------------
 inline bool   GribRecord::hasValueInBitBMS (int i, int j) const
 {
     // is data present in BMS ?
@@ -0,0 +1,172 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "GribRecordCache.h"
+#include "GribRecord.h"
+
+static QMutex     GLOB_cacheMutex;			// members below
+static std::set <GribRecord *> GLOB_cacheRecords;
+static long       GLOB_cacheBudget = 1024L*1024*1024;
+static long       GLOB_cacheEvictions = 0;
+static std::map <const void *, std::set <GribRecord *> > GLOB_cachePinned;
+
+static QAtomicInt GLOB_cacheUse;			// period of use (one per trim)
+static QAtomicInt GLOB_cacheHits;
+static QAtomicInt GLOB_cacheMisses;
+
+//---------------------------------------------------------------------
+void GribRecordCache::setBudgetMB (int mb)
+{
+	QMutexLocker lock (&GLOB_cacheMutex);
+	GLOB_cacheBudget = std::max (mb, 16) * 1024L*1024;
+}
+//---------------------------------------------------------------------
+int GribRecordCache::getBudgetMB ()
+{
+	QMutexLocker lock (&GLOB_cacheMutex);
+	return GLOB_cacheBudget / (1024L*1024);
+}
+//---------------------------------------------------------------------
+void GribRecordCache::registerRecord (GribRecord *rec)
+{
+	if (! rec->hasFileOrigin())
+		return;
+	QMutexLocker lock (&GLOB_cacheMutex);
+	GLOB_cacheRecords.insert (rec);
+	rec->setCached (true);
+	rec->setLastUse (GLOB_cacheUse.load());
+}
+//---------------------------------------------------------------------
+void GribRecordCache::unregisterRecord (GribRecord *rec)
+{
+	QMutexLocker lock (&GLOB_cacheMutex);
+	GLOB_cacheRecords.erase (rec);
+	rec->setCached (false);
+	std::map <const void *, std::set <GribRecord *> >::iterator it;
+	for (it=GLOB_cachePinned.begin(); it!=GLOB_cachePinned.end(); it++)
+		it->second.erase (rec);
+}
+//---------------------------------------------------------------------
+void GribRecordCache::pinRecords (const void *owner,
+								  const std::vector <GribRecord *> &recs)
+{
+	QMutexLocker lock (&GLOB_cacheMutex);
+	GLOB_cachePinned [owner] = std::set <GribRecord *> (recs.begin(), recs.end());
+}
+//---------------------------------------------------------------------
+void GribRecordCache::unpinRecords (const void *owner)
+{
+	QMutexLocker lock (&GLOB_cacheMutex);
+	GLOB_cachePinned.erase (owner);
+}
+//---------------------------------------------------------------------
+void GribRecordCache::touch (GribRecord *rec)
+{
+	if (rec==NULL || ! rec->isCached())
+		return;
+	rec->setLastUse (GLOB_cacheUse.load());
+	if (rec->isDataLoaded())
+		GLOB_cacheHits.ref ();
+}
+//---------------------------------------------------------------------
+void GribRecordCache::countMiss ()
+{
+	GLOB_cacheMisses.ref ();
+}
+//---------------------------------------------------------------------
+static bool isUsedBefore (const GribRecord *a, const GribRecord *b)
+{
+	return a->getLastUse() < b->getLastUse();
+}
+//---------------------------------------------------------------------
+static bool isPinned (GribRecord *rec)
+{
+	std::map <const void *, std::set <GribRecord *> >::iterator it;
+	for (it=GLOB_cachePinned.begin(); it!=GLOB_cachePinned.end(); it++)
+		if (it->second.count (rec) > 0)
+			return true;
+	return false;
+}
+//---------------------------------------------------------------------
+void GribRecordCache::trim ()
+{
+	QMutexLocker lock (&GLOB_cacheMutex);
+	GLOB_cacheUse.ref ();
+	long size = 0;
+	std::vector <GribRecord *> candidates;
+	std::set <GribRecord *>::iterator it;
+	for (it=GLOB_cacheRecords.begin(); it!=GLOB_cacheRecords.end(); it++) {
+		GribRecord *rec = *it;
+		size += rec->getPyramidsMemorySize ();
+		if (rec->isDataLoaded()) {
+			size += rec->getDataMemorySize ();
+			if (! isPinned (rec))
+				candidates.push_back (rec);
+		}
+	}
+	if (size <= GLOB_cacheBudget)
+		return;
+	std::stable_sort (candidates.begin(), candidates.end(), isUsedBefore);
+	for (size_t i=0; i<candidates.size() && size>GLOB_cacheBudget; i++) {
+		GribRecord *rec = candidates[i];
+		long recsize = rec->getDataMemorySize () + rec->getPyramidsMemorySize ();
+		if (rec->releaseValues ()) {
+			size -= recsize;
+			GLOB_cacheEvictions ++;
+		}
+	}
+}
+//---------------------------------------------------------------------
+GribRecordCacheStats GribRecordCache::getStats ()
+{
+	QMutexLocker lock (&GLOB_cacheMutex);
+	GribRecordCacheStats stats;
+	stats.budget = GLOB_cacheBudget;
+	stats.nbRecords = GLOB_cacheRecords.size();
+	stats.nbLoaded = 0;
+	stats.loadedSize = 0;
+	stats.pyramidsSize = 0;
+	std::set <GribRecord *>::iterator it;
+	for (it=GLOB_cacheRecords.begin(); it!=GLOB_cacheRecords.end(); it++) {
+		stats.pyramidsSize += (*it)->getPyramidsMemorySize ();
+		if ((*it)->isDataLoaded()) {
+			stats.nbLoaded ++;
+			stats.loadedSize += (*it)->getDataMemorySize ();
+		}
+	}
+	stats.hits = GLOB_cacheHits.load();
+	stats.misses = GLOB_cacheMisses.load();
+	stats.evictions = GLOB_cacheEvictions;
+	return stats;
+}
+//---------------------------------------------------------------------
+void GribRecordCache::resetStats ()
+{
+	QMutexLocker lock (&GLOB_cacheMutex);
+	GLOB_cacheHits.store (0);
+	GLOB_cacheMisses.store (0);
+	GLOB_cacheEvictions = 0;
+}
@@ -0,0 +1,80 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef GRIBRECORDCACHE_H
+#define GRIBRECORDCACHE_H
+
+#include <vector>
+
+class GribRecord;
+
+//====================================================================
+// Counters of the record cache
+//====================================================================
+class GribRecordCacheStats
+{
+	public:
+		long  budget;			// bytes
+		long  nbRecords;		// registered records
+		long  nbLoaded;			// ... with their values in memory
+		long  loadedSize;		// bytes
+		long  pyramidsSize;		// levels of detail of the records, bytes
+		long  hits;				// record used with its values in memory
+		long  misses;			// values decoded again from the file
+		long  evictions;
+};
+
+//====================================================================
+// Memory budget of the grid values of all GRIB readers.
+// Registered records (read from an uncompressed file) may lose their
+// values when the budget is exceeded: the least recently used are
+// released first, the records pinned by any reader are kept.
+// The levels of detail (GridPyramid) of a record count in the budget
+// and are released with its values.
+// Released values are decoded again from the file on first access.
+// trim is called only by the GUI thread, between Terrain::lockData and
+// unlockData (no other thread reads the records), and never while a
+// file is loaded.
+//====================================================================
+class GribRecordCache
+{
+	public:
+		static void  setBudgetMB (int mb);
+		static int   getBudgetMB ();
+
+		static void  registerRecord   (GribRecord *rec);
+		static void  unregisterRecord (GribRecord *rec);
+
+		// The record is used (LRU order, statistics)
+		static void  touch (GribRecord *rec);
+		static void  countMiss ();
+
+		// Records kept whatever the budget, by reader (owner):
+		// replaces the records pinned before by the same owner
+		static void  pinRecords   (const void *owner,
+								   const std::vector <GribRecord *> &recs);
+		static void  unpinRecords (const void *owner);
+
+		// Releases values until the budget is respected
+		static void  trim ();
+
+		static GribRecordCacheStats getStats ();
+		static void  resetStats ();
+};
+
+#endif
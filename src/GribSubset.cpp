@@ -0,0 +1,438 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "GribSubset.h"
+#include "GribFramer.h"
+#include "GribRecord.h"
+#include "Grib2Record.h"
+#include "g2clib/grib2.h"
+
+//---------------------------------------------------------------------
+GribSubset::GribSubset ()
+{
+	zone = false;
+	zx0 = zy0 = zx1 = zy1 = 0;
+	dateMin = dateMax = 0;
+}
+//---------------------------------------------------------------------
+void GribSubset::setZone (double x0, double y0, double x1, double y1)
+{
+	zx0 = std::min (x0, x1);
+	zx1 = std::max (x0, x1);
+	zy0 = std::min (y0, y1);
+	zy1 = std::max (y0, y1);
+	zone = zx0 < zx1 && zy0 < zy1;
+}
+//---------------------------------------------------------------------
+void GribSubset::getZone (double *x0, double *y0, double *x1, double *y1) const
+{
+	*x0 = zx0;
+	*y0 = zy0;
+	*x1 = zx1;
+	*y1 = zy1;
+}
+//---------------------------------------------------------------------
+void GribSubset::addDataCode (const DataCode &dtc)
+{
+	// 2D vectors are stored as 2 records
+	if (dtc.dataType==GRB_PRV_WIND_XY2D || dtc.dataType==GRB_PRV_WIND_JET
+			|| dtc.dataType==GRB_PRV_WIND_DIR) {
+		dataCodes.insert (DataCode (GRB_WIND_VX, dtc.getAltitude()));
+		dataCodes.insert (DataCode (GRB_WIND_VY, dtc.getAltitude()));
+	}
+	else if (dtc.dataType==GRB_PRV_CUR_XY2D || dtc.dataType==GRB_PRV_CUR_DIR) {
+		dataCodes.insert (DataCode (GRB_CUR_VX, dtc.getAltitude()));
+		dataCodes.insert (DataCode (GRB_CUR_VY, dtc.getAltitude()));
+	}
+	else {
+		dataCodes.insert (dtc);
+	}
+}
+//---------------------------------------------------------------------
+void GribSubset::setDataCodes (const std::set<DataCode> &codes)
+{
+	dataCodes.clear ();
+	std::set<DataCode>::const_iterator it;
+	for (it=codes.begin(); it!=codes.end(); it++)
+		addDataCode (*it);
+}
+//---------------------------------------------------------------------
+void GribSubset::setDateRange (time_t dmin, time_t dmax)
+{
+	dateMin = dmin;
+	dateMax = dmax;
+}
+
+//=====================================================================
+// Writing the subset
+//=====================================================================
+static int get2 (const uint8_t *p)
+{
+	return (p[0]<<8) + p[1];
+}
+static long get3 (const uint8_t *p)
+{
+	return ((long)p[0]<<16) + (p[1]<<8) + p[2];
+}
+static int getSigned3 (const uint8_t *p)
+{
+	int v = ((p[0]&0x7F)<<16) + (p[1]<<8) + p[2];
+	return (p[0]&0x80) ? -v : v;
+}
+static void put2 (uint8_t *p, int v)
+{
+	p[0] = (v>>8) & 0xFF;
+	p[1] =  v     & 0xFF;
+}
+static void put3 (uint8_t *p, long v)
+{
+	p[0] = (v>>16) & 0xFF;
+	p[1] = (v>>8)  & 0xFF;
+	p[2] =  v      & 0xFF;
+}
+static void putSigned3 (uint8_t *p, int v)
+{
+	put3 (p, v<0 ? -v : v);
+	if (v < 0)
+		p[0] |= 0x80;
+}
+static uint32_t readBits (const uint8_t *buf, long first, int nbBits)
+{
+	uint32_t v = 0;
+	for (int k=0; k<nbBits; k++, first++)
+		v = (v<<1) | ((buf[first>>3] >> (7-(first&7))) & 1);
+	return v;
+}
+static void writeBits (uint8_t *buf, long first, uint32_t v, int nbBits)
+{
+	for (int k=nbBits-1; k>=0; k--, first++) {
+		if ((v>>k) & 1)
+			buf[first>>3] |= 0x80 >> (first&7);
+	}
+}
+static int roundLongitude (double v)	// millidegrees
+{
+	while (v >= 360000)
+		v -= 360000;
+	while (v < -180000)
+		v += 360000;
+	return (int) floor (v+0.5);
+}
+//---------------------------------------------------------------------
+int GribSubset::writeFile (const std::string &inName,
+						   const std::string &outName) const
+{
+	std::vector<std::string> inNames;
+	inNames.push_back (inName);
+	return writeFile (inNames, outName);
+}
+//---------------------------------------------------------------------
+int GribSubset::writeFile (const std::vector<std::string> &inNames,
+						   const std::string &outName) const
+{
+	FILE *out = fopen (outName.c_str(), "wb");
+	if (out == NULL) {
+		erreur ("Can't create file: %s", outName.c_str());
+		return -1;
+	}
+	int nb = 0;
+	bool ok = true;
+	for (size_t n=0; ok && n<inNames.size(); n++) {
+		int nbfile = writeMessages (inNames[n], out);
+		if (nbfile < 0)
+			ok = false;
+		else
+			nb += nbfile;
+	}
+	if (fclose (out) != 0)
+		ok = false;
+	return ok ? nb : -1;
+}
+//---------------------------------------------------------------------
+int GribSubset::writeMessages (const std::string &inName, FILE *out) const
+{
+	ZUFILE *in = zu_open (inName.c_str(), "rb", ZU_COMPRESS_AUTO);
+	if (in == NULL) {
+		erreur ("Can't open file: %s", inName.c_str());
+		return -1;
+	}
+	GribFramer framer (in);
+	std::vector <uint8_t> buf;
+	int nb = 0;
+	int id = 0;
+	bool ok = true;
+	while (ok && framer.nextMessage())
+	{
+		const uint8_t *msg = framer.getMessage();
+		long size = framer.getMessageSize();
+		bool wanted;
+		id ++;
+		if (framer.getEdition() == 1) {
+			wanted = isGrib1MessageWanted (msg, size,
+										   framer.getMessageOffset(), id)
+					&& cropGrib1Message (msg, size, buf);
+		}
+		else {
+			wanted = isGrib2MessageWanted (msg);
+			if (wanted)
+				buf.assign (msg, msg+size);
+		}
+		if (wanted) {
+			ok = fwrite (&buf[0], 1, buf.size(), out) == buf.size();
+			nb ++;
+		}
+	}
+	zu_close (in);
+	return ok ? nb : -1;
+}
+//---------------------------------------------------------------------
+// Data code and date after the corrections made for each center.
+// Only the sections 0 to 2 are read: the values are not decoded.
+//---------------------------------------------------------------------
+bool GribSubset::isGrib1MessageWanted (const uint8_t *msg, long size,
+									   long offset, int id) const
+{
+	ZUFILE msgfile;
+	zu_init_memory (&msgfile, msg, size, offset);
+	GribRecord rec (&msgfile, id, this, false);
+	if (! rec.isOk() || ! rec.isDataKnown())
+		return false;
+	if (zone)
+		return rec.cropToZone (zx0,zy0, zx1,zy1);
+	return true;
+}
+//---------------------------------------------------------------------
+// At least one field of the message is wanted
+//---------------------------------------------------------------------
+bool GribSubset::isGrib2MessageWanted (const uint8_t *msg) const
+{
+	unsigned char *cgrib = const_cast <unsigned char *> (msg);
+	g2int  listsec0[3],listsec1[13],numlocal=0,numfields=0;
+	if (g2_info (cgrib,listsec0,listsec1,&numfields,&numlocal) != 0)
+		return false;
+	int idCenter = listsec1[0];
+	time_t refDate = DataRecordAbstract::UTC_mktime
+				(listsec1[5],listsec1[6],listsec1[7],
+				 listsec1[8],listsec1[9],listsec1[10]);
+	for (g2int n=0; n<numfields; n++) {
+		gribfield *gfld = NULL;
+		if (g2_getfld (cgrib, n+1, 0, 0, &gfld) == 0) {
+			Grib2Record probe (gfld, n+1, idCenter, refDate);
+			g2_free (gfld);
+			if (probe.isOk()
+					&& isDataWanted (probe.getDataCode())
+					&& isDateWanted (probe.getRecordCurrentDate())) {
+				return true;
+			}
+		}
+		else if (gfld) {
+			g2_free (gfld);
+		}
+	}
+	return false;
+}
+//---------------------------------------------------------------------
+// The packed values of the points in the zone are copied with the
+// same reference value and scale factors : no precision is lost.
+// Only regular lat/lon grids with simple packing (as GribRecord).
+//---------------------------------------------------------------------
+bool GribSubset::cropGrib1Message (const uint8_t *msg, long size,
+								   std::vector <uint8_t> &out) const
+{
+	const uint8_t *end = msg+size-4;		// '7777'
+	const uint8_t *pds = msg+8;
+	if (pds+28 > end)
+		return false;
+	long len1 = get3 (pds);
+	bool hasGDS = (pds[7]&128) != 0;
+	bool hasBMS = (pds[7]&64) != 0;
+	const uint8_t *gds = pds+len1;
+	if (! hasGDS || gds+32 > end)
+		return false;
+	long len2 = get3 (gds);
+	if (gds[5] != 0)
+		return false;
+	int ni  = get2 (gds+6);
+	int nj  = get2 (gds+8);
+	int la1 = getSigned3 (gds+10);
+	int lo1 = getSigned3 (gds+13);
+	int la2 = getSigned3 (gds+17);
+	int lo2 = getSigned3 (gds+20);
+	zuchar scanFlags = gds[27];
+	if (ni<=1 || nj<=1)
+		return false;
+	const uint8_t *bms = gds+len2;
+	long len3 = 0;
+	if (hasBMS) {
+		if (bms+6 > end)
+			return false;
+		len3 = get3 (bms);
+		if (get2 (bms+4) != 0 || (len3-6)*8 < (long)ni*nj)
+			return false;		// predefined bit map
+	}
+	const uint8_t *bds = bms+len3;
+	if (bds+11 > end)
+		return false;
+	long len4 = get3 (bds);
+	if (bds+len4 > end || (bds[3]&0xF0) != 0)
+		return false;
+	int nbBits = bds[10];
+
+	// Position of the points (millidegrees)
+	bool isScanIpositive = (scanFlags&0x80) == 0;
+	bool isAdjacentI     = (scanFlags&0x20) == 0;
+	double dlon = lo2 - lo1;
+	if (isScanIpositive && dlon < 0)
+		dlon += 360000;
+	if (!isScanIpositive && dlon > 0)
+		dlon -= 360000;
+	double stepI = dlon / (ni-1);
+	double stepJ = (double) (la2-la1) / (nj-1);
+
+	// Columns and rows in the zone, with a margin of 1 cell
+	int i0=0, i1=ni-1, j0=0, j1=nj-1;
+	if (zone) {
+		double x0 = zx0 - fabs(stepI)/1000.0;
+		double x1 = zx1 + fabs(stepI)/1000.0;
+		if (x1-x0 < 360) {
+			int nbi = 0;
+			for (int i=0; i<ni; i++) {
+				double d = fmod ((lo1+i*stepI)/1000.0 - x0, 360.0);
+				if (d < 0)
+					d += 360;
+				if (d <= x1-x0) {
+					if (nbi == 0)
+						i0 = i;
+					i1 = i;
+					nbi ++;
+				}
+			}
+			if (nbi == 0)
+				return false;
+			if (nbi != i1-i0+1) {	// zone across the limit of a global grid
+				i0 = 0;
+				i1 = ni-1;
+			}
+		}
+		double y0 = zy0 - fabs(stepJ)/1000.0;
+		double y1 = zy1 + fabs(stepJ)/1000.0;
+		j0 = nj;
+		j1 = -1;
+		for (int j=0; j<nj; j++) {
+			double y = (la1+j*stepJ)/1000.0;
+			if (y>=y0 && y<=y1) {
+				j0 = std::min (j0, j);
+				j1 = j;
+			}
+		}
+		if (j1 < j0)
+			return false;
+	}
+	if (i0==0 && i1==ni-1 && j0==0 && j1==nj-1) {
+		out.assign (msg, msg+size);
+		return true;
+	}
+
+	// Unpacked values, in the order of the file
+	long nbPoints = (long)ni*nj;
+	std::vector <uint32_t> values (nbPoints, 0);
+	std::vector <bool> present (nbPoints, true);
+	const uint8_t *packed = bds+11;
+	long availBits = (len4-11)*8;
+	long pos = 0;
+	for (long k=0; k<nbPoints; k++) {
+		if (hasBMS)
+			present[k] = (bms[6+k/8] & (0x80>>(k%8))) != 0;
+		if (present[k]) {
+			if (pos+nbBits > availBits)
+				return false;
+			values[k] = readBits (packed, pos, nbBits);
+			pos += nbBits;
+		}
+	}
+	// Points kept, in the same scanning mode
+	std::vector <long> kept;
+	kept.reserve ((long)(i1-i0+1)*(j1-j0+1));
+	if (isAdjacentI) {
+		for (int j=j0; j<=j1; j++)
+			for (int i=i0; i<=i1; i++)
+				kept.push_back ((long)j*ni+i);
+	}
+	else {
+		for (int i=i0; i<=i1; i++)
+			for (int j=j0; j<=j1; j++)
+				kept.push_back ((long)i*nj+j);
+	}
+	long nbKept = kept.size();
+	long nbValues = 0;
+	for (long n=0; n<nbKept; n++)
+		if (present[kept[n]])
+			nbValues ++;
+
+	// Sections have an even length
+	long bmsLen = 0;
+	if (hasBMS) {
+		bmsLen = 6 + (nbKept+7)/8;
+		bmsLen += bmsLen%2;
+	}
+	long bdsLen = 11 + (nbValues*nbBits+7)/8;
+	bdsLen += bdsLen%2;
+	long totalLen = 8 + len1 + len2 + bmsLen + bdsLen + 4;
+	if (totalLen > 0xFFFFFF)
+		return false;
+
+	out.assign (totalLen, 0);
+	uint8_t *p = &out[0];
+	memcpy (p, msg, 8);						// IS
+	put3 (p+4, totalLen);
+	memcpy (p+8, pds, len1);				// PDS
+	uint8_t *g = p+8+len1;					// GDS
+	memcpy (g, gds, len2);
+	put2 (g+6, i1-i0+1);
+	put2 (g+8, j1-j0+1);
+	putSigned3 (g+10, (int) floor (la1+j0*stepJ+0.5));
+	putSigned3 (g+13, roundLongitude (lo1+i0*stepI));
+	putSigned3 (g+17, (int) floor (la1+j1*stepJ+0.5));
+	putSigned3 (g+20, roundLongitude (lo1+i1*stepI));
+	uint8_t *b = g+len2;					// BMS
+	if (hasBMS) {
+		put3 (b, bmsLen);
+		b[3] = (bmsLen-6)*8 - nbKept;		// unused bits
+		for (long n=0; n<nbKept; n++)
+			if (present[kept[n]])
+				b[6+n/8] |= 0x80 >> (n%8);
+	}
+	uint8_t *d = b+bmsLen;					// BDS
+	put3 (d, bdsLen);
+	d[3] = (bds[3]&0xF0) | (((bdsLen-11)*8 - nbValues*nbBits) & 0x0F);
+	memcpy (d+4, bds+4, 7);					// E, R, nb bits
+	pos = 0;
+	for (long n=0; n<nbKept; n++) {
+		if (present[kept[n]]) {
+			writeBits (d+11, pos, values[kept[n]], nbBits);
+			pos += nbBits;
+		}
+	}
+	memcpy (p+totalLen-4, "7777", 4);		// ES
+	return true;
+}
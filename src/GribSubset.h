@@ -0,0 +1,92 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef GRIBSUBSET_H
+#define GRIBSUBSET_H
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <stdint.h>
+
+#include "DataDefines.h"
+
+//====================================================================
+// Part of a GRIB file to keep: a zone, a list of data and a period.
+// Messages outside the subset are not decoded, the grids of the
+// other messages are cropped to the zone (with a margin of 1 cell).
+// An empty criterion keeps everything.
+// The File menu ("Open selected area") sets only the zone.
+//====================================================================
+class GribSubset
+{
+	public:
+		GribSubset ();
+
+		bool  isEmpty () const
+					{ return !hasZone() && !hasDataCodes() && !hasDateRange(); }
+
+		// Zone (corners in any order)
+		void  setZone (double x0, double y0, double x1, double y1);
+		void  clearZone ()   {zone = false;}
+		bool  hasZone () const   {return zone;}
+		void  getZone (double *x0, double *y0, double *x1, double *y1) const;
+
+		// Data codes (private codes like GRB_PRV_WIND_XY2D are expanded)
+		void  addDataCode (const DataCode &dtc);
+		void  setDataCodes (const std::set<DataCode> &codes);
+		bool  hasDataCodes () const   {return ! dataCodes.empty();}
+		bool  isDataWanted (const DataCode &dtc) const
+					{ return dataCodes.empty() || dataCodes.count(dtc) > 0; }
+
+		// Period (0 = no limit)
+		void  setDateRange (time_t dmin, time_t dmax);
+		bool  hasDateRange () const   {return dateMin!=0 || dateMax!=0;}
+		bool  isDateWanted (time_t date) const
+					{ return (dateMin==0 || date>=dateMin)
+							&& (dateMax==0 || date<=dateMax); }
+
+		// Writes the messages of the subset in an other GRIB file.
+		// GRIB1 grids are cropped without decoding the values again,
+		// GRIB2 messages are copied as they are.
+		// Returns the number of messages written, -1 on error.
+		int   writeFile (const std::string &inName,
+						 const std::string &outName) const;
+		// Messages of several files (dataset) in one file
+		int   writeFile (const std::vector<std::string> &inNames,
+						 const std::string &outName) const;
+
+	private:
+		bool   zone;
+		double zx0, zy0, zx1, zy1;		// zx0<zx1 zy0<zy1
+		std::set<DataCode> dataCodes;
+		time_t dateMin, dateMax;
+
+		// Appends the wanted messages of a file (number, -1 on error)
+		int   writeMessages (const std::string &inName, FILE *out) const;
+		bool  isGrib1MessageWanted (const uint8_t *msg, long size,
+									long offset, int id) const;
+		bool  isGrib2MessageWanted (const uint8_t *msg) const;
+		// Cropped copy of a GRIB1 message (false if nothing to keep)
+		bool  cropGrib1Message (const uint8_t *msg, long size,
+								std::vector <uint8_t> &out) const;
+};
+
+#endif
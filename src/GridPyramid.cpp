@@ -0,0 +1,402 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include "GridPyramid.h"
+#include "Util.h"
+
+//--------------------------------------------------------------------
+GridPyramid::GridPyramid (const GriddedRecord *rec, const DataCode &dtc,
+						  const GriddedRecord *recY, const DataCode &dtcY)
+	: mutex (QMutex::Recursive)		// a level is built from the previous one
+{
+	this->rec = rec;
+	this->dtc = dtc;
+	this->recY = recY;
+	this->dtcY = dtcY;
+	// stop when the coarsest level has only a few cells
+	nbLevels = 1;
+	int ni = rec->getNi();
+	int nj = rec->getNj();
+	while (nbLevels < PYRAMID_MAX_LEVELS && (ni > 4 || nj > 4)) {
+		ni = (ni+1)/2;
+		nj = (nj+1)/2;
+		nbLevels ++;
+	}
+	for (int i=0; i < PYRAMID_MAX_LEVELS; i++)
+		levels[i].store (NULL);
+	statsDone = hasStats = false;
+	statMin = statMax = statMean = GRIB_NOTDEF;
+	extremaDone = false;
+}
+//--------------------------------------------------------------------
+GridPyramid::~GridPyramid ()
+{
+	for (int i=0; i < PYRAMID_MAX_LEVELS; i++)
+		delete levels[i].load ();
+}
+//--------------------------------------------------------------------
+long GridPyramid::getMemorySize ()
+{
+	long size = 0;
+	for (int i=1; i < nbLevels; i++) {
+		const Level *lev = levels[i].loadAcquire ();
+		if (lev != NULL)
+			size += 3L * lev->ni*lev->nj * sizeof(float);
+	}
+	QMutexLocker lock (&mutex);
+	return size + extrema.capacity() * sizeof(GridExtremum);
+}
+//--------------------------------------------------------------------
+double GridPyramid::getValue (int i, int j) const
+{
+	double vx = rec->getValueOnRegularGrid (dtc, i, j);
+	if (recY == NULL || vx == GRIB_NOTDEF)
+		return vx;
+	double vy = recY->getValueOnRegularGrid (dtcY, i, j);
+	if (vy == GRIB_NOTDEF)
+		return GRIB_NOTDEF;
+	return sqrt (vx*vx + vy*vy);
+}
+//--------------------------------------------------------------------
+int GridPyramid::getLevelForCellSize (double dx, double dy) const
+{
+	double cx = fabs (rec->getDeltaX());
+	double cy = fabs (rec->getDeltaY());
+	int level = 0;
+	while (level+1 < nbLevels && 2*cx <= dx && 2*cy <= dy) {
+		cx *= 2;
+		cy *= 2;
+		level ++;
+	}
+	return level;
+}
+//--------------------------------------------------------------------
+int GridPyramid::getNi (int level) const
+{
+	int n = rec->getNi();
+	for (int k=0; k < level; k++)
+		n = (n+1)/2;
+	return n;
+}
+//--------------------------------------------------------------------
+int GridPyramid::getNj (int level) const
+{
+	int n = rec->getNj();
+	for (int k=0; k < level; k++)
+		n = (n+1)/2;
+	return n;
+}
+//--------------------------------------------------------------------
+double GridPyramid::getX (int level, int i) const
+{
+	int s = 1<<level;
+	int last = std::min ((i+1)*s, rec->getNi()) - 1;
+	return rec->getX(0) + 0.5*(i*s+last)*rec->getDeltaX();
+}
+//--------------------------------------------------------------------
+double GridPyramid::getY (int level, int j) const
+{
+	int s = 1<<level;
+	int last = std::min ((j+1)*s, rec->getNj()) - 1;
+	return rec->getY(0) + 0.5*(j*s+last)*rec->getDeltaY();
+}
+//--------------------------------------------------------------------
+const GridPyramid::Level * GridPyramid::getLevel (int level)
+{
+	const Level *lev = levels[level].loadAcquire ();
+	if (lev == NULL) {
+		QMutexLocker lock (&mutex);
+		if (levels[level].loadAcquire() == NULL)
+			buildLevel (level);
+		lev = levels[level].loadAcquire ();
+	}
+	return lev;
+}
+//--------------------------------------------------------------------
+void GridPyramid::buildLevel (int level)
+{
+	const Level *src = (level > 1) ? getLevel (level-1) : NULL;
+	int sni = getNi (level-1);
+	int snj = getNj (level-1);
+	Level *lev = new Level;
+	assert (lev);
+	lev->ni = getNi (level);
+	lev->nj = getNj (level);
+	int size = lev->ni*lev->nj;
+	lev->vmin.assign  (size, GRIB_NOTDEF);
+	lev->vmax.assign  (size, GRIB_NOTDEF);
+	lev->vmean.assign (size, GRIB_NOTDEF);
+	for (int j=0; j < lev->nj; j++) {
+		for (int i=0; i < lev->ni; i++) {
+			double vmin=0, vmax=0, sum=0;
+			int nb = 0;
+			for (int cj=2*j; cj <= 2*j+1 && cj < snj; cj++) {
+				for (int ci=2*i; ci <= 2*i+1 && ci < sni; ci++) {
+					double a, b, m;
+					if (src != NULL) {
+						int c = cj*sni + ci;
+						a = src->vmin[c];
+						b = src->vmax[c];
+						m = src->vmean[c];
+					}
+					else {
+						a = b = m = getValue (ci, cj);
+					}
+					if (m == GRIB_NOTDEF)
+						continue;
+					if (nb == 0 || a < vmin)
+						vmin = a;
+					if (nb == 0 || b > vmax)
+						vmax = b;
+					sum += m;
+					nb ++;
+				}
+			}
+			if (nb > 0) {
+				int c = j*lev->ni + i;
+				lev->vmin[c]  = vmin;
+				lev->vmax[c]  = vmax;
+				lev->vmean[c] = sum/nb;
+			}
+		}
+	}
+	levels[level].storeRelease (lev);
+}
+//--------------------------------------------------------------------
+double GridPyramid::getMin (int level, int i, int j)
+{
+	if (level == 0)
+		return getValue (i, j);
+	const Level *lev = getLevel (level);
+	if (i<0 || j<0 || i>=lev->ni || j>=lev->nj)
+		return GRIB_NOTDEF;
+	return lev->vmin [j*lev->ni+i];
+}
+//--------------------------------------------------------------------
+double GridPyramid::getMax (int level, int i, int j)
+{
+	if (level == 0)
+		return getValue (i, j);
+	const Level *lev = getLevel (level);
+	if (i<0 || j<0 || i>=lev->ni || j>=lev->nj)
+		return GRIB_NOTDEF;
+	return lev->vmax [j*lev->ni+i];
+}
+//--------------------------------------------------------------------
+double GridPyramid::getMean (int level, int i, int j)
+{
+	if (level == 0)
+		return getValue (i, j);
+	const Level *lev = getLevel (level);
+	if (i<0 || j<0 || i>=lev->ni || j>=lev->nj)
+		return GRIB_NOTDEF;
+	return lev->vmean [j*lev->ni+i];
+}
+//--------------------------------------------------------------------
+// Same rules as GriddedRecord::getInterpolatedValueUsingRegularGrid,
+// on the means of a level.
+//--------------------------------------------------------------------
+double GridPyramid::getInterpolatedValue (int level,
+							double px, double py, bool interpolate)
+{
+	if (level == 0) {
+		double vx = rec->getInterpolatedValue (dtc, px, py, interpolate);
+		if (recY == NULL || vx == GRIB_NOTDEF)
+			return vx;
+		double vy = recY->getInterpolatedValue (dtcY, px, py, interpolate);
+		return vy == GRIB_NOTDEF ? GRIB_NOTDEF : sqrt (vx*vx + vy*vy);
+	}
+	if (!rec->isOk() || !rec->isYInMap(py))
+		return GRIB_NOTDEF;
+	if (!rec->isXInMap(px)) {
+		px += 360.0;
+		if (!rec->isXInMap(px)) {
+			px -= 2*360.0;
+			if (!rec->isXInMap(px))
+				return GRIB_NOTDEF;
+		}
+	}
+	const Level *lev = getLevel (level);
+	int s = 1<<level;
+	double pi = ((px-rec->getX(0))/rec->getDeltaX() - 0.5*(s-1)) / s;
+	double pj = ((py-rec->getY(0))/rec->getDeltaY() - 0.5*(s-1)) / s;
+	int i0 = (int) floor (pi);
+	int j0 = (int) floor (pj);
+	double dx = pi-i0;
+	double dy = pj-j0;
+	int ii[2], jj[2];
+	for (int k=0; k < 2; k++) {
+		int i = i0+k;
+		if (rec->entireWorldInLongitude)
+			i = ((i % lev->ni) + lev->ni) % lev->ni;
+		else
+			i = std::max (0, std::min (lev->ni-1, i));
+		ii[k] = i;
+		jj[k] = std::max (0, std::min (lev->nj-1, j0+k));
+	}
+	double v[2][2];
+	int nbval = 0;
+	for (int a=0; a < 2; a++)
+		for (int b=0; b < 2; b++) {
+			v[a][b] = lev->vmean [jj[b]*lev->ni + ii[a]];
+			if (v[a][b] != GRIB_NOTDEF)
+				nbval ++;
+		}
+	if (nbval < 3)
+		return GRIB_NOTDEF;
+	if (! interpolate)
+		return v[dx<0.5 ? 0:1][dy<0.5 ? 0:1];
+
+	dx = (3.0 - 2.0*dx)*dx*dx;   // pseudo hermite interpolation
+	dy = (3.0 - 2.0*dy)*dy*dy;
+	double sv=0, sk=0;
+	for (int a=0; a < 2; a++)
+		for (int b=0; b < 2; b++) {
+			if (v[a][b] == GRIB_NOTDEF)
+				continue;
+			double k = (a ? dx : 1-dx) * (b ? dy : 1-dy);
+			sv += k*v[a][b];
+			sk += k;
+		}
+	return sk > 0 ? sv/sk : GRIB_NOTDEF;
+}
+
+//====================================================================
+// Statistics
+//====================================================================
+bool GridPyramid::getStatistics (double *vmin, double *vmax, double *vmean)
+{
+	QMutexLocker lock (&mutex);
+	if (! statsDone) {
+		statsDone = true;
+		double sum = 0;
+		int nb = 0;
+		for (int j=0; j < rec->getNj(); j++) {
+			for (int i=0; i < rec->getNi(); i++) {
+				double v = getValue (i, j);
+				if (v == GRIB_NOTDEF)
+					continue;
+				if (nb == 0 || v < statMin)
+					statMin = v;
+				if (nb == 0 || v > statMax)
+					statMax = v;
+				sum += v;
+				nb ++;
+			}
+		}
+		hasStats = nb > 0;
+		if (hasStats)
+			statMean = sum/nb;
+	}
+	*vmin  = statMin;
+	*vmax  = statMax;
+	*vmean = statMean;
+	return hasStats;
+}
+//--------------------------------------------------------------------
+bool GridPyramid::getRegionMinMax (int i0, int j0, int i1, int j1,
+								   double *vmin, double *vmax)
+{
+	bool found = false;
+	*vmin = *vmax = GRIB_NOTDEF;
+	i0 = std::max (i0, 0);
+	j0 = std::max (j0, 0);
+	i1 = std::min (i1, rec->getNi()-1);
+	j1 = std::min (j1, rec->getNj()-1);
+	if (i0 > i1 || j0 > j1)
+		return false;
+	int top = nbLevels-1;
+	int ni = getNi (top);
+	int nj = getNj (top);
+	for (int j=0; j < nj; j++)
+		for (int i=0; i < ni; i++)
+			regionMinMax (top, i, j, i0, j0, i1, j1, vmin, vmax, &found);
+	return found;
+}
+//--------------------------------------------------------------------
+// Cells inside the region give their min/max, cells on its border
+// are split in their 4 sub-cells.
+//--------------------------------------------------------------------
+void GridPyramid::regionMinMax (int level, int i, int j,
+							int i0, int j0, int i1, int j1,
+							double *vmin, double *vmax, bool *found)
+{
+	int s = 1<<level;
+	int ci0 = i*s,  ci1 = ci0+s-1;
+	int cj0 = j*s,  cj1 = cj0+s-1;
+	if (ci1 < i0 || ci0 > i1 || cj1 < j0 || cj0 > j1)
+		return;
+	if (level == 0 || (ci0 >= i0 && ci1 <= i1 && cj0 >= j0 && cj1 <= j1))
+	{
+		double a = getMin (level, i, j);
+		double b = getMax (level, i, j);
+		if (a == GRIB_NOTDEF)
+			return;
+		if (! *found || a < *vmin)
+			*vmin = a;
+		if (! *found || b > *vmax)
+			*vmax = b;
+		*found = true;
+		return;
+	}
+	for (int cj=2*j; cj <= 2*j+1; cj++)
+		for (int ci=2*i; ci <= 2*i+1; ci++)
+			regionMinMax (level-1, ci, cj, i0, j0, i1, j1, vmin, vmax, found);
+}
+//--------------------------------------------------------------------
+const std::vector <GridExtremum> & GridPyramid::getLocalExtrema ()
+{
+	QMutexLocker lock (&mutex);
+	if (extremaDone)
+		return extrema;
+	extremaDone = true;
+	int Ni = rec->getNi();
+	int Nj = rec->getNj();
+	for (int j=1; j < Nj-1; j++) {     // !!!! 1 to end-1
+		for (int i=1; i < Ni-1; i++) {
+			double v = getValue (i, j);
+			if (v == GRIB_NOTDEF)
+				continue;
+			bool isMin = true, isMax = true;
+			for (int dj=-1; dj <= 1 && (isMin || isMax); dj++) {
+				for (int di=-1; di <= 1; di++) {
+					if (di == 0 && dj == 0)
+						continue;
+					double w = getValue (i+di, j+dj);
+					if (! (v < w))
+						isMin = false;
+					if (! (v > w))
+						isMax = false;
+				}
+			}
+			if (isMin || isMax) {
+				GridExtremum ext;
+				ext.i = i;
+				ext.j = j;
+				ext.value = v;
+				ext.isMax = isMax;
+				extrema.push_back (ext);
+			}
+		}
+	}
+	return extrema;
+}
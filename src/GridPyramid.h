@@ -0,0 +1,116 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef GRIDPYRAMID_H
+#define GRIDPYRAMID_H
+
+#include <vector>
+
+#include <QMutex>
+#include <QAtomicPointer>
+
+#include "GriddedRecord.h"
+
+#define PYRAMID_MAX_LEVELS  12
+
+//====================================================================
+// Local minimum or maximum of a field (grid indexes)
+//====================================================================
+class GridExtremum
+{
+	public:
+		int    i, j;
+		double value;
+		bool   isMax;
+};
+
+//====================================================================
+// Levels of detail and statistics of one field of a regular grid.
+// Level 0 is the record itself, each cell of level n+1 covers
+// 2x2 cells of level n (min, max and mean of the defined values),
+// so the levels are also a min/max quadtree for region queries.
+// Levels and statistics are computed on first use
+// (from the map thread or from the GUI).
+// With a second record, the field is the norm of the vector (x,y):
+// coarse cells give the mean of the speeds, not the speed of the
+// mean vector (which is too low where directions vary).
+// Pyramids are shared (GridPyramidPtr): a user keeps its pyramid
+// even if the record drops it (values modified or released).
+//====================================================================
+class GridPyramid
+{
+	public:
+		GridPyramid (const GriddedRecord *rec, const DataCode &dtc,
+					 const GriddedRecord *recY=NULL, const DataCode &dtcY=DataCode());
+		~GridPyramid ();
+
+		int  getNbLevels () const   {return nbLevels;}
+		// Coarsest level with cells not larger than dx*dy degrees
+		int  getLevelForCellSize (double dx, double dy) const;
+
+		int     getNi (int level) const;
+		int     getNj (int level) const;
+		// Center of the cells
+		double  getX (int level, int i) const;
+		double  getY (int level, int j) const;
+
+		double  getMin  (int level, int i, int j);
+		double  getMax  (int level, int i, int j);
+		double  getMean (int level, int i, int j);
+
+		double  getInterpolatedValue (int level, double px, double py,
+									  bool interpolate=true);
+
+		// Statistics of the defined values (false if there is none)
+		bool  getStatistics (double *vmin, double *vmax, double *vmean);
+		// Min and max in the grid cells i0..i1 x j0..j1 (inclusive)
+		bool  getRegionMinMax (int i0, int j0, int i1, int j1,
+							   double *vmin, double *vmax);
+		// Points lower or higher than their 8 neighbours
+		const std::vector <GridExtremum> & getLocalExtrema ();
+
+		// Memory of the levels and extrema already computed (bytes)
+		long  getMemorySize ();
+
+	private:
+		struct Level {
+			int ni, nj;
+			std::vector <float> vmin, vmax, vmean;
+		};
+		const GriddedRecord *rec;
+		DataCode dtc;
+		const GriddedRecord *recY;		// NULL: scalar field
+		DataCode dtcY;
+		int    nbLevels;
+		QAtomicPointer <Level> levels [PYRAMID_MAX_LEVELS];	// levels[0] is not used
+		QMutex mutex;		// computations on first use
+
+		bool   statsDone, hasStats;
+		double statMin, statMax, statMean;
+		bool   extremaDone;
+		std::vector <GridExtremum> extrema;
+
+		double getValue (int i, int j) const;		// level 0
+		const Level *getLevel (int level);
+		void   buildLevel (int level);
+		void   regionMinMax (int level, int i, int j,
+							 int i0, int j0, int i1, int j1,
+							 double *vmin, double *vmax, bool *found);
+};
+
+#endif
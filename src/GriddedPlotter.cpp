@@ -16,8 +16,11 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
+#include <algorithm>
+
 #include "GriddedPlotter.h"
 #include "DataQString.h"
+#include "RenderBuffer.h"
 
 /* Longueur de fleche courant */
 #define LF_MINC_A	3.
@@ -69,7 +72,7 @@ GriddedPlotter::~GriddedPlotter ()
 void GriddedPlotter::updateGraphicsParameters ()
 {
 	setCloudsColorMode ("cloudsColorMode");	
-    thinWindArrows = Util::getSetting("thinWindArrows", false).toBool();
+    thinWindArrows = Util::getSettingsSnapshot().thinWindArrows;
 }
 
 //==================================================================================
@@ -112,6 +115,14 @@ void GriddedPlotter::drawWaveArrow (QPainter &pnt,
 }
 //-----------------------------------------------------------------------------
 void GriddedPlotter::drawCurrentArrow (QPainter &pnt, int i, int j, double cx, double cy)
+{
+    double vkn = sqrt(cx*cx+cy*cy)*3.6/1.852;
+    int speedBin = qMin (qRound(vkn*20), 200);	// 0.05 kn (constant above 10 kn)
+	drawArrowSprite (pnt, i, j, SPRITE_CURRENT_ARROW, false, speedBin,
+					 atan2(cy, -cx), QColor(0,0,220));
+}
+//-----------------------------------------------------------------------------
+void GriddedPlotter::drawCurrentArrow_direct (QPainter &pnt, int i, int j, double cx, double cy)
 {
     double vkn = sqrt(cx*cx+cy*cy)*3.6/1.852;
 	// double ang = atan2(cy, -cx)-M_PI;  // unlike wind, arrows follows the current
@@ -196,6 +207,12 @@ void GriddedPlotter::drawCurrentArrow (
 }
 //-----------------------------------------------------------------------------
 void GriddedPlotter::drawWindArrow (QPainter &pnt, int i, int j, double vx, double vy)
+{
+	drawArrowSprite (pnt, i, j, SPRITE_WIND_ARROW, false, 0,
+					 atan2(vy, -vx), windArrowColor);
+}
+//-----------------------------------------------------------------------------
+void GriddedPlotter::drawWindArrow_direct (QPainter &pnt, int i, int j, double vx, double vy)
 {
     double ang = atan2(vy, -vx);
     double si=sin(ang),  co=cos(ang);
@@ -226,6 +243,28 @@ void GriddedPlotter::drawWindArrowWithBarbs (
 					this->thinWindArrows);
 }
 //-----------------------------------------------------------------------------
+// Barbs change at these speeds (knots)
+static const double barbsSpeeds[] = {1, 7.5, 12.5, 17.5, 22.5, 27.5, 32.5, 37.5,
+									 45, 55, 65, 75, 85};
+#define NB_BARBS_SPEEDS  (int)(sizeof(barbsSpeeds)/sizeof(barbsSpeeds[0]))
+//-----------------------------------------------------------------------------
+void GriddedPlotter::drawWindArrowWithBarbs_sprite (
+			QPainter &pnt,
+			int i, int j, double vx, double vy,
+			bool south,
+			QColor arrowColor
+	)
+{
+	if (vx==GRIB_NOTDEF || vy==GRIB_NOTDEF)
+		return;
+    double vkn = sqrt(vx*vx+vy*vy)*3.6/1.852;
+	int speedBin = 0;
+	while (speedBin < NB_BARBS_SPEEDS && vkn >= barbsSpeeds[speedBin])
+		speedBin ++;
+	double ang = (speedBin == 0) ? 0 : atan2(vy, -vx);	// circle if no wind
+	drawArrowSprite (pnt, i, j, SPRITE_WIND_BARBS, south, speedBin, ang, arrowColor);
+}
+//-----------------------------------------------------------------------------
 void GriddedPlotter::drawWindArrowWithBarbs_static (
 					QPainter &pnt,
 					int i, int j, double vx, double vy,
@@ -364,6 +403,91 @@ void GriddedPlotter::drawTriangle(QPainter &pnt, bool south,
     }
 }
 
+//==========================================================================
+// Arrows sprites : each arrow is drawn once by direction (5°) and speed bin,
+// then copied on the map.
+//==========================================================================
+#define SPRITES_NB_DIRS   72
+#define SPRITES_MAX     1500		// clear the cache when full
+
+void GriddedPlotter::drawArrowSprite (QPainter &pnt, int i, int j,
+					int kind, bool south, int speedBin, double ang, QColor color)
+{
+	int dirBin = qRound (ang*SPRITES_NB_DIRS/(2*M_PI));
+	dirBin = (dirBin%SPRITES_NB_DIRS + SPRITES_NB_DIRS) % SPRITES_NB_DIRS;
+	bool antialias = pnt.testRenderHint (QPainter::Antialiasing);
+	quint64 key = ((quint64) color.rgba() << 32)
+				| (speedBin << 12) | (dirBin << 5)
+				| (kind << 3) | (south << 2) | (thinWindArrows << 1) | antialias;
+	
+	QImage pix;		// shared copy: the cache may be cleared by an other thread
+	spritesMutex.lock ();
+	QHash <quint64,QImage>::const_iterator it = arrowSprites.constFind (key);
+	if (it == arrowSprites.constEnd()) {
+		if (arrowSprites.size() >= SPRITES_MAX)
+			arrowSprites.clear ();
+		it = arrowSprites.insert (key, 
+					createArrowSprite (kind, south, speedBin, dirBin, color, antialias));
+	}
+	pix = it.value();
+	spritesMutex.unlock ();
+	pnt.drawImage (i-pix.width()/2, j-pix.height()/2, pix);
+}
+//---------------------------------------------------------------
+QImage GriddedPlotter::createArrowSprite (int kind, bool south, int speedBin,
+					int dirBin, QColor color, bool antialias)
+{
+	int r;		// the arrow is drawn at the center of the sprite
+	switch (kind) {
+		case SPRITE_WIND_BARBS  : r = windBarbuleSize/2 + 16; break;
+		case SPRITE_WIND_ARROW  : r = 3*windArrowSize/2 + 4; break;
+		default                 : r = 40;
+	}
+	QImage pix (2*r, 2*r, QImage::Format_ARGB32_Premultiplied);	// drawn in the map thread
+	pix.fill (Qt::transparent);
+	QPainter pnt (&pix);
+	pnt.setRenderHint (QPainter::Antialiasing, antialias);
+	
+	// a vector with the direction and the speed of the bin (m/s)
+	double ang = dirBin*2*M_PI/SPRITES_NB_DIRS;
+	double vkn;
+	switch (kind) {
+		case SPRITE_WIND_BARBS :
+			if (speedBin == 0)
+				vkn = 0.5;
+			else if (speedBin == NB_BARBS_SPEEDS)
+				vkn = barbsSpeeds [NB_BARBS_SPEEDS-1] + 5;
+			else
+				vkn = (barbsSpeeds[speedBin-1] + barbsSpeeds[speedBin])/2;
+			break;
+		case SPRITE_CURRENT_ARROW :
+			vkn = speedBin/20.0;
+			break;
+		default :
+			vkn = 10;
+	}
+	double v = vkn*1.852/3.6;
+	double vx = -v*cos(ang);
+	double vy =  v*sin(ang);
+	
+	QColor oldWindColor = windArrowColor;
+	switch (kind) {
+		case SPRITE_WIND_BARBS :
+			drawWindArrowWithBarbs_static (pnt, r, r, vx, vy, south, color,
+										   windBarbuleSize, thinWindArrows);
+			break;
+		case SPRITE_WIND_ARROW :
+			windArrowColor = color;
+			drawWindArrow_direct (pnt, r, r, vx, vy);
+			windArrowColor = oldWindColor;
+			break;
+		default :
+			drawCurrentArrow_direct (pnt, r, r, vx, vy);
+	}
+	pnt.end ();
+	return pix;
+}
+
 //==========================================================================
 // Rectangle translucide sur la zone couverte par les données
 void GriddedPlotter::draw_CoveredZone 
@@ -401,16 +525,18 @@ void  GriddedPlotter::drawColorMapGeneric_1D (
 	)
 {
 	//DBGQS (Util::formatDateTimeLong(currentDate)); 
-	GriddedRecord *rec = getReader()->getRecord (dtc, currentDate);
+	GriddedRecord *rec = getReader()->getRecordAtDate (dtc, currentDate);
     if (rec == NULL || !rec->isOk())
         return;
+	// coarser level of detail when grid cells are smaller than 2 pixels
+	GridPyramidPtr pyr = rec->getPyramid (dtc);
+	int level = pyr ? getVisibleGridLevel (proj, pyr, 2) : 0;
     int i, j;
     double x, y, v;
     int W = proj->getW();
     int H = proj->getH();
     QRgb   rgb;
-    QImage *image = new QImage(W,H,QImage::Format_ARGB32);
-    image->fill( qRgba(0,0,0,0));
+    QImage *image = & RenderBuffer::getImage (colorMapImage, W, H);
     for (i=0; i<W-1; i+=2) {
         for (j=0; j<H-1; j+=2)
         {
@@ -419,7 +545,10 @@ void  GriddedPlotter::drawColorMapGeneric_1D (
                 x += 360.0;    // tour complet ?
             if (rec->isPointInMap(x, y))
             {
-                v = rec->getInterpolatedValue (dtc, x, y, mustInterpolateValues);
+                if (level > 0)
+                	v = pyr->getInterpolatedValue (level, x, y, mustInterpolateValues);
+                else
+                	v = rec->getInterpolatedValue (dtc, x, y, mustInterpolateValues);
                 if (v != GRIB_NOTDEF)
                 {
                     rgb = (this->*function_getColor) (v, smooth);
@@ -432,7 +561,6 @@ void  GriddedPlotter::drawColorMapGeneric_1D (
         }
     }
 	pnt.drawImage(0,0,*image);
-    delete image;
 }
 //--------------------------------------------------------------------------
 // Carte de couleurs générique en dimension 2
@@ -444,17 +572,19 @@ void  GriddedPlotter::drawColorMapGeneric_2D (
 	)
 {
 	//DBGQS (Util::formatDateTimeLong(currentDate)); 
-	GriddedRecord *recX = getReader()->getRecord (dtcX, currentDate);
-	GriddedRecord *recY = getReader()->getRecord (dtcY, currentDate);
+	GriddedRecord *recX = getReader()->getRecordAtDate (dtcX, currentDate);
+	GriddedRecord *recY = getReader()->getRecordAtDate (dtcY, currentDate);
     if (recX == NULL || !recX->isOk() || recY == NULL || !recY->isOk())
         return;
+	// coarse levels: mean of the norms (not the norm of the mean vector)
+	GridPyramidPtr pyr = recX->getNormPyramid (dtcX, recY, dtcY);
+	int level = pyr ? getVisibleGridLevel (proj, pyr, 2) : 0;
     int i, j;
     double x, y, vx, vy, v;
     int W = proj->getW();
     int H = proj->getH();
     QRgb   rgb;
-    QImage *image = new QImage(W,H,QImage::Format_ARGB32);
-    image->fill( qRgba(0,0,0,0));
+    QImage *image = & RenderBuffer::getImage (colorMapImage, W, H);
     for (i=0; i<W-1; i+=2) {
         for (j=0; j<H-1; j+=2)
         {
@@ -464,12 +594,18 @@ void  GriddedPlotter::drawColorMapGeneric_2D (
                 x += 360.0;    // tour complet ?
             if (recX->isPointInMap(x, y))
             {
-                vx = recX->getInterpolatedValue (dtcX, x, y, mustInterpolateValues);
-                vy = recY->getInterpolatedValue (dtcY, x, y, mustInterpolateValues);
+                if (level > 0) {
+                	v = pyr->getInterpolatedValue (level, x, y, mustInterpolateValues);
+                }
+                else {
+                	vx = recX->getInterpolatedValue (dtcX, x, y, mustInterpolateValues);
+                	vy = recY->getInterpolatedValue (dtcY, x, y, mustInterpolateValues);
+                	v = (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF) ?
+                			sqrt(vx*vx+vy*vy) : GRIB_NOTDEF;
+                }
 				
-                if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF)
+                if (v != GRIB_NOTDEF)
                 {
-                    v = sqrt(vx*vx+vy*vy);
                     rgb = (this->*function_getColor) (v, smooth);
                     image->setPixel(i,  j, rgb);
                     image->setPixel(i+1,j, rgb);
@@ -480,7 +616,6 @@ void  GriddedPlotter::drawColorMapGeneric_2D (
         }
     }
 	pnt.drawImage(0,0,*image);
-    delete image;
 }
 //--------------------------------------------------------------------------
 // Carte de couleurs générique de la différence entre 2 champs
@@ -491,17 +626,19 @@ void  GriddedPlotter::drawColorMapGeneric_Abs_Delta_Data (
 		QRgb (DataColors::*function_getColor) (double v, bool smooth)
 	)
 {
-	GriddedRecord *rec1 = getReader()->getRecord (dtc1, currentDate);
-	GriddedRecord *rec2 = getReader()->getRecord (dtc2, currentDate);
+	GriddedRecord *rec1 = getReader()->getRecordAtDate (dtc1, currentDate);
+	GriddedRecord *rec2 = getReader()->getRecordAtDate (dtc2, currentDate);
     if (rec1 == NULL || !rec1->isOk() || rec2 == NULL || !rec2->isOk())
         return;
+	GridPyramidPtr pyr1 = rec1->getPyramid (dtc1);
+	GridPyramidPtr pyr2 = rec2->getPyramid (dtc2);
+	int level = (pyr1 && pyr2) ? getVisibleGridLevel (proj, pyr1, 2) : 0;
     int i, j;
     double x, y, vx, vy, v;
     int W = proj->getW();
     int H = proj->getH();
     QRgb   rgb;
-    QImage *image = new QImage(W,H,QImage::Format_ARGB32);
-    image->fill( qRgba(0,0,0,0));
+    QImage *image = & RenderBuffer::getImage (colorMapImage, W, H);
     for (i=0; i<W-1; i+=2) {
         for (j=0; j<H-1; j+=2)
         {
@@ -511,8 +648,14 @@ void  GriddedPlotter::drawColorMapGeneric_Abs_Delta_Data (
                 x += 360.0;    // tour complet ?
             if (rec1->isPointInMap(x, y))
             {
-                vx = rec1->getInterpolatedValue (dtc1, x, y, mustInterpolateValues);
-                vy = rec2->getInterpolatedValue (dtc2, x, y, mustInterpolateValues);
+                if (level > 0) {
+                	vx = pyr1->getInterpolatedValue (level, x, y, mustInterpolateValues);
+                	vy = pyr2->getInterpolatedValue (level, x, y, mustInterpolateValues);
+                }
+                else {
+                	vx = rec1->getInterpolatedValue (dtc1, x, y, mustInterpolateValues);
+                	vy = rec2->getInterpolatedValue (dtc2, x, y, mustInterpolateValues);
+                }
 
                 if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF)
                 {
@@ -527,7 +670,6 @@ void  GriddedPlotter::drawColorMapGeneric_Abs_Delta_Data (
         }
     }
 	pnt.drawImage(0,0,*image);
-    delete image;
 }
 
 
@@ -549,7 +691,8 @@ void GriddedPlotter::draw_listIsolines_labels (
 						double offset,
 						QColor &color,
 						QPainter &pnt, const Projection *proj, 
-						int density 	// default -1
+						int density, 	// default -1
+						LabelPlacer *placer		// default NULL
 					)
 {
     std::vector <IsoLine *>::iterator it;
@@ -569,11 +712,24 @@ void GriddedPlotter::draw_listIsolines_labels (
 		if (density < 20)
 			density = 20;
 	}
-    first = 0; 
-    for(it=listIsolines.begin(); it!=listIsolines.end(); it++)
+    // Round values are labelled first (1000 hPa before 1004 hPa)
+    std::vector <std::pair<int,int> > order;
+    for (size_t k=0; k < listIsolines.size(); k++) {
+		int v = qRound (listIsolines[k]->getValue()*coef+offset);
+		int prio = 0;
+		if (v == 0)
+			prio = 10;
+		else
+			for ( ; v%10 == 0; v /= 10)
+				prio ++;
+		order.push_back (std::make_pair(-prio, (int)k));
+	}
+	std::stable_sort (order.begin(), order.end());
+    for (size_t k=0; k < order.size(); k++)
     {
-        first += 20;
-        (*it)->drawIsoLineLabels (pnt, color, proj, density, first, coef,offset);
+        int n = order[k].second;
+        first = 20*(n+1);
+        listIsolines[n]->drawIsoLineLabels (pnt, color, proj, density, first, coef,offset, placer);
     }
 }
 //----------------------------------------------------
@@ -588,12 +744,31 @@ void GriddedPlotter::complete_listIsolines (
     if (reader == NULL) {
         return;
     }   
-    GriddedRecord *rec = reader->getRecord (dtc, currentDate);
+    GriddedRecord *rec = reader->getRecordAtDate (dtc, currentDate);
     if (rec == NULL)
         return;
 	int deltaI, deltaJ;
 	analyseVisibleGridDensity (proj, rec, 16, &deltaI, &deltaJ);
 	//DBG("deltaI=%d deltaJ=%d", deltaI, deltaJ);
+	// Only the values present in the visible part of the grid
+	GridPyramidPtr pyr = rec->getPyramid (dtc);
+	std::vector <int> cols, rows;
+	if (pyr && dataStep > 0)
+		getVisibleGridIndexes (rec, proj, 0, cols, rows);
+	if (!cols.empty() && !rows.empty()) {
+		double vmin, vmax;
+		int i0 = *std::min_element (cols.begin(), cols.end());
+		int i1 = *std::max_element (cols.begin(), cols.end());
+		int j0 = *std::min_element (rows.begin(), rows.end());
+		int j1 = *std::max_element (rows.begin(), rows.end());
+		int mi = deltaI+1, mj = deltaJ+1;		// cells crossing the borders
+		if (! pyr->getRegionMinMax (i0-mi, j0-mj, i1+mi, j1+mj, &vmin, &vmax))
+			return;
+		if (vmin > dataMin)
+			dataMin += floor ((vmin-dataMin)/dataStep)*dataStep;
+		if (vmax < dataMax)
+			dataMax = vmax;
+	}
 	IsoLine *iso;
 	for (double val=dataMin; val<=dataMax; val += dataStep)
 	{
@@ -632,18 +807,98 @@ void GriddedPlotter::analyseVisibleGridDensity
 	if (*deltaJ < 1)
 		*deltaJ = 1;
 }
+//-----------------------------------------------------------------
+void GriddedPlotter::getVisibleGridIndexes 
+		(const GriddedRecord *rec, const Projection *proj, int margin,
+		 std::vector <int> &cols, std::vector <int> &rows)
+{
+	int W = proj->getW();
+	int H = proj->getH();
+	int i, j;
+	double x, y;
+	cols.clear ();
+	rows.clear ();
+	// cylindrical projections : i depends only on x, j only on y
+	y = proj->getCY();
+	for (int gi=0; gi<rec->getNi(); gi++) {
+		x = rec->getX(gi);
+		if (! rec->isXInMap(x))
+			x += 360.0;   // tour du monde ?
+		proj->map2screen (x,y, &i,&j);
+		if (i > W)
+			proj->map2screen (x-360,y, &i,&j);
+		if (i >= -margin && i <= W+margin)
+			cols.push_back (gi);
+	}
+	x = proj->getCX();
+	for (int gj=0; gj<rec->getNj(); gj++) {
+		proj->map2screen (x,rec->getY(gj), &i,&j);
+		if (j >= -margin && j <= H+margin)
+			rows.push_back (gj);
+	}
+}
+//-----------------------------------------------------------------
+// Coarsest level of detail with cells not larger than nbpixels
+// at the center of the screen.
+//-----------------------------------------------------------------
+int GriddedPlotter::getVisibleGridLevel 
+		(const Projection *proj, const GridPyramidPtr &pyr, double nbpixels)
+{
+	double x0,y0, x1,y1;
+	int i0 = proj->getW()/2;
+	int j0 = proj->getH()/2;
+	proj->screen2map (i0,j0, &x0,&y0);
+	proj->screen2map (i0+1,j0+1, &x1,&y1);
+	return pyr->getLevelForCellSize (nbpixels*fabs(x1-x0), nbpixels*fabs(y1-y0));
+}
+//-----------------------------------------------------------------
+// Cells of a level of detail visible on the screen
+//-----------------------------------------------------------------
+void GriddedPlotter::getVisibleGridIndexes 
+		(const GriddedRecord *rec, const GridPyramidPtr &pyr, int level,
+		 const Projection *proj, int margin,
+		 std::vector <int> &cols, std::vector <int> &rows)
+{
+	int W = proj->getW();
+	int H = proj->getH();
+	int i, j;
+	double x, y;
+	cols.clear ();
+	rows.clear ();
+	y = proj->getCY();
+	int ni = pyr->getNi (level);
+	for (int gi=0; gi<ni; gi++) {
+		x = pyr->getX (level, gi);
+		if (! rec->isXInMap(x))
+			x += 360.0;   // tour du monde ?
+		proj->map2screen (x,y, &i,&j);
+		if (i > W)
+			proj->map2screen (x-360,y, &i,&j);
+		if (i >= -margin && i <= W+margin)
+			cols.push_back (gi);
+	}
+	x = proj->getCX();
+	int nj = pyr->getNj (level);
+	for (int gj=0; gj<nj; gj++) {
+		proj->map2screen (x, pyr->getY(level,gj), &i,&j);
+		if (j >= -margin && j <= H+margin)
+			rows.push_back (gj);
+	}
+}
 //======================================================================
 void GriddedPlotter::draw_DATA_Labels (
 				DataCode dtc, 
 				QFont 	 labelsFont,
 				QColor   labelsColor,
 				QString  (formatLabelFunction) (float v, bool withUnit),
-				QPainter &pnt, const Projection *proj)
+				QPainter &pnt, const Projection *proj,
+				LabelPlacer *placer		// default NULL
+		)
 {
 	GriddedReader *reader = getReader();
     if (reader == NULL)
         return;
-	GriddedRecord *rec = reader->getRecord (dtc, currentDate);
+	GriddedRecord *rec = reader->getRecordAtDate (dtc, currentDate);
 	if (rec == NULL)
 		return;
     QFontMetrics fmet (labelsFont);
@@ -654,13 +909,21 @@ void GriddedPlotter::draw_DATA_Labels (
     int i, j, dimin, djmin;
     dimin = 50;
     djmin = 30;
+    int wlabel = fmet.width("XXX");
     for (j=0; j<proj->getH(); j+= djmin) {
         for (i=0; i<proj->getW(); i+= dimin) {
             proj->screen2map(i,j, &x,&y);
             v = rec->getInterpolatedValue (dtc, x, y, mustInterpolateValues);
             if (v!= GRIB_NOTDEF) {
                 QString strtemp = formatLabelFunction (v,false);
-                pnt.drawText(i-fmet.width("XXX")/2, j+fmet.ascent()/2, strtemp);
+                int x0 = i-wlabel/2;
+                int y0 = j+fmet.ascent()/2;
+                if (placer != NULL) {
+					QSize sz = placer->textSize (labelsFont, strtemp);
+					if (! placer->place (QRect(x0, y0-fmet.ascent(), sz.width(), sz.height())))
+						continue;
+				}
+                pnt.drawText(x0, y0, strtemp);
             }
         }
     } 
@@ -678,58 +941,34 @@ void GriddedPlotter::draw_DATA_MinMax (
 	GriddedReader *reader = getReader();
     if (reader == NULL)
         return;
-	GriddedRecord *rec = reader->getRecord (dtc, currentDate);
+	GriddedRecord *rec = reader->getRecordAtDate (dtc, currentDate);
 	if (rec == NULL)
 		return;
     QFontMetrics fmet (labelsFont);
     pnt.setFont (labelsFont);
     pnt.setPen  (labelsColor);
 
-    int i, j, Ni, Nj, pi,pj;
-    double x, y, v;
-          
-    Ni = rec->getNi();
-    Nj = rec->getNj();
-
-    for (j=1; j<Nj-1; j++) {     // !!!! 1 to end-1
-        for (i=1; i<Ni-1; i++) {
-            v = rec->getValueOnRegularGrid (dtc, i, j );
-            if ( v < meanValue
-                   && v < rec->getValueOnRegularGrid (dtc, i-1, j-1 )  // Minima local ?
-                   && v < rec->getValueOnRegularGrid (dtc, i-1, j   )
-                   && v < rec->getValueOnRegularGrid (dtc, i-1, j+1 )
-                   && v < rec->getValueOnRegularGrid (dtc, i  , j-1 )
-                   && v < rec->getValueOnRegularGrid (dtc, i  , j+1 )
-                   && v < rec->getValueOnRegularGrid (dtc, i+1, j-1 )
-                   && v < rec->getValueOnRegularGrid (dtc, i+1, j   )
-                   && v < rec->getValueOnRegularGrid (dtc, i+1, j+1 )
-            ) {
-                x = rec->getX(i);
-                y = rec->getY(j);
-                proj->map2screen(x,y, &pi, &pj);
-                pnt.drawText(pi-fmet.width('L')/2, pj+fmet.ascent()/2, minSymbol);
-                proj->map2screen(x-360.0,y, &pi, &pj);
-                pnt.drawText(pi-fmet.width('L')/2, pj+fmet.ascent()/2, minSymbol);
-            }
-            else if ( v > meanValue
-                   && v > rec->getValueOnRegularGrid (dtc, i-1, j-1 )  // Maxima local ?
-                   && v > rec->getValueOnRegularGrid (dtc, i-1, j   )
-                   && v > rec->getValueOnRegularGrid (dtc, i-1, j+1 )
-                   && v > rec->getValueOnRegularGrid (dtc, i  , j-1 )
-                   && v > rec->getValueOnRegularGrid (dtc, i  , j+1 )
-                   && v > rec->getValueOnRegularGrid (dtc, i+1, j-1 )
-                   && v > rec->getValueOnRegularGrid (dtc, i+1, j   )
-                   && v > rec->getValueOnRegularGrid (dtc, i+1, j+1 )
-            ) {
-                x = rec->getX(i);
-                y = rec->getY(j);
-                proj->map2screen(x,y, &pi, &pj);
-                pnt.drawText(pi-fmet.width('H')/2, pj+fmet.ascent()/2, maxSymbol);
-                proj->map2screen(x-360.0,y, &pi, &pj);
-                pnt.drawText(pi-fmet.width('H')/2, pj+fmet.ascent()/2, maxSymbol);
-            }
-        }
-    }
+    int pi,pj;
+    double x, y;
+	GridPyramidPtr pyr = rec->getPyramid (dtc);
+	if (! pyr)
+		return;
+	// local extrema are computed once for the record
+	const std::vector <GridExtremum> &extrema = pyr->getLocalExtrema ();
+	for (size_t k=0; k<extrema.size(); k++)
+	{
+		const GridExtremum &ext = extrema[k];
+		if (ext.isMax ? ext.value <= meanValue : ext.value >= meanValue)
+			continue;
+		const QString &symbol = ext.isMax ? maxSymbol : minSymbol;
+		int dx = fmet.width(ext.isMax ? 'H' : 'L')/2;
+		x = rec->getX(ext.i);
+		y = rec->getY(ext.j);
+		proj->map2screen(x,y, &pi, &pj);
+		pnt.drawText(pi-dx, pj+fmet.ascent()/2, symbol);
+		proj->map2screen(x-360.0,y, &pi, &pj);
+		pnt.drawText(pi-dx, pj+fmet.ascent()/2, symbol);
+	}
 }
 
 //------------------------------------------------------------
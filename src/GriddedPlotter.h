@@ -29,10 +29,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QApplication>
 #include <QPainter>
+#include <QHash>
+#include <QMutex>
 
 #include "DataMeteoAbstract.h"
 #include "DataColors.h"
 #include "GriddedReader.h"
+#include "GridPyramid.h"
 #include "Projection.h"
 #include "IsoLine.h"
 #include "Util.h"
@@ -51,8 +54,10 @@ class GriddedPlotter :
 		virtual bool  isReaderOk () const = 0;
 		virtual GriddedReader *getReader () const = 0;
 		virtual void  loadFile (QString fileName, 
-								LongTaskProgress *taskProgress,
-								int nbrecs=0) = 0;
+								LongTaskProgress *taskProgress) = 0;
+		// After the loading, under Terrain::lockData: the values of the
+		// records may then be released by GribRecordCache::trim
+		virtual void  enableRecordCache ()  {}
 		
 		virtual void  updateGraphicsParameters ();
 		
@@ -102,6 +107,8 @@ class GriddedPlotter :
 							{mustDuplicateMissingWaveRecords = b;}
 		virtual void setUseJetStreamColorMap (bool b)
 							{useJetStreamColorMap = b;}
+		bool    getUseJetStreamColorMap () const
+							{return useJetStreamColorMap;}
         virtual Altitude getWindAltitude () 
 							{return windAltitude;}
 		
@@ -118,7 +125,8 @@ class GriddedPlotter :
 						QFont 	 labelsFont,
 						QColor   labelsColor,
 						QString  (formatLabelFunction) (float v, bool withUnit),
-						QPainter &pnt, const Projection *proj);
+						QPainter &pnt, const Projection *proj,
+						LabelPlacer *placer = NULL);
 
 		/** Pressure: write H and L at hight and low points (pressure).
 		*/
@@ -193,7 +201,8 @@ class GriddedPlotter :
 						QColor &color,
 						QPainter &pnt, 
 						const Projection *proj,
-						int density = -1
+						int density = -1,
+						LabelPlacer *placer = NULL
   					);
 
 						
@@ -208,6 +217,13 @@ class GriddedPlotter :
         			bool south,
         			QColor arrowColor=Qt::white);
 		
+		// Same drawing, copied from a cache of pre-rendered arrows
+		void drawWindArrowWithBarbs_sprite (
+        			QPainter &pnt, int i, int j,
+        			double vx, double vy,
+        			bool south,
+        			QColor arrowColor);
+		
 		static void drawWindArrowWithBarbs_static (
         			QPainter &pnt, int i, int j,
         			double vx, double vy,
@@ -250,6 +266,7 @@ class GriddedPlotter :
 		int    currentArrowSpace;        // distance mini entre flèches (pixels)
         int    currentArrowSpaceOnGrid;  // distance mini entre flèches si affichage sur grille
 
+        // Arrows on the map (pre-rendered sprites)
         void    drawWindArrow (QPainter &pnt, int i, int j, double vx, double vy);
         void    drawWaveArrow (QPainter &pnt, int i, int j, double dir, double period);
         void    drawCurrentArrow (QPainter &pnt, int i, int j, double vx, double vy);
@@ -273,12 +290,35 @@ class GriddedPlotter :
 		
 		void analyseVisibleGridDensity (const Projection *proj, GriddedRecord *rec, 
 										double coef, int *deltaI, int *deltaJ);
+		// Grid columns and rows visible on the screen (margin in pixels)
+		void getVisibleGridIndexes (const GriddedRecord *rec, const Projection *proj,
+								int margin, std::vector <int> &cols, std::vector <int> &rows);
+		// Same on a level of detail of the grid
+		void getVisibleGridIndexes (const GriddedRecord *rec,
+								const GridPyramidPtr &pyr, int level,
+								const Projection *proj, int margin,
+								std::vector <int> &cols, std::vector <int> &rows);
+		// Level of detail with cells of about nbpixels on the screen
+		int  getVisibleGridLevel (const Projection *proj, const GridPyramidPtr &pyr,
+								double nbpixels);
 
 		
 	private:
         int    windArrowSize;         // longueur des flèches
         int    windBarbuleSize;       // longueur des flèches
 
+        enum { SPRITE_WIND_ARROW, SPRITE_WIND_BARBS, SPRITE_CURRENT_ARROW };
+        QHash <quint64,QImage> arrowSprites;	// key: color, speed, direction...
+        QMutex  spritesMutex;		// map thread and meteo tables (GUI thread)
+        QImage  colorMapImage;		// reused by the color maps (size of the view)
+        
+        void    drawArrowSprite (QPainter &pnt, int i, int j,
+        					int kind, bool south, int speedBin, double ang, QColor color);
+        QImage  createArrowSprite (int kind, bool south, int speedBin,
+        					int dirBin, QColor color, bool antialias);
+        void    drawWindArrow_direct (QPainter &pnt, int i, int j, double vx, double vy);
+        void    drawCurrentArrow_direct (QPainter &pnt, int i, int j, double vx, double vy);
+        
         static void drawTransformedLine( QPainter &pnt,
                 double si, double co,int di, int dj, int i,int j, int k,int l);
         
@@ -43,6 +43,7 @@ class GriddedReader : public DataReaderAbstract
 		//virtual void openFile (const std::string fname) = 0;
 		long  getFileSize ()          {return fileSize;}
 		std::string getFileName ()    {return fileName;}
+		void  setFileName (const std::string &fname)  {fileName = fname;}
 
 		/// Give the englobing rectangle of all data.
 		virtual bool getZoneExtension 
@@ -75,6 +76,9 @@ class GriddedReader : public DataReaderAbstract
 													 
 		virtual GriddedRecord *getFirstRecord() = 0;
 		virtual GriddedRecord *getRecord (DataCode dtc, time_t date) = 0;
+		// Record drawn at this date (may be interpolated between 2 dates)
+		virtual GriddedRecord *getRecordAtDate (DataCode dtc, time_t date)
+							{return getRecord (dtc, date);}
 		
 		virtual std::set<DataCode> getAllDataCode () const {return setAllDataCode;}
 		virtual bool hasData (const DataCode &dtc) const;
@@ -17,15 +17,86 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include <cstdlib>
+#include <cassert>
+
+#include <QAtomicInt>
+
 #include "GriddedRecord.h"
+#include "GridPyramid.h"
 #include "Util.h"
 
+static QAtomicInt GLOB_dataSerial;
+
 //------------------------------------------------------------
 GriddedRecord::GriddedRecord ()
 {
 	dataCenterModel = OTHER_DATA_CENTER;
 	duplicated = false;
 	entireWorldInLongitude = false;
+	dataSerial = GLOB_dataSerial.fetchAndAddOrdered (1) + 1;
+}
+//------------------------------------------------------------
+void GriddedRecord::dataChanged ()
+{
+	pyramidCache.clear ();
+	dataSerial = GLOB_dataSerial.fetchAndAddOrdered (1) + 1;
+}
+
+//------------------------------------------------------------
+void GridPyramidCache::clear ()
+{
+	QMutexLocker lock (&mutex);
+	pyramids.clear ();
+	norms.clear ();
+}
+//------------------------------------------------------------
+long GridPyramidCache::getMemorySize ()
+{
+	QMutexLocker lock (&mutex);
+	long size = 0;
+	std::map <DataCode, GridPyramidPtr>::iterator it;
+	for (it=pyramids.begin(); it!=pyramids.end(); it++)
+		size += it->second->getMemorySize ();
+	std::map <NormKey, std::pair <int,GridPyramidPtr> >::iterator itn;
+	for (itn=norms.begin(); itn!=norms.end(); itn++)
+		size += itn->second.second->getMemorySize ();
+	return size;
+}
+//------------------------------------------------------------
+GridPyramidPtr GriddedRecord::getPyramid (const DataCode &dtc) const
+{
+	if (!isOk() || !isRegularGrid() || getNi()<=0 || getNj()<=0)
+		return GridPyramidPtr ();
+	QMutexLocker lock (&pyramidCache.mutex);
+	std::map <DataCode, GridPyramidPtr>::iterator it
+						= pyramidCache.pyramids.find (dtc);
+	if (it != pyramidCache.pyramids.end())
+		return it->second;
+	GridPyramidPtr pyr (new GridPyramid (this, dtc));
+	assert (pyr);
+	pyramidCache.pyramids [dtc] = pyr;
+	return pyr;
+}
+//------------------------------------------------------------
+GridPyramidPtr GriddedRecord::getNormPyramid (const DataCode &dtc,
+						const GriddedRecord *recY, const DataCode &dtcY) const
+{
+	if (!isOk() || !isRegularGrid() || getNi()<=0 || getNj()<=0
+			|| recY==NULL || !recY->isOk() || !recY->isRegularGrid()
+			|| recY->getNi()!=getNi() || recY->getNj()!=getNj())
+		return GridPyramidPtr ();
+	QMutexLocker lock (&pyramidCache.mutex);
+	GridPyramidCache::NormKey key (recY, dtcY);
+	std::map <GridPyramidCache::NormKey, std::pair <int,GridPyramidPtr> >::iterator it
+						= pyramidCache.norms.find (key);
+	// an other record at the same address, or modified values
+	if (it != pyramidCache.norms.end()
+			&& it->second.first == recY->getDataSerial())
+		return it->second.second;
+	GridPyramidPtr pyr (new GridPyramid (this, dtc, recY, dtcY));
+	assert (pyr);
+	pyramidCache.norms [key] = std::make_pair (recY->getDataSerial(), pyr);
+	return pyr;
 }
 
 //=====================================================================
@@ -21,10 +21,41 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cstdio>
 #include <cmath>
+#include <map>
+
+#include <QMutex>
+#include <QSharedPointer>
 
 #include "DataDefines.h"
 #include "DataMeteoAbstract.h"
 
+class GridPyramid;
+class GriddedRecord;
+typedef QSharedPointer <GridPyramid> GridPyramidPtr;
+
+//====================================================================
+// Levels of detail of a record, by data code, and norms of the
+// vectors made with an other record (serial of its values).
+// They are never copied with the record.
+// clear only drops the references: a pyramid in use is deleted
+// by its last user.
+//====================================================================
+class GridPyramidCache
+{
+	public:
+		GridPyramidCache () {}
+		GridPyramidCache (const GridPyramidCache &) {}
+		GridPyramidCache & operator= (const GridPyramidCache &) {return *this;}
+		
+		void  clear ();
+		long  getMemorySize ();
+		
+		typedef std::pair <const GriddedRecord *, DataCode>  NormKey;
+		std::map <DataCode, GridPyramidPtr> pyramids;
+		std::map <NormKey, std::pair <int,GridPyramidPtr> > norms;
+		QMutex mutex;
+};
+
 //====================================================================
 class GriddedRecord : public DataRecordAbstract
 {
@@ -76,6 +107,20 @@ class GriddedRecord : public DataRecordAbstract
         virtual double  getDeltaX () const = 0;
         virtual double  getDeltaY () const = 0;
 								
+        /** Levels of detail of a field (NULL if the grid is not regular).
+			Must be cleared (dataChanged) when grid values are modified.
+		*/
+		GridPyramidPtr getPyramid (const DataCode &dtc) const;
+        /** Levels of detail of the norm of the vector (this, recY),
+			same grid for both records.
+		*/
+		GridPyramidPtr getNormPyramid (const DataCode &dtc,
+							const GriddedRecord *recY, const DataCode &dtcY) const;
+		long  getPyramidsMemorySize () const
+						{return pyramidCache.getMemorySize();}
+		// Changes when grid values are modified
+		int   getDataSerial () const   {return dataSerial;}
+		
         virtual int    getTotalNumberOfPoints ()  const = 0;
         virtual double getAveragePointsDensity () const = 0;
 		
@@ -92,6 +137,12 @@ class GriddedRecord : public DataRecordAbstract
 		double xmin,xmax, ymin,ymax;
 		bool   duplicated;
 		DataCenterModel    dataCenterModel;
+		void  dataChanged ();
+		void  releasePyramids ()   {pyramidCache.clear();}
+	
+	private:
+		mutable GridPyramidCache pyramidCache;
+		int    dataSerial;
 };
 
 
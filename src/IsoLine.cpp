@@ -37,19 +37,13 @@ IsoLine::IsoLine (DataCode dtc, double val, GriddedRecord *rec, int deltaI, int
 //---------------------------------------------------------------
 IsoLine::~IsoLine()
 {
-    std::vector <Segment *>::iterator it;
-    for (it=trace.begin(); it!=trace.end(); it++) {
-        delete *it;
-        *it = NULL;
-    }
-    trace.clear();
 }
 
 //---------------------------------------------------------------
 void IsoLine::drawIsoLine (QPainter &pnt,
                             const Projection *proj)
 {
-    std::vector <Segment *>::iterator it;
+    std::vector <Segment>::const_iterator it;
     int   a,b,c,d;
     int nb = 0;
 	pnt.setRenderHint(QPainter::Antialiasing, true);
@@ -59,7 +53,7 @@ void IsoLine::drawIsoLine (QPainter &pnt,
     //---------------------------------------------------------
     for (it=trace.begin(); it!=trace.end(); it++,nb++)
     {
-        Segment *seg = *it;
+        const Segment *seg = &(*it);
 
         // Teste la visibilité (bug clipping sous windows avec pen.setWidthF())
         if ( proj->isPointVisible(seg->px1, seg->py1)
@@ -83,9 +77,10 @@ void IsoLine::drawIsoLine (QPainter &pnt,
 //---------------------------------------------------------------
 void IsoLine::drawIsoLineLabels(QPainter &pnt, QColor &couleur,
                             const Projection *proj,
-                            int density, int first, double coef,double offset)
+                            int density, int first, double coef,double offset,
+                            LabelPlacer *placer)
 {
-    std::vector <Segment *>::iterator it;
+    std::vector <Segment>::const_iterator it;
     int   a,b,c,d;
     int nb = first;
     QString label;
@@ -95,7 +90,9 @@ void IsoLine::drawIsoLineLabels(QPainter &pnt, QColor &couleur,
     QPen penText(couleur);
     QFont fontText = Font::getFont(FONT_IsolineLabel);
     QFontMetrics fmet(fontText);
-    QRect rect = fmet.boundingRect(label);
+    QSize sz = placer ? placer->textSize(fontText, label)
+                      : fmet.boundingRect(label).size();
+    QRect rect (QPoint(0,0), sz);
     pnt.setPen(penText);
     pnt.setFont(fontText);
 
@@ -112,23 +109,30 @@ void IsoLine::drawIsoLineLabels(QPainter &pnt, QColor &couleur,
     for (it=trace.begin(); it!=trace.end(); it++,nb++)
     {
         if (nb % density == 0) {
-            Segment *seg = *it;
-    		rect = fmet.boundingRect(label);
+            const Segment *seg = &(*it);
             proj->map2screen( seg->px1, seg->py1, &a, &b );
             proj->map2screen( seg->px2, seg->py2, &c, &d );
             rect.moveTo((a+c)/2-rect.width()/2, (b+d)/2-rect.height()/2);
-            pnt.drawRect(rect.x()-1, rect.y(), rect.width()+2, fmet.ascent()+2);
-            pnt.drawText(rect, Qt::AlignHCenter|Qt::AlignVCenter, label);
+            drawLabel (pnt, rect, fmet.ascent(), label, placer);
 
             // tour du monde ?
             proj->map2screen( seg->px1-360.0, seg->py1, &a, &b );
             proj->map2screen( seg->px2-360.0, seg->py2, &c, &d );
             rect.moveTo((a+c)/2-rect.width()/2, (b+d)/2-rect.height()/2);
-            pnt.drawRect(rect.x()-1, rect.y(), rect.width()+2, fmet.ascent()+2);
-            pnt.drawText(rect, Qt::AlignHCenter|Qt::AlignVCenter, label);
+            drawLabel (pnt, rect, fmet.ascent(), label, placer);
         }
     }
 }
+//---------------------------------------------------------------
+void IsoLine::drawLabel (QPainter &pnt, const QRect &rect, int ascent,
+						 const QString &label, LabelPlacer *placer)
+{
+	QRect box (rect.x()-1, rect.y(), rect.width()+2, ascent+2);
+	if (placer!=NULL && !placer->place(box))
+		return;
+	pnt.drawRect(box);
+	pnt.drawText(rect, Qt::AlignHCenter|Qt::AlignVCenter, label);
+}
 //==================================================================================
 // Segment
 //==================================================================================
@@ -218,35 +222,35 @@ void IsoLine::extractIsoLine (GriddedRecord *rec, int deltaI, int deltaJ)
             //--------------------------------
             if     ((a<=value && b<=value && c<=value  && d>value)
                  || (a>value && b>value && c>value  && d<=value))
-                trace.push_back(new Segment (i,j, 'c','d',  'b','d',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'c','d',  'b','d',rec,value,dtc,deltaI,deltaJ));
             else if ((a<=value && c<=value && d<=value  && b>value)
                  || (a>value && c>value && d>value  && b<=value))
-                trace.push_back(new Segment (i,j, 'a','b',  'b','d',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'a','b',  'b','d',rec,value,dtc,deltaI,deltaJ));
             else if ((c<=value && d<=value && b<=value  && a>value)
                  || (c>value && d>value && b>value  && a<=value))
-                trace.push_back(new Segment (i,j, 'a','b',  'a','c',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'a','b',  'a','c',rec,value,dtc,deltaI,deltaJ));
             else if ((a<=value && b<=value && d<=value  && c>value)
                  || (a>value && b>value && d>value  && c<=value))
-                trace.push_back(new Segment (i,j, 'a','c',  'c','d',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'a','c',  'c','d',rec,value,dtc,deltaI,deltaJ));
             //--------------------------------
             // 1 segment H ou V
             //--------------------------------
             else if ((a<=value && b<=value   &&  c>value && d>value)
                  || (a>value && b>value   &&  c<=value && d<=value))
-                trace.push_back(new Segment (i,j, 'a','c',  'b','d',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'a','c',  'b','d',rec,value,dtc,deltaI,deltaJ));
             else if ((a<=value && c<=value   &&  b>value && d>value)
                  || (a>value && c>value   &&  b<=value && d<=value))
-                trace.push_back(new Segment (i,j, 'a','b',  'c','d',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'a','b',  'c','d',rec,value,dtc,deltaI,deltaJ));
             //--------------------------------
             // 2 segments en diagonale
             //--------------------------------
             else if  (a<=value && d<=value   &&  c>value && b>value) {
-                trace.push_back(new Segment (i,j, 'a','b',  'b','d',rec,value,dtc,deltaI,deltaJ));
-                trace.push_back(new Segment (i,j, 'a','c',  'c','d',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'a','b',  'b','d',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'a','c',  'c','d',rec,value,dtc,deltaI,deltaJ));
             }
             else if  (a>value && d>value   &&  c<=value && b<=value) {
-                trace.push_back(new Segment (i,j, 'a','b',  'a','c',rec,value,dtc,deltaI,deltaJ));
-                trace.push_back(new Segment (i,j, 'b','d',  'c','d',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'a','b',  'a','c',rec,value,dtc,deltaI,deltaJ));
+                trace.push_back(Segment (i,j, 'b','d',  'c','d',rec,value,dtc,deltaI,deltaJ));
             }
 
         }
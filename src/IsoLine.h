@@ -34,6 +34,7 @@ Dessin des données GRIB (avec QT)
 #include "GriddedRecord.h"
 #include "Projection.h"
 #include "Util.h"
+#include "LabelPlacer.h"
 
 // TODO: join segments and draw a spline
 
@@ -82,10 +83,13 @@ class IsoLine
 
         void drawIsoLine (QPainter &pnt, const Projection *proj);
 
+        // placer : labels are written only where the place is free (if not NULL)
         void drawIsoLineLabels (QPainter &pnt, QColor &couleur, const Projection *proj,
-                                int density, int first, double coef, double offset);
+                                int density, int first, double coef, double offset,
+                                LabelPlacer *placer=NULL);
 
         int getNbSegments()     {return trace.size();}
+        double getValue()       {return value;}
 
     private:
         double value;
@@ -94,7 +98,10 @@ class IsoLine
 		DataCode dtc;
 
         QColor isoLineColor;
-        std::vector <Segment *> trace;
+        std::vector <Segment> trace;	// stored by value: one allocation for all
+
+        void drawLabel (QPainter &pnt, const QRect &rect, int ascent,
+                        const QString &label, LabelPlacer *placer);
 
         void intersectionAreteGrille (
 						int i,int j, int k,int l, double *x, double *y,
@@ -32,92 +32,72 @@ LongTaskProgress::LongTaskProgress (QWidget *parent)
 					 parent);
 	assert (progress);
 	progress->setMinimumWidth (300);
-	
 	progress->setWindowModality(Qt::WindowModal);
  	progress->setAutoClose (false);
  	progress->setAutoReset (false);
-	continueDownload = true; 
-	
+	lastValue = -1;
+	previewWanted = false;
+	qRegisterMetaType <GribReader *> ("GribReader*");
+	// direct calls from the GUI thread, queued from the loading thread
+	connect (this, SIGNAL(signalTitle(QString)), progress, SLOT(setWindowTitle(QString)));
+	connect (this, SIGNAL(signalValue(int)), this, SLOT(slotValue(int)));
+	connect (this, SIGNAL(signalVisible(bool)), progress, SLOT(setVisible(bool)));
+	connect (this, SIGNAL(signalMessage(QString)), progress, SLOT(setLabelText(QString)));
 	setWindowTitle (tr("Open file"));
 	setMessage (LTASK_OPEN_FILE);
 	setVisible (false);
-	
 	connect (progress,  SIGNAL(canceled()), this, SLOT(downloadCanceled()));
 }
-
 //------------------------------------------------------------
 LongTaskProgress::~LongTaskProgress ()
 {
 	if (progress)
 		delete progress;
 }
-
 //-------------------------------------------
 void LongTaskProgress::downloadCanceled ()
 { 
-	continueDownload = false;
+	cancel ();
 }
-
 //------------------------------------------------------------
 void LongTaskProgress::setWindowTitle (QString title)
 {
-	progress->setWindowTitle (title);
+	emit signalTitle (title);
 }
-
 //------------------------------------------------------------
 void LongTaskProgress::setValue (int value)
+{
+	if (lastValue.fetchAndStoreRelaxed (value) != value)	// one signal by percent
+		emit signalValue (value);
+}
+//------------------------------------------------------------
+void LongTaskProgress::slotValue (int value)
 {
 	progress->setValue (value);
 	progress->open ();
-	qApp->processEvents ();
 }
-
 //------------------------------------------------------------
 void LongTaskProgress::setVisible (bool vis)
 {
- 	progress->setVisible (vis);
-	qApp->processEvents ();
+	emit signalVisible (vis);
 }
-
 //------------------------------------------------------------
 void LongTaskProgress::setMessage (LongTaskMessageType msgtype)
 {
+	QString txt;
 	switch (msgtype) {
 		case LTASK_OPEN_FILE :
-			progress->setLabelText (QObject::tr("Loading file..."));
+			txt = QObject::tr("Loading file...");
 			break;
 		case LTASK_ANALYSE_DATA :
-			progress->setLabelText (QObject::tr("Analyse data..."));
+			txt = QObject::tr("Analyse data...");
 			break;
 		case LTASK_PREPARE_MAPS :
-			progress->setLabelText (QObject::tr("Prepare maps..."));
+			txt = QObject::tr("Prepare maps...");
 			break;
 		case LTASK_UNCOMPRESS_FILE :
-			progress->setLabelText (QObject::tr("Uncompress file..."));
+			txt = QObject::tr("Uncompress file...");
 			break;
 	}
-	
-	qApp->processEvents ();
+	emit signalMessage (txt);
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
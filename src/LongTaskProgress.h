@@ -20,6 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define LONGTASKPROGRESS_H
 
 #include <QProgressDialog>
+#include <QAtomicInt>
+
+class GribReader;
 
 //-----------------------------------------
 enum LongTaskMessageType
@@ -30,29 +33,51 @@ enum LongTaskMessageType
 		LTASK_UNCOMPRESS_FILE
 	};
 
+//-----------------------------------------
+// Progress dialog and cancellation of a file loaded in a thread.
+// The setters may be called from the loading thread:
+// the dialog is updated by queued signals.
 //-----------------------------------------
 class LongTaskProgress : public QObject
 { Q_OBJECT
-
 	public:
-			
 		LongTaskProgress (QWidget *parent=NULL);
 		~LongTaskProgress ();
-
+		
 		void setWindowTitle (QString title);
 		void setValue (int value);
 		void setVisible (bool vis);
 		void setMessage (LongTaskMessageType msgtype);
 		
-		QProgressDialog *progress;
+		// Cancellation token, read by the loading thread
+		bool isCanceled () const   {return canceled.load() != 0;}
+		void cancel ()             {canceled.store (1);}
+		
+		// Records of the first date, given before the end of the loading
+		// (the receiver of previewReady owns the reader)
+		bool isPreviewWanted () const    {return previewWanted;}
+		void setPreviewWanted (bool b)   {previewWanted = b;}
+		void setPreview (GribReader *reader)   {emit previewReady (reader);}
 		
-		volatile bool continueDownload;
+		QProgressDialog *progress;
 		
 	public slots :
 		void downloadCanceled ();
-};
-
-
 
+	signals:
+		void signalTitle   (QString title);
+		void signalValue   (int value);
+		void signalVisible (bool vis);
+		void signalMessage (QString txt);
+		void previewReady  (GribReader *reader);
+		
+	private slots :
+		void slotValue (int value);
+		
+	private:
+		QAtomicInt canceled;
+		QAtomicInt lastValue;
+		bool       previewWanted;
+};
 
 #endif
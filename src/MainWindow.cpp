@@ -39,6 +39,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "AngleConverterDialog.h"
 #include "DataQString.h"
 #include "CurveDrawer.h"
+#include "GribRecordCache.h"
 
 
 //-----------------------------------------------------------
@@ -69,7 +70,7 @@ void MainWindow::InitActionsStatus ()
     menuBar->acMap_Rivers->setChecked(Util::getSetting("showRivers", false).toBool());
     menuBar->acMap_LonLatGrid->setChecked(Util::getSetting("showLonLatGrid", true).toBool());
     menuBar->acMap_CountriesBorders->setChecked(Util::getSetting("showCountriesBorders", true).toBool());
-    menuBar->acMap_Orthodromie->setChecked(Util::getSetting("showOrthodromie", true).toBool());
+    menuBar->acMap_Orthodromie->setChecked(Util::getSetting("showOrthodromie", false).toBool());
     menuBar->acMap_AutoZoomOnGribArea->setChecked(Util::getSetting("autoZoomOnGribArea", true).toBool());
 
 	strdtc = DataCodeStr::serialize (DataCode(GRB_PRV_WIND_XY2D,LV_ABOV_GND,10));
@@ -106,7 +107,7 @@ void MainWindow::InitActionsStatus ()
     menuBar->acView_ColorMapSmooth->setChecked(Util::getSetting("colorMapSmooth", true).toBool());
     menuBar->acView_WindArrow->setChecked(Util::getSetting("showWindArrows", true).toBool());
     menuBar->acView_Barbules->setChecked(Util::getSetting("showBarbules", true).toBool());
-    menuBar->acView_ThinWindArrows->setChecked(Util::getSetting("thinWindArrows", true).toBool());
+    menuBar->acView_ThinWindArrows->setChecked(Util::getSetting("thinWindArrows", false).toBool());
 
     menuBar->acView_CurrentArrow->setChecked(Util::getSetting("showCurrentArrows", true).toBool());
 	
@@ -242,6 +243,9 @@ void MainWindow::connectSignals()
     connect(mb->ac_showSkewtDiagram, SIGNAL(triggered()), this, SLOT(slotShowSkewtDiagram()));
 
     connect(mb->acFile_Open, SIGNAL(triggered()), this, SLOT(slotFile_Open()));
+    connect(mb->acFile_OpenZone, SIGNAL(triggered()), this, SLOT(slotFile_OpenZone()));
+    connect(mb->acFile_OpenDataset, SIGNAL(triggered()), this, SLOT(slotFile_OpenDataset()));
+    connect(mb->acFile_SaveZone, SIGNAL(triggered()), this, SLOT(slotFile_SaveZone()));
     connect(mb->acFile_Close, SIGNAL(triggered()), this, SLOT(slotFile_Close()));
     connect(mb->acFile_NewInstance, SIGNAL(triggered()), this, SLOT(slotGenericAction()));
     connect(mb->acFile_Load_GRIB, SIGNAL(triggered()), this, SLOT(slotFile_Load_GRIB()));
@@ -402,6 +406,7 @@ mb->acMap_SelectMETARs->setVisible (false);	// TODO
     connect(dialogGraphicsParams, SIGNAL(accepted()), this, SLOT(updateGraphicsParameters()));
 
     connect(mb->acOptions_Proxy, SIGNAL(triggered()), dialogProxy, SLOT(exec()));
+    connect(mb->acOptions_RecordCache, SIGNAL(triggered()), dialogRecordCache, SLOT(exec()));
     connect(mb->acOptions_AngleConverter, SIGNAL(triggered()), this, SLOT(slotOpenAngleConverter()));
 
     connect(mb->acOptions_Language, SIGNAL(triggered()),
@@ -437,6 +442,8 @@ mb->acMap_SelectMETARs->setVisible (false);	// TODO
             this,  SLOT(slotMouseMoved(QMouseEvent *)));
     connect(terre, SIGNAL(mouseLeave(QEvent *)),
             this,  SLOT(slotMouseLeaveTerre(QEvent *)));
+    connect(terre, SIGNAL(meteoDataLoaded(FileDataType, QString)),
+            this,  SLOT(slotMeteoDataLoaded(FileDataType, QString)));
     //-----------------------------------------------------------
 	connect(mb->acAlt_GroupGeopotLine, SIGNAL(triggered(QAction *)),
 			this,  SLOT(slot_GroupGeopotentialLines (QAction *)));
@@ -508,6 +515,10 @@ MainWindow::MainWindow (int w, int h, bool withmblue, QWidget *parent)
 	assert (dialogFonts);
 	dialogGraphicsParams = new DialogGraphicsParams (this);
 	assert (dialogGraphicsParams);
+	GribRecordCache::setBudgetMB (
+				Util::getSetting("recordCacheBudgetMB", 1024).toInt());
+	dialogRecordCache = new DialogRecordCache (this);
+	assert (dialogRecordCache);
 
     //--------------------------------------------------
 	createToolBar (withmblue);
@@ -682,21 +693,65 @@ void MainWindow::slotTimeZoneChanged()
     }
 }
 //-------------------------------------------------
-void MainWindow::openMeteoDataFile (QString fileName)
+// The file is read in a thread: the end is in slotMeteoDataLoaded
+//-------------------------------------------------
+void MainWindow::openMeteoDataFile (QString fileName, GribReader *reader,
+									const GribSubset *subset,
+									const QStringList &datasetFiles)
 {
-	QCursor oldcursor = cursor();
-	setCursor(Qt::WaitCursor);
-	bool ok,ok2,ok3,ok4,ok5,ok6,ok7,ok8,ok9,ok10,ok11;
-	FileDataType meteoFileType = DATATYPE_NONE;
+	if (terre->isLoadingFile()) {
+		delete reader;
+		return;
+	}
 	colorScaleWidget->setColorScale (NULL, DataCode());
 	dateChooser->reset ();
+	loadingDatasetFiles = datasetFiles;
 	if (QFile::exists(fileName))
 	{
 		// 	DBG ("open file %s", qPrintable(fileName));	
+		cursorBeforeLoading = cursor();
+		setCursor(Qt::WaitCursor);
+		enableLoadingConflicts (false);
 		bool zoom = Util::getSetting("autoZoomOnGribArea", true).toBool();
-		meteoFileType = terre->loadMeteoDataFile (fileName, zoom);
-		if (meteoFileType != DATATYPE_NONE)
-			Util::setSetting("gribFileName",  fileName);
+		terre->loadMeteoDataFile (fileName, zoom, reader, subset, datasetFiles);
+	}
+	else {
+		delete reader;
+		cursorBeforeLoading = cursor();
+		slotMeteoDataLoaded (DATATYPE_NONE, fileName);
+	}
+}
+//-------------------------------------------------
+// Actions which can't run while a file is loaded
+//-------------------------------------------------
+void MainWindow::enableLoadingConflicts (bool b)
+{
+	menuBar->acFile_Open->setEnabled (b);
+	menuBar->acFile_OpenZone->setEnabled (b);
+	menuBar->acFile_OpenDataset->setEnabled (b);
+	menuBar->acFile_SaveZone->setEnabled (b);
+	menuBar->acFile_Close->setEnabled (b);
+	menuBar->acFile_Load_GRIB->setEnabled (b);
+	menuBar->acFile_Load_IAC->setEnabled (b);
+	menuBar->acMBlueSwiss_Load->setEnabled (b);
+	menuBar->acFile_Info_GRIB->setEnabled (b);
+	menuBar->ac_OpenMeteotable->setEnabled (b);
+	menuBar->ac_OpenCurveDrawer->setEnabled (b);
+	menuBar->ac_showSkewtDiagram->setEnabled (b);
+	menuBar->ac_CreateAnimation->setEnabled (b);
+	menuBar->ac_ExportImage->setEnabled (b);
+	menuBar->acDatesGrib_prev->setEnabled (b);
+	menuBar->acDatesGrib_next->setEnabled (b);
+	menuBar->cbDatesGrib->setEnabled (b);
+}
+//-------------------------------------------------
+void MainWindow::slotMeteoDataLoaded (FileDataType meteoFileType, QString fileName)
+{
+	bool ok,ok2,ok3,ok4,ok5,ok6,ok7,ok8,ok9,ok10,ok11;
+	enableLoadingConflicts (true);
+	if (meteoFileType != DATATYPE_NONE) {
+		Util::setSetting("gribFileName",  fileName);
+		Util::setSetting("gribDatasetFiles",  loadingDatasetFiles);
 	}
 	
 	GriddedPlotter *plotter = terre->getGriddedPlotter();
@@ -710,6 +765,7 @@ void MainWindow::openMeteoDataFile (QString fileName)
 			menuBar->updateListeDates (plotter->getListDates(),
 									   plotter->getCurrentDate() );
 			gribFileName = fileName;
+			gribDatasetFiles = loadingDatasetFiles;
 
 			menuBar->menuColorMap->setEnabled (true);
 			menuBar->menuIsolines->setEnabled (true);
@@ -826,6 +882,7 @@ void MainWindow::openMeteoDataFile (QString fileName)
 		{
 			//DBG("DATATYPE_MBLUE");
 			gribFileName = fileName;
+			gribDatasetFiles.clear ();
 			setWindowTitle(Version::getShortName()+" - "+ QFileInfo(fileName).fileName());
 			menuBar->updateListeDates (plotter->getListDates(),
 									   plotter->getCurrentDate() );
@@ -899,6 +956,7 @@ void MainWindow::openMeteoDataFile (QString fileName)
 		std::set<time_t> setDatesEmpty;
 		setWindowTitle(Version::getShortName()+" - "+ QFileInfo(fileName).fileName());
 		gribFileName = fileName;
+		gribDatasetFiles.clear ();
 
 		menuBar->updateListeDates(&setDatesEmpty, 0);
 		menuBar->menuColorMap->setEnabled (false);
@@ -928,7 +986,7 @@ void MainWindow::openMeteoDataFile (QString fileName)
 		menuBar->acDatesGrib_next->setEnabled (false);
 		menuBar->cbDatesGrib->setEnabled (false);
 	}
-	setCursor(oldcursor);
+	setCursor(cursorBeforeLoading);
 }
 //-------------------------------------------------------
 void MainWindow::slotUseJetStreamColorMap (bool b) 
@@ -1011,7 +1069,7 @@ void MainWindow::slotCreatePOI ()
 {
 	double lon, lat;
 	proj->screen2map(mouseClicX,mouseClicY, &lon, &lat);
-	new POI_Editor (Settings::getNewCodePOI(), lon, lat, proj, this, terre);
+	new POI_Editor (Settings::getNewCodePOI(), lon, lat, this, terre);
 }
 //-------------------------------------------------
 void MainWindow::createPOIs ()
@@ -1021,19 +1079,15 @@ void MainWindow::createPOIs ()
 	for (int i=0; i < lscodes.size(); ++i)
 	{
 		uint code = lscodes.at(i);
- 		poi = new POI (code, proj, this, terre);
+ 		poi = new POI (code, this, terre);
 		connectPOI (poi);
  	}
 }
 //-------------------------------------------------
 void MainWindow::connectPOI (POI *poi)
 {
-	bool visible = Util::getSetting("showPOIs", true).toBool();
 	if (poi!=NULL) {
-		if (poi->isValid()) {
-			poi->setVisible (visible);
-		}
-		else {
+		if (! poi->isValid()) {
 			Settings::deleteSettingsPOI (poi->getCode() );
 			delete poi;
 			poi = NULL;
@@ -1059,19 +1113,18 @@ void MainWindow::slotMETARsListChanged ()
 //-------------------------------------------------
 void MainWindow::createAllMETARs ()
 {
-	MetarWidget  *mw;
-	MetarWidgetFactory *factory;
+	MetarMarker  *mw;
+	MetarMarkerFactory *factory;
 	QStringList allMetarsSelected = 
 		(Util::getSetting("metar_selected", QStringList()).toStringList() );
 	qDeleteAll (listAllMetars);
 	listAllMetars.clear ();
-	bool isVisible = Util::getSetting("showMETARs", true).toBool();
 	if (allMetarsSelected.size() > 0) {
-		factory = new MetarWidgetFactory ();
+		factory = new MetarMarkerFactory ();
 		assert (factory);
 		for (int i=0; i < allMetarsSelected.size(); i++) {
 			QString icao = allMetarsSelected.at(i);
-			mw = factory->createMetarWidget (icao, isVisible, proj, terre);
+			mw = factory->createMetarMarker (icao, terre);	// drawn by terre
 			listAllMetars.append (mw);
 		}
 		delete factory;
@@ -1080,10 +1133,7 @@ void MainWindow::createAllMETARs ()
 //-------------------------------------------------
 void MainWindow::slotMETARSvisibility (bool vis)
 {
-	Util::setSetting ("showMETARs", vis);
-	for (int i=0; i < listAllMetars.size(); i++) {
-		listAllMetars.at(i)->setVisible (vis);
-	}
+	terre->setShowMETARs (vis);
 }
 //-------------------------------------------------
 void MainWindow::slotPOImoved(POI* poi)
@@ -1097,7 +1147,9 @@ void MainWindow::slotPOImoved(POI* poi)
 void MainWindow::slotFile_Close()
 {
     gribFileName = "";
+    gribDatasetFiles.clear ();
 	Util::setSetting ("gribFileName",  gribFileName);
+	Util::setSetting ("gribDatasetFiles",  gribDatasetFiles);
 	colorScaleWidget->setColorScale (NULL, DataCode());
     terre->closeMeteoDataFile ();
 	dateChooser->reset ();
@@ -1484,6 +1536,106 @@ void MainWindow::slotFile_Open()
         openMeteoDataFile (fileName);
     }
 }
+//-------------------------------------------------
+// Only the records of the selected area are kept (big files)
+//-------------------------------------------------
+void MainWindow::slotFile_OpenZone()
+{
+    double x0, y0, x1, y1;
+    if (! terre->getSelectedRectangle (&x0,&y0, &x1,&y1))
+    {
+        QMessageBox::warning (this,
+            tr("Open selected area"),
+            tr("Please select an area on the map."));
+        return;
+    }
+    QString fileName = Util::getOpenFileName(this,
+                         tr("Choose a GRIB file"),
+                         gribFilePath,
+                         "");
+    if (fileName != "")
+    {
+        QFileInfo finfo(fileName);
+        gribFilePath = finfo.absolutePath();
+    	Util::setSetting("gribFilePath",  gribFilePath);
+		GribSubset subset;
+		subset.setZone (x0,y0, x1,y1);
+        openMeteoDataFile (fileName, NULL, &subset);
+    }
+}
+//-------------------------------------------------
+// Several GRIB files (a file by date, by data...) merged in one set of data
+//-------------------------------------------------
+void MainWindow::slotFile_OpenDataset()
+{
+    QStringList fileNames = Util::getOpenFileNames (this,
+                         tr("Choose GRIB files"),
+                         gribFilePath,
+                         "");
+    if (fileNames.size() > 0)
+    {
+		fileNames.sort ();
+        QFileInfo finfo(fileNames[0]);
+        gribFilePath = finfo.absolutePath();
+    	Util::setSetting("gribFilePath",  gribFilePath);
+        openMeteoDataFile (fileNames[0], NULL, NULL, fileNames);
+    }
+}
+//-------------------------------------------------
+void MainWindow::slotFile_SaveZone()
+{
+    double x0, y0, x1, y1;
+    if (terre->getMeteoFileType() != DATATYPE_GRIB || gribFileName == "")
+    {
+        QMessageBox::warning (this,
+            tr("Save selected area"),
+            tr("Please open a GRIB file."));
+        return;
+    }
+    if (! terre->getSelectedRectangle (&x0,&y0, &x1,&y1))
+    {
+        QMessageBox::warning (this,
+            tr("Save selected area"),
+            tr("Please select an area on the map."));
+        return;
+    }
+    QString fileName = Util::getSaveFileName (this,
+                         tr("Save selected area"),
+                         gribFilePath, "*.grb");
+    if (fileName == "")
+        return;
+	// every file of a dataset is written in the new file
+	QStringList inputFiles = gribDatasetFiles;
+	if (inputFiles.size() == 0)
+		inputFiles << gribFileName;
+	std::vector<std::string> inNames;
+	for (int i=0; i<inputFiles.size(); i++) {
+		if (QFileInfo(fileName).absoluteFilePath()
+					== QFileInfo(inputFiles[i]).absoluteFilePath()) {
+			QMessageBox::warning (this,
+				tr("Save selected area"),
+				tr("Please choose an other file name."));
+			return;
+		}
+		inNames.push_back (qPrintable(inputFiles[i]));
+	}
+	QCursor oldcursor = cursor();
+	setCursor(Qt::WaitCursor);
+	GribSubset subset;
+	subset.setZone (x0,y0, x1,y1);
+	int nb = subset.writeFile (inNames, qPrintable(fileName));
+	setCursor(oldcursor);
+	if (nb < 0) {
+        QMessageBox::critical (this,
+            tr("Save selected area"),
+            tr("Can't write file %1").arg(fileName));
+	}
+	else if (nb == 0) {
+        QMessageBox::warning (this,
+            tr("Save selected area"),
+            tr("No data in the selected area."));
+	}
+}
 
 //========================================================================
 void MainWindow::slotFile_Load_IAC()
@@ -1548,9 +1700,11 @@ void MainWindow::slotFile_Load_GRIB ()
     if ( terre->getSelectedRectangle (&x0,&y0, &x1,&y1)
 		 || terre->getGribFileRectangle (&x0,&y0, &x1,&y1) )
     {
-		QString fname = DialogLoadGRIB::getFile (networkManager, this, x0,y0,x1,y1);
+		GribReader *reader = NULL;
+		QString fname = DialogLoadGRIB::getFile (networkManager, this, x0,y0,x1,y1,
+												 &reader);
 		if (fname != "") {
-			openMeteoDataFile (fname);
+			openMeteoDataFile (fname, reader);
 		}
     }
     else {
@@ -37,6 +37,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DialogLoadMBLUE.h"
 #include "DialogServerStatus.h"
 #include "DialogProxy.h"
+#include "DialogRecordCache.h"
 #include "DialogUnits.h"
 #include "DialogSelectMetar.h"
 #include "POI.h"
@@ -63,7 +64,11 @@ class MainWindow: public QMainWindow
         MainWindow (int w, int h, bool withmblue, QWidget *parent = 0);
         ~MainWindow();
 
-        void openMeteoDataFile (QString fileName);
+        // datasetFiles: several GRIB files read as one set of data
+        // (fileName is the first one)
+        void openMeteoDataFile (QString fileName, GribReader *reader=NULL,
+								const GribSubset *subset=NULL,
+								const QStringList &datasetFiles=QStringList());
 		
 		void openSkewtDiagramWindow (double lon, double lat, 
 									 GriddedReader *reader = NULL, 
@@ -85,6 +90,9 @@ class MainWindow: public QMainWindow
 		void slotShowSkewtDiagram ();
 		
         void slotFile_Open ();
+        void slotFile_OpenZone ();
+        void slotFile_OpenDataset ();
+        void slotFile_SaveZone ();
         void slotFile_Close ();
         void slotFile_Load_GRIB ();
         void slotFile_Load_IAC ();
@@ -136,6 +144,7 @@ class MainWindow: public QMainWindow
         void slotHelp_APropos ();
         void slotHelp_AProposQT ();
 		void slotUseJetStreamColorMap  (bool);
+		void slotMeteoDataLoaded (FileDataType fileType, QString fileName);
 
     signals:
         void signalMapQuality (int quality);
@@ -145,17 +154,21 @@ class MainWindow: public QMainWindow
         Projection  *proj;
         
         QString      gribFileName;
+        QStringList  gribDatasetFiles;		// files merged with gribFileName
+        QStringList  loadingDatasetFiles;
         QString      gribFilePath;
+        QCursor      cursorBeforeLoading;
         
 		QNetworkAccessManager *networkManager;
 
 		DialogProxy      *dialogProxy;
+		DialogRecordCache *dialogRecordCache;
         DialogUnits      *dialogUnits;
         DialogFonts      *dialogFonts;
         DialogGraphicsParams *dialogGraphicsParams;
 		
 		DialogSelectMetar    *dialogSelectMetar;
-		QList <MetarWidget *> listAllMetars;
+		QList <MetarMarker *> listAllMetars;
 		
         Terrain      *terre;
         MenuBar      *menuBar;
@@ -168,6 +181,7 @@ class MainWindow: public QMainWindow
         QMenu    *menuPopupBtRight;
         
         void    connectSignals();
+        void    enableLoadingConflicts (bool b);
 		void    createPOIs ();
 		void    connectPOI (POI *poi);
 		
@@ -18,11 +18,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 
 #include <QApplication>
 #include <QMouseEvent>
 #include <QPaintEvent>
 #include <QPainter>
+#include <QElapsedTimer>
 
 #include "MapDrawer.h"
 #include "LonLatGrid.h"
@@ -33,8 +35,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 MapDrawer::MapDrawer(GshhsReader *gshhsReader)
 	: QObject()
 {
-    imgEarth = NULL;
     imgAll   = NULL;
+	initLayers ();
 
     gisReader = new GisReader ();
     assert (gisReader);
@@ -50,8 +52,8 @@ MapDrawer::MapDrawer(GshhsReader *gshhsReader)
 MapDrawer::MapDrawer(const MapDrawer &model)
 	: QObject()
 {
-    imgEarth = NULL;
     imgAll   = NULL;
+	initLayers ();
 	gisReader = model.gisReader;
     gisReaderIsNew = false;		// don't delete pointer
     
@@ -76,6 +78,19 @@ MapDrawer::MapDrawer(const MapDrawer &model)
 	updateGraphicsParameters();
 }
 //---------------------------------------------------------------------
+MapDrawer::MapDrawer()
+	: QObject()
+{
+    imgAll   = NULL;
+	initLayers ();
+	gisReader = NULL;
+	gisReaderIsNew = false;
+	gshhsReader = NULL;
+	gshhsReaderIsNew = false;
+	initGraphicsParameters();
+	updateGraphicsParameters();
+}
+//---------------------------------------------------------------------
 MapDrawer::~MapDrawer()
 {
 	if (gisReaderIsNew) {
@@ -87,9 +102,38 @@ MapDrawer::~MapDrawer()
 	if (imgAll != NULL) {
 		delete imgAll;
 	}
-	if (imgEarth != NULL) {
-		delete imgEarth;
+	for (int layer=0; layer < NB_MAP_LAYERS; layer++) {
+		if (layerImg [layer] != NULL)
+			delete layerImg [layer];
 	}
+	clearIsolines ();
+}
+//---------------------------------------------------------------------
+void MapDrawer::initLayers ()
+{
+	for (int layer=0; layer < NB_MAP_LAYERS; layer++) {
+		layerImg [layer] = NULL;
+		layerLastMs  [layer] = 0;
+		layerTotalMs [layer] = 0;
+		layerCount   [layer] = 0;
+	}
+	dataGeneration = 0;
+	abortFlag = NULL;
+}
+//---------------------------------------------------------------------
+void MapDrawer::invalidateLayers ()
+{
+	for (int layer=0; layer < NB_MAP_LAYERS; layer++)
+		layerKey [layer] = "";
+}
+//---------------------------------------------------------------------
+void MapDrawer::clearIsolines ()
+{
+	Util::cleanVectorPointers (listIsobars);
+	Util::cleanVectorPointers (listIsotherms0);
+	Util::cleanVectorPointers (listGeopotential);
+	Util::cleanVectorPointers (listIsotherms);
+	Util::cleanVectorPointers (listLinesThetaE);
 }
 
 //===========================================================
@@ -111,7 +155,7 @@ void MapDrawer::initGraphicsParameters()
 
     showIsotherms0  = Util::getSetting("showIsotherms0", false).toBool();
     showIsotherms0Labels  = Util::getSetting("showIsotherms0Labels", false).toBool();
-    isotherms0Step = Util::getSetting("isotherms0Step", 50).toDouble();
+    isotherms0Step = Util::getSetting("isotherms0Step", 100).toDouble();
 
     showIsotherms = Util::getSetting("showIsotherms", false).toBool();
     showIsotherms_Labels  = Util::getSetting("showIsotherms_Labels", false).toBool();
@@ -140,6 +184,8 @@ void MapDrawer::initGraphicsParameters()
     showBarbules  = Util::getSetting("showBarbules", true).toBool();
 
     showCurrentArrows  = Util::getSetting("showCurrentArrows", true).toBool();
+	hasWindForArrows = false;
+	hasCurrentForArrows = false;
 
     showTemperatureLabels = Util::getSetting("showTemperatureLabels", false).toBool();
     showGribGrid = Util::getSetting("showGribGrid", false).toBool();
@@ -174,6 +220,67 @@ void MapDrawer::updateGraphicsParameters()
     linesThetaE_Pen.setWidthF(Util::getSetting("linesThetaE_LineWidth", 1.6).toDouble());
 }
 
+//---------------------------------------------------------------------
+// The map thread draws with a copy of the options of the view
+//---------------------------------------------------------------------
+void MapDrawer::copyOptions (const MapDrawer &model)
+{
+	dataGeneration = model.dataGeneration;
+
+	showCitiesNamesLevel = model.showCitiesNamesLevel;
+	showCountriesNames   = model.showCountriesNames;
+	showCountriesBorders = model.showCountriesBorders;
+	showRivers     = model.showRivers;
+	showLonLatGrid = model.showLonLatGrid;
+
+	colorMapData   = model.colorMapData;
+	colorMapSmooth = model.colorMapSmooth;
+	showTemperatureLabels = model.showTemperatureLabels;
+
+	isobarsStep  = model.isobarsStep;
+	showIsobars  = model.showIsobars;
+	showIsobarsLabels  = model.showIsobarsLabels;
+	showPressureMinMax = model.showPressureMinMax;
+
+	geopotentialData = model.geopotentialData;
+	showGeopotential = model.showGeopotential;
+	showGeopotentialLabels = model.showGeopotentialLabels;
+	geopotentialStep = model.geopotentialStep;
+	geopotentialMin  = model.geopotentialMin;
+	geopotentialMax  = model.geopotentialMax;
+
+	isotherms0Step = model.isotherms0Step;
+	showIsotherms0 = model.showIsotherms0;
+	showIsotherms0Labels = model.showIsotherms0Labels;
+
+	isotherms_Step = model.isotherms_Step;
+	showIsotherms  = model.showIsotherms;
+	showIsotherms_Labels = model.showIsotherms_Labels;
+	isothermsAltitude = model.isothermsAltitude;
+
+	linesThetaE_Step = model.linesThetaE_Step;
+	showLinesThetaE  = model.showLinesThetaE;
+	showLinesThetaE_Labels = model.showLinesThetaE_Labels;
+	linesThetaEAltitude = model.linesThetaEAltitude;
+
+	showWindArrows = model.showWindArrows;
+	showGribGrid   = model.showGribGrid;
+	showBarbules   = model.showBarbules;
+	showCurrentArrows  = model.showCurrentArrows;
+	showWaveArrowsType = model.showWaveArrowsType;
+
+	seaColor   = model.seaColor;
+	landColor  = model.landColor;
+	backgroundColor = model.backgroundColor;
+	isobarsPen = model.isobarsPen;
+	geopotentialsPen = model.geopotentialsPen;
+	isotherms0Pen = model.isotherms0Pen;
+	isotherms_Pen = model.isotherms_Pen;
+	linesThetaE_Pen = model.linesThetaE_Pen;
+	seaBordersPen = model.seaBordersPen;
+	boundariesPen = model.boundariesPen;
+	riversPen     = model.riversPen;
+}
 //---------------------------------------------------------------------
 void MapDrawer::setGeopotentialData (const DataCode &dtc)
 {
@@ -222,37 +329,17 @@ void MapDrawer::setGeopotentialData (const DataCode &dtc)
 }
 
 //---------------------------------------------------------------------
-void MapDrawer::draw_Map_Background(bool isEarthMapValid, Projection *proj)
+void MapDrawer::draw_Map_Background (QPainter &pnt, Projection *proj)
 {
-	if (imgAll != NULL) {
-		delete imgAll;
-		imgAll = NULL;
-	}
-	imgAll = new QPixmap(proj->getW(), proj->getH());
-	assert(imgAll);
-
-	QPainter pnt(imgAll);
-	pnt.setRenderHint(QPainter::Antialiasing, true);
-
-	if (!isEarthMapValid)
+	if (gshhsReader != NULL)
 	{
-		if (imgEarth != NULL) {
-			delete imgEarth;
-			imgEarth = NULL;
-		}
-
-		imgEarth = new QPixmap(proj->getW(), proj->getH());
-		assert(imgEarth);
-
-		if (gshhsReader != NULL)
-		{
-			QPainter pnt1(imgEarth);
-			pnt1.setRenderHint(QPainter::Antialiasing, false);
-			gshhsReader->drawBackground(pnt1, proj, seaColor, backgroundColor);
-			gshhsReader->drawContinents(pnt1, proj, seaColor, landColor);
-		}
+		pnt.setRenderHint(QPainter::Antialiasing, false);
+		gshhsReader->drawBackground(pnt, proj, seaColor, backgroundColor);
+		gshhsReader->drawContinents(pnt, proj, seaColor, landColor);
+	}
+	else {
+		pnt.fillRect (0,0, proj->getW(),proj->getH(), backgroundColor);
 	}
-	pnt.drawPixmap(0,0, *imgEarth);
 }
 //----------------------------------------------------------------------
 void MapDrawer::draw_Map_Foreground(QPainter &pnt, Projection *proj)
@@ -275,14 +362,243 @@ void MapDrawer::draw_Map_Foreground(QPainter &pnt, Projection *proj)
 		LonLatGrid gr;
 		gr.drawLonLatGrid(pnt, proj);
 	}
+}
+//----------------------------------------------------------------------
+// Cities names are placed before the data labels,
+// which are written only where the place is free.
+//----------------------------------------------------------------------
+void MapDrawer::draw_Map_Labels (QPainter &pnt, Projection *proj, GriddedPlotter *plotter)
+{
+	labelPlacer.reset (proj->getW(), proj->getH());
+	citiesLabels.clear ();
+	if (showCitiesNamesLevel > 0) {
+		gisReader->placeCitiesNames (proj, showCitiesNamesLevel,
+									 labelPlacer, citiesLabels);
+	}
+	if (plotter != NULL) {
+		draw_MeteoData_Labels (pnt, proj, plotter);
+	}
 	if (showCountriesNames) {
 		gisReader->drawCountriesNames(pnt, proj);
 	}
 	if (showCitiesNamesLevel > 0) {
-		gisReader->drawCitiesNames(pnt, proj, showCitiesNamesLevel);
+		gisReader->drawCitiesNames(pnt, citiesLabels);
 	}
 }
 
+//=======================================================================
+// Layers
+//=======================================================================
+static QString keyBool (bool b)
+{
+	return b ? "1" : "0";
+}
+//---------------------------------------------------------------------
+// Everything a layer depends on, except the graphics parameters
+// (a change of them invalidates all the layers).
+//---------------------------------------------------------------------
+QString MapDrawer::getLayerKey (int layer, Projection *proj,
+								GriddedPlotter *plotter, IacPlot *iacPlot)
+{
+	QStringList k;
+	k << QString::number (proj->getW())
+	  << QString::number (proj->getH())
+	  << QString::number (proj->getCX(), 'g', 15)
+	  << QString::number (proj->getCY(), 'g', 15)
+	  << QString::number (proj->getScale(), 'g', 15);
+	if (layer == LAYER_EARTH)
+		return k.join (" ");
+	if (layer == LAYER_BORDERS) {
+		k << keyBool (showCountriesBorders) << keyBool (showRivers)
+		  << keyBool (showLonLatGrid);
+		return k.join (" ");
+	}
+	// Layers depending on the meteo data
+	k << QString::number (dataGeneration)
+	  << QString::number ((quintptr) plotter)
+	  << QString::number ((quintptr) iacPlot);
+	if (plotter != NULL)
+		k << QString::number ((qlonglong) plotter->getCurrentDate());
+	switch (layer) {
+		case LAYER_COLORMAP :
+			k << DataCodeStr::serialize (colorMapData) << keyBool (colorMapSmooth)
+			  << keyBool (plotter!=NULL && plotter->getUseJetStreamColorMap());
+			break;
+		case LAYER_ISOLINES :
+			k << keyBool (showIsobars) << QString::number (isobarsStep)
+			  << keyBool (showIsotherms0) << QString::number (isotherms0Step)
+			  << keyBool (showGeopotential) << DataCodeStr::serialize (geopotentialData)
+			  << QString::number (geopotentialStep)
+			  << QString::number (geopotentialMin) << QString::number (geopotentialMax)
+			  << keyBool (showIsotherms) << QString::number (isotherms_Step)
+			  << AltitudeStr::serialize (isothermsAltitude)
+			  << keyBool (showLinesThetaE) << QString::number (linesThetaE_Step)
+			  << AltitudeStr::serialize (linesThetaEAltitude);
+			break;
+		case LAYER_ARROWS :
+			k << QString::number (showWaveArrowsType)
+			  << keyBool (showWindArrows && hasWindForArrows)
+			  << AltitudeStr::serialize (windArrowsAltitude)
+			  << keyBool (showBarbules) << windArrowsColor.name()
+			  << keyBool (showCurrentArrows && hasCurrentForArrows)
+			  << AltitudeStr::serialize (currentArrowsAltitude)
+			  << currentArrowsColor.name()
+			  << keyBool (showGribGrid) << DataCodeStr::serialize (colorMapData);
+			break;
+		case LAYER_LABELS :
+			k << layerKey [LAYER_ISOLINES]
+			  << QString::number (showCitiesNamesLevel) << keyBool (showCountriesNames)
+			  << keyBool (showIsobarsLabels) << keyBool (showIsotherms0Labels)
+			  << keyBool (showGeopotentialLabels) << keyBool (showIsotherms_Labels)
+			  << keyBool (showLinesThetaE_Labels) << keyBool (showPressureMinMax)
+			  << keyBool (showTemperatureLabels)
+			  << AltitudeStr::serialize (temperatureLabelsAlt);
+			break;
+		case LAYER_CARTOUCHE :
+			k << layerKey [LAYER_COLORMAP] << layerKey [LAYER_ISOLINES]
+			  << layerKey [LAYER_ARROWS]   << layerKey [LAYER_LABELS];
+			break;
+	}
+	return k.join (" ");
+}
+//---------------------------------------------------------------------
+// Draw the layer again if its key has changed
+//---------------------------------------------------------------------
+void MapDrawer::update_Layer (int layer, Projection *proj,
+							  GriddedPlotter *plotter, IacPlot *iacPlot)
+{
+	QString key = getLayerKey (layer, proj, plotter, iacPlot);
+	QImage *img = layerImg [layer];
+	if (img != NULL && key == layerKey [layer]
+			&& img->width() == proj->getW() && img->height() == proj->getH())
+		return;
+	
+	QElapsedTimer timer;
+	timer.start ();
+	if (img == NULL || img->width() != proj->getW() || img->height() != proj->getH()) {
+		delete img;
+		img = layerImg [layer] = new QImage (proj->getW(), proj->getH(),
+											 QImage::Format_ARGB32_Premultiplied);
+		assert (img);
+	}
+	img->fill (Qt::transparent);
+	layerKey [layer] = key;
+	layerDataCenters [layer].clear ();
+	
+	QPainter pnt (img);
+	pnt.setRenderHint (QPainter::Antialiasing, true);
+	switch (layer) {
+		case LAYER_EARTH :
+			draw_Map_Background (pnt, proj);
+			break;
+		case LAYER_COLORMAP :
+			if (plotter != NULL)
+				draw_MeteoData_ColorMap (pnt, proj, plotter);
+			break;
+		case LAYER_ISOLINES :
+			clearIsolines ();
+			if (plotter != NULL)
+				draw_MeteoData_Isolines (pnt, proj, plotter);
+			else if (iacPlot != NULL)
+				draw_MeteoData_IAC (pnt, proj, iacPlot);
+			break;
+		case LAYER_ARROWS :
+			if (plotter != NULL)
+				draw_MeteoData_Arrows (pnt, proj, plotter);
+			break;
+		case LAYER_BORDERS :
+			draw_Map_Foreground (pnt, proj);
+			break;
+		case LAYER_LABELS :
+			draw_Map_Labels (pnt, proj, plotter);
+			break;
+		case LAYER_CARTOUCHE :
+			if (plotter != NULL) {
+				setUsedDataCenters.clear ();
+				for (int i=0; i < NB_MAP_LAYERS; i++)
+					setUsedDataCenters.insert (layerDataCenters[i].begin(),
+											   layerDataCenters[i].end());
+				draw_Cartouche_Gridded (pnt, proj, plotter);
+			}
+			else if (iacPlot != NULL)
+				draw_Cartouche_IAC (pnt, proj, iacPlot);
+			break;
+	}
+	pnt.end ();
+	addRenderTime (layer, timer.nsecsElapsed()/1e6);
+}
+//---------------------------------------------------------------------
+void MapDrawer::compose_Layers (QPainter &pntGlobal, Projection *proj,
+								const int *layers, int nbLayers)
+{
+	if (imgAll == NULL
+			|| imgAll->width() != proj->getW() || imgAll->height() != proj->getH())
+	{
+		delete imgAll;
+		imgAll = new QImage (proj->getW(), proj->getH(),
+							 QImage::Format_ARGB32_Premultiplied);
+		assert (imgAll);
+	}
+	QPainter pnt (imgAll);
+	for (int i=0; i < nbLayers; i++) {
+		if (layerImg [layers[i]] != NULL)
+			pnt.drawImage (0,0, *layerImg [layers[i]]);
+	}
+	pnt.end ();
+    // Recopie l'image complète
+    pntGlobal.drawImage (0,0, *imgAll);
+}
+//---------------------------------------------------------------------
+void MapDrawer::addRenderTime (int layer, double ms)
+{
+	QMutexLocker lock (&timesMutex);
+	layerLastMs  [layer] = ms;
+	layerTotalMs [layer] += ms;
+	layerCount   [layer] ++;
+}
+//---------------------------------------------------------------------
+// Debug panel : render times of the layers (last, mean, count)
+//---------------------------------------------------------------------
+void MapDrawer::draw_RenderTimes (QPainter &pnt, int W)
+{
+	static const char *names [NB_MAP_LAYERS] = {
+		"Earth", "Color map", "Isolines", "Arrows",
+		"Borders", "Labels", "Cartouche", "POIs"
+	};
+	QFont font = Font::getFont (FONT_MapInfo_Small);
+	QFontMetrics fm (font);
+	QStringList lines;
+	lines << "Layer          last ms   mean ms     n";
+	QMutexLocker lock (&timesMutex);
+	for (int layer=0; layer < NB_MAP_LAYERS; layer++) {
+		QString txt;
+		txt.sprintf ("%-12s %9.1f %9.1f %5d", names[layer],
+					layerLastMs[layer],
+					layerCount[layer]>0 ? layerTotalMs[layer]/layerCount[layer] : 0.0,
+					layerCount[layer]);
+		lines << txt;
+	}
+	lock.unlock ();
+	font.setFamily ("Courier");
+	font.setStyleHint (QFont::TypeWriter);
+	fm = QFontMetrics (font);
+	int w = 0;
+	for (int i=0; i < lines.size(); i++)
+		w = std::max (w, fm.width (lines.at(i)));
+	int dy = fm.height();
+	int h = lines.size()*dy + 6;
+	w += 8;
+	int x = W - w - 4;
+	int y = 4;
+	pnt.setPen (Qt::NoPen);
+	pnt.setBrush (QColor(255,255,255,200));
+	pnt.drawRect (x,y, w,h);
+	pnt.setPen (QColor(20,20,20));
+	pnt.setFont (font);
+	for (int i=0; i < lines.size(); i++)
+		pnt.drawText (x+4, y+3+(i+1)*dy - fm.descent(), lines.at(i));
+}
+
 //=======================================================================
 // GSHHS Map
 //=======================================================================
@@ -292,21 +608,23 @@ void MapDrawer::draw_GSHHS (
 			Projection *proj
 	)
 {
-    if (mustRedraw  ||  !isEarthMapValid)
+	static const int layers [] = {
+		LAYER_EARTH, LAYER_BORDERS, LAYER_LABELS
+	};
+    if (mustRedraw  ||  !isEarthMapValid  ||  imgAll == NULL)
     {
-		//===================================================
-		// Dessin du fond de carte
-		//===================================================
-		draw_Map_Background (isEarthMapValid, proj);
-		//===================================================
-		// Dessin des bordures et frontières
-		//===================================================
-		QPainter pnt (imgAll);
-		pnt.setRenderHint (QPainter::Antialiasing, true);
-		draw_Map_Foreground (pnt, proj);
+		if (!isEarthMapValid)
+			invalidateLayers ();
+		clearIsolines ();
+		layerKey [LAYER_ISOLINES] = "";
+		for (int i=0; i < 3 && !isAborted(); i++)
+			update_Layer (layers[i], proj, NULL, NULL);
+		if (! isAborted())
+			compose_Layers (pntGlobal, proj, layers, 3);
     }
-    // Recopie l'image complète
-    pntGlobal.drawPixmap (0,0, *imgAll);
+	else {
+		pntGlobal.drawImage (0,0, *imgAll);
+	}
 }
 
 //=======================================================================
@@ -320,31 +638,23 @@ void MapDrawer::draw_GSHHS_and_IAC (
 			bool drawCartouche
 	)
 {
-    if (mustRedraw  ||  !isEarthMapValid)
+	// IAC data are drawn above the map foreground
+	static const int layers [] = {
+		LAYER_EARTH, LAYER_BORDERS, LAYER_LABELS, LAYER_ISOLINES, LAYER_CARTOUCHE
+	};
+    if (mustRedraw  ||  !isEarthMapValid  ||  imgAll == NULL)
     {
-		//===================================================
-		// Dessin du fond de carte
-		//===================================================
-		draw_Map_Background(isEarthMapValid, proj);
-		QPainter pnt(imgAll);
-		pnt.setRenderHint(QPainter::Antialiasing, true);
-		//===================================================
-		// Dessin des bordures et frontières
-		//===================================================
-		draw_Map_Foreground(pnt, proj);
-		//===================================================
-		// Dessin des données Meteo
-		//===================================================
-		draw_MeteoData_IAC (pnt, proj, iacPlot);
-
-		//===================================================
-		// Cartouche
-		//===================================================
-		if (drawCartouche)
-			draw_Cartouche_IAC (pnt, proj, iacPlot);
+		if (!isEarthMapValid)
+			invalidateLayers ();
+		int nbLayers = drawCartouche ? 5 : 4;
+		for (int i=0; i < nbLayers && !isAborted(); i++)
+			update_Layer (layers[i], proj, NULL, iacPlot);
+		if (! isAborted())
+			compose_Layers (pntGlobal, proj, layers, nbLayers);
     }
-    // Recopie l'image complète
-    pntGlobal.drawPixmap(0,0, *imgAll);
+	else {
+		pntGlobal.drawImage (0,0, *imgAll);
+	}
 }
 //=======================================================================
 // Gridded data
@@ -357,35 +667,28 @@ void MapDrawer::draw_GSHHS_and_GriddedData (
 			bool drawCartouche
 	)
 {
-    if (mustRedraw  ||  !isEarthMapValid)
+	// Isolines are updated before the labels which use them
+	static const int layers [] = {
+		LAYER_EARTH, LAYER_COLORMAP, LAYER_ISOLINES, LAYER_ARROWS,
+		LAYER_BORDERS, LAYER_LABELS, LAYER_CARTOUCHE
+	};
+    if (mustRedraw  ||  !isEarthMapValid  ||  imgAll == NULL)
     {
-		//===================================================
-		// Dessin du fond de carte
-		//===================================================
-		draw_Map_Background (isEarthMapValid, proj);
-		//===================================================
-		// Dessin des données Meteo
-		//===================================================
-		QPainter pnt (imgAll);
-		pnt.setRenderHint (QPainter::Antialiasing, true);
-		draw_MeteoData_Gridded (pnt, proj, plotter);
-
-		//===================================================
-		// Dessin des bordures et frontières
-		//===================================================
-		draw_Map_Foreground(pnt, proj);
-
-		//===================================================
-		// Cartouche
-		//===================================================
-		if (drawCartouche)
-			draw_Cartouche_Gridded (pnt, proj, plotter);
+		if (!isEarthMapValid)
+			invalidateLayers ();
+		prepare_MeteoData_Gridded (plotter);
+		int nbLayers = drawCartouche ? 7 : 6;
+		for (int i=0; i < nbLayers && !isAborted(); i++)
+			update_Layer (layers[i], proj, plotter, NULL);
+		if (! isAborted())
+			compose_Layers (pntGlobal, proj, layers, nbLayers);
     }
-    // Recopie l'image complète
-    pntGlobal.drawPixmap(0,0, *imgAll);
+	else {
+		pntGlobal.drawImage (0,0, *imgAll);
+	}
 }
 //===================================================================
-void MapDrawer::addUsedDataCenterModel (const DataCode &dtc, GriddedPlotter *plotter)
+void MapDrawer::addUsedDataCenterModel (int layer, const DataCode &dtc, GriddedPlotter *plotter)
 {
 	int type;
 	if (dtc.dataType == GRB_PRV_WIND_XY2D)
@@ -399,19 +702,15 @@ void MapDrawer::addUsedDataCenterModel (const DataCode &dtc, GriddedPlotter *plo
 	GriddedRecord *rec = plotter->getReader()->getRecord 
 			(DataCode(type,dtc.levelType,dtc.levelValue),  plotter->getCurrentDate());
 	if (rec && rec->isOk()) {
-		setUsedDataCenters.insert (rec->getDataCenterModel());
+		layerDataCenters[layer].insert (rec->getDataCenterModel());
 	}
 }
 //===================================================================
 // Draw gridded data
 //===================================================================
-void MapDrawer::draw_MeteoData_Gridded 
-			( QPainter &pnt, Projection *proj,
-			GriddedPlotter   *plotter )
+// Choices depending on the available data, made before the layer keys
+void MapDrawer::prepare_MeteoData_Gridded (GriddedPlotter *plotter)
 {
-	setUsedDataCenters.clear ();
-	plotter->draw_CoveredZone (pnt, proj);
-	
 	Altitude mapAltitude =  colorMapData.getAltitude ();
 	
 	if (showWindArrows) {
@@ -489,19 +788,6 @@ void MapDrawer::draw_MeteoData_Gridded
 			currentArrowsColor.setRgb(25, 25, 25);
 			break;
 	}
-	
-	//-------------------------------------------------------
-	// draw complete colored map
-	//-------------------------------------------------------
-	plotter->draw_ColoredMapPlain (colorMapData, colorMapSmooth,pnt,proj);
-	addUsedDataCenterModel (colorMapData, plotter);
-	//-------------------------------------------------------
-
-	std::vector <IsoLine *> listIsobars;
-	std::vector <IsoLine *> listIsotherms0;
-	std::vector <IsoLine *> listGeopotential;
-	std::vector <IsoLine *> listIsotherms;
-	std::vector <IsoLine *> listLinesThetaE;
 
 	if (! plotter->hasData (GRB_PRESSURE_MSL,LV_MSL,0))
 		showIsobars = false;
@@ -513,11 +799,28 @@ void MapDrawer::draw_MeteoData_Gridded
 		showIsotherms = false;
 	if (! plotter->hasData (GRB_PRV_THETA_E,linesThetaEAltitude))
 		showLinesThetaE = false;
-
+}
+//-------------------------------------------------------------------
+void MapDrawer::draw_MeteoData_ColorMap 
+			( QPainter &pnt, Projection *proj,
+			GriddedPlotter   *plotter )
+{
+	plotter->draw_CoveredZone (pnt, proj);
+	//-------------------------------------------------------
+	// draw complete colored map
+	//-------------------------------------------------------
+	plotter->draw_ColoredMapPlain (colorMapData, colorMapSmooth,pnt,proj);
+	addUsedDataCenterModel (LAYER_COLORMAP, colorMapData, plotter);
+}
+//-------------------------------------------------------------------
+void MapDrawer::draw_MeteoData_Isolines 
+			( QPainter &pnt, Projection *proj,
+			GriddedPlotter   *plotter )
+{
 	if (showIsobars) {
 		pnt.setPen (isobarsPen);
 		DataCode dtc (GRB_PRESSURE_MSL,LV_MSL,0);
-		addUsedDataCenterModel (dtc, plotter);
+		addUsedDataCenterModel (LAYER_ISOLINES, dtc, plotter);
 		plotter->complete_listIsolines (&listIsobars, dtc,
 						   84000, 112000, isobarsStep*100, proj);
         plotter->draw_listIsolines (listIsobars, pnt,proj);
@@ -526,7 +829,7 @@ void MapDrawer::draw_MeteoData_Gridded
 	if (showIsotherms0) {
 		pnt.setPen (isotherms0Pen);
 		DataCode dtc (GRB_GEOPOT_HGT,LV_ISOTHERM0,0);
-		addUsedDataCenterModel (dtc, plotter);
+		addUsedDataCenterModel (LAYER_ISOLINES, dtc, plotter);
 		plotter->complete_listIsolines (&listIsotherms0, dtc,
 						   0, 15000, isotherms0Step, proj);
         plotter->draw_listIsolines (listIsotherms0, pnt,proj);
@@ -543,7 +846,7 @@ void MapDrawer::draw_MeteoData_Gridded
 	if (showIsotherms) {
 		pnt.setPen (isotherms_Pen);
 		DataCode dtc (GRB_TEMP,isothermsAltitude);
-		addUsedDataCenterModel (dtc, plotter);
+		addUsedDataCenterModel (LAYER_ISOLINES, dtc, plotter);
 		plotter->complete_listIsolines (&listIsotherms, dtc,
 						   -140+273.15, 80+273.15, isotherms_Step, proj);
         plotter->draw_listIsolines (listIsotherms, pnt,proj);
@@ -552,12 +855,17 @@ void MapDrawer::draw_MeteoData_Gridded
 	if (showLinesThetaE) {
 		pnt.setPen (linesThetaE_Pen);
 		DataCode dtc (GRB_PRV_THETA_E,linesThetaEAltitude);
-		addUsedDataCenterModel (dtc, plotter);
+		addUsedDataCenterModel (LAYER_ISOLINES, dtc, plotter);
 		plotter->complete_listIsolines (&listLinesThetaE, dtc,
 						   -80+273.15, 140+273.15, linesThetaE_Step, proj);
         plotter->draw_listIsolines (listLinesThetaE, pnt,proj);
 	}
-
+}
+//-------------------------------------------------------------------
+void MapDrawer::draw_MeteoData_Arrows 
+			( QPainter &pnt, Projection *proj,
+			GriddedPlotter   *plotter )
+{
 	if (showWaveArrowsType != GRB_TYPE_NOT_DEFINED) {
 		plotter->draw_WAVES_Arrows (showWaveArrowsType, pnt, proj);
 	}
@@ -569,44 +877,59 @@ void MapDrawer::draw_MeteoData_Gridded
 		plotter->draw_CURRENT_Arrows (currentArrowsAltitude, currentArrowsColor, pnt, proj);
 	}
 
+	//===================================================
+	// Grille
+	//===================================================
+	if (showGribGrid) {
+		pnt.setPen(QColor (40,40,40));
+		plotter->draw_GridPoints (colorMapData, pnt, proj);
+	}
+}
+//-------------------------------------------------------------------
+// Labels of the isolines computed by the isolines layer
+//-------------------------------------------------------------------
+void MapDrawer::draw_MeteoData_Labels 
+			( QPainter &pnt, Projection *proj,
+			GriddedPlotter   *plotter )
+{
 	if (showIsobarsLabels && showIsobars) {
 		QColor color (40,40,40);
-        plotter->draw_listIsolines_labels (listIsobars, 0.01,0, color, pnt,proj);
+        plotter->draw_listIsolines_labels (listIsobars, 0.01,0, color, pnt,proj, -1, &labelPlacer);
 	}
 	if (showIsotherms0Labels && showIsotherms0) {
 		QColor color(200,80,80);
 		DataCode dtc (GRB_GEOPOT_HGT,LV_ISOTHERM0,0);
-		addUsedDataCenterModel (dtc, plotter);
+		addUsedDataCenterModel (LAYER_LABELS, dtc, plotter);
 		double coef = Util::getDataCoef (dtc);
-        plotter->draw_listIsolines_labels (listIsotherms0, coef,0, color, pnt,proj);
+        plotter->draw_listIsolines_labels (listIsotherms0, coef,0, color, pnt,proj, -1, &labelPlacer);
 	}
 	if (showGeopotentialLabels && showGeopotential) {
 		QColor color(200,80,80);
 		DataCode dtc (GRB_GEOPOT_HGT,LV_ISOBARIC,0);
-		addUsedDataCenterModel (dtc, plotter);
+		addUsedDataCenterModel (LAYER_LABELS, dtc, plotter);
 		double coef = Util::getDataCoef (dtc);
-        plotter->draw_listIsolines_labels (listGeopotential, coef,0, color, pnt,proj);
+        plotter->draw_listIsolines_labels (listGeopotential, coef,0, color, pnt,proj, -1, &labelPlacer);
 	}
 	if (showIsotherms_Labels && showIsotherms) {
 		QColor color(40,40,150); 
         plotter->draw_listIsolines_labels (listIsotherms,
 										1.,-273.15,
 										color, pnt,proj, 
-										16	// TODO: labels density
-										);
+										16,	// TODO: labels density
+										&labelPlacer);
 	} 
 	if (showLinesThetaE_Labels && showLinesThetaE) {
 		QColor color(40,40,150); 
         plotter->draw_listIsolines_labels (listLinesThetaE,
 										1.,-273.15,
 										color, pnt,proj, 
-										16	// TODO: labels density
-										);
+										16,	// TODO: labels density
+										&labelPlacer);
 	} 
 
 	if (showPressureMinMax) {
 		DataCode dtc (GRB_PRESSURE_MSL,LV_MSL,0);
-		addUsedDataCenterModel (dtc, plotter);
+		addUsedDataCenterModel (LAYER_LABELS, dtc, plotter);
 		plotter->draw_DATA_MinMax ( 
 						dtc, 101200, "L", "H",
 						Font::getFont(FONT_GRIB_PressHL),
@@ -614,19 +937,11 @@ void MapDrawer::draw_MeteoData_Gridded
 	}
 	if (showTemperatureLabels) {
 		DataCode dtc (GRB_TEMP,temperatureLabelsAlt);
-		addUsedDataCenterModel (dtc, plotter);
+		addUsedDataCenterModel (LAYER_LABELS, dtc, plotter);
 		plotter->draw_DATA_Labels (
 					dtc, Font::getFont(FONT_GRIB_Temp),
 					QColor(0,0,0),
-					Util::formatTemperature_short, pnt, proj);
-	}
-
-	//===================================================
-	// Grille
-	//===================================================
-	if (showGribGrid) {
-		pnt.setPen(QColor (40,40,40));
-		plotter->draw_GridPoints (colorMapData, pnt, proj);
+					Util::formatTemperature_short, pnt, proj, &labelPlacer);
 	}
 }
 //-------------------------------------------------------------
@@ -647,7 +962,7 @@ void MapDrawer::draw_Cartouche_Gridded
 	else if (dtmp.dataType == GRB_PRV_CUR_XY2D)
 			dtmp.dataType = GRB_CUR_VX;
 	
-	GriddedRecord *rec = reader->getRecord (dtmp, plotter->getCurrentDate());
+	GriddedRecord *rec = reader->getRecordAtDate (dtmp, plotter->getCurrentDate());
 	if (rec && rec->isOk()) {
 		origine = DataCodeStr::toString (rec->getDataCenterModel());
 		duplicated = rec->isDuplicated() ? " (dup)" : "";
@@ -942,12 +1257,9 @@ QPixmap * MapDrawer::createPixmap_GriddedData (
 		else {
 			this->draw_GSHHS (pnt, true, isEarthMapValid, proj);
 		}
-		// Ajoute les pOIs visibles
+		// Ajoute les POIs (drawContent ignore ceux hors de la carte)
 		for (int i=0; i<lspois.size(); i++) {
-			POI *poi = lspois.at(i);
-			if (poi->isVisible()) {
-				poi->drawContent (pnt, proj, true);
-			}
+			lspois.at(i)->drawContent (pnt, proj);
 		}
 	pnt.end();
 	return pixmap;
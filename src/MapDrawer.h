@@ -21,6 +21,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QWidget>
 #include <QBitmap>
+#include <QImage>
+#include <QStringList>
+#include <QMutex>
+#include <QAtomicInt>
 
 #include "GshhsReader.h"
 #include "GisReader.h"
@@ -41,7 +45,34 @@ friend class Terrain;	// TODO (or not) getters setters
 	public:
 		MapDrawer(GshhsReader *gshhsReader);
 		MapDrawer(const MapDrawer &model);
+		MapDrawer();		// only the options (no map readers)
 		~MapDrawer();
+		
+		// Options of the drawing (flags, steps, colors...) of the model
+		void copyOptions (const MapDrawer &model);
+		// The drawing stops between 2 layers when *flag is not 0
+		void setAbortFlag (const QAtomicInt *flag)   {abortFlag = flag;}
+		bool isAborted () const  {return abortFlag!=NULL && abortFlag->load()!=0;}
+
+		// Layers of the map, each one cached in its own image.
+		// A layer is drawn again only when its key changes.
+		enum MapLayer {
+			LAYER_EARTH = 0,	// sea and land
+			LAYER_COLORMAP,
+			LAYER_ISOLINES,		// (or IAC data)
+			LAYER_ARROWS,		// arrows and grid points
+			LAYER_BORDERS,		// coasts, boundaries, rivers, lon/lat grid
+			LAYER_LABELS,		// names, isolines labels, data labels
+			LAYER_CARTOUCHE,
+			LAYER_POIS,			// not cached here : times given by Terrain
+			NB_MAP_LAYERS
+		};
+		// Data changed outside of MapDrawer (plotter options)
+		void invalidateData ()   {dataGeneration ++;}
+		
+		// Render times of the layers (debug, read from the GUI thread)
+		void addRenderTime    (int layer, double ms);
+		void draw_RenderTimes (QPainter &pnt, int W);
 
 		void draw_GSHHS_and_GriddedData (
 				QPainter &pntGlobal,
@@ -90,8 +121,24 @@ friend class Terrain;	// TODO (or not) getters setters
 						QList<POI*> lspois );
 					
 	private:
-		QPixmap     *imgEarth;   // images précalculées pour accélérer l'affichage
-		QPixmap     *imgAll;
+		QImage      *imgAll;	// layers composition (drawn in the map thread)
+		
+		QImage      *layerImg  [NB_MAP_LAYERS];
+		QString      layerKey  [NB_MAP_LAYERS];
+		double       layerLastMs  [NB_MAP_LAYERS];
+		double       layerTotalMs [NB_MAP_LAYERS];
+		int          layerCount   [NB_MAP_LAYERS];
+		QMutex       timesMutex;
+		const QAtomicInt *abortFlag;
+		std::set<DataCenterModel> layerDataCenters [NB_MAP_LAYERS];
+		uint         dataGeneration;
+		
+		// Isolines of the current layer, kept for the labels layer
+		std::vector <IsoLine *> listIsobars;
+		std::vector <IsoLine *> listIsotherms0;
+		std::vector <IsoLine *> listGeopotential;
+		std::vector <IsoLine *> listIsotherms;
+		std::vector <IsoLine *> listLinesThetaE;
 		
 		GshhsReader *gshhsReader;
 		bool         gshhsReaderIsNew;
@@ -99,6 +146,10 @@ friend class Terrain;	// TODO (or not) getters setters
 		GisReader	*gisReader;
 		bool		 gisReaderIsNew;
 		
+		// Labels of the current frame (cities first, then data)
+		LabelPlacer  labelPlacer;
+		std::vector <GisCityLabel> citiesLabels;
+		
 		int   showCitiesNamesLevel;
 		bool  showCountriesNames;
 		bool  showCountriesBorders;
@@ -164,15 +215,29 @@ friend class Terrain;	// TODO (or not) getters setters
 
 		void	updateGraphicsParameters();
 		void	initGraphicsParameters  ();
-		void    addUsedDataCenterModel (const DataCode &dtc, GriddedPlotter *plotter);
+		void    initLayers ();
+		void    invalidateLayers ();
+		void    clearIsolines ();
+		void    addUsedDataCenterModel (int layer, const DataCode &dtc, GriddedPlotter *plotter);
+		
+		QString getLayerKey   (int layer, Projection *proj,
+							   GriddedPlotter *plotter, IacPlot *iacPlot);
+		void    update_Layer  (int layer, Projection *proj,
+							   GriddedPlotter *plotter, IacPlot *iacPlot);
+		void    compose_Layers (QPainter &pntGlobal, Projection *proj,
+							   const int *layers, int nbLayers);
 		
 		void 	draw_MeteoData_IAC   (QPainter &pnt, Projection *proj, IacPlot *iacPlot);
-		void    draw_MeteoData_Gridded 
-						( QPainter &pnt, Projection *proj,
-						GriddedPlotter   *plotter );
+		
+		void    prepare_MeteoData_Gridded (GriddedPlotter *plotter);
+		void    draw_MeteoData_ColorMap (QPainter &pnt, Projection *proj, GriddedPlotter *plotter);
+		void    draw_MeteoData_Isolines (QPainter &pnt, Projection *proj, GriddedPlotter *plotter);
+		void    draw_MeteoData_Arrows   (QPainter &pnt, Projection *proj, GriddedPlotter *plotter);
+		void    draw_MeteoData_Labels   (QPainter &pnt, Projection *proj, GriddedPlotter *plotter);
 
-		void	draw_Map_Background  (bool isEarthMapValid, Projection *proj);
+		void	draw_Map_Background  (QPainter &pnt, Projection *proj);
 		void	draw_Map_Foreground  (QPainter &pnt, Projection *proj);
+		void	draw_Map_Labels      (QPainter &pnt, Projection *proj, GriddedPlotter *plotter);
 };
 
 
@@ -0,0 +1,220 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <cassert>
+
+#include <QPainter>
+
+#include "MapRenderer.h"
+
+//---------------------------------------------------------------------
+bool MapFrame::isSameView (const Projection *proj) const
+{
+	return W == proj->getW() && H == proj->getH()
+			&& cx == proj->getCX() && cy == proj->getCY()
+			&& scale == proj->getScale();
+}
+
+//=====================================================================
+MapRenderer::MapRenderer (const MapDrawer &model, QObject *parent)
+	: QThread (parent), dataMutex (QMutex::Recursive)
+{
+	drawer = new MapDrawer (model);
+	assert (drawer);
+	drawer->setAbortFlag (&abortFrame);
+	reqOptions = new MapDrawer ();
+	assert (reqOptions);
+	stopping = false;
+	lastGeneration = 0;
+	droppedGeneration = 0;
+	hasRequest = false;
+	reqProj = NULL;
+	reqFileType = DATATYPE_NONE;
+	reqPlotter = NULL;
+	reqIacPlot = NULL;
+	reqEarthMapValid = false;
+	reqDrawCartouche = true;
+	hasFrame = false;
+}
+//---------------------------------------------------------------------
+MapRenderer::~MapRenderer ()
+{
+	mutex.lock ();
+	stopping = true;
+	wakeUp.wakeAll ();
+	mutex.unlock ();
+	abortFrame.ref ();
+	wait ();
+	delete reqProj;
+	delete reqOptions;
+	delete drawer;
+}
+//---------------------------------------------------------------------
+uint MapRenderer::requestFrame (const MapDrawer &options, const Projection *proj,
+							FileDataType fileType,
+							GriddedPlotter *plotter, IacPlot *iacPlot,
+							bool isEarthMapValid, bool drawCartouche)
+{
+	Projection *clone = const_cast <Projection *> (proj)->clone ();
+	assert (clone);
+	QMutexLocker lock (&mutex);
+	if (hasRequest) {
+		// the dropped request may have asked to draw the whole map again
+		isEarthMapValid = isEarthMapValid && reqEarthMapValid;
+	}
+	delete reqProj;
+	reqProj = clone;
+	reqOptions->copyOptions (options);
+	reqFileType = fileType;
+	reqPlotter = plotter;
+	reqIacPlot = iacPlot;
+	reqEarthMapValid = isEarthMapValid;
+	reqDrawCartouche = drawCartouche;
+	hasRequest = true;
+	lastGeneration ++;
+	wakeUp.wakeOne ();
+	return lastGeneration;
+}
+//---------------------------------------------------------------------
+bool MapRenderer::takeFrame (MapFrame &frame)
+{
+	QMutexLocker lock (&mutex);
+	if (! hasFrame)
+		return false;
+	frame = readyFrame;
+	readyFrame.image = QImage ();
+	hasFrame = false;
+	return true;
+}
+//---------------------------------------------------------------------
+void MapRenderer::lockData ()
+{
+	abortFrame.ref ();
+	mutex.lock ();
+	if (hasRequest) {
+		hasRequest = false;
+		delete reqProj;
+		reqProj = NULL;
+	}
+	droppedGeneration = lastGeneration;
+	mutex.unlock ();
+	dataMutex.lock ();
+}
+//---------------------------------------------------------------------
+void MapRenderer::unlockData ()
+{
+	dataMutex.unlock ();
+	abortFrame.deref ();
+}
+//---------------------------------------------------------------------
+void MapRenderer::run ()
+{
+	while (true)
+	{
+		mutex.lock ();
+		while (!hasRequest && !stopping)
+			wakeUp.wait (&mutex);
+		if (stopping) {
+			mutex.unlock ();
+			break;
+		}
+		Projection *proj = reqProj;
+		reqProj = NULL;
+		hasRequest = false;
+		uint generation = lastGeneration;
+		FileDataType fileType = reqFileType;
+		GriddedPlotter *plotter = reqPlotter;
+		IacPlot *iacPlot = reqIacPlot;
+		bool isEarthMapValid = reqEarthMapValid;
+		bool drawCartouche = reqDrawCartouche;
+		drawer->copyOptions (*reqOptions);
+		mutex.unlock ();
+
+		dataMutex.lock ();
+		mutex.lock ();
+		bool dropped = generation <= droppedGeneration;	// data changed since
+		mutex.unlock ();
+		bool ok = false;
+		if (! dropped)
+			ok = render (proj, fileType, plotter, iacPlot,
+						 isEarthMapValid, drawCartouche);
+		dataMutex.unlock ();
+
+		if (ok) {
+			MapFrame frame;
+			frame.generation = generation;
+			frame.W = proj->getW();
+			frame.H = proj->getH();
+			frame.cx = proj->getCX();
+			frame.cy = proj->getCY();
+			frame.scale = proj->getScale();
+			proj->screen2map (0,0, &frame.x0, &frame.y0);
+			proj->screen2map (frame.W,frame.H, &frame.x1, &frame.y1);
+			frame.image.swap (backBuffer);
+			mutex.lock ();
+			// the image not taken by the view becomes the next back buffer
+			if (hasFrame)
+				backBuffer.swap (readyFrame.image);
+			readyFrame = frame;
+			hasFrame = true;
+			mutex.unlock ();
+			emit frameReady ();
+		}
+		delete proj;
+	}
+}
+//---------------------------------------------------------------------
+// Draws the map in the back buffer (false if aborted)
+//---------------------------------------------------------------------
+bool MapRenderer::render (Projection *proj, FileDataType fileType,
+						  GriddedPlotter *plotter, IacPlot *iacPlot,
+						  bool isEarthMapValid, bool drawCartouche)
+{
+	if (abortFrame.load() != 0)
+		return false;
+	int W = proj->getW();
+	int H = proj->getH();
+	if (W <= 0 || H <= 0)
+		return false;
+	if (backBuffer.width() != W || backBuffer.height() != H)
+		backBuffer = QImage (W, H, QImage::Format_ARGB32_Premultiplied);
+	QPainter pnt (&backBuffer);
+	switch (fileType) {
+		case DATATYPE_GRIB :
+		case DATATYPE_MBLUE :
+			if (plotter != NULL) {
+				drawer->draw_GSHHS_and_GriddedData
+					(pnt, true, isEarthMapValid, proj, plotter, drawCartouche);
+				break;
+			}
+			drawer->draw_GSHHS (pnt, true, isEarthMapValid, proj);
+			break;
+		case DATATYPE_IAC :
+			if (iacPlot != NULL) {
+				drawer->draw_GSHHS_and_IAC
+					(pnt, true, isEarthMapValid, proj, iacPlot, drawCartouche);
+				break;
+			}
+			drawer->draw_GSHHS (pnt, true, isEarthMapValid, proj);
+			break;
+		default :
+			drawer->draw_GSHHS (pnt, true, isEarthMapValid, proj);
+	}
+	pnt.end ();
+	return ! drawer->isAborted ();
+}
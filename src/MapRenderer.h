@@ -0,0 +1,122 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef MAPRENDERER_H
+#define MAPRENDERER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QImage>
+
+#include "MapDrawer.h"
+
+//==============================================================================
+// Image of the map made by the map thread
+//==============================================================================
+class MapFrame
+{
+	public:
+		MapFrame ()  {generation = 0; W = H = 0; cx = cy = scale = 0;
+					  x0 = y0 = x1 = y1 = 0;}
+
+		QImage image;
+		uint   generation;			// of the request
+		int    W, H;				// projection used for the image
+		double cx, cy, scale;
+		double x0,y0, x1,y1;		// map position of the corners
+
+		bool   isNull () const   {return image.isNull();}
+		// Is the image drawn with this projection ?
+		bool   isSameView (const Projection *proj) const;
+};
+
+//==============================================================================
+// Draws the map in its own thread.
+// A request is a snapshot of the view (projection, options of the
+// drawer, plotter of the data). Only the last request is kept: the
+// older ones are dropped. Finished images are announced by frameReady.
+// The data of the plotters must be modified only between lockData and
+// unlockData, which also drop the current image and the waiting request.
+//
+// The plotter is not copied in the request: it shares the records of its
+// reader (the whole file) and its own caches (pyramids, sprites). It is
+// read in place, frozen by dataMutex while an image is drawn: every change
+// of the GUI (date, options, loading, closing) takes lockData, which stops
+// the drawing at the end of the current layer. The GUI thread may read the
+// plotter at the same time (meteo tables): only the caches are written then,
+// each under its own mutex. dataMutex is recursive, so code of the GUI
+// thread called under lockData may take it again.
+//==============================================================================
+class MapRenderer : public QThread
+{ Q_OBJECT
+	public:
+		MapRenderer (const MapDrawer &model, QObject *parent=NULL);
+		~MapRenderer ();
+
+		// Returns the generation of the request (increasing)
+		uint  requestFrame (const MapDrawer &options, const Projection *proj,
+							FileDataType fileType,
+							GriddedPlotter *plotter, IacPlot *iacPlot,
+							bool isEarthMapValid, bool drawCartouche);
+		// Last finished image (false if there is no new one)
+		bool  takeFrame (MapFrame &frame);
+
+		void  lockData ();		// waits for the end of the current layer
+		void  unlockData ();
+
+		// Drawer of the map thread (use it between lockData and unlockData,
+		// except for the render times)
+		MapDrawer * getDrawer ()   {return drawer;}
+
+	signals:
+		void  frameReady ();
+
+	protected:
+		void  run ();
+
+	private:
+		MapDrawer  *drawer;
+
+		QMutex      mutex;			// members below
+		QWaitCondition wakeUp;
+		bool        stopping;
+		uint        lastGeneration;
+		uint        droppedGeneration;	// requests up to this one are dropped
+		bool        hasRequest;
+		MapDrawer  *reqOptions;
+		Projection *reqProj;
+		FileDataType    reqFileType;
+		GriddedPlotter *reqPlotter;
+		IacPlot    *reqIacPlot;
+		bool        reqEarthMapValid;
+		bool        reqDrawCartouche;
+		bool        hasFrame;
+		MapFrame    readyFrame;
+
+		QMutex      dataMutex;		// held while an image is drawn (recursive)
+		QAtomicInt  abortFrame;		// number of lockData waiting
+		QImage      backBuffer;
+
+		bool  render (Projection *proj, FileDataType fileType,
+					  GriddedPlotter *plotter, IacPlot *iacPlot,
+					  bool isEarthMapValid, bool drawCartouche);
+};
+
+#endif
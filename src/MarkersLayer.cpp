@@ -0,0 +1,209 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#include "MarkersLayer.h"
+
+#define MARKERS_CELL_DEG   2		// geographic cells (degrees)
+#define MARKERS_NB_LON   (360/MARKERS_CELL_DEG)
+#define MARKERS_NB_LAT   (180/MARKERS_CELL_DEG)
+#define MARKERS_CELL_PIX  64		// screen cells (pixels)
+
+//-------------------------------------------------------------------------------
+MarkersLayer::MarkersLayer ()
+{
+	valid = false;
+	screenNi = screenNj = 0;
+}
+//-------------------------------------------------------------------------------
+static int markerCell (double lon, double lat)
+{
+	while (lon < -180)
+		lon += 360;
+	while (lon >= 180)
+		lon -= 360;
+	int i = (int) floor ((lon+180)/MARKERS_CELL_DEG);
+	int j = (int) floor ((lat+90)/MARKERS_CELL_DEG);
+	i = std::max (0, std::min (MARKERS_NB_LON-1, i));
+	j = std::max (0, std::min (MARKERS_NB_LAT-1, j));
+	return j*MARKERS_NB_LON + i;
+}
+//-------------------------------------------------------------------------------
+void MarkersLayer::setMarkers (const QList<POI*> &lspois,
+							   const QList<MetarMarker*> &lsmetars)
+{
+	items.clear ();
+	drawn.clear ();
+	screenNi = screenNj = 0;
+	for (int i=0; i < lsmetars.size(); i++) {
+		MetarMarker *m = lsmetars.at(i);
+		MarkerItem it = {m->getLongitude(), m->getLatitude(), NULL, m};
+		items.push_back (it);
+	}
+	for (int i=0; i < lspois.size(); i++) {
+		POI *poi = lspois.at(i);
+		if (poi->isValid()) {
+			MarkerItem it = {poi->getLongitude(), poi->getLatitude(), poi, NULL};
+			items.push_back (it);
+		}
+	}
+	// Items sorted by cell (counting sort), keeping their order in a cell
+	int nbcells = MARKERS_NB_LON*MARKERS_NB_LAT;
+	cellStart.assign (nbcells+1, 0);
+	std::vector <int> cells (items.size());
+	for (size_t k=0; k < items.size(); k++) {
+		cells[k] = markerCell (items[k].lon, items[k].lat);
+		cellStart [cells[k]+1] ++;
+	}
+	for (int c=0; c < nbcells; c++)
+		cellStart [c+1] += cellStart [c];
+	cellItems.resize (items.size());
+	std::vector <int> pos (cellStart.begin(), cellStart.end()-1);
+	for (size_t k=0; k < items.size(); k++)
+		cellItems [pos[cells[k]]++] = k;
+	valid = true;
+}
+//-------------------------------------------------------------------------------
+// Indexes of the items in the cells of the visible area, in items order
+//-------------------------------------------------------------------------------
+void MarkersLayer::findVisibleItems (Projection *proj, std::vector <int> &res) const
+{
+	res.clear ();
+	if (items.empty())
+		return;
+	double x0,y0, x1,y1;
+	proj->getVisibleArea (&x0,&y0, &x1,&y1);
+	int i0, ni;
+	if (x1-x0 >= 360) {
+		i0 = 0;
+		ni = MARKERS_NB_LON;
+	}
+	else {		// longitudes may be outside [-180,180]
+		i0 = (int) floor ((x0+180)/MARKERS_CELL_DEG);
+		ni = (int) floor ((x1+180)/MARKERS_CELL_DEG) - i0 + 1;
+		ni = std::min (ni, MARKERS_NB_LON);
+	}
+	int j0 = std::max (0, (int) floor ((std::min(y0,y1)+90)/MARKERS_CELL_DEG));
+	int j1 = std::min (MARKERS_NB_LAT-1,
+					   (int) floor ((std::max(y0,y1)+90)/MARKERS_CELL_DEG));
+	for (int j=j0; j <= j1; j++) {
+		for (int n=0; n < ni; n++) {
+			int i = ((i0+n) % MARKERS_NB_LON + MARKERS_NB_LON) % MARKERS_NB_LON;
+			int c = j*MARKERS_NB_LON + i;
+			for (int k=cellStart[c]; k < cellStart[c+1]; k++)
+				res.push_back (cellItems[k]);
+		}
+	}
+	std::sort (res.begin(), res.end());
+}
+//-------------------------------------------------------------------------------
+void MarkersLayer::draw (QPainter &pnt, Projection *proj,
+						 bool showPOIs, bool showMETARs)
+{
+	drawn.clear ();
+	if (proj == NULL)
+		return;
+	std::vector <int> visibles;
+	if (showPOIs || showMETARs)
+		findVisibleItems (proj, visibles);
+	for (size_t n=0; n < visibles.size(); n++) {
+		const MarkerItem &it = items [visibles[n]];
+		DrawnItem d = {QRect(), it.poi, it.metar};
+		if (it.poi != NULL) {
+			if (! showPOIs || ! it.poi->getScreenRect (proj, &d.rect))
+				continue;
+			it.poi->drawContent (pnt, proj);
+		}
+		else {
+			int pi, pj;
+			if (! showMETARs || ! proj->map2screen_glob (it.lon, it.lat, &pi, &pj))
+				continue;
+			if (airportPixmap.isNull())
+				airportPixmap = QPixmap (Util::pathImg("airport.png"));
+			d.rect = QRect (pi-airportPixmap.width()/2, pj-airportPixmap.height()/2,
+							airportPixmap.width(), airportPixmap.height());
+			it.metar->drawContent (pnt, airportPixmap, pi, pj);
+		}
+		drawn.push_back (d);
+	}
+	indexDrawnItems (proj->getW(), proj->getH());
+}
+//-------------------------------------------------------------------------------
+void MarkersLayer::indexDrawnItems (int W, int H)
+{
+	screenNi = std::max (1, (W+MARKERS_CELL_PIX-1)/MARKERS_CELL_PIX);
+	screenNj = std::max (1, (H+MARKERS_CELL_PIX-1)/MARKERS_CELL_PIX);
+	screenStart.assign (screenNi*screenNj+1, 0);
+	// A marker is registered in all the cells covered by its rectangle
+	for (int pass=0; pass < 2; pass++) {
+		std::vector <int> pos;
+		if (pass == 1) {
+			for (int c=0; c < screenNi*screenNj; c++)
+				screenStart [c+1] += screenStart [c];
+			screenItems.resize (screenStart.back());
+			pos.assign (screenStart.begin(), screenStart.end()-1);
+		}
+		for (size_t k=0; k < drawn.size(); k++) {
+			const QRect &r = drawn[k].rect;
+			int ci0 = std::max (0, r.left()/MARKERS_CELL_PIX);
+			int ci1 = std::min (screenNi-1, r.right()/MARKERS_CELL_PIX);
+			int cj0 = std::max (0, r.top()/MARKERS_CELL_PIX);
+			int cj1 = std::min (screenNj-1, r.bottom()/MARKERS_CELL_PIX);
+			for (int cj=cj0; cj <= cj1; cj++)
+				for (int ci=ci0; ci <= ci1; ci++) {
+					int c = cj*screenNi + ci;
+					if (pass == 0)
+						screenStart [c+1] ++;
+					else
+						screenItems [pos[c]++] = k;
+				}
+		}
+	}
+}
+//-------------------------------------------------------------------------------
+const MarkersLayer::DrawnItem * MarkersLayer::findDrawn
+							(int x, int y, bool wantPOI) const
+{
+	if (x < 0 || y < 0 || drawn.empty())
+		return NULL;
+	int ci = x/MARKERS_CELL_PIX;
+	int cj = y/MARKERS_CELL_PIX;
+	if (ci >= screenNi || cj >= screenNj)
+		return NULL;
+	int c = cj*screenNi + ci;
+	for (int k=screenStart[c+1]-1; k >= screenStart[c]; k--) {	// topmost first
+		const DrawnItem &d = drawn [screenItems[k]];
+		if ((d.poi != NULL) == wantPOI && d.rect.contains (x,y))
+			return &d;
+	}
+	return NULL;
+}
+//-------------------------------------------------------------------------------
+POI * MarkersLayer::findPOI (int x, int y) const
+{
+	const DrawnItem *d = findDrawn (x, y, true);
+	return d ? d->poi : NULL;
+}
+//-------------------------------------------------------------------------------
+MetarMarker * MarkersLayer::findMetar (int x, int y) const
+{
+	const DrawnItem *d = findDrawn (x, y, false);
+	return d ? d->metar : NULL;
+}
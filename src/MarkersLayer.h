@@ -0,0 +1,85 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef MARKERSLAYER_H
+#define MARKERSLAYER_H
+
+#include <vector>
+
+#include <QPainter>
+#include <QPixmap>
+#include <QRect>
+#include <QList>
+
+#include "Projection.h"
+#include "POI.h"
+#include "Metar.h"
+
+//==============================================================================
+// Points of interest and METAR stations, drawn by the map on one layer.
+// Markers are indexed by lon/lat cells to draw only the visible ones,
+// and the drawn markers are indexed by screen cells for the mouse.
+//==============================================================================
+class MarkersLayer
+{
+	public:
+		MarkersLayer ();
+
+		// Rebuild the geographic index (markers added, removed or moved)
+		void  setMarkers (const QList<POI*> &lspois,
+						  const QList<MetarMarker*> &lsmetars);
+		void  invalidate ()  {valid = false;}
+		bool  isValid ()     {return valid;}
+
+		void  draw (QPainter &pnt, Projection *proj,
+					bool showPOIs, bool showMETARs);
+
+		// Topmost marker drawn at screen position (x,y), or NULL
+		POI         * findPOI   (int x, int y) const;
+		MetarMarker * findMetar (int x, int y) const;
+
+	private:
+		struct MarkerItem {
+			double lon, lat;
+			POI         *poi;
+			MetarMarker *metar;
+		};
+		struct DrawnItem {
+			QRect rect;
+			POI         *poi;
+			MetarMarker *metar;
+		};
+		bool  valid;
+
+		std::vector <MarkerItem> items;		// METARs first, POIs drawn above
+		std::vector <int> cellStart;		// lon/lat cell => first index in cellItems
+		std::vector <int> cellItems;
+
+		std::vector <DrawnItem> drawn;		// in drawing order
+		std::vector <int> screenStart;		// screen cell => first index in screenItems
+		std::vector <int> screenItems;
+		int   screenNi, screenNj;
+
+		QPixmap  airportPixmap;
+
+		void  findVisibleItems (Projection *proj, std::vector <int> &res) const;
+		void  indexDrawnItems  (int W, int H);
+		const DrawnItem * findDrawn (int x, int y, bool wantPOI) const;
+};
+
+#endif
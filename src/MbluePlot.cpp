@@ -37,7 +37,7 @@ MbluePlot::~MbluePlot ()
 }
 //--------------------------------------------------------------------
 void  MbluePlot::loadFile (QString fname,
-						   LongTaskProgress *taskProgress, int /*nbrecs*/)
+						   LongTaskProgress *taskProgress)
 {
 	if (reader != NULL) {
 		delete reader;
@@ -67,15 +67,15 @@ void MbluePlot::draw_GridPoints ( const DataCode &,
 	if (rec == NULL)
 		return;
 	
-	std::vector <MbluePoint *> *lspoints = rec->getListPoints ();
-	std::vector <MbluePoint *>::iterator itp;
-	for (itp=lspoints->begin(); itp != lspoints->end(); itp++) {
-		MbluePoint *pt = *itp;
+	int nbpts = rec->getNbPoints ();
+	for (int k=0; k<nbpts; k++) {
+		double x = rec->getPointX (k);
+		double y = rec->getPointY (k);
 		int px,py, dl=2;
-		proj->map2screen(pt->x, pt->y, &px,&py);
+		proj->map2screen(x, y, &px,&py);
 		pnt.drawLine(px-dl,py, px+dl,py);
 		pnt.drawLine(px,py-dl, px,py+dl);
-		proj->map2screen(pt->x-360.0, pt->y, &px,&py);
+		proj->map2screen(x-360.0, y, &px,&py);
 		pnt.drawLine(px-dl,py, px+dl,py);
 		pnt.drawLine(px,py-dl, px,py+dl);
 	}
@@ -109,22 +109,22 @@ void MbluePlot::draw_WIND_Arrows (
 
 	if (drawWindArrowsOnGrid)
     {	// Flèches uniquement sur les points de la grille
-		std::vector <MbluePoint *> *lspoints = rec->getListPoints ();
-		std::vector <MbluePoint *>::iterator itp;
-		for (itp=lspoints->begin(); itp != lspoints->end(); itp++) {
-			MbluePoint *pt = *itp;
-			x = pt->x;
-			y = pt->y;
+		int nbpts = rec->getNbPoints ();
+		for (int k=0; k<nbpts; k++) {
+			x = rec->getPointX (k);
+			y = rec->getPointY (k);
 			if (! rec->isXInMap(x))
 				x += 360.0;   // tour du monde ?
+			proj->map2screen (x,y, &i,&j);
+			if (i < -space || i > W+space || j < -space || j > H+space)
+				continue;	// not visible
 			if (rec->isPointInMap(x,y)) {
-				vx = pt->getValue (DataCode (GRB_WIND_VX,windAltitude));
-				vy = pt->getValue (DataCode (GRB_WIND_VY,windAltitude));
-				proj->map2screen (x,y, &i,&j);
+				vx = rec->getPointValue (DataCode (GRB_WIND_VX,windAltitude), k);
+				vy = rec->getPointValue (DataCode (GRB_WIND_VY,windAltitude), k);
 				if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF)
 				{
 					if (barbules)
-						drawWindArrowWithBarbs(pnt, i,j, vx,vy, (y<0), arrowsColor);
+						drawWindArrowWithBarbs_sprite(pnt, i,j, vx,vy, (y<0), arrowsColor);
 					else
 						drawWindArrow(pnt, i,j, vx,vy);
 				}
@@ -148,7 +148,7 @@ void MbluePlot::draw_WIND_Arrows (
 					if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF)
 					{
 						if (barbules)
-							drawWindArrowWithBarbs(pnt, i,j, vx,vy, (y<0), arrowsColor);
+							drawWindArrowWithBarbs_sprite(pnt, i,j, vx,vy, (y<0), arrowsColor);
 						else
 							drawWindArrow(pnt, i,j, vx,vy);
 					}
@@ -188,18 +188,18 @@ void MbluePlot::draw_CURRENT_Arrows (
 
 	if (drawCurrentArrowsOnGrid)
     {	// Flèches uniquement sur les points de la grille
-		std::vector <MbluePoint *> *lspoints = rec->getListPoints ();
-		std::vector <MbluePoint *>::iterator itp;
-		for (itp=lspoints->begin(); itp != lspoints->end(); itp++) {
-			MbluePoint *pt = *itp;
-			x = pt->x;
-			y = pt->y;
+		int nbpts = rec->getNbPoints ();
+		for (int k=0; k<nbpts; k++) {
+			x = rec->getPointX (k);
+			y = rec->getPointY (k);
 			if (! rec->isXInMap(x))
 				x += 360.0;   // tour du monde ?
+			proj->map2screen (x,y, &i,&j);
+			if (i < -space || i > W+space || j < -space || j > H+space)
+				continue;	// not visible
 			if (rec->isPointInMap(x,y)) {
-				cx = pt->getValue (DataCode (GRB_CUR_VX,LV_ABOV_GND,10));
-				cy = pt->getValue (DataCode (GRB_CUR_VY,LV_ABOV_GND,10));
-				proj->map2screen (x,y, &i,&j);
+				cx = rec->getPointValue (DataCode (GRB_CUR_VX,LV_ABOV_GND,10), k);
+				cy = rec->getPointValue (DataCode (GRB_CUR_VY,LV_ABOV_GND,10), k);
 				if (cx != GRIB_NOTDEF && cy != GRIB_NOTDEF)
 				{
 					drawWindArrow(pnt, i,j, cx,cy);
@@ -40,7 +40,7 @@ class MbluePlot : public IrregularGridPlot
         virtual ~MbluePlot();
 
 		void  loadFile (QString fileName,
-						LongTaskProgress *taskProgress, int nbrecs);
+						LongTaskProgress *taskProgress);
 		
 		virtual bool  isReaderOk() const
 					{return reader!=NULL && reader->isOk();}						
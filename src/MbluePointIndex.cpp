@@ -0,0 +1,242 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+
+#include "MbluePointIndex.h"
+
+//===========================================================
+// MbluePointIndex
+//===========================================================
+#define MBLUE_POINTS_BY_CELL      4
+#define MBLUE_STENCIL_CACHE_MIN_BITS  12		// 4096 entries
+#define MBLUE_STENCIL_CACHE_MAX_BITS  19
+
+MbluePointIndex::MbluePointIndex (
+						std::vector <float> &vx,
+						std::vector <float> &vy,
+						double xmin, double xmax, double ymin, double ymax)
+{
+	ptx.swap (vx);
+	pty.swap (vy);
+	this->xmin = xmin;
+	this->xmax = xmax;
+	this->ymin = ymin;
+	this->ymax = ymax;
+	
+	double w = xmax-xmin;
+	double h = ymax-ymin;
+	if (w <= 0) w = 1;
+	if (h <= 0) h = 1;
+	int nbcells = ptx.size()/MBLUE_POINTS_BY_CELL;
+	cellsNj = (int) sqrt (nbcells*h/w);
+	cellsNi = (int) (cellsNj*w/h);
+	if (cellsNi < 1)
+		cellsNi = 1;
+	if (cellsNj < 1)
+		cellsNj = 1;
+	cellW = w/cellsNi;
+	cellH = h/cellsNj;
+	
+	// points sorted by cell
+	int nbpts = ptx.size();
+	std::vector <int> vcell (nbpts);
+	cellStart.assign (cellsNi*cellsNj+1, 0);
+	for (int k=0; k<nbpts; k++) {
+		vcell[k] = getCellJ(pty[k])*cellsNi + getCellI(ptx[k]);
+		cellStart [vcell[k]+1] ++;
+	}
+	for (int c=0; c<cellsNi*cellsNj; c++)
+		cellStart [c+1] += cellStart [c];
+	std::vector <int> pos (cellStart.begin(), cellStart.end()-1);
+	cellPoints.resize (nbpts);
+	for (int k=0; k<nbpts; k++)
+		cellPoints [pos[vcell[k]]++] = k;
+	
+	// first size of the caches: about 2 entries by point
+	initialCacheBits = MBLUE_STENCIL_CACHE_MIN_BITS;
+	while (initialCacheBits < MBLUE_STENCIL_CACHE_MAX_BITS
+				&& (1<<initialCacheBits) < 2*nbpts)
+		initialCacheBits ++;
+	
+	makeGridStencils ();
+}
+//-----------------------------------------------------
+bool MbluePointIndex::hasSamePoints (
+						const std::vector <float> &ptx,
+						const std::vector <float> &pty) const
+{
+	return this->ptx == ptx && this->pty == pty;
+}
+//-----------------------------------------------------
+int MbluePointIndex::getCellI (double x) const
+{
+	int i = (int) floor ((x-xmin)/cellW);
+	if (i < 0) i = 0;
+	else if (i >= cellsNi) i = cellsNi-1;
+	return i;
+}
+//-----------------------------------------------------
+int MbluePointIndex::getCellJ (double y) const
+{
+	int j = (int) floor ((y-ymin)/cellH);
+	if (j < 0) j = 0;
+	else if (j >= cellsNj) j = cellsNj-1;
+	return j;
+}
+//-----------------------------------------------------
+void MbluePointIndex::findNeighbours (double x, double y, MblueStencil *st) const
+{
+	double d[4];
+	int    p[4];
+	int    nb = 0;
+	int ci = getCellI (x);
+	int cj = getCellJ (y);
+	for (int r=0; ; r++)
+	{
+		int i0=ci-r, i1=ci+r, j0=cj-r, j1=cj+r;
+		// cells of the ring r
+		for (int j=j0; j<=j1; j++) {
+			if (j<0 || j>=cellsNj)
+				continue;
+			int step = (j==j0 || j==j1 || i1==i0) ? 1 : i1-i0;
+			for (int i=i0; i<=i1; i+=step) {
+				if (i<0 || i>=cellsNi)
+					continue;
+				int c = j*cellsNi+i;
+				for (int n=cellStart[c]; n<cellStart[c+1]; n++) {
+					int k = cellPoints [n];
+					double dk = (ptx[k]-x)*(ptx[k]-x)+(pty[k]-y)*(pty[k]-y);
+					if (nb==4 && dk>=d[3])
+						continue;
+					// sorted insertion
+					int m = (nb<4) ? nb++ : 3;
+					while (m>0 && d[m-1]>dk) {
+						d[m] = d[m-1];
+						p[m] = p[m-1];
+						m --;
+					}
+					d[m] = dk;
+					p[m] = k;
+				}
+			}
+		}
+		if (i0<=0 && j0<=0 && i1>=cellsNi-1 && j1>=cellsNj-1)
+			break;		// all cells are visited
+		if (nb == 4) {
+			// distance to the cells not yet visited
+			double dmin = 1e100;
+			if (i0 > 0)          dmin = std::min (dmin, x-(xmin+i0*cellW));
+			if (i1 < cellsNi-1)  dmin = std::min (dmin, xmin+(i1+1)*cellW-x);
+			if (j0 > 0)          dmin = std::min (dmin, y-(ymin+j0*cellH));
+			if (j1 < cellsNj-1)  dmin = std::min (dmin, ymin+(j1+1)*cellH-y);
+			if (dmin > 0 && dmin*dmin >= d[3])
+				break;
+		}
+	}
+	st->nb = nb;
+	for (int m=0; m<nb; m++) {
+		st->pt [m] = p[m];
+		st->d2 [m] = d[m];
+	}
+}
+//-----------------------------------------------------
+void MbluePointIndex::resizeCache (ThreadCache *tc, int bits) const
+{
+	CachedStencil empty;
+	empty.used = false;
+	std::vector <CachedStencil> (1<<bits, empty).swap (tc->entries);
+	tc->bits = bits;
+	tc->used = 0;
+}
+//-----------------------------------------------------
+MbluePointIndex::ThreadCache * MbluePointIndex::getThreadCache () const
+{
+	QThread *thread = QThread::currentThread ();
+	for (int s=0; s<MBLUE_STENCIL_CACHE_THREADS; s++) {
+		if (cacheOwner[s].loadAcquire() == thread)
+			return &cache[s];
+	}
+	for (int s=0; s<MBLUE_STENCIL_CACHE_THREADS; s++) {
+		if (cacheOwner[s].testAndSetOrdered (NULL, thread)) {
+			resizeCache (&cache[s], initialCacheBits);
+			return &cache[s];
+		}
+	}
+	return NULL;	// all slots are used: no cache
+}
+//-----------------------------------------------------
+MblueStencil MbluePointIndex::getStencil (double x, double y) const
+{
+	MblueStencil st;
+	ThreadCache *tc = getThreadCache ();
+	if (tc == NULL) {
+		findNeighbours (x, y, &st);
+		return st;
+	}
+	// The positions are asked again in the same order (one pass by
+	// datacode and date): colliding positions always miss, so the
+	// cache is kept less than 1/8 full (the stencils are computed again).
+	if (tc->used > (int)tc->entries.size()/8
+				&& tc->bits < MBLUE_STENCIL_CACHE_MAX_BITS)
+		resizeCache (tc, tc->bits+1);
+	uint64_t hx, hy;
+	memcpy (&hx, &x, sizeof(hx));
+	memcpy (&hy, &y, sizeof(hy));
+	uint64_t h = hx*0x9E3779B97F4A7C15ULL;
+	h = (h ^ (h>>32) ^ hy) * 0xC2B2AE3D27D4EB4FULL;
+	h ^= h>>29;
+	h *= 0x9E3779B97F4A7C15ULL;
+	CachedStencil &cs = tc->entries [h>>(64-tc->bits)];
+	if (!cs.used || cs.x!=x || cs.y!=y) {
+		if (! cs.used)
+			tc->used ++;
+		cs.used = true;
+		cs.x = x;
+		cs.y = y;
+		findNeighbours (x, y, &cs.st);
+	}
+	return cs.st;
+}
+//-----------------------------------------------------
+// Virtual grid of about one node by point
+//-----------------------------------------------------
+void MbluePointIndex::makeGridStencils ()
+{
+	double dens = ptx.size() / ((xmax-xmin)*(ymax-ymin));
+	double dt = 1 / sqrt (dens);
+	if (dt<0.01)
+			dt = 0.01;
+	gridNi = (int) ceil ((xmax-xmin)/dt);
+	gridNj = (int) ceil ((ymax-ymin)/dt);
+	if (gridNi < 2)
+		gridNi = 2;
+	if (gridNj < 2)
+		gridNj = 2;
+	gridDi = (xmax-xmin)/(gridNi-1) - 1e-12;
+	gridDj = (ymax-ymin)/(gridNj-1) - 1e-12;
+	
+	gridStencils.resize (gridNi*gridNj);
+	for (int j=0; j<gridNj; j++)
+		for (int i=0; i<gridNi; i++)
+			findNeighbours (xmin+i*gridDi, ymin+j*gridDj,
+							&gridStencils[i+j*gridNi]);
+}
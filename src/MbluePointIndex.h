@@ -0,0 +1,122 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef MBLUEPOINTINDEX_H
+#define MBLUEPOINTINDEX_H
+
+#include <vector>
+
+#include <QThread>
+#include <QAtomicPointer>
+
+#define MBLUE_STENCIL_CACHE_THREADS  4	// threads with their own cache
+
+//===================================================
+// Interpolation stencil : the 4 (or less) nearest points
+// of a position and their squared distances.
+//===================================================
+class MblueStencil
+{
+	public:
+		int   nb;
+		int   pt [4];
+		float d2 [4];
+};
+
+//===================================================
+// Spatial index of the points of a record.
+// Points are sorted in the cells of a regular grid (bucket grid),
+// and the nearest points are searched in rings of cells around
+// the position.
+// The index owns the coordinates of the points : records with the
+// same points (usually all the dates of a file) share the same index,
+// so the coordinates are stored once and the cached stencils are
+// reused for all the datacodes and all the dates.
+//===================================================
+class MbluePointIndex
+{
+	public:
+		// The coordinates are taken (vx and vy are left empty)
+		MbluePointIndex (std::vector <float> &vx,
+						 std::vector <float> &vy,
+						 double xmin, double xmax, double ymin, double ymax);
+		
+		int    getNbPoints () const     { return ptx.size(); }
+		double getPointX (int k) const  { return ptx[k]; }
+		double getPointY (int k) const  { return pty[k]; }
+
+		bool hasSamePoints (const std::vector <float> &ptx,
+							const std::vector <float> &pty) const;
+		
+		// Search the 4 nearest points (exact search)
+		void findNeighbours (double x, double y, MblueStencil *st) const;
+		
+		// Same, with a cache (the screen sampling grid is the same
+		// for all the datacodes and all the dates).
+		// Each thread (map thread, GUI thread) has its own cache: no lock.
+		MblueStencil getStencil (double x, double y) const;
+
+		// Virtual regular grid of the points (the same for all the
+		// records sharing the index) and stencils of its nodes.
+		// Computed by the constructor, read only afterwards.
+		int    getGridNi () const    { return gridNi; }
+		int    getGridNj () const    { return gridNj; }
+		double getGridDi () const    { return gridDi; }
+		double getGridDj () const    { return gridDj; }
+		const std::vector <MblueStencil> & getGridStencils () const
+									{ return gridStencils; }
+		
+	private:
+		std::vector <float> ptx, pty;
+		double xmin, xmax, ymin, ymax;
+		
+		int    cellsNi, cellsNj;
+		double cellW, cellH;
+		std::vector <int> cellStart;	// points of cell c are
+		std::vector <int> cellPoints;	// cellPoints[cellStart[c]..cellStart[c+1]-1]
+		int  getCellI (double x) const;
+		int  getCellJ (double y) const;
+		
+		std::vector <MblueStencil> gridStencils;
+		int    gridNi, gridNj;
+		double gridDi, gridDj;
+		void   makeGridStencils ();
+		
+		// direct mapped caches of stencils, one for each thread.
+		// Slot s belongs to the thread cacheOwner[s] (claimed atomically),
+		// cache[s] is only used by this thread.
+		class CachedStencil {
+			public:
+				bool   used;
+				double x, y;
+				MblueStencil st;
+		};
+		class ThreadCache {
+			public:
+				std::vector <CachedStencil> entries;
+				int bits;
+				int used;		// entries used
+		};
+		int initialCacheBits;	// from the number of points
+		mutable QAtomicPointer <QThread>  cacheOwner [MBLUE_STENCIL_CACHE_THREADS];
+		mutable ThreadCache               cache [MBLUE_STENCIL_CACHE_THREADS];
+		ThreadCache * getThreadCache () const;
+		void  resizeCache (ThreadCache *tc, int bits) const;
+};
+
+#endif
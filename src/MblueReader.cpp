@@ -33,7 +33,6 @@ void MblueReader::openFile (const std::string fname,
 	this->taskProgress = taskProgress;
 	if (fname != "") {
 		hasAltitude = false;
-		taskProgress->continueDownload = true;
 		ok = false;
 		openFile (fname, fastInterpolation);
 	}
@@ -45,6 +44,7 @@ MblueReader::~MblueReader ()
 {
 // 	DBGS("Destroy MblueReader");
 	Util::cleanMapPointers (mapRecords);
+	Util::cleanVectorPointers (listPointIndex);
 }
 //-------------------------------------------------------------------
 bool MblueReader::getMeteoblueTotalArea (
@@ -88,62 +88,56 @@ void  MblueReader::openFile (const std::string fname, bool fastInterpolation)
 	setAllDates.clear ();
 	setAllDataCode.clear ();
 	Util::cleanMapPointers (mapRecords);
+	Util::cleanVectorPointers (listPointIndex);
 
-	// read datacodes
+	// read datacodes (the same for all lines)
 	for (uint32_t i=0; i<mbzfile.vcodes.size(); i++) {
 		DataCode dtc (mbzfile.vcodes[i]);
 		setAllDataCode.insert (dtc);
 //  	DBGQS (DataCodeStr::toString(dtc) );
+		if (dtc.levelType==LV_ISOBARIC
+				&& (   dtc.levelValue==850
+					|| dtc.levelValue==700
+					|| dtc.levelValue==500
+					|| dtc.levelValue==300 
+					|| dtc.levelValue==200 
+					)
+		) {
+			hasAltitude = true;
+		}
 	}
 	
 // mbzfile.debugmbz();
 	
-	// read data (each MBZline give a MbluePoint)
-	uint32_t nblines = mbzfile.vlines.size();
-	for (uint32_t i=0; taskProgress->continueDownload && i<nblines; i++) 
+	// read data (each MBZ line give a point of the record at its date)
+	time_t href = DataRecordAbstract::UTC_mktime 
+					(mbzfile.year,mbzfile.month,mbzfile.day,mbzfile.href,0,0);
+	int nblines = mbzfile.getNbLines ();
+	MblueRecord *rec = NULL;
+	time_t hprev = 0;
+	for (int i=0; !taskProgress->isCanceled() && i<nblines; i++) 
 	{
-		if (i%20 == 0)
-			taskProgress->setValue ((int)(100*i/nblines));
-		
-		MbzLine *mbzline = mbzfile.vlines[i];
+		if (i%1024 == 0)
+			taskProgress->setValue ((int)(100.0*i/nblines));
 		
-		time_t href = DataRecordAbstract::UTC_mktime 
-						(mbzfile.year,mbzfile.month,mbzfile.day,mbzfile.href,0,0);
-		time_t hcur = href + 3600* mbzline->hour;
-		
-		MblueRecord *rec;
-		rec = getMblueRecordByDate (hcur);
-		if (rec == NULL) {
-			setAllDates.insert (hcur);
-			rec = new MblueRecord (mbzfile, hcur, fastInterpolation);
-			assert (rec);
-			mapRecords.insert 
-				( std::pair<time_t, MblueRecord  *> (hcur, rec) );
-		}
+		time_t hcur = href + 3600* mbzfile.vhours[i];
 		
-		MbluePoint * pt = new MbluePoint (mbzfile.vcodes, mbzline);
-		rec->addMbluePoint (pt);
-		
-		// has new point altitude data ?
-		if (! hasAltitude) {
-			std::map <uint32_t, float>::const_iterator iter;
-			std::map <uint32_t, float> *map = pt->getMapValues ();
-			for (iter=map->begin(); iter!=map->end(); iter++) {
-				DataCode dtc = iter->first;
-				if (dtc.levelType==LV_ISOBARIC
-						&& (   dtc.levelValue==850
-							|| dtc.levelValue==700
-							|| dtc.levelValue==500
-							|| dtc.levelValue==300 
-							|| dtc.levelValue==200 
-							)
-				) {
-					hasAltitude = true;
-				}
+		// lines are usually grouped by date
+		if (rec == NULL || hcur != hprev) {
+			rec = getMblueRecordByDate (hcur);
+			if (rec == NULL) {
+				setAllDates.insert (hcur);
+				rec = new MblueRecord (mbzfile, hcur, fastInterpolation);
+				assert (rec);
+				mapRecords.insert 
+					( std::pair<time_t, MblueRecord  *> (hcur, rec) );
 			}
+			hprev = hcur;
 		}
+		
+		rec->addMbzLine (mbzfile, i);
 	}
-	if (! taskProgress->continueDownload) {
+	if (taskProgress->isCanceled()) {
 		ok = false;
 		return;
 	}
@@ -151,20 +145,25 @@ void  MblueReader::openFile (const std::string fname, bool fastInterpolation)
 	taskProgress->setMessage (LTASK_PREPARE_MAPS);
 	taskProgress->setValue (0);
 // 	DBG ("nb records = %d", mapRecords.size());
-	// finalize all records
+	// finalize all records (records with the same points share their index)
 	std::map <time_t, MblueRecord  *>::const_iterator iter;
+	MbluePointIndex *index = NULL;
 	int i=0, nbrec=mapRecords.size();
 	xmin =  1e30;
 	xmax = -1e30;
 	ymin =  1e30;
 	ymax = -1e30;
 	for (iter = mapRecords.begin(); 
-			taskProgress->continueDownload && iter != mapRecords.end(); iter++) 
+			!taskProgress->isCanceled() && iter != mapRecords.end(); iter++) 
 	{
 		taskProgress->setValue ((int)(100*i/nbrec));
 		i ++;
 		MblueRecord  *rec = iter->second;
-		rec->finalize ();
+		MbluePointIndex *recindex = rec->finalize (index);
+		if (recindex != NULL && recindex != index) {
+			listPointIndex.push_back (recindex);
+			index = recindex;
+		}
 		if (rec->isOk()) {
 			if (xmin > rec->getXmin()) xmin = rec->getXmin();
 			if (xmax < rec->getXmax()) xmax = rec->getXmax();
@@ -173,7 +172,7 @@ void  MblueReader::openFile (const std::string fname, bool fastInterpolation)
 		}
 	}
 	
-	if (! taskProgress->continueDownload) {
+	if (taskProgress->isCanceled()) {
 		ok = false;
 		return;
 	}
@@ -87,6 +87,7 @@ class MblueReader : public IrregularGridReader
 								bool fastInterpolation);
 		
 		std::map <time_t, MblueRecord  *> mapRecords;
+		std::vector <MbluePointIndex *> listPointIndex;	// shared by records
 
 
 };
@@ -26,44 +26,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IrregularGridded.h"
 #include "zuFile.h"
 #include "MbzFile.h"
+#include "MbluePointIndex.h"
 
 
-//------------------------------------------------------
-class MbluePoint
-{
-	public:
-		MbluePoint ();
-		~MbluePoint ();
-
-		MbluePoint (const std::vector <uint32_t> datacodes, 
-					const MbzLine *mbzline);
-		
-		// Interpolate values from other points
-		MbluePoint ( double x, double y,
-					 int  nbPoints,
-					 MbluePoint *p1,
-					 MbluePoint *p2,
-					 MbluePoint *p3,
-					 MbluePoint *p4 );
-
-		bool   hasData  (const DataCode &dtc) const;
-		double getValue (const DataCode &dtc) const;
-		
-		float x, y;
-		bool isOk() const {return ok;}
-		
-		std::map <uint32_t, float> * getMapValues () 
-							{ return &mapvalues; }
- 		
-	private:
-		bool ok;
-		
-		std::map <uint32_t, float> mapvalues;
-		
-};
-
 //===================================================
 // All the data valid at the same time
+// Data are stored by columns, as in the MBZ file : point k is at
+// (getPointX(k), getPointY(k)) and its value for the datacode vcodes[c]
+// is columns[c][k]. The coordinates are kept by the point index,
+// shared by the records with the same points.
+// The virtual regular grid uses the same layout (gridColumns).
 //===================================================
 class MblueRecord : public IrregularGridRecord
 {
@@ -77,8 +49,11 @@ class MblueRecord : public IrregularGridRecord
 		virtual std::string  getDataOrigin () const
 						 { return "Meteoblue-NMM"; }
 		
-		void addMbluePoint (MbluePoint *pt);
-		void finalize ();	// don't forget me
+		void addMbzLine (const MbzFile &mbzfile, int numline);
+		// don't forget me
+		// index : spatial index to share if possible (NULL=make a new one)
+		// Return the index used by the record (the caller must delete it).
+		MbluePointIndex * finalize (MbluePointIndex *index=NULL);
 		bool isOk() const	{return ok;}
 		void setFastInterpolation (bool b)
 					{fastInterpolation = b;}
@@ -96,7 +71,11 @@ class MblueRecord : public IrregularGridRecord
         time_t getRecordRefDate () const        { return refDate; }
         time_t getRecordCurrentDate () const    { return curDate; }
 	
-		std::vector <MbluePoint *> * getListPoints () {return &allPoints;}
+		int    getNbPoints () const
+						{ return pointIndex ? pointIndex->getNbPoints() : 0; }
+		double getPointX (int k) const       { return pointIndex->getPointX(k); }
+		double getPointY (int k) const       { return pointIndex->getPointY(k); }
+		double getPointValue (const DataCode &dtc, int k) const;
 		
 		/** All records have (or simulate) a rectangular regular grid.
 		*/ 
@@ -112,9 +91,9 @@ class MblueRecord : public IrregularGridRecord
         virtual double  getDeltaY () const;
 		
         virtual int    getTotalNumberOfPoints ()  const
-						{ return ok ? allPoints.size() : 0; }
+						{ return ok ? getNbPoints() : 0; }
         virtual double getAveragePointsDensity () const
-						{ return ok ? allPoints.size()/((xmax-xmin)*(ymax-ymin)) : 0; }
+						{ return ok ? getNbPoints()/((xmax-xmin)*(ymax-ymin)) : 0; }
 
         virtual int  getIdCenter() const { return 0; }
         virtual int  getIdModel()  const { return 0; }
@@ -122,17 +101,24 @@ class MblueRecord : public IrregularGridRecord
         
 	private:
 		bool ok;
-		std::vector <MbluePoint *> allPoints;
         time_t refDate;      // Reference date
         time_t curDate;      // Current date
+		
+		std::vector <float>     ptx, pty;	// points coordinates while loading
+		std::vector <uint32_t>  vcodes;		// DataCode of each column
+		std::vector <std::vector <float> > columns;	// one column by DataCode
+		std::map <uint32_t, int>  mapColumnIndex;
+		int    getColumnIndex (const DataCode &dtc) const;
+		
+		// columns used for computed data (-1 if unused)
+		int    colDewpoint, colTemp, colHumid;
+		int    colCloudTot, colCloudHig, colCloudMid, colCloudLow;
+		void   makeColumns (const MbzFile &mbzfile);
+		int    addColumn (uint32_t code);
 
-		std::vector <MbluePoint *> *clusters;	// table of clusters of points
-		int clustersNi, clustersNj;	     // number of clusters
-		double clusterWidth;
-		double clusterHight;
-		void  	makeClusters();
+		MbluePointIndex *pointIndex;	// owned by the reader (coordinates)
 		
-		MbluePoint **regularGrid;    // Virtual regular grid parameters
+		std::vector <std::vector <float> > gridColumns;   // Virtual regular grid
 		int    Ni, Nj;	
 		double Di, Dj;
 		void   makeVirtualRegularGrid ();
@@ -142,37 +128,10 @@ class MblueRecord : public IrregularGridRecord
 		float  *smoothPressureGrid;	    // try to reduce pressure noise
 		void   makeSmoothPressureGrid ();
 		
-		std::vector <MbluePoint *> & getCluster (
-										double x, double y) const;
-										
-		std::vector <std::vector <MbluePoint *> > *getClustersList (
-										double x, double y) const;
-										
-		std::vector <std::vector <MbluePoint *> > *getClustersList_9max (
-										double x, double y) const;
-										
-		std::vector <std::vector <MbluePoint *> > *getClustersList_4max (
-										double x, double y) const;
-
-		int  findNeighbour_clusters (
-					double lon, double lat,
-					MbluePoint **p1, MbluePoint **p2, 
-					MbluePoint **p3, MbluePoint **p4 ) const;
-		
-		int   findBestNeighboursInCluster (
-						double lon, double lat,
-						std::vector <MbluePoint *> cluster,
-						MbluePoint **p1, MbluePoint **p2, 
-						MbluePoint **p3, MbluePoint **p4, 
-						double *d1, double *d2, double *d3, double *d4
-					) const;
-
 		double  getInterpolatedValueWithoutGrid (
 					 DataCode dtc, 
 					 double px, double py,
 					 bool interpolateValues=true ) const;
-					 
-		double getRawPressureOnRegularGrid (int i, int j) const;
 };
 
 
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include <set>
+#include <cstring>
 
 #include "MbzFile.h"
 
@@ -155,14 +156,13 @@ MbzFile::MbzFile (const char *fname, LongTaskProgress *taskProgress)
 MbzFile::~MbzFile ()
 {
 // 	DBGS("Destroy MbzFile");
-	Util::cleanVectorPointers (vlines);
 }
 //---------------------------------------------------
 void MbzFile::read_MbzFile (const char *fname, LongTaskProgress *taskProgress)
 {
 	ok = true;
-	vlines.clear ();
 	vcodes.clear ();
+	clear_columns ();
 	
 	ZUFILE *fin = zu_open (fname, "rb");
 	if (!fin) {
@@ -209,35 +209,73 @@ void MbzFile::read_data_codes  (ZUFILE *f)
 {
 	DataCode dtc;
 	uint32_t v;
+	if (nbData < 0 || nbData > MBZ_MAX_DATA) {
+		ok = false;
+		return;
+	}
 	for (int i=0; i<nbData; i++) {
 		if (! MButil::readInt32 (f, (int*)(&v)))    {ok=false; return;}
 		vcodes.push_back (v);
 	}
 }
 
+//---------------------------------------------------
+void MbzFile::clear_columns ()
+{
+	vhours.clear ();
+	vx.clear ();
+	vy.clear ();
+	vdata.clear ();
+}
+//---------------------------------------------------
+// Lines are read by blocks and decoded column by column.
+// Line format : hour (int16, big endian), x, y, nbData values
+// (float32, written in the native order of the producer).
 //---------------------------------------------------
 void MbzFile::read_data_lines  (ZUFILE *f, LongTaskProgress *taskProgress)
 {
-	float v;
-	MbzLine *line;
-	vlines.reserve (nbLines);
-	for (int j=0; taskProgress->continueDownload && j<nbLines; j++) {
-		taskProgress->setValue ((int)(100*j/nbLines));
-		line = new MbzLine ();
-		assert (line);
-		if (! MButil::readInt16   (f, &(line->hour))) {ok=false; return;}
-		if (! MButil::readFloat32 (f, &(line->x)))    {ok=false; return;}
-		if (! MButil::readFloat32 (f, &(line->y)))    {ok=false; return;}
-		line->data.reserve (nbData);
+	if (nbLines < 0 || nbData < 0 || nbData > MBZ_MAX_DATA) {
+		ok = false;
+		return;
+	}
+	const size_t lineSize = 2 + 4 + 4 + 4*(size_t)nbData;
+	const int blockLines = 4096;
+	std::vector <unsigned char> buf (lineSize*blockLines);
+	
+	vhours.resize (nbLines);
+	vx.resize (nbLines);
+	vy.resize (nbLines);
+	vdata.resize (nbData);
+	for (int i=0; i<nbData; i++)
+		vdata[i].resize (nbLines);
+	
+	for (int j0=0; !taskProgress->isCanceled() && j0<nbLines; j0+=blockLines)
+	{
+		taskProgress->setValue ((int)(100.0*j0/nbLines));
+		int nb = nbLines-j0 < blockLines ? nbLines-j0 : blockLines;
+		qint64 blockSize = (qint64)lineSize*nb;
+		if ((qint64) zu_read (f, &buf[0], (long)blockSize) != blockSize) {
+			ok = false;
+			clear_columns ();
+			return;
+		}
+		const unsigned char *p;
+		int j;
+		for (j=0, p=&buf[0]; j<nb; j++, p+=lineSize)
+			vhours [j0+j] = (p[0]<<8) + p[1];
+		for (j=0, p=&buf[2]; j<nb; j++, p+=lineSize)
+			memcpy (&vx[j0+j], p, 4);
+		for (j=0, p=&buf[6]; j<nb; j++, p+=lineSize)
+			memcpy (&vy[j0+j], p, 4);
 		for (int i=0; i<nbData; i++) {
-			if (! MButil::readFloat32 (f,&v))    {ok=false; return;}
-			line->data.push_back (v);
+			float *col = &vdata[i][j0];
+			for (j=0, p=&buf[10+4*i]; j<nb; j++, p+=lineSize)
+				memcpy (&col[j], p, 4);
 		}
-		vlines.push_back (line);
 	}
 	
-	if (!taskProgress->continueDownload) {
-		Util::cleanVectorPointers (vlines);
+	if (taskProgress->isCanceled()) {
+		clear_columns ();
 		ok = false;
 	}
 }
@@ -278,9 +316,9 @@ void MbzFile::debugmbz () const
 		DBG ("Data:%d   Lines:%d", nbData, nbLines);
 		DBG ("X: %f %f    Y: %f %f", xmin,xmax, ymin,ymax);
 		std::set<int> alldates;
-		for (uint32_t i=0; i<vlines.size(); i++) 
+		for (uint32_t i=0; i<vhours.size(); i++) 
 		{
-			alldates.insert (vlines[i]->hour);
+			alldates.insert (vhours[i]);
 		}
 		int nbdates = alldates.size();
 		alldates.clear ();
@@ -292,22 +330,22 @@ void MbzFile::debugmbz () const
 				ec = 1/sqrt(dens);
 			}
 			DBG ("nb dates: %d    density: %.1f %.5f", nbdates, dens, ec);
-			DBG ("vlines.size()=%d  %d/hour", (int)vlines.size(), (int)(vlines.size()/nbdates));
+			DBG ("lines=%d  %d/hour", getNbLines(), getNbLines()/nbdates);
 		}
-		if (vlines.size()>0)  vlines[0]->print();
-		if (vlines.size()>1)  vlines[1]->print();
-		if (vlines.size()>0)  vlines[vlines.size()-1]->print();
+		if (getNbLines()>0)  printLine (0);
+		if (getNbLines()>1)  printLine (1);
+		if (getNbLines()>0)  printLine (getNbLines()-1);
 	}
 	else {
 		DBG ("Error in file");
 	}
 } 
 //---------------------------------------------------
-void MbzLine::print () const
+void MbzFile::printLine (int j) const
 {
-	fprintf (stderr, "hr=%3d (%5g %5g) :", hour, x, y);
-	for (unsigned int i=0; i<data.size(); i++) {
-		fprintf (stderr, " %g", data[i]);
+	fprintf (stderr, "hr=%3d (%5g %5g) :", vhours[j], vx[j], vy[j]);
+	for (unsigned int i=0; i<vdata.size(); i++) {
+		fprintf (stderr, " %g", vdata[i][j]);
 	}
 	fprintf (stderr, "\n");
 }
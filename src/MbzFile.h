@@ -23,6 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "zuFile.h"
 #include "LongTaskProgress.h"
 
+#define MBZ_MAX_DATA  1024		// data codes by line (bad header if more)
+
 //------------------------------------------------------
 class MButil
 {
@@ -38,18 +40,10 @@ class MButil
 		static bool readPosition  (char *line, float *x, float *y);
 };
 
-//------------------------------------------------------
-class MbzLine
-{
-	public:
-		float x, y;
-		int   hour;
-		std::vector <float> data;
-		void print() const;
-};
-
 //---------------------------------------------------
 // MBZfile : read a file in MBZ format
+// Lines are stored by columns : line j is at (vhours[j], vx[j], vy[j])
+// and its value for the datacode vcodes[i] is vdata[i][j].
 //---------------------------------------------------
 class MbzFile
 {
@@ -67,12 +61,17 @@ class MbzFile
 		
 		bool isOk () const {return ok;}
 		void debugmbz () const;
+		void printLine (int j) const;
+		
+		int   getNbLines () const  {return vhours.size();}
 		
 		int   year,month,day,href; 
 		float xmin,xmax, ymin,ymax;
 		
-		std::vector <MbzLine*>  vlines;
 		std::vector <uint32_t>  vcodes;		// DataCode
+		std::vector <int>    vhours;
+		std::vector <float>  vx, vy;
+		std::vector <std::vector <float> >  vdata;	// one column by DataCode
 		
 	private:
 		bool  ok;
@@ -82,6 +81,7 @@ class MbzFile
 		void read_header (ZUFILE *f);
 		void read_data_codes  (ZUFILE *f);
 		void read_data_lines  (ZUFILE *f, LongTaskProgress *taskProgress);
+		void clear_columns ();
 };
 
 
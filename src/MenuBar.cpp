@@ -69,6 +69,15 @@ MenuBar::MenuBar (QWidget *parent, bool withmblue)
         acFile_Open = addAction (menuFile,
         			tr("Open"), tr("Ctrl+O"),
                     tr("Open a GRIB file"), Util::pathImg("fileopen.png"));
+        acFile_OpenZone = addAction (menuFile,
+        			tr("Open selected area"), "",
+                    tr("Open only the selected area of a GRIB file"), "");
+        acFile_OpenDataset = addAction (menuFile,
+        			tr("Open several files"), "",
+                    tr("Open several GRIB files as one set of data (a file by date...)"), "");
+        acFile_SaveZone = addAction (menuFile,
+        			tr("Save selected area"), "",
+                    tr("Save the selected area of the GRIB file in a new file"), "");
         acFile_Close = addAction (menuFile,
         			tr("Close"), tr("Ctrl+W"),
                     tr("Close"), Util::pathImg("fileclose.png"));
@@ -415,6 +424,8 @@ MenuBar::MenuBar (QWidget *parent, bool withmblue)
         				tr("Fonts"), tr("Ctrl+E"), "","");
         acOptions_GraphicsParams = addAction (menuOptions,
 						tr("Graphical parameters"), tr("Ctrl+G"), "","");
+        acOptions_RecordCache = addAction (menuOptions,
+						tr("Memory of GRIB data"), "", "","");
 		//----------------------------------------------------
 		QString lang = Util::getSetting("appLanguage", "").toString();
 		QString flagIconName = (lang == "") ? "" : Util::pathImg("drapeau_")+lang+".png";
@@ -83,6 +83,9 @@ public:
 	QAction *ac_showSkewtDiagram;
 
     QAction *acFile_Open;
+    QAction *acFile_OpenZone;
+    QAction *acFile_OpenDataset;
+    QAction *acFile_SaveZone;
     QAction *acFile_Close;
 	QAction *acFile_NewInstance;
     QAction *acFile_Load_GRIB;
@@ -299,6 +302,7 @@ public:
     QAction *acOptions_DateChooser;
     QAction *acOptions_Fonts;
     QAction *acOptions_GraphicsParams;
+    QAction *acOptions_RecordCache;
     QAction *acOptions_Language;
 
     QAction *acHelp_Help;
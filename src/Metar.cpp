@@ -35,86 +35,47 @@ bool Airport::operator < (const Airport &o) const
 }
 
 //==============================================================
-MetarWidget::MetarWidget (const Airport &airport, Projection *proj, QWidget *parent)
-	: QLabel (parent)
+MetarMarker::MetarMarker (const Airport &airport, QObject *parent)
+	: QObject (parent)
 {
-	this->proj = proj;
 	this->airport = airport;
-	
-	QPixmap pixmap (Util::pathImg("airport.png"));
-	setPixmap (pixmap);
-	resize (pixmap.width(), pixmap.height());
-	
-	setToolTip ("METAR station: "+airport.icao+" - "+airport.name);
-	adjustGeometry ();
-	connect (proj, SIGNAL(projectionUpdated()), this, SLOT(projectionUpdated()) );
 }
 //-------------------------------------------------------------------------------
-void MetarWidget::projectionUpdated()
+QString MetarMarker::getToolTip () const
 {
-	adjustGeometry ();
+	return "METAR station: "+airport.icao+" - "+airport.name;
 }
-
 //-------------------------------------------------------------------------------
-void MetarWidget::adjustGeometry()
+// (pi,pj) : position of the station on the screen
+void MetarMarker::drawContent (QPainter &pnt, const QPixmap &pixmap, int pi, int pj)
 {
-	if (proj == NULL)
-		return;
-	int  pi, pj;
-	bool ok = proj->map2screen_glob (airport.lon, airport.lat, &pi, &pj);
-	
-	if (ok) {
-		//setGeometry (pi, pj,  10, 10);
-		//DBG ("%g %g",width()/2., height()/2.);
-		move (pi-width()/2, pj-height()/2);
-	}
-	else {
-		//setGeometry (-1000,-1000,  10,10);  // not visible
-		move (-1000,-1000);
-	}
+	pnt.drawPixmap (pi-pixmap.width()/2, pj-pixmap.height()/2, pixmap);
 }
 //-------------------------------------------------------------------------------
-void  MetarWidget::enterEvent (QEvent *)
-{
-    enterCursor = cursor();
-    setCursor (Qt::UpArrowCursor);
-
-}
-//-------------------------------------------------------------------------------
-void  MetarWidget::leaveEvent (QEvent *)
-{
-    setCursor(enterCursor);
-}
-void  MetarWidget::mousePressEvent(QMouseEvent *)
-{
-}
-void  MetarWidget::mouseReleaseEvent(QMouseEvent *)
+void  MetarMarker::mouseRelease ()
 {
 	DBGQS ("Open METAR : "+airport.icao+" : "+airport.name);
 }
 //==============================================================
-MetarWidgetFactory::MetarWidgetFactory ()
+MetarMarkerFactory::MetarMarkerFactory ()
 {
 	read_metar_list ();
 }
 //-----------------------------------------------
-MetarWidgetFactory::~MetarWidgetFactory ()
+MetarMarkerFactory::~MetarMarkerFactory ()
 {
 	mapAirports.clear ();
 	mapCountries.clear ();
 	mapStates.clear ();
 }
 //-----------------------------------------------
-MetarWidget * MetarWidgetFactory::createMetarWidget 
-			( const QString &icao, bool isVisible, Projection *proj, QWidget *parent )
+MetarMarker * MetarMarkerFactory::createMetarMarker 
+			( const QString &icao, QObject *parent )
 {
-	MetarWidget *w = NULL;
-	w = new MetarWidget (mapAirports.value(icao), proj, parent);
-	w->setVisible (isVisible);
-	return w;
+	return new MetarMarker (mapAirports.value(icao), parent);
 }
 //-------------------------------------------------------------------------------
-void MetarWidgetFactory::read_metar_list ()
+void MetarMarkerFactory::read_metar_list ()
 {
 	char buf [512];
 	ZUFILE *f;
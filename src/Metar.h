@@ -29,7 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Projection.h"
 #include "zuFile.h"
 
-class MetarWidgetFactory;
+class MetarMarkerFactory;
 
 //---------------------------------------
 class Airport {
@@ -43,43 +43,38 @@ class Airport {
 		bool operator < (const Airport &o) const;
 };
 //---------------------------------------
-class MetarWidget : public QLabel
+// METAR station marker.
+// Not a widget : markers are drawn and hit-tested by the map (MarkersLayer).
+//---------------------------------------
+class MetarMarker : public QObject
 { Q_OBJECT
 	public:
-		friend class MetarWidgetFactory;		// only factory can construct
+		friend class MetarMarkerFactory;		// only factory can construct
+		
+		const Airport & getAirport () const  {return airport;}
+		double   getLongitude () const  {return airport.lon;}
+		double   getLatitude ()  const  {return airport.lat;}
+		QString  getToolTip () const;
 		
-	public slots:
-		void projectionUpdated ();
+		void  drawContent (QPainter &pnt, const QPixmap &pixmap, int pi, int pj);
+		void  mouseRelease ();
 		
 	private:
 		// Constructor is private, so only factory can construct item
-        MetarWidget (const Airport &airport, Projection *proj, QWidget *parent);
+        MetarMarker (const Airport &airport, QObject *parent);
 		
 		Airport airport;
-		Projection *proj;
-		
-		void adjustGeometry ();
-		
-		// Events
-    	QCursor   enterCursor;
-		
-		void  enterEvent (QEvent * e);
-		void  leaveEvent (QEvent * e);
-		void  mousePressEvent(QMouseEvent * e);
-		void  mouseReleaseEvent(QMouseEvent * e);
-		
 };
 
 //---------------------------------------
-class MetarWidgetFactory
+class MetarMarkerFactory
 {
 	public:
-		MetarWidgetFactory ();
-		~MetarWidgetFactory ();
+		MetarMarkerFactory ();
+		~MetarMarkerFactory ();
 		
-		MetarWidget * createMetarWidget 
-				(const QString &icao, bool isVisible,
-					Projection *proj, QWidget *parent);
+		MetarMarker * createMetarMarker 
+				(const QString &icao, QObject *parent);
 		
 		QMap <QString, Airport> mapAirports;    // icao => data
 		QMap <QString, QString> mapCountries;   // code country => name
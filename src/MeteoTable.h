@@ -23,6 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QFrame>
 #include <QScrollArea>
 #include <QPushButton>
+#include <QGridLayout>
+#include <QLabel>
 
 #include "MeteoTableWidget.h"
 #include "MeteotableOptionsDialog.h"
@@ -16,13 +16,21 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
-#include <QTimer>
+#include <algorithm>
+
+#include <QImage>
+#include <QMouseEvent>
+#include <QPaintEvent>
 
 #include "Astro.h"
 #include "Settings.h"
 #include "DataQString.h"
 #include "MeteoTableWidget.h"
 
+#define MTABLE_MARGIN_H   2		// text margins in the cells (pixels)
+#define MTABLE_MARGIN_V   4
+#define MTABLE_ARROWS_H  50		// room for the arrows above the text
+
 //-------------------------------------------------------------------------------
 MeteoTableWidget::MeteoTableWidget 
 			(GriddedPlotter *plotter, 
@@ -30,72 +38,39 @@ MeteoTableWidget::MeteoTableWidget
 	: QWidget(parent)
 {
 	this->plotter = plotter;
-	this->parent = parent;
 	this->lon = lon;
 	this->lat = lat;
 	this->locationName = locationName;
+	reader = NULL;
+	nowCol = -1;
+	headerWidth = 0;
+	showSunMoonAlmanac = Util::getSetting("MTABLE_showSunMoonAlmanac", true).toBool();
+	showWindArrows = Util::getSetting("MTABLE_showWindArrows", true).toBool();
+	showCurrentArrows = Util::getSetting("MTABLE_showCurrentArrows", true).toBool();
+	nbTitleRows = showSunMoonAlmanac ? 3 : 2;
+	fontBold.setBold (true);
+	setMouseTracking (true);
 
-	layout = new QGridLayout (this);
-	assert (layout);
-	layout->setContentsMargins (0,0,0,0);
-	layout->setSpacing (0);
-	headerWidget = new QWidget ();
+	headerWidget = new MeteoTableHeader (this);
 	assert (headerWidget);
-	headerLayout = new QGridLayout (headerWidget);
-	assert (headerLayout);
-	headerLayout->setContentsMargins (0,0,0,0);
-	headerLayout->setSpacing (0);
 	
 	createTable();
+	computeGeometry();
 }
-//----------------------------------------------------------------
-void MeteoTableWidget::addCell_title_dataline (QString txt, bool bold,
-				int lig,int col)
+//-------------------------------------------------------------------------------
+MeteoTableWidget::~MeteoTableWidget()
 {
-	QColor bgcolor(200,200,255);
-	TableCell *cell2 = new TableCell (headerWidget, txt, bold, bgcolor,
-										Qt::AlignRight|Qt::AlignHCenter);	
-	assert (cell2);
-	cell2->setBorders (lig, col);
-	headerLayout->addWidget (cell2, lig,col, 1,1);
+	Util::cleanVectorPointers (lspinfos);
+	qDeleteAll (listVisibleData);
 }
 //------------------------------------------------------------------------
 QWidget * MeteoTableWidget::getDataHeaders ()
 {
 	return headerWidget;
 }
-//------------------------------------------------------------------------
-void MeteoTableWidget::showEvent (QShowEvent */*event*/)
-{
-	QRect r;
-	// Adjust header height to row height
-	for (int j=0; j<layout->rowCount(); j++) 
-	{
-		QLayoutItem *it1 = layout->itemAtPosition (j,1);
-		if (it1 && it1->widget()) {
-			QLayoutItem *it2 = headerLayout->itemAtPosition (j,0);
-			if (it2 && it2->widget()) 
-			{
- 				it2->widget()->setMinimumHeight (it1->widget()->height());
-			}
-		}
-	}
-}
-
-//-------------------------------------------------------------------------------
-MeteoTableWidget::~MeteoTableWidget()
-{
-	Util::cleanVectorPointers (lspinfos);
-	qDeleteAll (listVisibleData);
-}
 //----------------------------------------------------------------
-void MeteoTableWidget::addCell_SunMoonAlmanac (time_t t, double lat, double lon, 
-				QGridLayout *layout,int lig,int col, int rowspan,int colspan)
+QString MeteoTableWidget::getSunMoonAlmanac (time_t t)
 {
-	TableCell *cell = new TableCell (this);	
-	assert (cell);
-	cell->setBorders (lig, col);
-	
 	Almanac alm = Astro::getSunMoonAlmanac (t, lat, lon);
 
 	QString rs,st;
@@ -107,9 +82,7 @@ void MeteoTableWidget::addCell_SunMoonAlmanac (time_t t, double lat, double lon,
 	st = alm.moonSet>0 ? Util::formatTime (alm.moonSet) : "----";
 	txt += "⇑ "+rs+" ⇓ "+st;
 	txt += "  "+QString("%1%").arg( (int)(100*alm.moonDisk+0.5));
-	cell->label->setText (txt);
-	layout->setAlignment (Qt::AlignLeft);
-	layout->addWidget (cell, lig,col, rowspan,colspan );
+	return txt;
 }
 
 //-------------------------------------------------------------------------------
@@ -121,93 +94,38 @@ void MeteoTableWidget::createTable()
 	
 	std::set<time_t> sdates = reader->getListDates();
 	std::set<time_t>::iterator iter;
-	std::set<time_t>::iterator iter2;
-	int lig, col, colspan;
-	QString dstr;
-	bool showSunMoonAlmanac = Util::getSetting("MTABLE_showSunMoonAlmanac", true).toBool();
-	//-----------------------------------------------
-	// Titre 1 : une colonne par jour, regroupant plusieurs horaires
-	//-----------------------------------------------
-	col = 0;
-	lig = 0;
-	addCell_title_dataline ("", true, lig,col);
-	col ++;
-	QString actuel = "";
-	for (iter=sdates.begin(); iter!=sdates.end(); iter++)
-	{
-		time_t daterecord = *iter;
-		dstr = Util::formatDateLong (daterecord);
-		if (dstr != actuel)
-		{
-			colspan = 0;
-			actuel = dstr;
-			iter2 = iter;
-			do
-			{
-				colspan ++;
-				iter2 ++;
-				dstr = Util::formatDateLong(*iter2);
-			} while (actuel==dstr);
-			addCell_title (actuel, true, layout, lig,col, 1,colspan);
-			col += colspan;
-		}
-	}
-			
-	//-----------------------------------------------
-	// Titre 1 bis: sun moon almanac if needed
-	//-----------------------------------------------
-	if (showSunMoonAlmanac)
-	{
-		col = 0;
-		lig ++;
-		addCell_title_dataline (tr("Sun")+"\n"+tr("Moon"), true, lig,col);
-		col ++;
-		QString actuel = "";
-		for (iter=sdates.begin(); iter!=sdates.end(); iter++)
-		{
-			time_t daterecord = *iter;
-			dstr = Util::formatDateLong (daterecord);
-			if (dstr != actuel)
-			{
-				colspan = 0;
-				actuel = dstr;
-				iter2 = iter;
-				do
-				{
-					colspan ++;
-					iter2 ++;
-					dstr = Util::formatDateLong(*iter2);
-				} while (actuel==dstr);
-				addCell_SunMoonAlmanac (daterecord, lat, lon, layout, lig,col, 1,colspan);
-				col += colspan;
-			}
-		}
-	}	
+	time_t dateproche = reader->getClosestDateFromNow ();
 	//-----------------------------------------------
-	// Titre 2 : une colonne par date+horaires
+	// Titres : une colonne par date+horaires,
+	// les jours regroupent plusieurs horaires
 	//-----------------------------------------------
-	DataPointInfo *pinfo;
-	time_t dateproche = reader->getClosestDateFromNow ();
-	col = 0;
-	lig ++;
-	addCell_title_dataline ("", true, lig,col);
-	col ++;
 	for (iter=sdates.begin(); iter!=sdates.end(); iter++)
 	{
 		time_t date = *iter;
-		addCell_title(Util::formatTime(date), false, layout, lig,col, 1,1,
-						dateproche==date);
-		col ++;
+		int col = lsdates.size();
+		QString dstr = Util::formatDateLong (date);
+		if (days.empty() || days.back().title != dstr) {
+			MTableDay day;
+			day.col = col;
+			day.nbcols = 0;
+			day.title = dstr;
+			if (showSunMoonAlmanac)
+				day.almanac = getSunMoonAlmanac (date);
+			days.push_back (day);
+		}
+		days.back().nbcols ++;
+		if (date == dateproche)
+			nowCol = col;
+		hours.push_back (Util::formatTime(date));
 
 		// Grib data for this point and this date
-		pinfo = new DataPointInfo (reader, lon,lat, date);
-		lspinfos.push_back (pinfo);
+		lspinfos.push_back (new DataPointInfo (reader, lon,lat, date));
 		lsdates.push_back (date);
 	}
+	skewtPixmaps.resize (lsdates.size());
 	//-----------------------------------------------
 	// Contenus
 	//-----------------------------------------------
-	lig ++;
 	createListVisibleGribData();
 	QList <MTGribData *>::iterator it;
 	for (it=listVisibleData.begin(); it!=listVisibleData.end(); it++) {
@@ -218,84 +136,84 @@ void MeteoTableWidget::createTable()
 		
 		if (dataType==GRB_PRV_WIND_XY2D) {
 			Altitude alt (levelType, levelValue);
-			addLine_Wind (alt, lig++);
+			addLine_Wind (alt);
 		}
 		else if (dataType==GRB_PRV_CUR_XY2D) {
 			Altitude alt (levelType, levelValue);
-			addLine_Current (alt, lig++);
+			addLine_Current (alt);
 		}
 		else if (dataType==GRB_PRESSURE_MSL && levelType==LV_MSL && levelValue==0){
 			Altitude alt (levelType, levelValue);
-			addLine_Pressure (alt, lig++);
+			addLine_Pressure (alt);
 		}
 		else if (dataType==GRB_CLOUD_TOT && levelType==LV_ATMOS_ALL && levelValue==0){
-			addLine_CloudCover (lig++);
+			addLine_CloudCover ();
 		}
 		else if (dataType==GRB_CLOUD_TOT && levelType==LV_ATMOS_ENT && levelValue==0){
-			addLine_CloudCover (lig++);
+			addLine_CloudCover ();
 		}
 		else if (dataType==GRB_PRECIP_TOT && levelType==LV_GND_SURF && levelValue==0){
-			addLine_Rain (lig++);
+			addLine_Rain ();
 		}
 		else if (dataType==GRB_PRV_THETA_E) {
 			Altitude alt (levelType, levelValue);
-			addLine_Temperature (alt, GRB_PRV_THETA_E, lig++);
+			addLine_Temperature (alt, GRB_PRV_THETA_E);
 		}
 		else if (dataType==GRB_TEMP && levelType!=LV_ATMOS_ALL) {
 			Altitude alt (levelType, levelValue);
-			addLine_Temperature (alt, GRB_TEMP, lig++);
+			addLine_Temperature (alt, GRB_TEMP);
 		}
 		else if (dataType==GRB_TMIN) {
 			Altitude alt (levelType, levelValue);
-			addLine_Temperature (alt, GRB_TMIN, lig++);
+			addLine_Temperature (alt, GRB_TMIN);
 		}
 		else if (dataType==GRB_TMAX) {
 			Altitude alt (levelType, levelValue);
-			addLine_Temperature (alt, GRB_TMAX, lig++);
+			addLine_Temperature (alt, GRB_TMAX);
 		}
 		else if (dataType==GRB_TEMP_POT) {
 			Altitude alt (levelType, levelValue);
-			addLine_Temperature (alt, GRB_TEMP_POT, lig++);
+			addLine_Temperature (alt, GRB_TEMP_POT);
 		}
 		else if (dataType==GRB_HUMID_REL) {
 			Altitude alt (levelType, levelValue);
-			addLine_HumidRel (alt, lig++);
+			addLine_HumidRel (alt);
 		}
 		else if (dataType==GRB_GEOPOT_HGT && levelType!=LV_ISOTHERM0) {
 			Altitude alt (levelType, levelValue);
-			addLine_GeopotentialAltitude (alt, lig++);
+			addLine_GeopotentialAltitude (alt);
 		}
 		else if (dataType==GRB_GEOPOT_HGT  && levelType==LV_ISOTHERM0 && levelValue==0){
-			addLine_Isotherm0Height (lig++);
+			addLine_Isotherm0Height ();
 		}
 		else if (dataType==GRB_DEWPOINT && levelType==LV_ABOV_GND && levelValue==2){
 			Altitude alt (levelType, levelValue);
-			addLine_DewPoint (alt, lig++);
+			addLine_DewPoint (alt);
 		}
 		else if (dataType==GRB_PRV_DIFF_TEMPDEW && levelType==LV_ABOV_GND && levelValue==2){
 			Altitude alt (levelType, levelValue);
-			addLine_DeltaTemperature (alt, GRB_PRV_DIFF_TEMPDEW, lig++);
+			addLine_DeltaTemperature (alt, GRB_PRV_DIFF_TEMPDEW);
 		}
 		else if (dataType==GRB_SNOW_CATEG && levelType==LV_GND_SURF && levelValue==0){
-			addLine_Categorical (GRB_SNOW_CATEG, lig++);
+			addLine_Categorical (GRB_SNOW_CATEG);
 		}
 		else if (dataType==GRB_FRZRAIN_CATEG && levelType==LV_GND_SURF && levelValue==0){
-			addLine_Categorical (GRB_FRZRAIN_CATEG, lig++);
+			addLine_Categorical (GRB_FRZRAIN_CATEG);
 		}
 		else if (dataType==GRB_SNOW_DEPTH && levelType==LV_GND_SURF && levelValue==0){
-			addLine_SnowDepth (lig++);
+			addLine_SnowDepth ();
 		}
 		else if (dataType==GRB_CAPE && levelType==LV_GND_SURF && levelValue==0){
-			addLine_CAPEsfc (lig++);
+			addLine_CAPEsfc ();
 		}
 		else if (dataType==GRB_CIN && levelType==LV_GND_SURF && levelValue==0){
-			addLine_CINsfc (lig++);
+			addLine_CINsfc ();
 		}
 		else if (dataType==GRB_TEMP && levelType==LV_ATMOS_ALL && levelValue==0){
-			addLine_SkewT (lig++);
+			addLine_SkewT ();
 		}
 		else if (dataType==GRB_WIND_GUST && levelType==LV_GND_SURF && levelValue==0){
-			addLine_GUSTsfc (lig++);
+			addLine_GUSTsfc ();
 		}
 		//----------------------------------------------
 		// Waves
@@ -305,7 +223,7 @@ void MeteoTableWidget::createTable()
 				|| dataType==GRB_WAV_SWL_HT
 				|| dataType==GRB_WAV_MAX_HT
 		){
-			addLine_WaveHeight (dataType, lig++);
+			addLine_WaveHeight (dataType);
 		}
 		else if (dataType==GRB_PRV_WAV_MAX
 				|| dataType==GRB_PRV_WAV_WND
@@ -313,10 +231,10 @@ void MeteoTableWidget::createTable()
 				|| dataType==GRB_PRV_WAV_PRIM
 				|| dataType==GRB_PRV_WAV_SCDY
 		){
-			addLine_WaveCompleteCell (dataType, lig++);
+			addLine_WaveCompleteCell (dataType);
 		}
 		else if (dataType==GRB_WAV_WHITCAP_PROB) {
-			addLine_WaveWhitecap (dataType, lig++);
+			addLine_WaveWhitecap (dataType);
 		}
 		
 		//----------------------------------------------
@@ -329,50 +247,36 @@ void MeteoTableWidget::createTable()
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_WaveWhitecap (int type, int lig)
+MTableLine & MeteoTableWidget::addLine (QString title, int cellType)
+{
+	lines.push_back (MTableLine (cellType, title, lsdates.size()));
+	return lines.back();
+}
+//-----------------------------------------------------------------
+void MeteoTableWidget::addLine_WaveWhitecap (int type)
 {
-	std::vector <time_t>::iterator it; 
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline  (tr("Whitecap (prob)"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (tr("Whitecap (prob)"));
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
-		double v = pinfo->getWaveData (type);
+		double v = lspinfos[i]->getWaveData (type);
 		if (v != GRIB_NOTDEF) {
-			txt = Util::formatPercentValue (v);
-			bgColor = QColor(plotter->getWhiteCapColor (v, true));
+			line.texts[i] = Util::formatPercentValue (v);
+			line.bgcolors[i] = plotter->getWhiteCapColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_WaveCompleteCell (int prvtype, int lig)
+void MeteoTableWidget::addLine_WaveCompleteCell (int prvtype)
 {
-	std::vector <DataPointInfo *>::iterator iter;
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (DataCodeStr::toString(prvtype), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (DataCodeStr::toString(prvtype));
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+		QString txt = "";
 		float ht, per, dir;
-		pinfo->getWaveValues (prvtype, &ht, &per, &dir);
+		lspinfos[i]->getWaveValues (prvtype, &ht, &per, &dir);
 		if (ht != GRIB_NOTDEF) {
 			txt = Util::formatWaveHeight (ht);
-			bgColor = QColor(plotter->getWaveHeightColor (ht, true));
-		}
-		else {
-			bgColor = Qt::white;
+			line.bgcolors[i] = plotter->getWaveHeightColor (ht, true);
 		}
 		txt += "\n";
 		if (dir != GRIB_NOTDEF) {
@@ -382,30 +286,20 @@ void MeteoTableWidget::addLine_WaveCompleteCell (int prvtype, int lig)
 		if (per != GRIB_NOTDEF) {
 			txt += Util::formatWavePeriod (per, true);
 		}
-		addCell_content (txt, layout,lig,col, 1,1, bgColor);
+		line.texts[i] = txt;
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_WaveHeight (int type, int lig)
+void MeteoTableWidget::addLine_WaveHeight (int type)
 {
-	std::vector <DataPointInfo *>::iterator iter;
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (DataCodeStr::toString(type), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (DataCodeStr::toString(type));
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
-		double v = pinfo->getWaveData (type);
+		double v = lspinfos[i]->getWaveData (type);
 		if (v != GRIB_NOTDEF) {
-			txt = Util::formatWaveHeight (v);
-			bgColor = QColor(plotter->getWaveHeightColor (v, true));
+			line.texts[i] = Util::formatWaveHeight (v);
+			line.bgcolors[i] = plotter->getWaveHeightColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 
@@ -462,194 +356,120 @@ void MeteoTableWidget::createListVisibleGribData ()
 	qSort (listVisibleData.begin(), listVisibleData.end(), lessThanMTGribData);
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_Isotherm0Height(int lig)
+void MeteoTableWidget::addLine_Isotherm0Height ()
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Isotherm 0°C"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+	MTableLine &line = addLine (tr("Isotherm 0°C"));
+	for (size_t i=0; i<lspinfos.size(); i++) {
+		DataPointInfo * pinfo = lspinfos[i];
 		if (pinfo->hasIsotherm0HGT()) {
-			txt = Util::formatGeopotAltitude (pinfo->isotherm0HGT);
-			bgColor = QColor(plotter->getAltitudeColor
-						(pinfo->isotherm0HGT, Altitude(LV_ISOTHERM0,0), true));
+			line.texts[i] = Util::formatGeopotAltitude (pinfo->isotherm0HGT);
+			line.bgcolors[i] = plotter->getAltitudeColor
+						(pinfo->isotherm0HGT, Altitude(LV_ISOTHERM0,0), true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_GeopotentialAltitude(const Altitude &alt, int lig)
+void MeteoTableWidget::addLine_GeopotentialAltitude (const Altitude &alt)
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Geopotential altitude") +" ("+AltitudeStr::toStringShort(alt)+")", 
-				  true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++) {
-		DataPointInfo * pinfo = *iter;
-		txt = "";
-		float v = pinfo->getDataValue (DataCode(GRB_GEOPOT_HGT,alt));
+	MTableLine &line = addLine (tr("Geopotential altitude")
+						+" ("+AltitudeStr::toStringShort(alt)+")");
+	for (size_t i=0; i<lspinfos.size(); i++) {
+		float v = lspinfos[i]->getDataValue (DataCode(GRB_GEOPOT_HGT,alt));
 		if (v != GRIB_NOTDEF) {
-			txt = Util::formatGeopotAltitude (v);
-			bgColor = QColor(plotter->getAltitudeColor(v, alt, true));
+			line.texts[i] = Util::formatGeopotAltitude (v);
+			line.bgcolors[i] = plotter->getAltitudeColor (v, alt, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_Pressure(const Altitude &alt, int lig)
+void MeteoTableWidget::addLine_Pressure (const Altitude &alt)
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Pressure") +" ("+AltitudeStr::toStringShort(alt)+")", 
-				  true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++) {
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+	MTableLine &line = addLine (tr("Pressure") +" ("+AltitudeStr::toStringShort(alt)+")");
+	for (size_t i=0; i<lspinfos.size(); i++) {
+		DataPointInfo * pinfo = lspinfos[i];
 		if (pinfo->hasPressureMSL()) {
-			txt = Util::formatPressure (pinfo->pressureMSL);
-			bgColor = QColor(plotter->getPressureColor(pinfo->pressureMSL, true));
+			line.texts[i] = Util::formatPressure (pinfo->pressureMSL);
+			line.bgcolors[i] = plotter->getPressureColor (pinfo->pressureMSL, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_Wind (const Altitude &alt, int lig)
+void MeteoTableWidget::addLine_Wind (const Altitude &alt)
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	std::vector <time_t>::iterator it; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Wind")+" ("+AltitudeStr::toStringShort(alt)+")", 
-					layout, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++) {
-		DataPointInfo * pf = *iter;
+	MTableLine &line = addLine (tr("Wind")+" ("+AltitudeStr::toStringShort(alt)+")",
+								MTABLE_WIND_CELL);
+	bool showWindBeauforts = Util::getSetting("MTABLE_showWindBeauforts", true).toBool();
+	for (size_t i=0; i<lspinfos.size(); i++) {
+		DataPointInfo * pf = lspinfos[i];
 		float v, dir;
-		txt = "";
-		bgColor = Qt::white;
 		if (pf->getWindValues (alt, &v, &dir)) {
 			if (dir != GRIB_NOTDEF) {
-				QString tmp;
+				QString tmp, txt;
 				tmp.sprintf("%.0f", dir);
 				txt += tmp + tr(" °") + "\n";
 				txt += Util::formatSpeed_Wind(v);
-				if ( Util::getSetting("MTABLE_showWindBeauforts", true).toBool() ) {
+				if (showWindBeauforts) {
 					tmp.sprintf("%2d", Util::msToBeaufort(v));
 					txt += "\n";
 					txt += tmp + tr(" Bf");
 				}
-				bgColor = QColor(plotter->getWindColor(v, true));
+				line.texts[i] = txt;
+				line.bgcolors[i] = plotter->getWindColor (v, true);
 			}
 		}
-		float vx, vy;
-		pf->getWindVxVy (alt, &vx, &vy);   
-		addCell_content (txt, layout,lig,col, 1,1, bgColor, MTABLE_WIND_CELL,vx,vy);
+		pf->getWindVxVy (alt, &line.vx[i], &line.vy[i]);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_Current (const Altitude &alt, int lig)
+void MeteoTableWidget::addLine_Current (const Altitude &alt)
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	std::vector <time_t>::iterator it; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Current")+" ("+AltitudeStr::toStringShort(alt)+")", 
-					layout, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++) {
-		DataPointInfo * pf = *iter;
+	MTableLine &line = addLine (tr("Current")+" ("+AltitudeStr::toStringShort(alt)+")",
+								MTABLE_CURRENT_CELL);
+	for (size_t i=0; i<lspinfos.size(); i++) {
+		DataPointInfo * pf = lspinfos[i];
 		float v, dir;
-		txt = "";
-		bgColor = Qt::white;
 		if (pf->getCurrentValues (&v, &dir)) {
 			if (dir != GRIB_NOTDEF) {
 				QString tmp;
 				tmp.sprintf("%.0f", dir);
-				txt += tmp + tr(" °") + "\n";
-				txt += Util::formatSpeed_Current(v);
-				bgColor = QColor(plotter->getCurrentColor(v, true));
+				line.texts[i] = tmp + tr(" °") + "\n" + Util::formatSpeed_Current(v);
+				line.bgcolors[i] = plotter->getCurrentColor (v, true);
 			}
 		}
-		float cx, cy;
-		pf->getCurrentCxCy (alt, &cx, &cy);   
-		addCell_content (txt, layout,lig,col, 1,1, bgColor, MTABLE_CURRENT_CELL,cx,cy);
+		pf->getCurrentCxCy (alt, &line.vx[i], &line.vy[i]);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_GUSTsfc(int lig)
+void MeteoTableWidget::addLine_GUSTsfc ()
 {
-	std::vector <DataPointInfo *>::iterator iter;
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Wind gust"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++) {
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+	MTableLine &line = addLine (tr("Wind gust"));
+	for (size_t i=0; i<lspinfos.size(); i++) {
+		DataPointInfo * pinfo = lspinfos[i];
 		if (pinfo->hasGUSTsfc()) {
 			double v = pinfo->GUSTsfc;
-			txt = Util::formatSpeed_Wind(v);
-			bgColor = QColor(plotter->getWindColor(v, true));
+			line.texts[i] = Util::formatSpeed_Wind(v);
+			line.bgcolors[i] = plotter->getWindColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_HumidRel (const Altitude &alt, int lig)
+void MeteoTableWidget::addLine_HumidRel (const Altitude &alt)
 {
-	std::vector <time_t>::iterator it; 
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	//addCell_title(tr("Relative humidity"), true, layout, lig,col);
-	addCell_title_dataline  (tr("Relative humidity")+" ("+AltitudeStr::toStringShort(alt)+")", 
-					true, lig,col);
-	col ++;
-	for (it=lsdates.begin(); it!=lsdates.end(); it++, col++)
+	MTableLine &line = addLine (tr("Relative humidity")
+						+" ("+AltitudeStr::toStringShort(alt)+")");
+	DataCode dtc (GRB_HUMID_REL,alt);
+	for (size_t i=0; i<lsdates.size(); i++)
 	{
-		time_t date = *it;
-		txt = "";
-		double v = 0;
-		v = reader->getDateInterpolatedValue (DataCode(GRB_HUMID_REL,alt), lon,lat, date);
+		double v = reader->getDateInterpolatedValue (dtc, lon,lat, lsdates[i]);
 		if (v != GRIB_NOTDEF) {
-			txt = Util::formatPercentValue(v);
-			bgColor = QColor(plotter->getHumidColor(v, true));
+			line.texts[i] = Util::formatPercentValue(v);
+			line.bgcolors[i] = plotter->getHumidColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_Temperature(const Altitude &alt, uchar type, int lig)
+void MeteoTableWidget::addLine_Temperature (const Altitude &alt, uchar type)
 {
-	std::vector <time_t>::iterator it; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	double v;
 	QString title;
 	switch (type) {
 		case GRB_PRV_THETA_E:
@@ -664,10 +484,10 @@ void MeteoTableWidget::addLine_Temperature(const Altitude &alt, uchar type, int
 			title = tr("Temp. pot"); break;
 	}
 	title += " ("+AltitudeStr::toStringShort(alt)+")";
-	addCell_title_dataline (title, true, lig,col);
-	col ++;
-	for (it=lsdates.begin(); it!=lsdates.end(); it++, col++) {
-		time_t date = *it;
+	MTableLine &line = addLine (title);
+	double v;
+	for (size_t i=0; i<lsdates.size(); i++) {
+		time_t date = lsdates[i];
 		if (type == GRB_PRV_THETA_E) {
 			int P = alt.levelValue;	// 925 850 700 600 500 400 300 200
 			double RH = reader->getDateInterpolatedValue (DataCode(GRB_HUMID_REL,alt), lon,lat,date);
@@ -676,191 +496,142 @@ void MeteoTableWidget::addLine_Temperature(const Altitude &alt, uchar type, int
 		}
 		else
 			v = reader->getDateInterpolatedValue (DataCode(type,alt), lon,lat, date);
-		txt = "";
 		if (v != GRIB_NOTDEF) {
-			txt = Util::formatTemperature(v);
-			bgColor = QColor(plotter->getTemperatureColor(v, true));
+			line.texts[i] = Util::formatTemperature(v);
+			line.bgcolors[i] = plotter->getTemperatureColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_DeltaTemperature(const Altitude &alt, uchar type, int lig)
+void MeteoTableWidget::addLine_DeltaTemperature (const Altitude &alt, uchar type)
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	double v;
+	QString title;
 	switch (type) {
 		case GRB_PRV_DIFF_TEMPDEW:
 		default:
-			addCell_title_dataline (tr("Gap temp-dew point")+" ("+AltitudeStr::toStringShort(alt)+")", 
-							true, lig,col);
+			title = tr("Gap temp-dew point")+" ("+AltitudeStr::toStringShort(alt)+")";
 			break;
 	}
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (title);
+	double v;
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
+		DataPointInfo * pinfo = lspinfos[i];
 		switch (type) {
 			case GRB_PRV_DIFF_TEMPDEW:
 			default:
 				v = fabs(pinfo->temp - pinfo->dewPoint);
 				break;
 		}
-		txt = "";
 		if (pinfo->temp != GRIB_NOTDEF && pinfo->dewPoint != GRIB_NOTDEF) {
-			txt = Util::formatTemperature(v + 273.15);
-			bgColor = QColor(plotter->getDeltaTemperaturesColor(v, true));
+			line.texts[i] = Util::formatTemperature(v + 273.15);
+			line.bgcolors[i] = plotter->getDeltaTemperaturesColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_DewPoint(const Altitude &alt, int lig)
+void MeteoTableWidget::addLine_DewPoint (const Altitude &alt)
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Dew point")+" ("+AltitudeStr::toStringShort(alt)+")", 
-				  true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (tr("Dew point")+" ("+AltitudeStr::toStringShort(alt)+")");
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+		DataPointInfo * pinfo = lspinfos[i];
 		if (pinfo->hasDewPoint()) {
 			double v = pinfo->dewPoint;
-			txt = Util::formatTemperature(v);
-			bgColor = QColor(plotter->getTemperatureColor(v, true));
+			line.texts[i] = Util::formatTemperature(v);
+			line.bgcolors[i] = plotter->getTemperatureColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_CAPEsfc (int lig)
+void MeteoTableWidget::addLine_CAPEsfc ()
 {
-	std::vector <DataPointInfo *>::iterator iter;
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("CAPE (surface)"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (tr("CAPE (surface)"));
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+		DataPointInfo * pinfo = lspinfos[i];
 		if (pinfo->hasCAPEsfc()) {
 			double v = pinfo->CAPEsfc;
+			QString txt;
 			txt.sprintf("%d ", qRound(v));
-			txt += tr("J/kg");
-			bgColor = QColor(plotter->getCAPEColor(v, true));
+			line.texts[i] = txt + tr("J/kg");
+			line.bgcolors[i] = plotter->getCAPEColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content (txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_CINsfc (int lig)
+void MeteoTableWidget::addLine_CINsfc ()
 {
-	std::vector <DataPointInfo *>::iterator iter;
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("CIN (surface)"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (tr("CIN (surface)"));
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+		DataPointInfo * pinfo = lspinfos[i];
 		if (pinfo->hasCINsfc()) {
 			double v = pinfo->CINsfc;
+			QString txt;
 			txt.sprintf("%d ", qRound(v));
-			txt += tr("J/kg");
-			bgColor = QColor(plotter->getCINColor(v, true));
+			line.texts[i] = txt + tr("J/kg");
+			line.bgcolors[i] = plotter->getCINColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content (txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_Rain(int lig)
+void MeteoTableWidget::addLine_Rain ()
 {
-	std::vector <DataPointInfo *>::iterator iter;
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Precipitation"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (tr("Precipitation"));
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+		DataPointInfo * pinfo = lspinfos[i];
 		if (pinfo->hasRain()) {
 			double v = pinfo->rain;
+			QString txt;
 			txt.sprintf("%.2f ", v);
-			txt += tr("mm/h");
-			bgColor = QColor(plotter->getRainColor(v, true));
+			line.texts[i] = txt + tr("mm/h");
+			line.bgcolors[i] = plotter->getRainColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content (txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_CloudCover (int lig)
+void MeteoTableWidget::addLine_CloudCover ()
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	addCell_title_dataline (tr("Cloud cover"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (tr("Cloud cover"), MTABLE_CLOUD_CELL);
+	// Color = seaColor + cloudColor
+	QColor seaColor (50,50,200, 255);
+	QImage img (1,1, QImage::Format_ARGB32_Premultiplied);
+	QPainter pnt (&img);
+	DataColors colors;		// the plotter is also used by the map thread
+	colors.setCloudsColorMode("MTABLE_cloudsColorMode");
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		txt = "";
+		DataPointInfo * pinfo = lspinfos[i];
 		double v = 0;
 		if (pinfo->hasCloudTotal()) {
 			v = pinfo->cloudTotal;
-			txt = Util::formatPercentValue(v);
-			bgColor = QColor(plotter->getCloudColor(v, true));
+			line.texts[i] = Util::formatPercentValue(v);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor, MTABLE_CLOUD_CELL, v);
+		QColor cloudColor = QColor::fromRgba(colors.getCloudColor(v, true));
+		pnt.fillRect (0,0, 1,1, seaColor );
+		pnt.fillRect (0,0, 1,1, cloudColor);
+		line.bgcolors[i] = img.pixel(0,0);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_Categorical (uchar type, int lig)
+void MeteoTableWidget::addLine_Categorical (uchar type)
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	double v = -1000;
+	QString title;
 	switch (type) {
 		case GRB_FRZRAIN_CATEG:
-			addCell_title_dataline (tr("Frozen rain possible"), true, lig,col);
+			title = tr("Frozen rain possible");
 			break;
 		case GRB_SNOW_CATEG:
-			addCell_title_dataline (tr("Snowfall possible"), true, lig,col);
+			title = tr("Snowfall possible");
 			break;
 	}
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (title);
+	double v = -1000;
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
+		DataPointInfo * pinfo = lspinfos[i];
 		switch (type) {
 			case GRB_FRZRAIN_CATEG:
 				v = pinfo->frzRainCateg;
@@ -870,353 +641,369 @@ void MeteoTableWidget::addLine_Categorical (uchar type, int lig)
 				break;
 		}
 		if (v != GRIB_NOTDEF) {
-			txt = Util::formatCategoricalData (v);
-			bgColor = QColor(plotter->getSnowDepthColor(v, true));
+			line.texts[i] = Util::formatCategoricalData (v);
+			line.bgcolors[i] = plotter->getSnowDepthColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_SnowDepth (int lig)
+void MeteoTableWidget::addLine_SnowDepth ()
 {
-	std::vector <DataPointInfo *>::iterator iter; 
-	QColor    bgColor = Qt::white;
-	QString   txt;
-	int col = 0;
-	double v = -1000;
-	addCell_title_dataline (tr("Snow"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
+	MTableLine &line = addLine (tr("Snow"));
+	for (size_t i=0; i<lspinfos.size(); i++)
 	{
-		DataPointInfo * pinfo = *iter;
-		v = pinfo->snowDepth;
-		txt = "";
+		double v = lspinfos[i]->snowDepth;
 		if (v >= 0) {
-			txt.sprintf("%.2f", v);
-			txt = Util::formatSnowDepth(v);
-			bgColor = QColor(plotter->getSnowDepthColor(v, true));
+			line.texts[i] = Util::formatSnowDepth(v);
+			line.bgcolors[i] = plotter->getSnowDepthColor (v, true);
 		}
-		else
-			bgColor = Qt::white;
-		addCell_content(txt, layout,lig,col, 1,1, bgColor);
 	}
 }
 //-----------------------------------------------------------------
-void MeteoTableWidget::addLine_SkewT (int lig)
+// The diagrams are computed when their cells are painted the first time
+void MeteoTableWidget::addLine_SkewT ()
 {
-	std::vector <DataPointInfo *>::iterator iter;
-	int col = 0;
-	addCell_title_dataline (tr("SkewT-LogP"), true, lig,col);
-	col ++;
-	for (iter=lspinfos.begin(); iter!=lspinfos.end(); iter++, col++)
-	{
-		DataPointInfo *pinfo = *iter;
-		addCell_SkewT (layout,lig,col, pinfo->date);
-	}
+	addLine (tr("SkewT-LogP"), MTABLE_SKEWT_CELL);
 }
 
 //===================================================================
-void MeteoTableWidget::addCell_SkewT (
-				QGridLayout *layout,int lig,int col,
-				time_t date
-				)
+// Geometry
+//===================================================================
+static QSize cellTextSize (const QFontMetrics &fm, const QString &txt)
 {
-	TableCell *cell = new TableCell_SkewT (this, lon, lat, locationName, date, reader);	
-	assert (cell);
-	cell->setBorders (lig, col);
-	layout->addWidget (cell, lig,col, 1,1, Qt::AlignCenter);
+	if (txt.isEmpty())
+		return QSize (0, fm.height());
+	return fm.boundingRect (QRect(0,0, 100000,100000), Qt::AlignLeft, txt).size();
 }
-//----------------------------------------------------------------
-void MeteoTableWidget::addCell_content (
-				QString txt,
-				QGridLayout *layout,int lig,int col,
-				int    rowspan,
-				int    colspan,
-				QColor bgcolor,
-				int    cellType,
-				double  vx,
-				double  vy
-				)
+//-----------------------------------------------------------------
+void MeteoTableWidget::computeGeometry ()
+{
+	QFontMetrics fmn (fontNormal);
+	QFontMetrics fmb (fontBold);
+	int nbcols = lsdates.size();
+	int nbrows = nbTitleRows + lines.size();
+	std::vector <int> widths  (nbcols, 0);
+	std::vector <int> heights (nbrows, 0);
+	QSize sz;
+	headerWidth = 0;
+	// Titles of the rows (header widget)
+	for (int row=0; row<nbrows; row++) {
+		QString title = "";
+		if (row >= nbTitleRows)
+			title = lines [row-nbTitleRows].title;
+		else if (showSunMoonAlmanac && row == 1)
+			title = tr("Sun")+"\n"+tr("Moon");
+		sz = cellTextSize (fmb, title);
+		headerWidth = std::max (headerWidth, sz.width());
+		heights[row] = std::max (heights[row], sz.height());
+	}
+	// Hours
+	int rowHours = nbTitleRows-1;
+	for (int col=0; col<nbcols; col++) {
+		sz = cellTextSize (fmn, hours[col]);
+		widths[col] = std::max (widths[col], sz.width());
+		heights[rowHours] = std::max (heights[rowHours], sz.height());
+	}
+	// Lines
+	for (size_t l=0; l<lines.size(); l++) {
+		const MTableLine &line = lines[l];
+		int row = nbTitleRows + l;
+		for (int col=0; col<nbcols; col++) {
+			if (line.cellType == MTABLE_SKEWT_CELL) {
+				sz = QSize (MTABLE_SKEWT_SIZE-2*MTABLE_MARGIN_H,
+							MTABLE_SKEWT_SIZE-2*MTABLE_MARGIN_V);
+			}
+			else {
+				sz = cellTextSize (fmn, line.texts[col]);
+				bool arrows = (line.cellType == MTABLE_WIND_CELL && showWindArrows)
+						|| (line.cellType == MTABLE_CURRENT_CELL && showCurrentArrows);
+				if (arrows && line.vx[col]!=GRIB_NOTDEF && line.vy[col]!=GRIB_NOTDEF)
+					sz.rheight() += MTABLE_ARROWS_H;
+			}
+			widths[col] = std::max (widths[col], sz.width());
+			heights[row] = std::max (heights[row], sz.height());
+		}
+	}
+	for (int col=0; col<nbcols; col++)
+		widths[col] += 2*MTABLE_MARGIN_H;
+	// Days : titles spanning several columns
+	for (size_t d=0; d<days.size(); d++) {
+		const MTableDay &day = days[d];
+		QSize sz1 = cellTextSize (fmb, day.title);
+		heights[0] = std::max (heights[0], sz1.height());
+		int need = sz1.width();
+		if (showSunMoonAlmanac) {
+			QSize sz2 = cellTextSize (fmn, day.almanac);
+			heights[1] = std::max (heights[1], sz2.height());
+			need = std::max (need, sz2.width());
+		}
+		need += 2*MTABLE_MARGIN_H;
+		int w = 0;
+		for (int col=day.col; col<day.col+day.nbcols; col++)
+			w += widths[col];
+		if (need > w) {
+			for (int k=0; k<day.nbcols; k++)
+				widths[day.col+k] += (need-w)/day.nbcols + (k < (need-w)%day.nbcols ? 1 : 0);
+		}
+	}
+	colX.assign (nbcols+1, 0);
+	for (int col=0; col<nbcols; col++)
+		colX[col+1] = colX[col] + widths[col];
+	rowY.assign (nbrows+1, 0);
+	for (int row=0; row<nbrows; row++)
+		rowY[row+1] = rowY[row] + heights[row] + 2*MTABLE_MARGIN_V;
+	headerWidth += 2*MTABLE_MARGIN_H;
+	
+	setFixedSize (colX.back(), rowY.back());
+	headerWidget->setFixedSize (headerWidth, rowY.back());
+}
+//-----------------------------------------------------------------
+int MeteoTableWidget::rowAt (int y)
 {
-	TableCell *cell;
- 	if (cellType == MTABLE_WIND_CELL) {
-	 	cell = new TableCell_Wind (vx, vy, (lat<0), plotter,
-	 				this, txt, false, bgcolor);
- 	}
- 	else if (cellType == MTABLE_CURRENT_CELL) {
-	 	cell = new TableCell_Current (vx, vy, (lat<0), plotter,
-	 				this, txt, false, bgcolor);
- 	}
- 	else if (cellType == MTABLE_CLOUD_CELL) {
-	 	cell = new TableCell_Clouds (vx, plotter,
-	 				this, txt, false, bgcolor);
- 	}
- 	else {
-	 	cell = new TableCell (this, txt, false, bgcolor);
-	}
-	assert (cell);
-	cell->setBorders (lig, col);
-	layout->addWidget (cell, lig,col, rowspan,colspan );
+	int nbrows = rowY.size()-1;
+	if (nbrows < 1)
+		return -1;
+	int row = std::upper_bound (rowY.begin(), rowY.end(), y) - rowY.begin() - 1;
+	return std::max (0, std::min (nbrows-1, row));
 }
-//----------------------------------------------------------------
-void MeteoTableWidget::addCell_title (QString txt, bool bold,
-				QGridLayout *layout,int lig,int col, int rowspan,int colspan,
-				bool isNowDate)
+//-----------------------------------------------------------------
+int MeteoTableWidget::colAt (int x)
 {
-	QColor bgcolor(200,200,255);
-	if (isNowDate) {
-		bgcolor = QColor(250,250,100);
-	}
-	TableCell *cell = new TableCell(this, txt, bold, bgcolor);	
-	assert (cell);
-	cell->setBorders (lig, col);
-	layout->addWidget (cell, lig,col, rowspan,colspan );
+	int nbcols = colX.size()-1;
+	if (nbcols < 1)
+		return -1;
+	int col = std::upper_bound (colX.begin(), colX.end(), x) - colX.begin() - 1;
+	return std::max (0, std::min (nbcols-1, col));
+}
+//-----------------------------------------------------------------
+QRect MeteoTableWidget::cellRect (int row, int col)
+{
+	return QRect (colX[col], rowY[row],
+				  colX[col+1]-colX[col], rowY[row+1]-rowY[row]);
 }
+
 //===================================================================
-// TableCell : case seule
+// Painting
 //===================================================================
-TableCell::TableCell(QWidget *parent, QString txt, bool bold,
-						QColor bgcolor,
-						Qt::Alignment alignment
-					)
-	: QWidget(parent)
+void MeteoTableWidget::paintCell (QPainter &pnt, const QRect &rect,
+								  QColor bgcolor, uint borders)
 {
-	this->bgcolor = bgcolor;
-	this->bordercolor = QColor(100,100,100);
-	this->borders = TableCell::none;
+	pnt.setRenderHint (QPainter::Antialiasing, false);
+	pnt.fillRect (rect, QBrush(bgcolor));
 	
-	label = new QLabel (txt, this);
-//	label->setAlignment (alignment);
-	if (bold) {
-		QFont font;
-		font.setBold(true);
-		label->setFont(font);
-	}
-	setContrastedTextColor(this->bgcolor);
-	
-	QGridLayout *layout = new QGridLayout (this);
-	int mh=2, mv=4;
-	layout->setContentsMargins (mh,mv,mh,mv);
-//	layout->addWidget(label, 0,0, Qt::AlignHCenter|Qt::AlignBottom);
-	layout->addWidget(label, 0,0, alignment);
+	QPen pen (QColor(100,100,100));
+	pen.setWidth (1);
+	pnt.setPen (pen);
+	int x0 = rect.left();
+	int y0 = rect.top();
+	int x1 = rect.right();
+	int y1 = rect.bottom();
+	if (borders & north)
+		pnt.drawLine (x0,y0, x1,y0);
+	if (borders & south)
+		pnt.drawLine (x0,y1, x1,y1);
+	if (borders & west)
+		pnt.drawLine (x0,y0, x0,y1);
+	if (borders & east)
+		pnt.drawLine (x1,y0, x1,y1);
 }
-//----------------------------------------------------------
-void    TableCell::setContrastedTextColor(QColor bgcolor)
-{
-	QColor fgcolor = DataColors::getContrastedColor (bgcolor);
-	QPalette p;
-	p.setBrush(QPalette::Active, QPalette::WindowText, fgcolor);
-	p.setBrush(QPalette::Inactive, QPalette::WindowText, fgcolor);
-	label->setPalette(p);
-}
-//---------------------------------------------------------
-void TableCell::setBorders (int lig, int col)
+//-----------------------------------------------------------------
+// Text block aligned in the cell, lines aligned to the left
+void MeteoTableWidget::paintCellText (QPainter &pnt, const QRect &rect,
+							const QString &txt, QColor bgcolor,
+							Qt::Alignment alignment)
 {
-	if (lig==0 && col==0)
-		this->setBorders (TableCell::all);
-	else if (lig==0)
-		this->setBorders (TableCell::south+TableCell::east+TableCell::north);
-	else if (col==0)
-		this->setBorders (TableCell::west+TableCell::south+TableCell::east);
+	if (txt.isEmpty())
+		return;
+	QRect r = rect.adjusted (MTABLE_MARGIN_H, MTABLE_MARGIN_V,
+							-MTABLE_MARGIN_H, -MTABLE_MARGIN_V);
+	QSize sz = cellTextSize (pnt.fontMetrics(), txt);
+	int x, y;
+	if (alignment & Qt::AlignRight)
+		x = r.right() - sz.width() + 1;
+	else if (alignment & Qt::AlignHCenter)
+		x = r.left() + (r.width()-sz.width())/2;
+	else
+		x = r.left();
+	if (alignment & Qt::AlignBottom)
+		y = r.bottom() - sz.height() + 1;
+	else if (alignment & Qt::AlignVCenter)
+		y = r.top() + (r.height()-sz.height())/2;
 	else
-		this->setBorders (TableCell::south+TableCell::east);
+		y = r.top();
+	pnt.setPen (DataColors::getContrastedColor (bgcolor));
+	pnt.drawText (QRect(x,y, sz.width(),sz.height()), Qt::AlignLeft, txt);
 }
-//---------------------------------------------------------
-void TableCell::paintEvent(QPaintEvent * /*event*/)
-{
-    QPainter pnt(this);
-	
-	pnt.fillRect(0,0,width(),height(), QBrush(bgcolor));
-	
-	QPen pen(bordercolor);
-	pen.setWidth(1);
-	pnt.setPen(pen);
-	
-	if (borders & TableCell::north)
-		pnt.drawLine(0,0, width()-1,0);
-	if (borders & TableCell::south)
-		pnt.drawLine(0,height()-1, width()-1,height()-1);
-	
-	if (borders & TableCell::west)
-		pnt.drawLine(0,0, 0,height()-1);
-	if (borders & TableCell::east)
-		pnt.drawLine(width()-1,0, width()-1,height()-1);
+//-----------------------------------------------------------------
+void MeteoTableWidget::paintLineCell (QPainter &pnt, const MTableLine &line, int col,
+									  const QRect &rect)
+{
+	if (line.cellType == MTABLE_SKEWT_CELL) {
+		paintCell (pnt, rect, Qt::white, south+east);
+		QPixmap &pixmap = skewtPixmaps [col];
+		if (pixmap.isNull()) {
+			MiniSkewT miniskewt (MTABLE_SKEWT_SIZE, MTABLE_SKEWT_SIZE);
+			miniskewt.initFromGriddedReader (reader, lon, lat, lsdates[col]);
+			pixmap = miniskewt.createPixmap ();
+		}
+		pnt.drawPixmap (rect.left() + (rect.width()-pixmap.width())/2,
+						rect.top() + (rect.height()-pixmap.height())/2, pixmap);
+		return;
+	}
+	QColor bgcolor (line.bgcolors[col]);
+	paintCell (pnt, rect, bgcolor, south+east);
 	
+	float vx = line.vx[col];
+	float vy = line.vy[col];
+	if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF) {
+		QColor arrowsColor (40,40,40);
+		int x = rect.left() + rect.width()/2;
+		int y = rect.top() + MTABLE_ARROWS_H/2;
+		if (line.cellType == MTABLE_WIND_CELL && showWindArrows) {
+			pnt.setRenderHint (QPainter::Antialiasing, true);
+			plotter->drawWindArrowWithBarbs_sprite (
+						pnt, x, y, vx, vy, (lat<0), arrowsColor);
+		}
+		else if (line.cellType == MTABLE_CURRENT_CELL && showCurrentArrows) {
+			pnt.setRenderHint (QPainter::Antialiasing, true);
+			plotter->drawCurrentArrow (
+						pnt, x, y, vx, vy, (lat<0), arrowsColor);
+		}
+	}
+	paintCellText (pnt, rect, line.texts[col], bgcolor);
 }
-
-
-//===================================================================
-// TableCell_Wind : case seule spécialisée pour le vent (flêche+barbules)
-//===================================================================
-TableCell_Wind::TableCell_Wind (double vx, double vy, bool south,
-        			GriddedPlotter *plotter,
-        			QWidget *parent, QString txt, bool bold,
-        			QColor bgcolor )
-	: TableCell(parent, txt, bold, bgcolor)
-{
-	this->vx = vx;
-	this->vy = vy;
-	this->south = south;
-	this->plotter = plotter;
-
-	windArrowsColor = QColor(40,40,40);
-	showWindArrows = Util::getSetting("MTABLE_showWindArrows", true).toBool();
-
-	if (showWindArrows && vx!=GRIB_NOTDEF && vy!=GRIB_NOTDEF)
-		setMinimumHeight(label->minimumSizeHint().height()+50);
-}	
-//---------------------------------------------------------
-void TableCell_Wind::paintEvent(QPaintEvent * e)
-{
-	TableCell::paintEvent(e);
-    QPainter pnt(this);
-	pnt.setRenderHint(QPainter::Antialiasing, true);
-
-	if (showWindArrows && vx != GRIB_NOTDEF && vx != GRIB_NOTDEF)
+//-----------------------------------------------------------------
+// Only the cells in the exposed area are painted
+void MeteoTableWidget::paintEvent (QPaintEvent *event)
+{
+	const QRect &area = event->rect();
+	int c0 = colAt (area.left());
+	int c1 = colAt (area.right());
+	int r0 = rowAt (area.top());
+	int r1 = rowAt (area.bottom());
+	if (c0 < 0 || r0 < 0)
+		return;
+    QPainter pnt (this);
+	QColor titleColor (200,200,255);
+	for (int row=r0; row<=r1; row++)
 	{
-    	plotter->drawWindArrowWithBarbs(
-    			pnt, width()/2, 25, vx, vy, south, windArrowsColor);
+		if (row == 0 || (showSunMoonAlmanac && row == 1)) {
+			// Days and sun/moon almanac
+			pnt.setFont (row==0 ? fontBold : fontNormal);
+			for (size_t d=0; d<days.size(); d++) {
+				const MTableDay &day = days[d];
+				if (day.col+day.nbcols-1 < c0 || day.col > c1)
+					continue;
+				QRect r = cellRect (row, day.col).united (
+								cellRect (row, day.col+day.nbcols-1));
+				paintCell (pnt, r, titleColor,
+							row==0 ? north+south+east : south+east);
+				paintCellText (pnt, r, row==0 ? day.title : day.almanac, titleColor);
+			}
+		}
+		else if (row == nbTitleRows-1) {
+			// Hours
+			pnt.setFont (fontNormal);
+			for (int col=c0; col<=c1; col++) {
+				QColor bgcolor = (col == nowCol) ? QColor(250,250,100) : titleColor;
+				QRect r = cellRect (row, col);
+				paintCell (pnt, r, bgcolor, south+east);
+				paintCellText (pnt, r, hours[col], bgcolor);
+			}
+		}
+		else {
+			pnt.setFont (fontNormal);
+			const MTableLine &line = lines [row-nbTitleRows];
+			for (int col=c0; col<=c1; col++)
+				paintLineCell (pnt, line, col, cellRect (row, col));
+		}
 	}
 }
-
-
-//===================================================================
-// TableCell_Current : case seule spécialisée pour le courant (flêche)
-//===================================================================
-TableCell_Current::TableCell_Current (double cx, double cy, bool south,
-        			GriddedPlotter *plotter,
-        			QWidget *parent, QString txt, bool bold,
-        			QColor bgcolor )
-	: TableCell(parent, txt, bold, bgcolor)
-{
-	this->cx = cx;
-	this->cy = cy;
-	this->south = south;
-	this->plotter = plotter;
-
-	currentArrowsColor = QColor(40,40,40);
-	showCurrentArrows = Util::getSetting("MTABLE_showCurrentArrows", true).toBool();
-
-	if (showCurrentArrows && cx!=GRIB_NOTDEF && cy!=GRIB_NOTDEF)
-		setMinimumHeight(label->minimumSizeHint().height()+50);
-}	
-//---------------------------------------------------------
-void TableCell_Current::paintEvent(QPaintEvent * e)
+//-----------------------------------------------------------------
+void MeteoTableWidget::paintHeaders (QPainter &pnt, const QRect &area, int W)
 {
-	TableCell::paintEvent(e);
-    QPainter pnt(this);
-	pnt.setRenderHint(QPainter::Antialiasing, true);
-
-	if (showCurrentArrows && cx != GRIB_NOTDEF && cx != GRIB_NOTDEF)
+	int r0 = rowAt (area.top());
+	int r1 = rowAt (area.bottom());
+	if (r0 < 0)
+		return;
+	QColor bgcolor (200,200,255);
+	pnt.setFont (fontBold);
+	for (int row=r0; row<=r1; row++)
 	{
-    	plotter->drawCurrentArrow (
-    			pnt, width()/2, 25, cx, cy, south, currentArrowsColor);
+		QString title = "";
+		if (row >= nbTitleRows)
+			title = lines [row-nbTitleRows].title;
+		else if (showSunMoonAlmanac && row == 1)
+			title = tr("Sun")+"\n"+tr("Moon");
+		QRect r (0, rowY[row], W, rowY[row+1]-rowY[row]);
+		paintCell (pnt, r, bgcolor, row==0 ? all : west+south+east);
+		paintCellText (pnt, r, title, bgcolor, Qt::AlignRight|Qt::AlignVCenter);
 	}
 }
 
-
 //===================================================================
-// TableCell_Clouds : case seule spécialisée pour la nébulosité
+// Mouse : a click on a SkewT cell opens the complete diagram
 //===================================================================
-TableCell_Clouds::TableCell_Clouds (
-					double   val,
-        			GriddedPlotter *plotter,
-        			QWidget  *parent, QString txt, bool bold,
-        			QColor bgcolor )
-	: TableCell(parent, txt, bold, bgcolor)
+bool MeteoTableWidget::isSkewTCell (const QPoint &pos, int *col)
 {
-	this->plotter = plotter;
-	this->val = val;
-
-	// Color = seaColor + bgColor
-	QColor seaColor (50,50,200, 255);
-	QImage img (1,1, QImage::Format_ARGB32_Premultiplied);
-	QPainter pnt (&img);
-	
-	plotter->setCloudsColorMode("MTABLE_cloudsColorMode");
-	QColor cloudColor = QColor::fromRgba(plotter->getCloudColor(val, true));
-	plotter->setCloudsColorMode("cloudsColorMode");
-		
-	pnt.fillRect (0,0, 1,1, seaColor );
-	pnt.fillRect (0,0, 1,1, cloudColor);
-	this->bgcolor = QColor(img.pixel(0,0));
-	
-	setContrastedTextColor(this->bgcolor);
-}	
+	int row = rowAt (pos.y());
+	*col = colAt (pos.x());
+	if (row < nbTitleRows || *col < 0 || ! rect().contains (pos))
+		return false;
+	return lines [row-nbTitleRows].cellType == MTABLE_SKEWT_CELL;
+}
 //---------------------------------------------------------
-void TableCell_Clouds::paintEvent(QPaintEvent * e)
+void MeteoTableWidget::mouseMoveEvent (QMouseEvent *e)
 {
-	TableCell::paintEvent(e);
-    QPainter pnt(this);
-	pnt.setRenderHint(QPainter::Antialiasing, true);
-
+	int col;
+	if (isSkewTCell (e->pos(), &col))
+		setCursor (Qt::PointingHandCursor);
+	else
+		unsetCursor ();
 }
-
-
-
-//===================================================================
-// TableCell_SkewT
-//===================================================================
-TableCell_SkewT::TableCell_SkewT (QWidget *parent,
-					double lon, double lat,  QString locationName,
-					time_t date,
-					GriddedReader *reader)
-	: TableCell (parent)
+//---------------------------------------------------------
+void MeteoTableWidget::leaveEvent (QEvent *)
 {
-	this->lon = lon;
-	this->lat = lat;
-	this->locationName = locationName;
-	this->date = date;
-	this->reader = reader;
-	MiniSkewT miniskewt;
-	miniskewt.initFromGriddedReader (reader, lon, lat, date);
-	pixmap = miniskewt.createPixmap ();
-	setFixedSize (miniskewt.size());
+	unsetCursor ();
 }
 //---------------------------------------------------------
-void TableCell_SkewT::paintEvent (QPaintEvent * e)
+void MeteoTableWidget::mouseReleaseEvent (QMouseEvent *e)
 {
-	TableCell::paintEvent (e);
-    QPainter pnt (this);
-	pnt.setRenderHint(QPainter::Antialiasing, true);
-	pnt.drawPixmap (0,0, pixmap);
+	int col;
+	if (isSkewTCell (e->pos(), &col))
+		openSkewTWindow (lsdates[col]);
 }
 //---------------------------------------------------------
-void TableCell_SkewT::enterEvent (QEvent *)
+void MeteoTableWidget::openSkewTWindow (time_t date)
 {
-	setCursor (Qt::PointingHandCursor);
+	SkewT *skewt = new SkewT ();
+	skewt->initFromGriddedReader (reader, lon, lat, date);
+	
+	SkewTWindow *sdial = new SkewTWindow (skewt);
+	
+	QString position = Util::formatPosition(lon, lat);
+	if (locationName == "") {
+		skewt->setLocation (position);
+		sdial->setWindowTitle ("SkewT - "+position);
+	}
+	else {
+		skewt->setLocation (position+" ("+locationName+")");
+		sdial->setWindowTitle ("SkewT - "+locationName);
+	}
+	sdial->show ();
 }
-//---------------------------------------------------------
-void TableCell_SkewT::leaveEvent (QEvent *)
+
+//===================================================================
+// MeteoTableHeader : titles of the lines
+//===================================================================
+MeteoTableHeader::MeteoTableHeader (MeteoTableWidget *table)
+	: QWidget ()
 {
-	unsetCursor ();
+	this->table = table;
 }
 //---------------------------------------------------------
-void TableCell_SkewT::mouseReleaseEvent (QMouseEvent *e)
+void MeteoTableHeader::paintEvent (QPaintEvent *event)
 {
-	if (this->rect().contains (e->pos())) {
-		SkewT *skewt = new SkewT ();
-		skewt->initFromGriddedReader (reader, lon, lat, date);
-		
-		SkewTWindow *sdial = new SkewTWindow (skewt);
-		
-		QString position = Util::formatPosition(lon, lat);
-		if (locationName == "") {
-			skewt->setLocation (position);
-			sdial->setWindowTitle ("SkewT - "+position);
-		}
-		else {
-			skewt->setLocation (position+" ("+locationName+")");
-			sdial->setWindowTitle ("SkewT - "+locationName);
-		}
-		sdial->show ();
-	}
+    QPainter pnt (this);
+	table->paintHeaders (pnt, event->rect(), width());
 }
-
-	
-	
-	
-	
-
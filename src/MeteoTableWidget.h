@@ -19,121 +19,66 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef METEOTABLEWIDGET_H
 #define METEOTABLEWIDGET_H
 
-#include <QGridLayout>
-#include <QLabel>
+#include <vector>
+
+#include <QWidget>
+#include <QPainter>
+#include <QPixmap>
 
 #include "GriddedPlotter.h"
 #include "DataPointInfo.h"
 #include "SkewT.h"
 
+#define MTABLE_TEXT_CELL    0
 #define MTABLE_WIND_CELL    1
 #define MTABLE_CLOUD_CELL   2
 #define MTABLE_CURRENT_CELL 3
 #define MTABLE_SKEWT_CELL   4
 
+#define MTABLE_SKEWT_SIZE  60
 
 //===================================================================
-class TableCell : public QWidget
-{ Q_OBJECT
-    public:
-        TableCell (QWidget *parent, QString txt="", bool bold=false,
-					QColor bgcolor=QColor(200,200,255),
-					Qt::Alignment alignment=Qt::AlignHCenter|Qt::AlignBottom
-			);
-		
-		void setBorders (int lig, int col);
-	    QLabel  *label;
-
-    protected:
-	    void  	paintEvent(QPaintEvent *event);
-	    void    setContrastedTextColor(QColor bgColor);
-		
-		static const uint none  = 0;
-		static const uint north = 1;
-		static const uint west  = 2;
-		static const uint south = 4;
-		static const uint east  = 8;
-		static const uint all   = 1+2+4+8;
-		
-		void setBorders (int num) { borders=num; }
-		
-	    QColor  bgcolor, bordercolor;
-	    int     borders;
-};
-
+// One line of the table : a title and one cell by date.
+// Cells are stored by column, one vector by field.
 //===================================================================
-class TableCell_SkewT : public TableCell
-{ Q_OBJECT
-    public:
-        TableCell_SkewT (QWidget *parent,
-						 double lon, double lat, QString locationName,
-						 time_t date,
-						 GriddedReader *reader);
-    protected:
-		QPixmap pixmap;
-		double lon, lat;
-		QString locationName;
-		time_t date;
-		GriddedReader *reader;
-	    void  paintEvent (QPaintEvent *event);
-		void  enterEvent (QEvent *);
-		void  leaveEvent (QEvent *);
-		void  mouseReleaseEvent (QMouseEvent *);
+class MTableLine {
+	public :
+		MTableLine (int cellType, QString title, int nbdates)
+			: texts (nbdates), bgcolors (nbdates, qRgb(255,255,255)),
+			  vx (nbdates, GRIB_NOTDEF), vy (nbdates, GRIB_NOTDEF)
+		{
+			this->cellType = cellType;
+			this->title = title;
+		}
+		int     cellType;
+		QString title;
+		std::vector <QString> texts;
+		std::vector <QRgb>    bgcolors;
+		std::vector <float>   vx, vy;	// arrows (wind, current)
 };
 
 //===================================================================
-class TableCell_Wind : public TableCell
-{ Q_OBJECT
-    public:
-        TableCell_Wind(
-        			double vx, double vy, bool south,
-        			GriddedPlotter  *plotter,
-        			QWidget *parent, QString txt, bool bold,
-        			QColor bgcolor
-				);
-    protected:
-    	QColor    windArrowsColor;
-    	double 	  vx, vy;
-    	bool	  south;
-    	bool	  showWindArrows;
-    	GriddedPlotter *plotter;
-	    void  	paintEvent(QPaintEvent *event);
-};
-
+// Days of the table (title lines)
 //===================================================================
-class TableCell_Current : public TableCell
-{ Q_OBJECT
-    public:
-        TableCell_Current(
-        			double cx, double cy, bool south,
-        			GriddedPlotter  *plotter,
-        			QWidget *parent, QString txt, bool bold,
-        			QColor bgcolor
-				);
-    protected:
-    	QColor    windArrowsColor;
-    	QColor    currentArrowsColor;
-    	double 	  cx, cy;
-    	bool	  south;
-    	bool	  showCurrentArrows;
-    	GriddedPlotter *plotter;
-	    void  	paintEvent(QPaintEvent *event);
+class MTableDay {
+	public :
+		int     col, nbcols;
+		QString title;
+		QString almanac;
 };
 
+class MeteoTableWidget;
+
 //===================================================================
-class TableCell_Clouds : public TableCell
+// Titles of the lines, painted by the MeteoTableWidget
+//===================================================================
+class MeteoTableHeader : public QWidget
 { Q_OBJECT
     public:
-        TableCell_Clouds (
-        			double val,
-        			GriddedPlotter *plotter,
-        			QWidget *parent, QString txt, bool bold,
-        			QColor bgcolor
-				);
+        MeteoTableHeader (MeteoTableWidget *table);
     protected:
-    	GriddedPlotter *plotter;
-    	double   val;
-	    void  	 paintEvent(QPaintEvent *event);
+		MeteoTableWidget *table;
+	    void  paintEvent (QPaintEvent *event);
 };
 
 //===================================================================
@@ -155,6 +100,10 @@ class MTGribData {
 		int  pos;
 };
 
+//===================================================================
+// The table is painted by a single widget : only the cells intersecting
+// the exposed area are drawn. Contents of the cells are computed once,
+// when the table is created.
 //===================================================================
 class MeteoTableWidget : public QWidget
 { Q_OBJECT
@@ -171,74 +120,92 @@ class MeteoTableWidget : public QWidget
 
 		QWidget *getDataHeaders (); 
 		
+		void  paintHeaders (QPainter &pnt, const QRect &area, int W);
+		
 	private:
         double          lon, lat;
 		QString         locationName;
         GriddedPlotter  *plotter;
         GriddedReader   *reader;
-		QGridLayout     *layout;
 		
-		QWidget         *parent;
-		QWidget         *headerWidget;
-		QGridLayout     *headerLayout;
+		MeteoTableHeader *headerWidget;
 		
 		std::vector <time_t> lsdates;
 		std::vector <DataPointInfo *> lspinfos;
 		
 		QList <MTGribData *> listVisibleData;
 		
+		std::vector <MTableDay>  days;
+		std::vector <QString>    hours;
+		std::vector <MTableLine> lines;
+		std::vector <QPixmap>    skewtPixmaps;	// by date, created when painted
+		int    nowCol;
+		bool   showSunMoonAlmanac;
+		bool   showWindArrows;
+		bool   showCurrentArrows;
+		
+		// Geometry : columns are dates, rows are title rows then lines
+		QFont  fontNormal, fontBold;
+		int    nbTitleRows;
+		std::vector <int> colX;		// nbdates+1 positions
+		std::vector <int> rowY;		// nbrows+1 positions
+		int    headerWidth;
+		
 		void  createTable();
 		void  createListVisibleGribData();
+		void  computeGeometry ();
+		
+		MTableLine & addLine (QString title, int cellType=MTABLE_TEXT_CELL);
+		
+		void  addLine_Wind        (const Altitude &alt);
+		void  addLine_Current     (const Altitude &alt);
+		void  addLine_Temperature (const Altitude &alt, uchar type);
+		void  addLine_HumidRel    (const Altitude &alt);
+		void  addLine_CloudCover  ();
+		void  addLine_Rain        ();
+		void  addLine_DewPoint    (const Altitude &alt);
+		void  addLine_Pressure    (const Altitude &alt);
+		void  addLine_SnowDepth        ();
+		void  addLine_DeltaTemperature (const Altitude &alt, uchar type);
+		void  addLine_Categorical 	   (uchar type);
+		void  addLine_CAPEsfc    ();
+		void  addLine_CINsfc     ();
+		void  addLine_SkewT      ();
+		void  addLine_GUSTsfc    ();
+		void  addLine_Isotherm0Height  ();
+		void  addLine_GeopotentialAltitude  (const Altitude &alt);
+
+		void  addLine_WaveHeight (int type);
+		void  addLine_WaveWhitecap (int type);
+		void  addLine_WaveCompleteCell (int prvtype);
+		
+		QString  getSunMoonAlmanac (time_t t);
+		
+		static const uint none  = 0;
+		static const uint north = 1;
+		static const uint west  = 2;
+		static const uint south = 4;
+		static const uint east  = 8;
+		static const uint all   = 1+2+4+8;
 		
-		void  addLine_Wind        (const Altitude &alt, int lig);
-		void  addLine_Current     (const Altitude &alt, int lig);
-		void  addLine_Temperature (const Altitude &alt, uchar type, int lig);
-		void  addLine_HumidRel    (const Altitude &alt, int lig);
-		void  addLine_CloudCover  (int lig);
-		void  addLine_Rain        (int lig);
-		void  addLine_DewPoint    (const Altitude &alt, int lig);
-		void  addLine_Pressure    (const Altitude &alt, int lig);
-		void  addLine_SnowDepth        (int lig);
-		void  addLine_DeltaTemperature (const Altitude &alt, uchar type, int lig);
-		void  addLine_Categorical 	   (uchar type, int lig);
-		void  addLine_CAPEsfc    (int lig);
-		void  addLine_CINsfc     (int lig);
-		void  addLine_SkewT      (int lig);
-		void  addLine_GUSTsfc    (int lig);
-		void  addLine_Isotherm0Height  (int lig);
-		void  addLine_GeopotentialAltitude  (const Altitude &alt, int lig);
-
-		void  addLine_WaveHeight (int type, int lig);
-		void  addLine_WaveWhitecap (int type, int lig);
-		void  addLine_WaveCompleteCell (int prvtype, int lig);
-		
-		void addCell_content (QString txt, 
-				QGridLayout *layout,int lig,int col,
-				int    rowspan=1,
-				int    colspan=1,
-				QColor bgcolor=Qt::white,
-				int    cellType = 0,
-				double  vx=0,
-				double  vy=0
-				);
-				
-		void addCell_title (QString txt, bool bold,
-				QGridLayout *layout,int lig,int col,
-				int rowspan=1, int colspan=1,
-				bool isNowDate=false);
-		
-		void addCell_SunMoonAlmanac (time_t t, double lat, double lon,
-				QGridLayout *layout,int lig,int col, int rowspan,int colspan);
-		
-		void addCell_SkewT (QGridLayout *layout,int lig,int col, time_t date);
-		
-		void addCell_title_dataline (QString txt, bool bold,
-				int lig,int col);
-		
-		void showEvent (QShowEvent *event);		
+		static void  paintCell (QPainter &pnt, const QRect &rect,
+							QColor bgcolor, uint borders);
+		static void  paintCellText (QPainter &pnt, const QRect &rect,
+							const QString &txt, QColor bgcolor,
+							Qt::Alignment alignment=Qt::AlignHCenter|Qt::AlignBottom);
+		
+		void  paintLineCell  (QPainter &pnt, const MTableLine &line, int col,
+							  const QRect &rect);
+		QRect cellRect       (int row, int col);
+		int   rowAt          (int y);
+		int   colAt          (int x);
+		bool  isSkewTCell    (const QPoint &pos, int *col);
+		void  openSkewTWindow (time_t date);
+		
+		void  paintEvent        (QPaintEvent *event);
+		void  mouseMoveEvent    (QMouseEvent *event);
+		void  mouseReleaseEvent (QMouseEvent *event);
+		void  leaveEvent        (QEvent *event);
 };
 
-
-
-
 #endif
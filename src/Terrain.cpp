@@ -25,11 +25,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QPainter>
 #include <QProgressDialog>
 #include <QMessageBox>
+#include <QToolTip>
+#include <QElapsedTimer>
 
 #include "Terrain.h"
 #include "Orthodromie.h"
 #include "Font.h"
 #include "DataQString.h"
+#include "Settings.h"
+#include "RenderBuffer.h"
+#include "GribRecordCache.h"
 
 //---------------------------------------------------------
 // Constructeur
@@ -63,6 +68,11 @@ Terrain::Terrain (QWidget *parent, Projection *proj, GshhsReader *gshhsReader)
 	drawer = new MapDrawer(gshhsReader);
 	assert(drawer);
 	currentFileType = DATATYPE_NONE;
+	renderer = new MapRenderer (*drawer, this);
+	assert(renderer);
+	requestedGeneration = 0;
+	connect (renderer, SIGNAL(frameReady()), this, SLOT(slotFrameReady()));
+	renderer->start ();
     
     //----------------------------------------------------------------------------
     showOrthodromie   = Util::getSetting("showOrthodromie", false).toBool();
@@ -72,6 +82,13 @@ Terrain::Terrain (QWidget *parent, Projection *proj, GshhsReader *gshhsReader)
     windArrowsOnGribGrid = Util::getSetting("windArrowsOnGribGrid", false).toBool();
     currentArrowsOnGribGrid = Util::getSetting("currentArrowsOnGribGrid", false).toBool();
 	fastInterpolation_MBlue = Util::getSetting ("MBfastInterpolation", true).toBool();
+	showPOIs   = Util::getSetting ("showPOIs", true).toBool();
+	showMETARs = Util::getSetting ("showMETARs", true).toBool();
+	showRenderTimes = Util::getSetting ("showMapRenderTimes", false).toBool();
+	poiUnderMouse = NULL;
+	metarUnderMouse = NULL;
+	markerUnderCursor = NULL;
+	keyModifiers = Qt::NoModifier;
     
     isEarthMapValid = false;
     mustRedraw = true;
@@ -84,6 +101,11 @@ Terrain::Terrain (QWidget *parent, Projection *proj, GshhsReader *gshhsReader)
 	griddedPlot = NULL;
 	iacPlot = NULL;
 	taskProgress = NULL;
+	loadingZoom = false;
+	hasLoadingSubset = false;
+	loadingStep = LOAD_GRIB;
+	loadingPlot = NULL;
+	loadThread = NULL;
 
     //---------------------------------------------------------------
 	updateGraphicsParameters();
@@ -96,13 +118,28 @@ Terrain::Terrain (QWidget *parent, Projection *proj, GshhsReader *gshhsReader)
     setFocusPolicy(Qt::StrongFocus);
 	
 	createCrossCursor ();
+	connect (Settings::getNotifier(), SIGNAL(settingChanged(const QString &)),
+			 this, SLOT(slotSettingChanged(const QString &)));
+}
+//-------------------------------------------
+Terrain::~Terrain ()
+{
+	if (loadThread != NULL) {	// file being loaded: stop it
+		taskProgress->cancel ();
+		loadThread->wait ();
+		delete loadThread;
+		delete loadingPlot;
+	}
 }
 //-------------------------------------------
 void Terrain::updateGraphicsParameters()
 {            
     drawer->updateGraphicsParameters();
-	if (griddedPlot)
+	if (griddedPlot) {
+		renderer->lockData ();
 		griddedPlot->updateGraphicsParameters();
+		renderer->unlockData ();
+	}
 	isEarthMapValid = false;
 	mustRedraw = true;
     update();
@@ -229,10 +266,6 @@ void Terrain::setProjection(Projection *proj)
     Util::setSetting("projectionCY", proj->getCY());
     Util::setSetting("projectionScale",  proj->getScale());	
 	
-	QList<POI*> lpois = getListPOIs();
-	for (int i=0; i<lpois.size(); i++) {
-		lpois.at(i)->setProjection(proj);
-	}
     isEarthMapValid = false;
 	mustRedraw = true;
     update();
@@ -321,7 +354,10 @@ void Terrain::setMapQuality (int q) {
         //update();
         QCursor oldcursor = cursor();
         setCursor(Qt::WaitCursor);
+            renderer->lockData ();
             drawer->gshhsReader->setUserPreferredQuality(q);
+            renderer->getDrawer()->gshhsReader->setUserPreferredQuality(q);
+            renderer->unlockData ();
             isEarthMapValid = false;
             update();
         setCursor(oldcursor);
@@ -333,7 +369,10 @@ void Terrain::setDuplicateMissingWaveRecords (bool b) {
     if (duplicateMissingWaveRecords != b) {
         duplicateMissingWaveRecords = b;
         Util::setSetting("duplicateMissingWaveRecords", b);
+	    renderer->lockData ();
 	    griddedPlot->duplicateMissingWaveRecords (b);
+	    renderer->unlockData ();
+	    drawer->invalidateData ();
         mustRedraw = true;
         update();
     }
@@ -343,7 +382,10 @@ void Terrain::setDuplicateFirstCumulativeRecord (bool b) {
     if (duplicateFirstCumulativeRecord != b) {
         duplicateFirstCumulativeRecord = b;
         Util::setSetting("duplicateFirstCumulativeRecord", b);
+	    renderer->lockData ();
 	    griddedPlot->duplicateFirstCumulativeRecord (b);
+	    renderer->unlockData ();
+	    drawer->invalidateData ();
         mustRedraw = true;
         update();
     }
@@ -353,7 +395,10 @@ void Terrain::setInterpolateValues (bool b) {
     if (interpolateValues != b) {
         interpolateValues = b;
         Util::setSetting("interpolateValues", b);
+	    renderer->lockData ();
 	    griddedPlot->setInterpolateValues (b);
+	    renderer->unlockData ();
+	    drawer->invalidateData ();
         mustRedraw = true;
         update();
     }
@@ -363,7 +408,10 @@ void Terrain::setWindArrowsOnGribGrid (bool b) {
     if (windArrowsOnGribGrid != b) {
         windArrowsOnGribGrid = b;
         Util::setSetting("windArrowsOnGribGrid", b);
+	    renderer->lockData ();
 	    griddedPlot->setWindArrowsOnGrid (b);
+	    renderer->unlockData ();
+	    drawer->invalidateData ();
         mustRedraw = true;
         update();
     }
@@ -377,8 +425,10 @@ void Terrain::setColorMapData (const DataCode &dtc)
 		Util::setSetting ("colorMapData", DataCodeStr::serialize(dtc));
         drawer->setColorMapData (dtc);
 		if (griddedPlot!=NULL && griddedPlot->isReaderOk()) {
+			renderer->lockData ();
 			griddedPlot->setUseJetStreamColorMap (
-						Util::getSetting("useJetStreamColorMap", false).toBool());
+						Util::getSettingsSnapshot().useJetStreamColorMap);
+			renderer->unlockData ();
 		}
         mustRedraw = true;
         update();
@@ -389,7 +439,10 @@ void Terrain::setCurrentArrowsOnGribGrid (bool b) {
     if (currentArrowsOnGribGrid != b) {
         currentArrowsOnGribGrid = b;
         Util::setSetting("currentArrowsOnGribGrid", b);
+	    renderer->lockData ();
 	    griddedPlot->setCurrentArrowsOnGrid (b);
+	    renderer->unlockData ();
+	    drawer->invalidateData ();
         mustRedraw = true;
         update();
     }
@@ -436,8 +489,11 @@ void Terrain::setThinArrows (bool b) {
     if (actual != b) {
         Util::setSetting("thinWindArrows", b);
 		if (griddedPlot) {
+			renderer->lockData ();
 			griddedPlot->updateGraphicsParameters ();
+			renderer->unlockData ();
 		}
+		drawer->invalidateData ();
         mustRedraw = true;
         update();
     }
@@ -645,16 +701,29 @@ bool  Terrain::getGribFileRectangle(double *x0, double *y0, double *x1, double *
 //---------------------------------------------------------
 // Grib or IAC files or ...
 //---------------------------------------------------------
-FileDataType Terrain::loadMeteoDataFile (QString fileName, bool zoom)
+void Terrain::loadMeteoDataFile (QString fileName, bool zoom,
+								 GribReader *reader,
+								 const GribSubset *subset,
+								 const QStringList &datasetFiles)
 {
+	if (taskProgress != NULL) {		// an other file is being loaded
+		delete reader;
+		return;
+	}
     indicateWaitingMap();
-	currentFileType = DATATYPE_NONE;
-	bool ok = false;
 	
 	taskProgress = new LongTaskProgress (this);
 	assert (taskProgress);
-	taskProgress->continueDownload = true;
+	connect (taskProgress, SIGNAL(previewReady(GribReader *)),
+			 this, SLOT(slotPreviewReady(GribReader *)));
+	loadingFileName = fileName;
+	loadingZoom = zoom;
+	hasLoadingSubset = (subset != NULL);
+	loadingSubset = hasLoadingSubset ? *subset : GribSubset();
+	loadingDatasetFiles = datasetFiles;
 	
+	renderer->lockData ();
+	currentFileType = DATATYPE_NONE;
 	if (griddedPlot != NULL) {
 		delete griddedPlot;
 		griddedPlot = NULL;
@@ -663,120 +732,145 @@ FileDataType Terrain::loadMeteoDataFile (QString fileName, bool zoom)
 		delete iacPlot;
 		iacPlot = NULL;
 	}
+	renderer->unlockData ();
 	taskProgress->setMessage (LTASK_OPEN_FILE);
 	taskProgress->setValue (0);
+	if (reader != NULL) {		// GRIB file decoded while downloaded
+		if (reader->isOk()) {
+			GribPlot *gribPlot = new GribPlot ();
+			assert(gribPlot);
+			gribPlot->loadReader (reader, fileName);
+			endLoading (gribPlot, NULL, DATATYPE_GRIB);
+			return;
+		}
+		delete reader;
+	}
     //--------------------------------------------------------
     // Ouverture du fichier
     //--------------------------------------------------------
-    ZUFILE *file = zu_open (qPrintable(fileName), "rb", ZU_COMPRESS_AUTO);
-    if (file == NULL) {
-        erreur("Can't open file: %s", qPrintable(fileName));
-		taskProgress->setVisible (false);
-		delete taskProgress;
-		taskProgress = NULL;
-        return DATATYPE_NONE;
-    }
-    int nbrecs = GribReader::countGribRecords (file, taskProgress);
-
-    //----------------------------------------------
-	GriddedPlotter  *griddedPlot_Temp = NULL;
-	if (nbrecs>0 && !ok && taskProgress->continueDownload) {	// try to load a GRIB file
-		//DBGQS("try to load a GRIB1 file: "+fileName);
-		taskProgress->setWindowTitle (tr("Open file")+" GRIB");
-		taskProgress->setVisible (true);
-		taskProgress->setValue (0);
-		griddedPlot_Temp = new GribPlot ();
-		assert(griddedPlot_Temp);
-		griddedPlot_Temp->loadFile (fileName, taskProgress, nbrecs);    // GRIB file ?
-		if (griddedPlot_Temp->isReaderOk()) {
-			currentFileType = DATATYPE_GRIB;
-			ok = true;
-		}
-		else {
-			delete griddedPlot_Temp;
-			griddedPlot_Temp = NULL;
-		}
+	ZUFILE *file = zu_open (qPrintable(fileName), "rb", ZU_COMPRESS_AUTO);
+	if (file == NULL) {
+		erreur("Can't open file: %s", qPrintable(fileName));
+		endLoading (NULL, NULL, DATATYPE_NONE);
+		return;
 	}
-	if (nbrecs>0 && !ok && taskProgress->continueDownload) {	// try to load a GRIB2 file
-		//DBGQS("try to load a GRIB2 file: "+fileName);
-		taskProgress->setWindowTitle (tr("Open file")+" GRIB2");
-		taskProgress->setVisible (true);
-		taskProgress->setValue (0);
-		griddedPlot_Temp = new Grib2Plot ();
-		assert(griddedPlot_Temp);
-		griddedPlot_Temp->loadFile (fileName, taskProgress, nbrecs);    // GRIB file ?
-		if (griddedPlot_Temp->isReaderOk()) {
-			currentFileType = DATATYPE_GRIB;
-			ok = true;
+	bool isGrib = GribFramer::isGribFile (file);
+	zu_close (file);
+	taskProgress->setPreviewWanted (isGrib);
+	loadingStep = isGrib ? LOAD_GRIB : LOAD_MBLUE;
+	startLoadingStep ();
+}
+//---------------------------------------------------------
+// Starts the reader of loadingStep in a thread
+// (the IAC files are small: read at once)
+//---------------------------------------------------------
+void Terrain::startLoadingStep ()
+{
+	GriddedPlotter *plotter = NULL;
+	if (! taskProgress->isCanceled()) {
+		if (loadingStep == LOAD_GRIB) {
+			//DBGQS("try to load a GRIB1 file: "+fileName);
+			taskProgress->setWindowTitle (tr("Open file")+" GRIB");
+			GribPlot *gribPlot = new GribPlot ();
+			assert(gribPlot);
+			if (hasLoadingSubset)
+				gribPlot->setLoadSubset (loadingSubset);
+			gribPlot->setDatasetFiles (loadingDatasetFiles);
+			plotter = gribPlot;
 		}
-		else {
-			delete griddedPlot_Temp;
-			griddedPlot_Temp = NULL;
+		else if (loadingStep == LOAD_GRIB2) {
+			//DBGQS("try to load a GRIB2 file: "+fileName);
+			taskProgress->setWindowTitle (tr("Open file")+" GRIB2");
+			Grib2Plot *grib2Plot = new Grib2Plot ();
+			assert(grib2Plot);
+			if (hasLoadingSubset)
+				grib2Plot->setLoadSubset (loadingSubset);
+			grib2Plot->setDatasetFiles (loadingDatasetFiles);
+			plotter = grib2Plot;
+		}
+		else if (loadingStep == LOAD_MBLUE) {
+			//DBG("try to load a MBLUE file");
+			taskProgress->setWindowTitle (tr("Open file")+" MBLUE");
+			plotter = new MbluePlot ();
+			assert(plotter);
 		}
 	}
-	if (!ok && taskProgress->continueDownload) {	// try to load a MBLUE file
-		//DBG("try to load a MBLUE file");
-		taskProgress->setWindowTitle (tr("Open file")+" MBLUE");
+	if (plotter != NULL) {
 		taskProgress->setVisible (true);
 		taskProgress->setValue (0);
-		griddedPlot_Temp = new MbluePlot ();
-		assert(griddedPlot_Temp);
-		griddedPlot_Temp->loadFile (fileName, taskProgress);    // MBLUE file ?
-		if (griddedPlot_Temp->isReaderOk()) {
-			griddedPlot_Temp->setFastInterpolation (fastInterpolation_MBlue);
-			currentFileType = DATATYPE_MBLUE;
-			ok = true;
-		}
-		else {
-			delete griddedPlot_Temp;
-			griddedPlot_Temp = NULL;
-		}
+		loadingPlot = plotter;
+		loadThread = new ThreadLoadFile (plotter, loadingFileName, taskProgress);
+		assert(loadThread);
+		connect (loadThread, SIGNAL(finished()), this, SLOT(slotLoadFileFinished()));
+		loadThread->start ();
+		return;
 	}
-	if (!ok && taskProgress->continueDownload) {	// try to load a IAC file
+	IacPlot *iac = NULL;
+	if (! taskProgress->isCanceled()) {	// try to load a IAC file
 		//DBG("try to load a IAC file");
-		iacPlot = new IacPlot ();
-		assert(iacPlot);
-		iacPlot->loadFile (fileName);      // IAC file ?
-		if (iacPlot->isReaderOk()) {
-			currentFileType = DATATYPE_IAC;
-			ok = true;
+		iac = new IacPlot ();
+		assert(iac);
+		iac->loadFile (loadingFileName);      // IAC file ?
+		if (! iac->isReaderOk()) {
+			delete iac;
+			iac = NULL;
+		}
+	}
+	endLoading (NULL, iac, iac!=NULL ? DATATYPE_IAC : DATATYPE_NONE);
+}
+//---------------------------------------------------------
+// End of the thread of loadingStep (GUI thread)
+//---------------------------------------------------------
+void Terrain::slotLoadFileFinished ()
+{
+	if (loadThread == NULL || sender() != loadThread)
+		return;
+	loadThread->wait ();
+	loadThread->deleteLater ();
+	loadThread = NULL;
+	GriddedPlotter *plotter = loadingPlot;
+	loadingPlot = NULL;
+	if (plotter->isReaderOk()) {
+		if (loadingStep == LOAD_MBLUE) {
+			plotter->setFastInterpolation (fastInterpolation_MBlue);
+			endLoading (plotter, NULL, DATATYPE_MBLUE);
 		}
 		else {
-			delete iacPlot;
-			iacPlot = NULL;
+			endLoading (plotter, NULL, DATATYPE_GRIB);
 		}
+		return;
 	}
-	
+	delete plotter;
+	loadingStep ++;			// try the next reader
+	startLoadingStep ();
+}
+//---------------------------------------------------------
+void Terrain::endLoading (GriddedPlotter *plotter, IacPlot *iac,
+						  FileDataType fileType)
+{
 	taskProgress->setVisible (false);
+	bool cancelled = taskProgress->isCanceled();
+	delete taskProgress;
+	taskProgress = NULL;
 	
-	griddedPlot = griddedPlot_Temp;
-	if (ok) {	// initializes data plotter
-		switch (currentFileType) {
-			case DATATYPE_GRIB :
-				griddedPlot_Temp->setInterpolateValues (interpolateValues);
-				griddedPlot_Temp->setWindArrowsOnGrid  (windArrowsOnGribGrid);
-				griddedPlot_Temp->setCurrentArrowsOnGrid  (currentArrowsOnGribGrid);
-				griddedPlot_Temp->duplicateFirstCumulativeRecord (duplicateFirstCumulativeRecord);
-				griddedPlot_Temp->duplicateMissingWaveRecords (duplicateMissingWaveRecords);
-				griddedPlot_Temp->setCurrentDateClosestFromNow ();
-				griddedPlot_Temp->setUseJetStreamColorMap (
-								Util::getSetting("useJetStreamColorMap", false).toBool());
-				break;
-			case DATATYPE_MBLUE :
-				griddedPlot_Temp->setInterpolateValues (interpolateValues);
-				griddedPlot_Temp->setWindArrowsOnGrid  (windArrowsOnGribGrid);
-				griddedPlot_Temp->setCurrentArrowsOnGrid  (currentArrowsOnGribGrid);
-				griddedPlot_Temp->setCurrentDateClosestFromNow ();
-				griddedPlot_Temp->setUseJetStreamColorMap (
-								Util::getSetting("useJetStreamColorMap", false).toBool());
-				break;
-			default :
-				break;
-		}
+	if (plotter != NULL) {	// initializes data plotter
+		initGriddedPlotter (plotter, fileType);
 	}
-	else {
-		//DBG("ERROR: unknown file type");
+	
+	// the whole file replaces the preview of the first date
+	renderer->lockData ();
+	if (griddedPlot != NULL) {
+		delete griddedPlot;
 	}
+	griddedPlot = plotter;
+	iacPlot = iac;
+	currentFileType = fileType;
+	if (plotter != NULL) {
+		plotter->enableRecordCache ();
+		GribRecordCache::trim ();
+	}
+	drawer->invalidateData ();
+	renderer->unlockData ();
 	
 	isSelectionZoneEnCours = false;
 	isDraggingMapEnCours = false;
@@ -784,19 +878,68 @@ FileDataType Terrain::loadMeteoDataFile (QString fileName, bool zoom)
     selX1 = selY1 = 0;
     isEarthMapValid = false;
 	mustRedraw = true;
-    if (zoom) {
+    if (loadingZoom) {
         zoomOnFileZone();    // Zoom sur la zone couverte par le fichier GRIB
     }
     update();
 
-	bool cancelled = ! taskProgress->continueDownload;
-	delete taskProgress;
-	taskProgress = NULL;
+	emit meteoDataLoaded (cancelled ? DATATYPE_CANCELLED : fileType,
+						  loadingFileName);
+}
+//---------------------------------------------------------
+void Terrain::initGriddedPlotter (GriddedPlotter *plotter, FileDataType fileType)
+{
+	switch (fileType) {
+		case DATATYPE_GRIB :
+			plotter->setInterpolateValues (interpolateValues);
+			plotter->setWindArrowsOnGrid  (windArrowsOnGribGrid);
+			plotter->setCurrentArrowsOnGrid  (currentArrowsOnGribGrid);
+			plotter->duplicateFirstCumulativeRecord (duplicateFirstCumulativeRecord);
+			plotter->duplicateMissingWaveRecords (duplicateMissingWaveRecords);
+			plotter->setCurrentDateClosestFromNow ();
+			plotter->setUseJetStreamColorMap (
+							Util::getSettingsSnapshot().useJetStreamColorMap);
+			break;
+		case DATATYPE_MBLUE :
+			plotter->setInterpolateValues (interpolateValues);
+			plotter->setWindArrowsOnGrid  (windArrowsOnGribGrid);
+			plotter->setCurrentArrowsOnGrid  (currentArrowsOnGribGrid);
+			plotter->setCurrentDateClosestFromNow ();
+			plotter->setUseJetStreamColorMap (
+							Util::getSettingsSnapshot().useJetStreamColorMap);
+			break;
+		default :
+			break;
+	}
+}
+//---------------------------------------------------------
+// First date of the GRIB file being loaded, shown until the end
+//---------------------------------------------------------
+void Terrain::slotPreviewReady (GribReader *reader)
+{
+	if (taskProgress == NULL || sender() != taskProgress
+			|| taskProgress->isCanceled() || griddedPlot != NULL) {
+		delete reader;			// loading already finished
+		return;
+	}
+	GribPlot *preview = new GribPlot ();
+	assert(preview);
+	preview->loadReader (reader, loadingFileName);
+	initGriddedPlotter (preview, DATATYPE_GRIB);
 	
-	if (cancelled)
-		return DATATYPE_CANCELLED;
-	else
-		return currentFileType;
+	renderer->lockData ();
+	griddedPlot = preview;
+	preview->enableRecordCache ();		// trimmed at the end of the loading
+	currentFileType = DATATYPE_GRIB;
+	drawer->invalidateData ();
+	renderer->unlockData ();
+	
+    isEarthMapValid = false;
+	mustRedraw = true;
+    if (loadingZoom) {
+        zoomOnFileZone();
+    }
+	update();
 }
 
 //---------------------------------------------------------
@@ -815,6 +958,7 @@ GriddedPlotter *Terrain::getGriddedPlotter ()
 //---------------------------------------------------------
 void   Terrain::closeMeteoDataFile()
 {
+	renderer->lockData ();
 	if (griddedPlot != NULL) {
 		delete griddedPlot;
 		griddedPlot = NULL;
@@ -824,6 +968,8 @@ void   Terrain::closeMeteoDataFile()
 		iacPlot = NULL;
 	}
 	currentFileType = DATATYPE_NONE;
+	renderer->unlockData ();
+	drawer->invalidateData ();
 	mustRedraw = true;
     update();
 }
@@ -891,12 +1037,27 @@ void Terrain::slotMustRedraw()
     update();
 }
 //---------------------------------------------------------
+// Units and formats of the displayed values
+//---------------------------------------------------------
+void Terrain::slotSettingChanged (const QString &key)
+{
+	if (SettingsSnapshot::isSnapshotKey (key)) {
+		drawer->invalidateData ();		// labels are redrawn
+		mustRedraw = true;
+		update();
+	}
+}
+//---------------------------------------------------------
 void Terrain::setCurrentDate(time_t t)
 {
     if (griddedPlot->getCurrentDate() != t)
     {
         indicateWaitingMap();
+        renderer->lockData ();
         griddedPlot->setCurrentDate(t);
+        if (! isLoadingFile())
+            GribRecordCache::trim ();
+        renderer->unlockData ();
 		mustRedraw = true;
         update();
     }
@@ -916,6 +1077,7 @@ void Terrain::enterEvent (QEvent * /*e*/) {
 void Terrain::leaveEvent (QEvent * e) {
 //printf("leave\n");
 	emit mouseLeave (e);
+	markerUnderCursor = NULL;
     setCursor(enterCursor);
 }
 
@@ -924,22 +1086,34 @@ void  Terrain::keyPressEvent (QKeyEvent *e)
 {
 //printf("Terrain::keyPressEvent\n");
 	keyModifiers = e->modifiers();
-    if (keyModifiers == Qt::ControlModifier) {
-        setCursor(Qt::ClosedHandCursor);
-    }
-    else if (keyModifiers == Qt::ShiftModifier) {
-        setCursor(Qt::UpArrowCursor);
-    }
-    else {
-        setCursor(myCrossCursor);
-    }
+	if (e->key() == Qt::Key_F12) {
+		showRenderTimes = ! showRenderTimes;
+		Util::setSetting ("showMapRenderTimes", showRenderTimes);
+		update ();
+	}
+	updateCursor ();
 }
 //---------------------------------------------------------
 void  Terrain::keyReleaseEvent (QKeyEvent *e)
 {
 //printf("keyReleaseEvent\n");
 	keyModifiers = e->modifiers();
-    if (keyModifiers == Qt::ControlModifier) {
+	updateCursor ();
+}
+//---------------------------------------------------------
+void  Terrain::updateCursor ()
+{
+	POI *poi = qobject_cast <POI*> (markerUnderCursor);
+	if (poi != NULL) {
+		if (poi->canBeMoved() && keyModifiers == Qt::ControlModifier)
+			setCursor(Qt::SizeAllCursor);
+		else
+			setCursor(Qt::PointingHandCursor);
+	}
+	else if (markerUnderCursor != NULL) {	// METAR station
+        setCursor(Qt::UpArrowCursor);
+	}
+    else if (keyModifiers == Qt::ControlModifier) {
         setCursor(Qt::ClosedHandCursor);
     }
     else if (keyModifiers == Qt::ShiftModifier) {
@@ -976,9 +1150,71 @@ void Terrain::slotTimerZoomWheel () {
 }
 
 
+//---------------------------------------------------------
+// POI or METAR station drawn at (x,y)
+//---------------------------------------------------------
+QObject * Terrain::findMarker (int x, int y)
+{
+	POI *poi = markers.findPOI (x, y);
+	if (poi != NULL)
+		return poi;
+	return markers.findMetar (x, y);
+}
+//---------------------------------------------------------
+bool Terrain::event (QEvent * e)
+{
+	if (e->type() == QEvent::ToolTip) {
+		QHelpEvent *he = static_cast <QHelpEvent *> (e);
+		QObject *marker = findMarker (he->x(), he->y());
+		POI *poi = qobject_cast <POI*> (marker);
+		MetarMarker *metar = qobject_cast <MetarMarker*> (marker);
+		if (poi != NULL)
+			QToolTip::showText (he->globalPos(), poi->getToolTip(), this);
+		else if (metar != NULL)
+			QToolTip::showText (he->globalPos(), metar->getToolTip(), this);
+		else
+			QToolTip::hideText ();
+		return true;
+	}
+	return QWidget::event (e);
+}
+//---------------------------------------------------------
+// POIs and METARs are children of the map: rebuild their index
+//---------------------------------------------------------
+void Terrain::childEvent (QChildEvent * e)
+{
+	if (e->removed()) {
+		if (e->child() == poiUnderMouse)
+			poiUnderMouse = NULL;
+		if (e->child() == metarUnderMouse)
+			metarUnderMouse = NULL;
+		if (e->child() == markerUnderCursor)
+			markerUnderCursor = NULL;
+	}
+	if (e->added() || e->removed()) {
+		markers.invalidate ();
+		update ();
+	}
+	QWidget::childEvent (e);
+}
+//---------------------------------------------------------
+void Terrain::slotMarkersChanged ()
+{
+	markers.invalidate ();
+	update ();
+}
+
 //---------------------------------------------------------
 void Terrain::mousePressEvent (QMouseEvent * e) {
 //printf("press\n");
+	QObject *marker = findMarker (e->x(), e->y());
+	if (marker != NULL) {
+		poiUnderMouse = qobject_cast <POI*> (marker);
+		metarUnderMouse = qobject_cast <MetarMarker*> (marker);
+		if (poiUnderMouse != NULL)
+			poiUnderMouse->mousePress (e, proj);
+		return;
+	}
     if (e->button() == Qt::LeftButton)
     {
         // Début de sélection de zone rectangulaire
@@ -1001,6 +1237,19 @@ void Terrain::mousePressEvent (QMouseEvent * e) {
 void Terrain::mouseReleaseEvent (QMouseEvent * e) {
     double x0, y0, x1, y1;
     
+	if (poiUnderMouse != NULL) {
+		POI *poi = poiUnderMouse;
+		poiUnderMouse = NULL;
+		poi->mouseRelease (e, markers.findPOI(e->x(),e->y()) == poi);
+		return;
+	}
+	if (metarUnderMouse != NULL) {
+		MetarMarker *metar = metarUnderMouse;
+		metarUnderMouse = NULL;
+		if (markers.findMetar(e->x(),e->y()) == metar)
+			metar->mouseRelease ();
+		return;
+	}
     globalX0 = 0;
     globalY0 = 0;
 	
@@ -1034,6 +1283,18 @@ void Terrain::mouseReleaseEvent (QMouseEvent * e) {
 //---------------------------------------------------------
 void Terrain::mouseMoveEvent (QMouseEvent * e) 
 {
+	if (poiUnderMouse != NULL || metarUnderMouse != NULL) {
+		if (poiUnderMouse != NULL && poiUnderMouse->isMoving())
+			poiUnderMouse->mouseMove (e, proj);
+		return;
+	}
+	if (!isDraggingMapEnCours && !isSelectionZoneEnCours) {
+		QObject *marker = findMarker (e->x(), e->y());
+		if (marker != markerUnderCursor) {
+			markerUnderCursor = marker;
+			updateCursor ();
+		}
+	}
     if (isDraggingMapEnCours)
     {
 		// TODO use  tiles to drag map
@@ -1100,28 +1361,15 @@ void Terrain::paintEvent(QPaintEvent *)
     if (!isResizing || !firstDrawingIsDone)
     {
 		firstDrawingIsDone = true;
-        // Draw the map and the GRIB data
-        QCursor oldcursor = cursor();
-        setCursor(Qt::WaitCursor);
-        
-        switch (currentFileType) {
-			case DATATYPE_GRIB :
-			case DATATYPE_MBLUE :
-				drawer->draw_GSHHS_and_GriddedData 
-					(pnt, mustRedraw, isEarthMapValid, proj, griddedPlot, drawCartouche);
-				break;
-			case DATATYPE_IAC :
-				drawer->draw_GSHHS_and_IAC 
-					(pnt, mustRedraw, isEarthMapValid, proj, iacPlot, drawCartouche);
-				break;
-			default :
-				drawer->draw_GSHHS (pnt, mustRedraw, isEarthMapValid, proj);
-        }
-		
-        setCursor(oldcursor);
-		isEarthMapValid = true;
-		mustRedraw = false;
-		pleaseWait = false;
+		if (mustRedraw || !isEarthMapValid) {
+			// drawn by the map thread, the last image is shown until then
+			requestedGeneration = renderer->requestFrame (*drawer, proj,
+								currentFileType, griddedPlot, iacPlot,
+								isEarthMapValid, drawCartouche);
+			isEarthMapValid = true;
+			mustRedraw = false;
+		}
+		draw_MapFrame (pnt);
         
         if (selX0!=selX1 && selY0!=selY1) {
             // Draw the rectangle of the selected zone
@@ -1143,19 +1391,7 @@ void Terrain::paintEvent(QPaintEvent *)
         }
     }
     else {
-        switch (currentFileType) {
-			case DATATYPE_GRIB :
-			case DATATYPE_MBLUE :
-				drawer->draw_GSHHS_and_GriddedData 
-						(pnt, false, true, proj, griddedPlot);
-				break;
-			case DATATYPE_IAC :
-				drawer->draw_GSHHS_and_IAC 
-						(pnt, false, true, proj, iacPlot);
-				break;
-			default :
-				drawer->draw_GSHHS (pnt, mustRedraw, isEarthMapValid, proj);
-        }
+		draw_MapFrame (pnt);
 	}
     
     if (mustShowSpecialZone) {
@@ -1171,6 +1407,21 @@ void Terrain::paintEvent(QPaintEvent *)
 		}
     }
     
+    //-----------------------------------------
+    // Points of interest and METAR stations
+    //-----------------------------------------
+    if (! markers.isValid()) {
+		markers.setMarkers (getListPOIs(), findChildren <MetarMarker*>());
+	}
+	QElapsedTimer timer;
+	timer.start ();
+	markers.draw (pnt, proj, showPOIs, showMETARs);
+	renderer->getDrawer()->addRenderTime (MapDrawer::LAYER_POIS, timer.nsecsElapsed()/1e6);
+	
+	if (showRenderTimes) {
+		renderer->getDrawer()->draw_RenderTimes (pnt, width());
+	}
+	
     if (pleaseWait) {
         // Write the message "please wait..." on the map
         QFont fontWait = Font::getFont(FONT_MapWait);
@@ -1189,6 +1440,47 @@ void Terrain::paintEvent(QPaintEvent *)
     }
 }
 //------------------------------------------------------------------
+// Last image of the map thread, moved and scaled to the current view
+//------------------------------------------------------------------
+void Terrain::draw_MapFrame (QPainter &pnt)
+{
+	if (frame.isNull()) {
+		pnt.fillRect (rect(), drawer->backgroundColor);
+	}
+	else if (frame.isSameView (proj)) {
+		pnt.drawImage (0,0, frame.image);
+	}
+	else {
+		int x0,y0, x1,y1;
+		proj->map2screen (frame.x0,frame.y0, &x0,&y0);
+		proj->map2screen (frame.x1,frame.y1, &x1,&y1);
+		pnt.fillRect (rect(), drawer->backgroundColor);
+		pnt.drawImage (QRect(x0,y0, x1-x0,y1-y0), frame.image);
+	}
+}
+//------------------------------------------------------------------
+void Terrain::slotFrameReady ()
+{
+	MapFrame newFrame;
+	if (! renderer->takeFrame (newFrame)
+			|| newFrame.generation < frame.generation)
+		return;
+	frame = newFrame;
+	if (frame.generation >= requestedGeneration) {
+		pleaseWait = false;
+	}
+#ifdef DEBUG
+	// a redraw of the same view must not allocate the render buffers again
+	// (only RenderBuffer allocations are counted, not the others)
+	static int nbBufferAllocations = 0;
+	if (RenderBuffer::getNbAllocations() != nbBufferAllocations) {
+		nbBufferAllocations = RenderBuffer::getNbAllocations();
+		DBG("render buffers: %d allocations", nbBufferAllocations);
+	}
+#endif
+	update ();
+}
+//------------------------------------------------------------------
 time_t Terrain::getCurrentDate()
 {
 	switch (currentFileType) {
@@ -1219,6 +1511,7 @@ QPixmap * Terrain::createPixmap (time_t date, int width, int height)
 		scaledproj->getVisibleArea (&x0,&y0, &x1,&y1);
 		scaledproj->setScreenSize  (width, height);
 		scaledproj->setVisibleArea (x0,y0, x1,y1);
+		renderer->lockData ();
 		switch (currentFileType) {
 			case DATATYPE_GRIB :
 			case DATATYPE_MBLUE :
@@ -1229,7 +1522,7 @@ QPixmap * Terrain::createPixmap (time_t date, int width, int height)
 										false, 
 										griddedPlot, 
 										scaledproj, 
-										getListPOIs() );
+										getListShownPOIs() );
 				}
 				break;
 			case DATATYPE_IAC :
@@ -1244,8 +1537,11 @@ QPixmap * Terrain::createPixmap (time_t date, int width, int height)
 									false, 
 									NULL, 
 									scaledproj, 
-									getListPOIs() );
+									getListShownPOIs() );
 		}
+		renderer->unlockData ();
+		mustRedraw = true;		// image of the map thread was dropped
+		update ();
 		delete scaledproj;
 		delete scaleddrawer;
 	}
@@ -1322,15 +1618,15 @@ void Terrain::slot_Go_Down()
 void Terrain::setShowPOIs(bool show)
 {
 	Util::setSetting("showPOIs", show);
-	// list of all the POI's
-	QList<POI*> lpois = getListPOIs();
-	for (int i=0; i<lpois.size(); i++)
-	{
-		if (show)
-			lpois.at(i)->setVisible(true);
-		else
-			lpois.at(i)->setVisible(false);
-	}
+	showPOIs = show;
+	update();
+}
+//---------------------------------------------------------
+void Terrain::setShowMETARs(bool show)
+{
+	Util::setSetting("showMETARs", show);
+	showMETARs = show;
+	update();
 }
 
 //-------------------------------------------------------
@@ -1381,7 +1677,9 @@ void Terrain::setMBlueFastInterpolation (bool b)
 		Util::setSetting ("MBfastInterpolation", b);
 		fastInterpolation_MBlue = b;
 		if (griddedPlot) {
+			renderer->lockData ();
 			griddedPlot->setFastInterpolation (fastInterpolation_MBlue);
+			renderer->unlockData ();
 			mustRedraw = true;
 			update();
 		}
@@ -1392,7 +1690,7 @@ DataCode Terrain::getColorMapData ()
 { 
 	DataCode dtc = drawer->getColorMapData();
 	if (dtc.dataType == GRB_PRV_WIND_XY2D) {
-		if (Util::getSetting("useJetStreamColorMap", false).toBool()) {
+		if (Util::getSettingsSnapshot().useJetStreamColorMap) {
 			dtc.dataType = GRB_PRV_WIND_JET;
 		}
 	}
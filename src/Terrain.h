@@ -24,13 +24,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QBitmap>
 #include <QTimer>
 #include <QPen>
+#include <QThread>
 
 #include "GshhsReader.h"
 #include "GisReader.h"
 #include "Projection.h"
 #include "POI.h"
+#include "MarkersLayer.h"
 
 #include "MapDrawer.h"
+#include "MapRenderer.h"
 #include "GribPlot.h"
 #include "Grib2Plot.h"
 #include "IacPlot.h"
@@ -38,6 +41,25 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "LongTaskProgress.h"
 
 
+//==============================================================================
+// Loads a meteo file out of the GUI thread
+//==============================================================================
+class ThreadLoadFile : public QThread
+{
+	public:
+		ThreadLoadFile (GriddedPlotter *plotter, QString fileName,
+						LongTaskProgress *taskProgress)
+			{ this->plotter = plotter;
+			  this->fileName = fileName;
+			  this->taskProgress = taskProgress; }
+		void run ()   { plotter->loadFile (fileName, taskProgress); }
+		
+	private:
+		GriddedPlotter   *plotter;
+		QString           fileName;
+		LongTaskProgress *taskProgress;
+};
+
 //==============================================================================
 class Terrain : public QWidget
 {
@@ -45,14 +67,24 @@ class Terrain : public QWidget
 
 public:
     Terrain (QWidget *parent, Projection *proj, GshhsReader *gshhsReader);
+    ~Terrain ();
 
 	void    setCurrentDate (time_t t);
 	time_t  getCurrentDate ();
     
-    MapDrawer   *getDrawer()      {return drawer;}
+    MapDrawer   *getDrawer()      {return drawer;}	// options of the map
     Projection  *getProjection()  {return proj;}
     
-    FileDataType  loadMeteoDataFile (QString fileName, bool zoom);
+    // Starts the loading and returns: the end is announced by
+    // meteoDataLoaded (the file is read in a thread).
+    // reader: GRIB file already decoded while downloaded (or NULL)
+    // subset: part of a GRIB file to load (or NULL for the whole file)
+    // datasetFiles: GRIB files read as one dataset (fileName is the first)
+    void  loadMeteoDataFile (QString fileName, bool zoom,
+							 GribReader *reader=NULL,
+							 const GribSubset *subset=NULL,
+							 const QStringList &datasetFiles=QStringList());
+	bool  isLoadingFile ()    {return taskProgress != NULL;}
 	FileDataType  getMeteoFileType()  {return currentFileType;}
 
 	void  closeMeteoDataFile();
@@ -79,11 +111,16 @@ public:
     bool  getGribFileRectangle (double *x0, double *y0, double *x1, double *y1);
     
 	QList<POI*> getListPOIs() { return findChildren <POI*>(); }
+	QList<POI*> getListShownPOIs() { return showPOIs ? getListPOIs() : QList<POI*>(); }
 	
 	void     setColorMapData (const DataCode &dtc);
 	DataCode getColorMapData ();
 					
 	QPixmap * createPixmap (time_t date, int width, int height);
+	
+	// Around any change of the data of the plotters (map thread)
+	void  lockData ()     {renderer->lockData();}
+	void  unlockData ()   {renderer->unlockData();}
     
 public slots :
     // Map
@@ -107,6 +144,8 @@ public slots :
     void slot_Go_Down ();
     
     void setShowPOIs (bool);
+    void setShowMETARs (bool);
+    void slotMarkersChanged ();
     void updateGraphicsParameters ();
     
     void setColorMapSmooth 	  (bool);
@@ -151,17 +190,27 @@ public slots :
     void slotTimerResize();
     void slotTimerZoomWheel();
     void slotMustRedraw();
+    void slotSettingChanged (const QString &key);
+    void slotFrameReady ();
+    void slotPreviewReady (GribReader *reader);
+    void slotLoadFileFinished ();
     
 signals:
     void selectionOK  (double x0, double y0, double x1, double y1);
     void mouseClicked (QMouseEvent * e);
     void mouseMoved   (QMouseEvent * e);
     void mouseLeave   (QEvent * e);
+    // end of loadMeteoDataFile (DATATYPE_CANCELLED if cancelled)
+    void meteoDataLoaded (FileDataType fileType, QString fileName);
 
 
 private:
 	MapDrawer *drawer;
 	FileDataType  currentFileType;
+	MapRenderer  *renderer;			// draws the map in its own thread
+	MapFrame      frame;			// last image of the map
+	uint          requestedGeneration;
+	void  draw_MapFrame (QPainter &pnt);
 
 	//-----------------------------------------------
     Projection  *proj;
@@ -177,13 +226,39 @@ private:
     bool		fastInterpolation_MBlue;
 	int 		lastMouseX, lastMouseY;
 	
-	LongTaskProgress *taskProgress;
+	LongTaskProgress *taskProgress;		// file being loaded
+	QString           loadingFileName;
+	bool              loadingZoom;
+	GribSubset        loadingSubset;
+	bool              hasLoadingSubset;
+	QStringList       loadingDatasetFiles;
+	// readers tried in turn until one accepts the file
+	enum { LOAD_GRIB, LOAD_GRIB2, LOAD_MBLUE, LOAD_IAC };
+	int               loadingStep;
+	GriddedPlotter   *loadingPlot;		// filled by loadThread
+	ThreadLoadFile   *loadThread;
+	void  startLoadingStep   ();
+	void  endLoading         (GriddedPlotter *plotter, IacPlot *iac,
+							  FileDataType fileType);
+	void  initGriddedPlotter (GriddedPlotter *plotter, FileDataType fileType);
 
     QTimer      *timerResize;
     QTimer      *timerZoomWheel;
     QCursor		myCrossCursor;
     QCursor     enterCursor;
 	double 		deltaZoomWheel;
+	
+	//-----------------------------------------------
+	// POIs and METAR stations
+	MarkersLayer markers;
+	bool         showPOIs, showMETARs;
+	POI         *poiUnderMouse;		// mouse pressed on this POI
+	MetarMarker *metarUnderMouse;
+	QObject     *markerUnderCursor;
+	QObject * findMarker (int x, int y);
+	void      updateCursor ();
+	
+	bool      showRenderTimes;		// debug panel (F12)
         
     void  draw_OrthodromieSegment
             (QPainter &pnt, double x0,double y0, double x1,double y1, int recurs=0);
@@ -201,6 +276,8 @@ private:
     void  enterEvent (QEvent * e);
     void  leaveEvent (QEvent * e);
     void  wheelEvent(QWheelEvent * e) ;
+    bool  event (QEvent * e);
+    void  childEvent (QChildEvent * e);
     void  zoomOnFileZone();
 
 	//-----------------------------------------------
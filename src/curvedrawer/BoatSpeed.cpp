@@ -9,13 +9,17 @@
 #include "zuFile.h"
 #include "BoatSpeed.h"
 
+#include <cstdio>
+
 #include <QFile>
+#include <QMap>
 
 //------------------------------------------------------------------
 // Constructor
 // build up wind boat speed relation
 BoatSpeed::BoatSpeed( QString fileName ) {
-	qhWindBoatCard.clear();	
+	iNbTWA = iNbTWS = 0;
+	dMaxTWS = 0;
 	loadBoatParams( fileName );
 }
 //------------------------------------------------------------------
@@ -24,72 +28,29 @@ BoatSpeed::BoatSpeed( QString fileName ) {
 	delete this;
 }*/
 //------------------------------------------------------------------
-// get quantisized wind degree steps for boat speed parameters
-int BoatSpeed::getDegSteps( double dTWindDir, double dBoatDir ) {
-	double dDir;
-	int iKeyTmp = 0;
-	
-	// 360 degree periodicity
-	// dWDir = (dTWindDir + 180.0) % 360.0;
-	dDir = dTWindDir - dBoatDir;
-	if( dDir < 0 ) {
-		dDir = 360 + dDir;
-	}
-
-	QHashIterator<int, tyWindBoatSpeed> iterHash(qhWindBoatCard);
-	while (iterHash.hasNext())
-	{
-		iterHash.next();
-		iKeyTmp =iterHash.key();
-		if( dDir < iterHash.key() )
-			break;
-	}
-	return iKeyTmp;
-}
-//------------------------------------------------------------------
 // get boat speed by true wind parameters for given boat parameters
 double BoatSpeed::getBoatSpeed( double dTWindDir, double dTWindSpeed, double dBoatDir ) {
-	tyWindBoatSpeed ptLastMin={0,0};
-	tyWindBoatSpeed ptMin={0,0};
-	double dDiffSpeed, dBoatSpeed=0;
-	double dDiffSpeedMin = 0xFFFFFFFF;
-		
-	// retrieve quantizied wind direction
-	int iWindStep = getDegSteps( dTWindDir, dBoatDir );
-//	DBG("BoatSpeedParams (WD/BD/WStep/WS): %f %f %f %i", dTWindDir, dBoatDir, iWindStep, dTWindSpeed );
-	if( qhWindBoatCard.contains( iWindStep )) {
-		
-		// get closest bases for interpolation
-		QList<tyWindBoatSpeed> qlWindSpeeds = qhWindBoatCard.values( iWindStep );
-		QList<tyWindBoatSpeed>::iterator iter;
-		for( iter=qlWindSpeeds.begin(); iter!=qlWindSpeeds.end(); iter++ ) {
-			dDiffSpeed = getWindKnots(dTWindSpeed)  - (iter->dWindSpeed);			
-			if (dDiffSpeed < 0) {
-				dDiffSpeed *= -1;
-			}
-			// find record for given wind speed
-//	DBG("Interpolation WSpeed: %f %f %f", dTWindSpeed, iter->dWindSpeed, dDiffSpeed );
-			if( dDiffSpeedMin > dDiffSpeed ) {
-				dDiffSpeedMin = dDiffSpeed;
-				// set closest bases
-				ptLastMin.dWindSpeed = ptMin.dWindSpeed;
-				ptMin.dWindSpeed = iter->dWindSpeed;
-				ptLastMin.dBoatSpeed = ptMin.dBoatSpeed;
-				ptMin.dBoatSpeed = iter->dBoatSpeed;
-			}
-			else
-			{
-				break;
-			}
-		}
-		// to be implemented: check if direction was calculated in previous step
-		// then just return member fBoatSpeed of last evaluation
-//	DBG("Boat ptMin(W/B) ptLastMin(W/B): %f %f %f %f %f", dTWindSpeed ,ptMin.dBoatSpeed, ptMin.dWindSpeed, ptLastMin.dBoatSpeed, ptLastMin.dWindSpeed );
-		dBoatSpeed = getInterpolatedSpeed( getWindKnots(dTWindSpeed) , ptMin, ptLastMin );		
-	} else {
-		dBoatSpeed = 0.;
+	if( vPolar.isEmpty() )
+		return 0.;
+	return getPolarSpeed( dTWindDir - dBoatDir, getWindKnots(dTWindSpeed) );
+}
+//------------------------------------------------------------------
+// get boat speeds for an array of wind vectors
+void BoatSpeed::getBoatSpeeds( int nb, const double *tabTWindDir,
+							   const double *tabTWindSpeed,
+							   const double *tabBoatDir,
+							   double *tabBoatSpeed )
+{
+	if( vPolar.isEmpty() ) {
+		for( int i=0; i < nb; i++ )
+			tabBoatSpeed[i] = 0.;
+		return;
+	}
+	double dKnots = 3.6 / ZY_MILE;
+	for( int i=0; i < nb; i++ ) {
+		tabBoatSpeed[i] = getPolarSpeed( tabTWindDir[i] - tabBoatDir[i],
+										 dKnots * tabTWindSpeed[i] );
 	}
-	return dBoatSpeed;
 }
 //------------------------------------------------------------------
 // get apparent wind speed by true wind parameters for given boat parameters
@@ -99,17 +60,82 @@ double BoatSpeed::getBoatSpeed( double dTWindDir, double dTWindSpeed, double dBo
 // get apparent wind direction by true wind parameters for given boat parameters
 //float BoatSpeed::getAppWindDir( float fBoatDir, float fTWindDir, float fTWindSpeed ) {
 //}
-//------------------------------------------------------------------
-// get interpolattion of boat speed
-// currently linear interpolation is implemented
-double BoatSpeed::getInterpolatedSpeed( double dWindSpeed, tyWindBoatSpeed ptFst, tyWindBoatSpeed ptLast )
+
+//---------------------------------------------------------------------
+// linear interpolation in a sorted list of abscissas
+// returns index i0 and weight of i0+1 (values outside are clamped)
+//---------------------------------------------------------------------
+static void findBracket( const QList<double> &lsX, double x, int &i0, double &dWeight )
+{
+	int n = lsX.size();
+	if( n < 2 || x <= lsX.at(0) ) {
+		i0 = 0;
+		dWeight = 0;
+		return;
+	}
+	if( x >= lsX.at(n-1) ) {
+		i0 = n-2;
+		dWeight = 1;
+		return;
+	}
+	i0 = 0;
+	while( i0 < n-2 && x >= lsX.at(i0+1) )
+		i0 ++;
+	dWeight = (x - lsX.at(i0)) / (lsX.at(i0+1) - lsX.at(i0));
+}
+
+//---------------------------------------------------------------------
+// compile the polar read from file into the dense table.
+// The file is resampled on a POLAR_TWA_STEP x POLAR_TWS_STEP grid
+// (bilinear between its nodes): nodes lying on the grid are exact,
+// the others are smoothed over one cell. A null speed is assumed at
+// TWS=0 and at TWA=0 when the file doesn't give them.
+//---------------------------------------------------------------------
+void BoatSpeed::compilePolar( QList<double> &lsTWA, QList<double> &lsTWS,
+							  QList< QList<double> > &lsSpeeds )
 {
-	double dDelta, dOffset;
+	vPolar.clear();
+	iNbTWA = iNbTWS = 0;
+	if( lsTWA.isEmpty() || lsTWS.isEmpty() )
+		return;
 	
-	dDelta = (ptFst.dBoatSpeed - ptLast.dBoatSpeed) / (ptFst.dWindSpeed - ptLast.dWindSpeed);
-	dOffset = ptLast.dBoatSpeed - dDelta * ptLast.dWindSpeed;
+	if( lsTWS.at(0) > 0 ) {
+		lsTWS.prepend( 0 );
+		for( int i=0; i < lsSpeeds.size(); i++ )
+			lsSpeeds[i].prepend( 0 );
+	}
+	if( lsTWA.at(0) > 0 ) {
+		lsTWA.prepend( 0 );
+		QList<double> lsZero;
+		for( int j=0; j < lsTWS.size(); j++ )
+			lsZero.append( 0 );
+		lsSpeeds.prepend( lsZero );
+	}
+	dMaxTWS = lsTWS.last();
+	iNbTWA = (int) ceil( 180.0 / POLAR_TWA_STEP ) + 1;
+	iNbTWS = (int) ceil( dMaxTWS / POLAR_TWS_STEP ) + 1;
+	if( iNbTWS < 2 )
+		iNbTWS = 2;
+	vPolar.resize( iNbTWA * iNbTWS );
 	
-	return (dDelta * dWindSpeed + dOffset);
+	double *p = vPolar.data();
+	for( int a=0; a < iNbTWA; a++ ) {
+		int ia;
+		double da;
+		findBracket( lsTWA, a*POLAR_TWA_STEP, ia, da );
+		int ia1 = (lsTWA.size() > 1) ? ia+1 : ia;
+		const QList<double> &row0 = lsSpeeds.at(ia);
+		const QList<double> &row1 = lsSpeeds.at(ia1);
+		for( int w=0; w < iNbTWS; w++ ) {
+			int iw;
+			double dw;
+			findBracket( lsTWS, w*POLAR_TWS_STEP, iw, dw );
+			int iw1 = (lsTWS.size() > 1) ? iw+1 : iw;
+			double v0 = row0.at(iw) + (row0.at(iw1) - row0.at(iw))*dw;
+			double v1 = row1.at(iw) + (row1.at(iw1) - row1.at(iw))*dw;
+			*p++ = v0 + (v1-v0)*da;
+		}
+	}
 }
 
 //---------------------------------------------------------------------
@@ -119,40 +145,77 @@ void BoatSpeed::loadBoatParams( QString fileName )
 {
 	char *myLine;
     long lLineMax = 10000000;
+	
+	if( ! QFile::exists(fileName) )
+		return;
+	ZUFILE *flBoatParams = zu_open( qPrintable(fileName), "r" );
+	if( flBoatParams == NULL )
+		return;
+	
     myLine = new char[lLineMax];
+	long lSize = zu_read( flBoatParams, myLine, lLineMax );
+	zu_close( flBoatParams );
 	
-
-	if( QFile::exists(fileName) )
+	QByteArray barr( myLine, lSize );
+	delete [] myLine;
+	QList<QByteArray> blist = barr.split('\n');
+	
+	// first line holds true wind speeds (sorted, a repeated speed
+	// keeps its first column)
+	QList<QByteArray> baWind = blist.at(0).split(';');
+	QMap<double,int> mapColumns;
+	for( int j=1; j < baWind.size(); j++ ) {
+		bool ok;
+		double dTWS = baWind.at(j).trimmed().toDouble( &ok );
+		if( !ok )
+			break;
+		if( mapColumns.contains(dTWS) )
+			fprintf( stderr, "%s: TWS %g repeated, column %d ignored\n",
+					 qPrintable(fileName), dTWS, j );
+		else
+			mapColumns.insert( dTWS, j );
+	}
+	QList<double> lsTWS = mapColumns.keys();
+	QList<int> lsColumns = mapColumns.values();
+	
+	// get boat speed at true wind directions (sorted by angle).
+	// Angles over 180 are mirrored, unless their symmetric is given.
+	QMap< double, QList<double> > mapRows;
+	QMap< double, QList<double> > mapMirroredRows;
+	for (int i=1; i < blist.size(); i++)
 	{
-		ZUFILE *flBoatParams = zu_open( qPrintable(fileName), "r" );
-		
-		if( flBoatParams != NULL ) {
-			long lSize = zu_read( flBoatParams, myLine, lLineMax );
-					
-			QByteArray barr( myLine, lSize );
-			QList<QByteArray> blist = barr.split('\n');
-			QByteArray bline = blist.at(0);
-			
-			// first line holds true wind speeds			
-			QList<QByteArray> baWind = bline.split(';');
-
-			// get boat speed at true wind directions
-			for (int i=1; i < blist.size(); i++)
-			{
-				bline = blist.at(i);
-				QList<QByteArray> baBoatSpeed = bline.split(';');
-				
-				for( int j=1; j < baBoatSpeed.size(); j++ ) {
-					tyWindBoatSpeed myStruct;
-					myStruct.dWindSpeed = baWind.at(j).toDouble();
-					myStruct.dBoatSpeed = baBoatSpeed.at(j).toDouble();
-					qhWindBoatCard.insertMulti( baBoatSpeed.at(0).toUInt(), myStruct );
-				}
-			}
+		QList<QByteArray> baBoatSpeed = blist.at(i).split(';');
+		bool ok;
+		double dTWA = baBoatSpeed.at(0).trimmed().toDouble( &ok );
+		if( !ok || baBoatSpeed.size() < 2 )
+			continue;
+		if( dTWA < 0 || dTWA > 360 ) {
+			fprintf( stderr, "%s: line %d: TWA %g out of range, ignored\n",
+					 qPrintable(fileName), i+1, dTWA );
+			continue;
+		}
+		QList<double> lsRow;
+		for( int j=0; j < lsColumns.size(); j++ ) {
+			int col = lsColumns.at(j);
+			double dBS = 0;
+			if( col < baBoatSpeed.size() )
+				dBS = baBoatSpeed.at(col).trimmed().toDouble();
+			lsRow.append( dBS );
 		}
-		zu_close( flBoatParams );
+		if( dTWA > 180 )
+			mapMirroredRows.insert( 360-dTWA, lsRow );
+		else
+			mapRows.insert( dTWA, lsRow );
 	}
-	delete myLine;
+	QMap< double, QList<double> >::const_iterator it;
+	for( it=mapMirroredRows.constBegin(); it!=mapMirroredRows.constEnd(); it++ ) {
+		if( ! mapRows.contains(it.key()) )
+			mapRows.insert( it.key(), it.value() );
+	}
+	
+	QList<double> lsTWA = mapRows.keys();
+	QList< QList<double> > lsSpeeds = mapRows.values();
+	compilePolar( lsTWA, lsTWS, lsSpeeds );
 }
 
 //----------------------------------------------------------------------------
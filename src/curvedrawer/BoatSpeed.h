@@ -14,17 +14,22 @@
 #define ZY_MILE		1.852
 #endif
 
+// resolution of the compiled polar table
+#define	POLAR_TWA_STEP	1.0		// degrees
+#define	POLAR_TWS_STEP	0.5		// knots
+
 //#include "CurveDrawer.h"
 
+#include <cmath>
 #include <QObject>
-#include <QHash>
 #include <QList>
-
-struct tyWindBoatSpeed {
-	double dWindSpeed;
-	double dBoatSpeed;
-};
+#include <QVector>
 
+//----------------------------------------------------------------------
+// Boat polar.
+// The polar file (first line: true wind speeds in knots, then one line
+// per true wind angle) is compiled on load into a dense, regularly
+// spaced table (TWA 0..180 x TWS 0..max) read by bilinear interpolation.
 //----------------------------------------------------------------------
 class BoatSpeed
 {	
@@ -32,20 +37,62 @@ class BoatSpeed
 		BoatSpeed( QString );
 //		~BoatSpeed();
 	
+		// wind speed in m/s, directions in degrees, result in knots
 		double getBoatSpeed( double, double, double );
+		
+		// batch query: boat speeds for nb wind vectors
+		void   getBoatSpeeds( int nb, const double *tabTWindDir,
+							  const double *tabTWindSpeed,
+							  const double *tabBoatDir,
+							  double *tabBoatSpeed );
+		
+		bool   isOk()  { return !vPolar.isEmpty(); }
 //		float getAppWindSpeed( float fBoatDir, float fTWindDir, float fTWindDir );
 //		float getAppWindDir( float fBoatDir, float fTWindDir, float fTWindDir );
 
 	private :
 	
-	QHash<int, tyWindBoatSpeed> qhWindBoatCard;
+	QVector<double> vPolar;		// iNbTWA rows of iNbTWS values
+	int    iNbTWA, iNbTWS;
+	double dMaxTWS;
 	
-	int getDegSteps( double, double );
-	double getInterpolatedSpeed( double, tyWindBoatSpeed, tyWindBoatSpeed );
 	void loadBoatParams( QString );
+	void compilePolar( QList<double> &lsTWA, QList<double> &lsTWS,
+					   QList< QList<double> > &lsSpeeds );
+	double getPolarSpeed( double dTWA, double dTWSKnots );
 	double getWindKnots( double & );
 	
 };
 
+//----------------------------------------------------------------------
+// bilinear interpolation in the compiled table
+//----------------------------------------------------------------------
+inline double BoatSpeed::getPolarSpeed( double dTWA, double dTWSKnots )
+{
+	// symmetric angle folding: TWA in [0,180]
+	dTWA = dTWA - 360.0*floor(dTWA/360.0);
+	if( dTWA > 180.0 )
+		dTWA = 360.0 - dTWA;
+	
+	if( dTWSKnots < 0 )
+		dTWSKnots = 0;
+	else if( dTWSKnots > dMaxTWS )
+		dTWSKnots = dMaxTWS;
+	
+	double da = dTWA / POLAR_TWA_STEP;
+	double dw = dTWSKnots / POLAR_TWS_STEP;
+	int ia = (int) da;
+	int iw = (int) dw;
+	if( ia >= iNbTWA-1 )  ia = iNbTWA-2;
+	if( iw >= iNbTWS-1 )  iw = iNbTWS-2;
+	da -= ia;
+	dw -= iw;
+	
+	const double *p = vPolar.constData() + ia*iNbTWS + iw;
+	double v0 = p[0]      + (p[1]       -p[0]     )*dw;
+	double v1 = p[iNbTWS] + (p[iNbTWS+1]-p[iNbTWS])*dw;
+	return v0 + (v1-v0)*da;
+}
+
 #endif
 
@@ -0,0 +1,229 @@
+/*
+ *  checkPolar.cpp
+ *  zyGrib
+ *
+ *  Accuracy and speed check of the compiled polar table (BoatSpeed)
+ *  against the former QMultiHash lookup.
+ *
+ *  Usage: checkPolar [polarfile]
+ *  Without argument a sample polar is written in the temp directory.
+ *  Returns 0 when every point is within POLAR_TOLERANCE.
+ *
+ */
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include "BoatSpeed.h"
+
+// max error allowed (knots). Resampling on the 0.5 kn grid only moves
+// the file nodes lying off the grid, by less than this for real polars.
+#define	POLAR_TOLERANCE	0.05
+
+#define	KNOTS_TO_MS		(ZY_MILE / 3.6)
+
+//------------------------------------------------------------------
+// Former lookup: file rows kept in a QMultiHash indexed by angle.
+// Speeds are interpolated between the two file wind speeds around
+// TWS (the former nearest-pair search could pick a one-sided pair
+// and extrapolate, which is not worth reproducing).
+// Only valid at the angles of the file and inside its TWS range.
+//------------------------------------------------------------------
+struct tyWindBoatSpeed {
+	double dWindSpeed;
+	double dBoatSpeed;
+};
+
+static bool lessWind( const tyWindBoatSpeed &a, const tyWindBoatSpeed &b )
+{
+	return a.dWindSpeed < b.dWindSpeed;
+}
+
+class OldBoatSpeed
+{
+	public :
+		OldBoatSpeed( QString fileName );
+
+		// iTWA: angle of the file, dTWS in knots
+		double getBoatSpeed( int iTWA, double dTWS );
+
+		QList<int>    lsTWA;
+		QList<double> lsTWS;
+
+	private :
+		QMultiHash<int, tyWindBoatSpeed> qhWindBoatCard;
+};
+
+//------------------------------------------------------------------
+OldBoatSpeed::OldBoatSpeed( QString fileName )
+{
+	QFile file( fileName );
+	if( ! file.open(QIODevice::ReadOnly) )
+		return;
+	QList<QByteArray> blist = file.readAll().split('\n');
+	QList<QByteArray> baWind = blist.at(0).split(';');
+	for( int j=1; j < baWind.size(); j++ )
+		lsTWS.append( baWind.at(j).trimmed().toDouble() );
+
+	for (int i=1; i < blist.size(); i++)
+	{
+		QList<QByteArray> baBoatSpeed = blist.at(i).split(';');
+		if( baBoatSpeed.size() < 2 )
+			continue;
+		int iTWA = baBoatSpeed.at(0).trimmed().toUInt();
+		lsTWA.append( iTWA );
+		for( int j=1; j < baBoatSpeed.size() && j <= lsTWS.size(); j++ ) {
+			tyWindBoatSpeed myStruct;
+			myStruct.dWindSpeed = lsTWS.at(j-1);
+			myStruct.dBoatSpeed = baBoatSpeed.at(j).trimmed().toDouble();
+			qhWindBoatCard.insert( iTWA, myStruct );
+		}
+	}
+}
+
+//------------------------------------------------------------------
+double OldBoatSpeed::getBoatSpeed( int iTWA, double dTWS )
+{
+	QList<tyWindBoatSpeed> qlWindSpeeds = qhWindBoatCard.values( iTWA );
+	if( qlWindSpeeds.size() < 2 )
+		return 0.;
+	std::sort( qlWindSpeeds.begin(), qlWindSpeeds.end(), lessWind );
+	int i = 0;
+	while( i < qlWindSpeeds.size()-2 && dTWS > qlWindSpeeds.at(i+1).dWindSpeed )
+		i ++;
+	const tyWindBoatSpeed &p0 = qlWindSpeeds.at(i);
+	const tyWindBoatSpeed &p1 = qlWindSpeeds.at(i+1);
+	return p0.dBoatSpeed + (p1.dBoatSpeed - p0.dBoatSpeed)
+				* (dTWS - p0.dWindSpeed) / (p1.dWindSpeed - p0.dWindSpeed);
+}
+
+//------------------------------------------------------------------
+// Sample polar: integer angles, one wind speed (5.2 kn) off the grid.
+//------------------------------------------------------------------
+static QString writeSamplePolar()
+{
+	QString fileName = QDir::temp().filePath( "checkPolar_sample.pol" );
+	QFile file( fileName );
+	if( ! file.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+		return "";
+	file.write(
+		"TWA\\TWS;5.2;6;8;10;12;14;16;20;25\n"
+		"32;1.9;2.3;3.1;3.7;4.0;4.2;4.3;4.4;4.4\n"
+		"40;3.1;3.6;4.6;5.3;5.7;5.9;6.0;6.1;6.1\n"
+		"52;4.1;4.7;5.7;6.3;6.7;6.9;7.0;7.1;7.1\n"
+		"60;4.4;5.0;6.0;6.6;7.0;7.2;7.3;7.4;7.5\n"
+		"75;4.7;5.3;6.3;6.9;7.3;7.6;7.8;8.0;8.1\n"
+		"90;4.8;5.4;6.5;7.1;7.5;7.8;8.1;8.4;8.6\n"
+		"110;4.6;5.3;6.4;7.1;7.6;8.0;8.4;8.9;9.3\n"
+		"120;4.4;5.1;6.2;6.9;7.5;8.0;8.4;9.1;9.7\n"
+		"135;3.9;4.6;5.7;6.5;7.2;7.7;8.2;9.2;10.1\n"
+		"150;3.3;3.9;5.0;5.9;6.6;7.2;7.7;8.8;10.0\n"
+		"165;2.9;3.5;4.5;5.4;6.1;6.8;7.3;8.3;9.4\n"
+		"180;2.7;3.2;4.2;5.1;5.9;6.5;7.1;8.0;9.0\n"
+	);
+	file.close();
+	return fileName;
+}
+
+//==================================================================
+int main( int argc, char **argv )
+{
+	QString fileName = (argc > 1) ? QString(argv[1]) : writeSamplePolar();
+
+	BoatSpeed    polar( fileName );
+	OldBoatSpeed oldPolar( fileName );
+	if( ! polar.isOk() || oldPolar.lsTWA.size() < 2 || oldPolar.lsTWS.size() < 2 ) {
+		fprintf( stderr, "can't read polar: %s\n", qPrintable(fileName) );
+		return 2;
+	}
+	QList<int>    &lsTWA = oldPolar.lsTWA;
+	QList<double> &lsTWS = oldPolar.lsTWS;
+	double dMinTWS = lsTWS.first();
+	double dMaxTWS = lsTWS.last();
+
+	// every equivalent form of the angle must give the same speed
+	const double tabBoatDir[] = { 0, 97.5, 263 };
+	const int    tabTurns[]   = { 0, 360, -360, 720 };
+
+	double dMaxErr = 0, dErrTWA = 0, dErrTWS = 0;
+	long   nbPoints = 0, nbBad = 0;
+
+	// file angles: compared to the former lookup
+	for( int a=0; a < lsTWA.size(); a++ ) {
+		int iTWA = lsTWA.at(a);
+		for( double tws=dMinTWS; tws <= dMaxTWS+1e-9; tws += 0.1 )
+		{
+			double dRef = oldPolar.getBoatSpeed( iTWA, tws );
+			for( int s=-1; s <= 1; s+=2 )
+			for( unsigned int t=0; t < sizeof(tabTurns)/sizeof(int); t++ )
+			for( unsigned int b=0; b < sizeof(tabBoatDir)/sizeof(double); b++ )
+			{
+				double bd  = tabBoatDir[b];
+				double twd = bd + s*iTWA + tabTurns[t];
+				double v = polar.getBoatSpeed( twd, tws*KNOTS_TO_MS, bd );
+				double err = fabs( v - dRef );
+				nbPoints ++;
+				if( err > dMaxErr ) {
+					dMaxErr = err;
+					dErrTWA = s*iTWA + tabTurns[t];
+					dErrTWS = tws;
+				}
+				if( err > POLAR_TOLERANCE )
+					nbBad ++;
+			}
+		}
+	}
+	// between file angles: bounded by the two surrounding rows
+	long nbBetween = 0, nbBadBetween = 0;
+	for( int a=0; a+1 < lsTWA.size(); a++ ) {
+		int a0 = lsTWA.at(a);
+		int a1 = lsTWA.at(a+1);
+		for( double twa=a0+0.25; twa < a1; twa += 0.5 )
+		for( double tws=dMinTWS; tws <= dMaxTWS+1e-9; tws += 0.1 )
+		{
+			double r0 = oldPolar.getBoatSpeed( a0, tws );
+			double r1 = oldPolar.getBoatSpeed( a1, tws );
+			double v  = polar.getBoatSpeed( -twa, tws*KNOTS_TO_MS, 0 );
+			nbBetween ++;
+			if( v < std::min(r0,r1) - POLAR_TOLERANCE
+					|| v > std::max(r0,r1) + POLAR_TOLERANCE )
+				nbBadBetween ++;
+		}
+	}
+	printf( "polar: %s\n", qPrintable(fileName) );
+	printf( "tolerance: %g kn\n", (double)POLAR_TOLERANCE );
+	printf( "file angles:    %ld points, max error %.4f kn (TWA %g, TWS %g), %ld out of tolerance\n",
+			nbPoints, dMaxErr, dErrTWA, dErrTWS, nbBad );
+	printf( "between angles: %ld points, %ld out of bounds\n",
+			nbBetween, nbBadBetween );
+
+	// speed: same queries through both lookups
+	const int nbRuns = 2000000;
+	QElapsedTimer timer;
+	double dSum = 0;
+	timer.start();
+	for( int i=0; i < nbRuns; i++ ) {
+		int iTWA = lsTWA.at( i % lsTWA.size() );
+		double tws = dMinTWS + (dMaxTWS-dMinTWS) * (i%1000) / 1000.0;
+		dSum += oldPolar.getBoatSpeed( iTWA, tws );
+	}
+	qint64 tOld = timer.nsecsElapsed();
+	timer.restart();
+	for( int i=0; i < nbRuns; i++ ) {
+		int iTWA = lsTWA.at( i % lsTWA.size() );
+		double tws = dMinTWS + (dMaxTWS-dMinTWS) * (i%1000) / 1000.0;
+		dSum += polar.getBoatSpeed( iTWA, tws*KNOTS_TO_MS, 0 );
+	}
+	qint64 tNew = timer.nsecsElapsed();
+	printf( "speed: QMultiHash %.1f ns/query, table %.1f ns/query (%g)\n",
+			(double)tOld/nbRuns, (double)tNew/nbRuns, dSum );
+
+	return (nbBad == 0 && nbBadBetween == 0) ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+# Accuracy and speed check of the compiled boat polar.
+#   qmake checkPolar.pro && make && ./checkPolar [polarfile]
+
+CONFIG += qt console release c++11
+CONFIG -= app_bundle
+QT -= gui
+
+TEMPLATE = app
+TARGET   = checkPolar
+
+INCLUDEPATH += .. ../../util
+
+LIBS += -lbz2 -lz
+
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+OBJECTS_DIR = objs
+
+SOURCES += checkPolar.cpp \
+           ../BoatSpeed.cpp \
+           ../../util/zuFile.cpp
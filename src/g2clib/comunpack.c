@@ -20,6 +20,8 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
 // 2004-12-16  Gilbert  -  Added test ( provided by Arthur Taylor/MDL )
 //                         to verify that group widths and lengths are
 //                         consistent with section length.
+//             zyGrib   -  Bulk extraction with gbitsn, single pass
+//                         sums for spatial differencing.
 //
 // USAGE:    int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,
 //                         g2int *idrstmpl, g2int ndpts,g2float *fld)
@@ -54,6 +56,7 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
       g2int  msng1,msng2;
       g2float ref,bscale,dscale,rmiss1,rmiss2;
       g2int totBit, totLen;
+      g2int  prev1,prev2,v;
 
       //printf('IDRSTMPL: ',(idrstmpl(j),j=1,16)
       rdieee(idrstmpl+0,&ref,1);
@@ -144,7 +147,7 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
 //
       //printf("SAG1: %ld %ld %ld \n",nbitsgref,ngroups,iofst);
       if (nbitsgref != 0) {
-         gbits(cpack,gref+0,iofst,nbitsgref,0,ngroups);
+         gbitsn(cpack,gref+0,iofst,nbitsgref,ngroups);
          itemp=nbitsgref*ngroups;
          iofst=iofst+itemp;
          if (itemp%8 != 0) iofst=iofst+(8-(itemp%8));
@@ -158,7 +161,7 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
 //
       //printf("SAG2: %ld %ld %ld %ld \n",nbitsgwidth,ngroups,iofst,idrstmpl[10]);
       if (nbitsgwidth != 0) {
-         gbits(cpack,gwidth+0,iofst,nbitsgwidth,0,ngroups);
+         gbitsn(cpack,gwidth+0,iofst,nbitsgwidth,ngroups);
          itemp=nbitsgwidth*ngroups;
          iofst=iofst+itemp;
          if (itemp%8 != 0) iofst=iofst+(8-(itemp%8));
@@ -178,7 +181,7 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
       //printf("ALLOC glen: %d %x\n",(int)ngroups,glen);
       //printf("SAG3: %ld %ld %ld %ld %ld \n",nbitsglen,ngroups,iofst,idrstmpl[13],idrstmpl[12]);
       if (nbitsglen != 0) {
-         gbits(cpack,glen,iofst,nbitsglen,0,ngroups);
+         gbitsn(cpack,glen,iofst,nbitsglen,ngroups);
          itemp=nbitsglen*ngroups;
          iofst=iofst+itemp;
          if (itemp%8 != 0) iofst=iofst+(8-(itemp%8));
@@ -200,10 +203,11 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
         totBit += (gwidth[j]*glen[j]);
         totLen += glen[j];
       }
-      if (totLen != ndpts) {
-        return 1;
-      }
-      if (totBit / 8. > lensec) {
+      if (totLen != ndpts || totBit / 8. > lensec) {
+        free(ifld);
+        free(gref);
+        free(gwidth);
+        free(glen);
         return 1;
       }
 //
@@ -213,9 +217,10 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
          n=0;
          for (j=0;j<ngroups;j++) {
            if (gwidth[j] != 0) {
-             gbits(cpack,ifld+n,iofst,gwidth[j],0,glen[j]);
+             gbitsn(cpack,ifld+n,iofst,gwidth[j],glen[j]);
+             itemp=gref[j];
              for (k=0;k<glen[j];k++) {
-               ifld[n]=ifld[n]+gref[j];
+               ifld[n]=ifld[n]+itemp;
                n=n+1;
              }
            }
@@ -236,9 +241,9 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
          for (j=0;j<ngroups;j++) {
            //printf(" SAGNGP %d %d %d %d\n",j,gwidth[j],glen[j],gref[j]);
            if (gwidth[j] != 0) {
-             msng1=(g2int)int_power(2.0,gwidth[j])-1;
+             msng1=((g2int)1<<gwidth[j])-1;
              msng2=msng1-1;
-             gbits(cpack,ifld+n,iofst,gwidth[j],0,glen[j]);
+             gbitsn(cpack,ifld+n,iofst,gwidth[j],glen[j]);
              iofst=iofst+(gwidth[j]*glen[j]);
              for (k=0;k<glen[j];k++) {
                if (ifld[n] == msng1) {
@@ -257,7 +262,7 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
              }
            }
            else {
-             msng1=(g2int)int_power(2.0,nbitsgref)-1;
+             msng1=((g2int)1<<nbitsgref)-1;
              msng2=msng1-1;
              if (gref[j] == msng1) {
                 for (l=n;l<n+glen[j];l++) ifldmiss[l]=1;
@@ -284,13 +289,15 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
 //
       //printf("SAGod: %ld %ld\n",idrsnum,idrstmpl[16]);
       if (idrsnum == 3) {         // spatial differencing
+         // running sums kept in registers (no reload of ifld[n-1])
          if (idrstmpl[16] == 1) {      // first order
             ifld[0]=ival1;
             if ( idrstmpl[6] == 0 ) itemp=ndpts;        // no missing values
             else  itemp=non;
+            prev1=ival1;
             for (n=1;n<itemp;n++) {
-               ifld[n]=ifld[n]+minsd;
-               ifld[n]=ifld[n]+ifld[n-1];
+               prev1 += ifld[n]+minsd;
+               ifld[n]=prev1;
             }
          }
          else if (idrstmpl[16] == 2) {    // second order
@@ -298,9 +305,13 @@ int comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,g2int *idrstmpl,g2
             ifld[1]=ival2;
             if ( idrstmpl[6] == 0 ) itemp=ndpts;        // no missing values
             else  itemp=non;
+            prev2=ival1;
+            prev1=ival2;
             for (n=2;n<itemp;n++) {
-               ifld[n]=ifld[n]+minsd;
-               ifld[n]=ifld[n]+(2*ifld[n-1])-ifld[n-2];
+               v = ifld[n]+minsd+(2*prev1)-prev2;
+               ifld[n]=v;
+               prev2=prev1;
+               prev1=v;
             }
          }
       }
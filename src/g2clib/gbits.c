@@ -61,6 +61,71 @@ void gbits(unsigned char *in,g2int *iout,g2int iskip,g2int nbyte,g2int nskip,
 }
 
 
+void gbitsn(unsigned char *in,g2int *iout,g2int iskip,g2int nbyte,g2int n)
+/*          Get bits - unpack n contiguous values (same result as
+/          gbits with nskip=0, faster for long runs).
+/           *in    = pointer to character array input
+/           *iout  = pointer to unpacked array output
+/            iskip = initial number of bits to skip
+/            nbyte = number of bits to take
+/            n     = number of values
+/          Byte aligned widths of 8, 16, 24 and 32 bits are copied by
+/          simple loops, other widths use a 64 bits accumulator filled
+/          one byte at a time (never reads beyond the last needed byte).
+*/
+{
+      g2int i;
+      unsigned char *p;
+      g2intu acc,mask;
+      g2int nacc;
+
+      if (n <= 0) return;
+      if (nbyte == 0) {
+         for (i=0;i<n;i++) iout[i]=0;
+         return;
+      }
+      if (nbyte > 56) {
+         gbits(in,iout,iskip,nbyte,(g2int)0,n);
+         return;
+      }
+
+      p = in + iskip/8;
+      if (iskip%8 == 0) {
+         switch (nbyte) {
+            case 8:
+               for (i=0;i<n;i++)
+                  iout[i] = p[i];
+               return;
+            case 16:
+               for (i=0;i<n;i++, p+=2)
+                  iout[i] = ((g2int)p[0]<<8) | p[1];
+               return;
+            case 24:
+               for (i=0;i<n;i++, p+=3)
+                  iout[i] = ((g2int)p[0]<<16) | ((g2int)p[1]<<8) | p[2];
+               return;
+            case 32:
+               for (i=0;i<n;i++, p+=4)
+                  iout[i] = ((g2int)p[0]<<24) | ((g2int)p[1]<<16)
+                          | ((g2int)p[2]<<8) | p[3];
+               return;
+         }
+      }
+
+      mask = ((g2intu)1 << nbyte) - 1;
+      nacc = 8 - iskip%8;
+      acc = *p++ & (((g2intu)1 << nacc) - 1);
+      for (i=0;i<n;i++) {
+         while (nacc < nbyte) {
+            acc = (acc << 8) | *p++;
+            nacc += 8;
+         }
+         nacc -= nbyte;
+         iout[i] = (g2int)((acc >> nacc) & mask);
+      }
+}
+
+
 void sbits(unsigned char *out,g2int *in,g2int iskip,g2int nbyte,g2int nskip,
            g2int n)
 /*C          Store bits - pack bits:  Put arbitrary size values into a
@@ -249,6 +249,7 @@ void misspack(g2float *,g2int ,g2int ,g2int *, unsigned char *, g2int *);
 void gbit(unsigned char *,g2int *,g2int ,g2int );
 void sbit(unsigned char *,g2int *,g2int ,g2int );
 void gbits(unsigned char *,g2int *,g2int ,g2int ,g2int ,g2int );
+void gbitsn(unsigned char *,g2int *,g2int ,g2int ,g2int );
 void sbits(unsigned char *,g2int *,g2int ,g2int ,g2int ,g2int );
 
 int pack_gp(g2int *, g2int *, g2int *,
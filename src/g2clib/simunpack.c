@@ -15,6 +15,7 @@ g2int simunpack(unsigned char *cpack,g2int *idrstmpl,g2int ndpts,g2float *fld)
 //
 // PROGRAM HISTORY LOG:
 // 2002-10-29  Gilbert
+//             zyGrib   -  Bulk extraction with gbitsn.
 //
 // USAGE:    int simunpack(unsigned char *cpack,g2int *idrstmpl,g2int ndpts,
 //                         g2float *fld)
@@ -60,7 +61,7 @@ g2int simunpack(unsigned char *cpack,g2int *idrstmpl,g2int ndpts,g2float *fld)
 //  is the data value at each gridpoint
 //
       if (nbits != 0) {
-         gbits(cpack,ifld,0,nbits,0,ndpts);
+         gbitsn(cpack,ifld,0,nbits,ndpts);
          for (j=0;j<ndpts;j++) {
            fld[j]=(((g2float)ifld[j]*bscale)+ref)*dscale;
          }
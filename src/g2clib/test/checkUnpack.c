@@ -0,0 +1,182 @@
+/*
+ *  checkUnpack.c
+ *  zyGrib
+ *
+ *  Check of the bulk bit extraction (gbitsn) and of simunpack() and
+ *  comunpack() against the former value by value code (oldunpack.c).
+ *
+ *  Usage: checkUnpack
+ *  Sample fields are packed with simpack, compack and misspack
+ *  (templates 5.0, 5.2, 5.3 order 1 and 2, with missing values),
+ *  then decoded by both paths: results must be identical.
+ *  Returns 0 when every check passes.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "grib2.h"
+
+g2int simunpack(unsigned char *cpack,g2int *idrstmpl,g2int ndpts,g2float *fld);
+int   comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,
+				g2int *idrstmpl,g2int ndpts,g2float *fld);
+g2int old_simunpack(unsigned char *cpack,g2int *idrstmpl,g2int ndpts,g2float *fld);
+int   old_comunpack(unsigned char *cpack,g2int lensec,g2int idrsnum,
+					g2int *idrstmpl,g2int ndpts,g2float *fld);
+
+#define NX  360
+#define NY  181
+#define NPTS  (NX*NY)
+#define MISSING  9.999e20
+
+static int nbBad = 0;
+
+//------------------------------------------------------------------
+static double elapsed (clock_t t0)
+{
+	return (double)(clock()-t0) / CLOCKS_PER_SEC;
+}
+
+//------------------------------------------------------------------
+// gbitsn must give the same values as gbits for every width and offset
+//------------------------------------------------------------------
+static void checkBits ()
+{
+	unsigned char buf[1024];
+	g2int v1[64], v2[64];
+	int i, nbyte, iskip, nbErr = 0;
+	srand (1);
+	for (i=0; i<(int)sizeof(buf); i++)
+		buf[i] = (unsigned char)(rand() & 255);
+	for (nbyte=0; nbyte<=60; nbyte++)
+		for (iskip=0; iskip<16; iskip++) {
+			gbits  (buf, v1, iskip, nbyte, 0, 64);
+			gbitsn (buf, v2, iskip, nbyte, 64);
+			if (memcmp (v1, v2, sizeof(v1)) != 0)
+				nbErr ++;
+		}
+	printf ("gbitsn: widths 0-60, offsets 0-15: %d differences\n", nbErr);
+	nbBad += nbErr;
+}
+
+//------------------------------------------------------------------
+// Sample field: smooth pressure-like pattern plus noise,
+// some points missing when withMissing is set.
+//------------------------------------------------------------------
+static void makeField (g2float *fld, int withMissing)
+{
+	int i, j;
+	srand (2);
+	for (j=0; j<NY; j++)
+		for (i=0; i<NX; i++) {
+			double v = 101300 + 1500*sin(i*0.05)*cos(j*0.08)
+						+ (rand()%200) - 100;
+			if (withMissing && (i+j)%17 == 0)
+				v = MISSING;
+			fld[j*NX+i] = (g2float)v;
+		}
+}
+
+//------------------------------------------------------------------
+static void compare (const char *name, g2float *fnew, g2float *fold,
+					 double tnew, double told)
+{
+	int j, nbErr = 0;
+	for (j=0; j<NPTS; j++)
+		if (memcmp (&fnew[j], &fold[j], sizeof(g2float)) != 0)
+			nbErr ++;
+	printf ("%-22s %6d differences   new %.2f ms   old %.2f ms\n",
+				name, nbErr, tnew*1000, told*1000);
+	nbBad += nbErr;
+}
+
+//------------------------------------------------------------------
+static void checkSimple (g2float *fld, g2float *fnew, g2float *fold)
+{
+	unsigned char *cpack = malloc (4*NPTS);
+	g2int idrstmpl[5] = {0, 0, 1, 0, 0};
+	g2int lcpack;
+	clock_t t0;
+	double tnew, told;
+	int k, nruns = 20;
+	makeField (fld, 0);
+	simpack (fld, NPTS, idrstmpl, cpack, &lcpack);
+	t0 = clock();
+	for (k=0; k<nruns; k++)
+		simunpack (cpack, idrstmpl, NPTS, fnew);
+	tnew = elapsed(t0)/nruns;
+	t0 = clock();
+	for (k=0; k<nruns; k++)
+		old_simunpack (cpack, idrstmpl, NPTS, fold);
+	told = elapsed(t0)/nruns;
+	compare ("template 5.0", fnew, fold, tnew, told);
+	free (cpack);
+}
+
+//------------------------------------------------------------------
+static void checkComplex (const char *name, g2float *fld, g2float *fnew,
+					g2float *fold, g2int idrsnum, g2int order, g2int missopt)
+{
+	unsigned char *cpack = malloc (4*NPTS);
+	g2int idrstmpl[18];
+	g2int lcpack;
+	g2float rmiss = MISSING;
+	clock_t t0;
+	double tnew, told;
+	int k, nruns = 20;
+
+	memset (idrstmpl, 0, sizeof(idrstmpl));
+	idrstmpl[2] = 1;			// decimal scale
+	idrstmpl[16] = order;		// spatial differencing order
+	makeField (fld, missopt != 0);
+	if (missopt != 0) {
+		idrstmpl[6] = missopt;
+		mkieee (&rmiss, idrstmpl+7, 1);
+		mkieee (&rmiss, idrstmpl+8, 1);
+		misspack (fld, NPTS, idrsnum, idrstmpl, cpack, &lcpack);
+	}
+	else {
+		compack (fld, NPTS, idrsnum, idrstmpl, cpack, &lcpack);
+	}
+	if (lcpack <= 0) {
+		printf ("%-22s packing failed\n", name);
+		nbBad ++;
+		free (cpack);
+		return;
+	}
+	t0 = clock();
+	for (k=0; k<nruns; k++)
+		comunpack (cpack, lcpack, idrsnum, idrstmpl, NPTS, fnew);
+	tnew = elapsed(t0)/nruns;
+	t0 = clock();
+	for (k=0; k<nruns; k++)
+		old_comunpack (cpack, lcpack, idrsnum, idrstmpl, NPTS, fold);
+	told = elapsed(t0)/nruns;
+	compare (name, fnew, fold, tnew, told);
+	free (cpack);
+}
+
+//==================================================================
+int main ()
+{
+	g2float *fld  = malloc (NPTS*sizeof(g2float));
+	g2float *fnew = malloc (NPTS*sizeof(g2float));
+	g2float *fold = malloc (NPTS*sizeof(g2float));
+
+	checkBits ();
+	checkSimple (fld, fnew, fold);
+	checkComplex ("template 5.2",         fld, fnew, fold, 2, 0, 0);
+	checkComplex ("template 5.3 order 1", fld, fnew, fold, 3, 1, 0);
+	checkComplex ("template 5.3 order 2", fld, fnew, fold, 3, 2, 0);
+	checkComplex ("5.2 missing values",   fld, fnew, fold, 2, 0, 1);
+	checkComplex ("5.3 missing values",   fld, fnew, fold, 3, 2, 2);
+
+	free (fld);
+	free (fnew);
+	free (fold);
+	printf ("%s\n", nbBad==0 ? "OK" : "FAILED");
+	return nbBad==0 ? 0 : 1;
+}
@@ -272,6 +272,7 @@ int main (int argc, char *argv[])
     // A. Degwerth [Cassidian] short modifications because the command line is parsed above
 	if (openLatestGribFile) {
 		QString filename = "";
+		QStringList datasetFiles;	// several files (or a pattern like *.grb)
 
 		if (cmdLineArgs.size() > 1) {
 			// find the last argument without "-"
@@ -282,8 +283,18 @@ int main (int argc, char *argv[])
 				if (! arg.startsWith("-"))
 				{
 					filename = arg;
+					if (arg.contains('*') || arg.contains('?'))
+						datasetFiles << Util::getMatchingFileNames (arg);
+					else if (QFile::exists(arg))
+						datasetFiles << arg;
 				}
 			}
+			if (datasetFiles.size() > 0) {
+				filename = datasetFiles[0];
+			}
+			if (datasetFiles.size() < 2) {
+				datasetFiles.clear ();
+			}
 			if(! QFile::exists(filename)) {
 				filename = "";
 			}
@@ -291,10 +302,23 @@ int main (int argc, char *argv[])
 		
 		if (filename == "") {
 			filename = Util::getSetting("gribFileName", "").toString();
+			// last dataset: its files still present
+			QStringList lastFiles = Util::getSetting("gribDatasetFiles",
+													 QStringList()).toStringList();
+			for (int i=0; i<lastFiles.size(); i++) {
+				if (QFile::exists(lastFiles[i]))
+					datasetFiles << lastFiles[i];
+			}
+			if (datasetFiles.size() > 0) {
+				filename = datasetFiles[0];
+			}
+			if (datasetFiles.size() < 2) {
+				datasetFiles.clear ();
+			}
 		}
 		if (QFile::exists(filename))
 		{
-			win->openMeteoDataFile (filename);
+			win->openMeteoDataFile (filename, NULL, NULL, datasetFiles);
 		}
 	}
     //====================================================
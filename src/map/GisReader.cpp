@@ -52,9 +52,14 @@ GisCity::GisCity (QString country, QString name, int pop, float lon, float lat)
 //==========================================================
 // GisReader
 //==========================================================
+static bool compareCities_sup(GisCity *a, GisCity *b)
+{
+	return a->population > b->population;
+}
+//-----------------------------------------------------------------------
 GisReader::GisReader()
 {
-    QString lang = Util::getSetting("appLanguage", "none").toString();
+    QString lang = Util::getSetting("appLanguage", "").toString();
     
     QString fname;
     bool ok1, ok2, ok3;
@@ -139,6 +144,8 @@ GisReader::GisReader()
 	}
 	
     delete [] buf;
+	// sort by population
+	std::stable_sort (lsCities.begin(), lsCities.end(), compareCities_sup);
 }
 
 //-----------------------------------------------------------------------
@@ -203,79 +210,50 @@ void GisCity::draw(QPainter *pnt, Projection *proj, int popmin)
     }
 }
 //-----------------------------------------------------------------------
-void GisCity::drawCityName (QPainter *pnt, QRect *rectName)
+void GisCity::drawCityName (QPainter *pnt, const QRect &rectName, int x0, int y0)
 {
-	// Warning: getRectName must be called first !!!
 	pnt->drawEllipse(x0-2,y0-2, 5,5);
-	pnt->drawText(*rectName, Qt::AlignCenter, name);
+	pnt->drawText(rectName, Qt::AlignCenter, name);
 }
 //-----------------------------------------------------------------------
-void GisCity::getRectName (QPainter *pnt, Projection *proj, QRect *rectName)
+QRect GisCity::getRectName (Projection *proj, LabelPlacer &placer, int *x0, int *y0)
 {
-	proj->map2screen(x, y, &x0, &y0);
-	QFont font = Font::getFont(fontCode);
-	pnt->setFont(font);
-	QRect prect = QFontMetrics(font).boundingRect(name);
-	int x1 = x0-prect.width()/2;
-	int y1 = y0-prect.height();
-	rectName->setX (x1);
-	rectName->setY (y1);
-	rectName->setWidth  (prect.width());
-	rectName->setHeight (prect.height());
+	proj->map2screen(x, y, x0, y0);
+	QSize sz = placer.textSize (Font::getFont(fontCode), name);
+	return QRect (*x0-sz.width()/2, *y0-sz.height(), sz.width(), sz.height());
 }
 //-----------------------------------------------------------------------
-bool compareCities_sup(GisCity *a, GisCity *b)
+void GisReader::placeCitiesNames (Projection *proj, int level, LabelPlacer &placer,
+								  std::vector <GisCityLabel> &labels)
 {
-	return a->population > b->population;
-}
-//-----------------------------------------------------------------------
-void GisReader::drawCitiesNames (QPainter &pnt, Projection *proj, int level)
-{
-    pnt.setPen(QColor(40,40,40));
-    pnt.setBrush(QColor(0,0,0));
-	
-    std::vector <GisCity*> lsVisibleCities;
+	labels.clear();
+	// lsCities is sorted by population : the biggest cities are placed first
 	std::vector <GisCity*>::iterator itp;
-
-	std::vector <QRect*> lsZonesOccupees;
-	std::vector <QRect*>::iterator itz;
-
 	for (itp=lsCities.begin(); itp != lsCities.end(); itp++) {
-		GisCity *p = *itp;
-		if (  (p->level <= level)
-			&&  proj->isPointVisible(p->x, p->y) ) 
+		GisCity *city = *itp;
+		if (  (city->level <= level)
+			&&  proj->isPointVisible(city->x, city->y) ) 
 		{
-			lsVisibleCities.push_back(p);
+			GisCityLabel lab;
+			lab.city = city;
+			lab.rect = city->getRectName (proj, placer, &lab.x0, &lab.y0);
+			if (placer.place (lab.rect))
+				labels.push_back (lab);
 		}
     }
-
-	// sort by population
-	//lsVisibleCities.sort (compareCities_sup);
-	std::sort (lsVisibleCities.begin(), lsVisibleCities.end(), compareCities_sup);
-
-	// draw if place is free
-	bool freePlace;
-    for (itp=lsVisibleCities.begin(); itp != lsVisibleCities.end(); itp++) {
-		GisCity *city = *itp;
-		QRect *rect = new QRect();
-		city->getRectName  (&pnt, proj, rect);
-		freePlace = true;
-		for (itz = lsZonesOccupees.begin(); 
-					freePlace && itz != lsZonesOccupees.end(); itz++) {
-			QRect *pr = *itz;
-			if (rect->intersects(*pr))
-				freePlace = false;
-		}
-		if (freePlace) {
-			city->drawCityName (&pnt, rect);
-			lsZonesOccupees.push_back(rect);
-		}
-		else {
-			delete rect;
+}
+//-----------------------------------------------------------------------
+void GisReader::drawCitiesNames (QPainter &pnt, const std::vector <GisCityLabel> &labels)
+{
+    pnt.setPen(QColor(40,40,40));
+    pnt.setBrush(QColor(0,0,0));
+	int fontCode = -1;
+	for (size_t i=0; i < labels.size(); i++) {
+		const GisCityLabel &lab = labels[i];
+		if (lab.city->fontCode != fontCode) {
+			fontCode = lab.city->fontCode;
+			pnt.setFont (Font::getFont(fontCode));
 		}
-    }	
-	
-	Util::cleanVectorPointers(lsZonesOccupees);
-	lsVisibleCities.clear();
+		lab.city->drawCityName (&pnt, lab.rect, lab.x0, lab.y0);
+	}
 }
-
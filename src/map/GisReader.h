@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Projection.h"
 #include "Util.h"
 #include "Font.h"
+#include "LabelPlacer.h"
 
 //==========================================================
 class GisPoint {
@@ -78,11 +79,15 @@ class GisCity : public GisPoint
 		}
 		
         void  draw (QPainter *pnt, Projection *proj, int level);
-        void  getRectName  (QPainter *pnt, Projection *proj, QRect *rectName);
-        void  drawCityName (QPainter *pnt, QRect *rectName);
-
-	private:
-	    int     x0, y0;   // for drawing
+        QRect getRectName  (Projection *proj, LabelPlacer &placer, int *x0, int *y0);
+        void  drawCityName (QPainter *pnt, const QRect &rectName, int x0, int y0);
+};
+//----------------------------------------------------------
+// City name chosen to be written on the map
+struct GisCityLabel {
+		GisCity *city;
+		QRect    rect;
+		int      x0, y0;	// position of the city on the screen
 };
 
 //==========================================================
@@ -93,11 +98,14 @@ class GisReader
         ~GisReader();
         
         void drawCountriesNames (QPainter &pnt, Projection *proj);
-        void drawCitiesNames (QPainter &pnt, Projection *proj, int level);
+        // Choose the cities names, by decreasing population, and reserve their place
+        void placeCitiesNames (Projection *proj, int level, LabelPlacer &placer,
+							   std::vector <GisCityLabel> &labels);
+        void drawCitiesNames  (QPainter &pnt, const std::vector <GisCityLabel> &labels);
     
     private:
         std::vector <GisPoint*> lsCountries;
-        std::vector <GisCity*>  lsCities;
+        std::vector <GisCity*>  lsCities;	// sorted by decreasing population
         
         void clearLists();
 };
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include "GshhsRangsReader.h"
+#include "RenderBuffer.h"
 
 //------------------------------------------------------------------------
 GshhsRangsCell::GshhsRangsCell(FILE *fcat_, FILE *fcel_, FILE *frim_, int x0_, int y0_)
@@ -361,10 +362,7 @@ void GshhsRangsReader::drawGshhsRangsMapPlain( QPainter &pnt, Projection *proj,
     if (!fcat || !fcel || !frim)
         return;
         
-    QPoint *pts;
-    uint ptsSize = 1000;		// Resolution Max => 9145 pts max
-    pts = new QPoint[ptsSize];
-    assert(pts);
+    QPoint *pts = RenderBuffer::getPoints (ptsBuffer, 1000);	// Resolution Max => 9145 pts max
     
     int cxmin, cxmax, cymax, cymin;  // cellules visibles
     cxmin = (int) floor (proj->getXmin());
@@ -393,19 +391,13 @@ void GshhsRangsReader::drawGshhsRangsMapPlain( QPainter &pnt, Projection *proj,
 				else {
 					cel = allCells[cxx][cy+90];
 				}
-                if (ptsSize <= cel->getPoligonSizeMax()) {
-    				delete [] pts;
-                	ptsSize = cel->getPoligonSizeMax()+1000;
-					pts = new QPoint[ptsSize];
-					assert(pts);
-                }
+                if (ptsBuffer.size() <= (size_t) cel->getPoligonSizeMax())
+					pts = RenderBuffer::getPoints (ptsBuffer, cel->getPoligonSizeMax()+1000);
                 dx = cx-cxx;
                 cel -> drawMapPlain(pnt, dx, pts, proj, seaColor, landColor);
             }
         }
     }
-
-    delete [] pts;
 }
 
 //-------------------------------------------------------------------------
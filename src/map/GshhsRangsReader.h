@@ -117,6 +117,7 @@ class GshhsRangsReader
         std::string path;
         FILE *fcat, *fcel, *frim;
         GshhsRangsCell * allCells[360][180];
+        std::vector <QPoint> ptsBuffer;	// screen points, kept between redraws
 };
 
 
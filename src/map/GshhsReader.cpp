@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include "GshhsReader.h"
+#include "RenderBuffer.h"
 
 //==========================================================
 // GshhsPolygon  (compatible avec le format .rim de RANGS)
@@ -420,18 +421,9 @@ void GshhsReader::GsshDrawPolygons(QPainter &pnt, std::vector <GshhsPolygon*> &l
     int i;
     int nbp;
     
-    int nbmax = 10000;
-    pts = new QPoint[nbmax];
-    assert(pts);
-    
     for  (i=0, iter=lst.begin(); iter!=lst.end(); iter++,i++) {
         pol = *iter;
-        
-        if (nbmax < pol->n+2) {
-            nbmax = pol->n+2;
-            pts = new QPoint[nbmax];
-            assert(pts);
-        }
+        pts = RenderBuffer::getPoints (ptsBuffer, pol->n+2);
         
         nbp = GSHHS_scaledPoints(pol, pts, 0, proj);
         if (nbp > 3)
@@ -441,8 +433,6 @@ void GshhsReader::GsshDrawPolygons(QPainter &pnt, std::vector <GshhsPolygon*> &l
         if (nbp > 3)
             pnt.drawPolygon(pts, nbp);
     }
-
-    delete [] pts;
 }
 
 //-----------------------------------------------------------------------
@@ -456,18 +446,9 @@ void GshhsReader::GsshDrawLines(QPainter &pnt, std::vector <GshhsPolygon*> &lst,
     int i;
     int nbp;
     
-    int nbmax = 10000;
-    pts = new QPoint[nbmax];
-    assert(pts);
-    
     for  (i=0, iter=lst.begin(); iter!=lst.end(); iter++,i++) {
         pol = *iter;
-        
-        if (nbmax < pol->n+2) {
-            nbmax = pol->n+2;
-            pts = new QPoint[nbmax];
-            assert(pts);
-        }
+        pts = RenderBuffer::getPoints (ptsBuffer, pol->n+2);
         
 		
 		//--------------------------------------------------------------
@@ -506,7 +487,6 @@ void GshhsReader::GsshDrawLines(QPainter &pnt, std::vector <GshhsPolygon*> &lst,
 			}
 		}
     }
-    delete [] pts;
 }
 
 //-----------------------------------------------------------------------
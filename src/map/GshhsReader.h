@@ -154,6 +154,8 @@ class GshhsReader
         std::vector <GshhsPolygon*> & getList_rivers();
         //-----------------------------------------------------
                 
+        std::vector <QPoint> ptsBuffer;	// screen points, kept between redraws
+        
         int GSHHS_scaledPoints(GshhsPolygon *pol, QPoint *pts, double decx,
                                 Projection *proj
         );
@@ -0,0 +1,117 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <algorithm>
+
+#include <QFontMetrics>
+
+#include "LabelPlacer.h"
+
+#define LABELS_CELL_PIX     32		// size of the cells of the grid (pixels)
+#define LABELS_MAX_TEXTS  20000		// by font, before clearing the cache
+
+//-----------------------------------------------------------------------
+LabelPlacer::LabelPlacer ()
+{
+	W = H = 0;
+	ni = nj = 0;
+	currentSizes = NULL;
+}
+//-----------------------------------------------------------------------
+void LabelPlacer::reset (int W, int H)
+{
+	this->W = W;
+	this->H = H;
+	ni = std::max (1, (W+LABELS_CELL_PIX-1)/LABELS_CELL_PIX);
+	nj = std::max (1, (H+LABELS_CELL_PIX-1)/LABELS_CELL_PIX);
+	rects.clear ();
+	if ((int) cells.size() != ni*nj)
+		cells.resize (ni*nj);
+	for (size_t c=0; c < cells.size(); c++)
+		cells[c].clear ();
+}
+//-----------------------------------------------------------------------
+// Cells covered by the visible part of rect
+bool LabelPlacer::cellsRange (const QRect &rect,
+							  int *i0, int *j0, int *i1, int *j1) const
+{
+	if (rect.right() < 0 || rect.bottom() < 0
+			|| rect.left() >= W || rect.top() >= H)
+		return false;
+	*i0 = std::max (0, rect.left()/LABELS_CELL_PIX);
+	*j0 = std::max (0, rect.top()/LABELS_CELL_PIX);
+	*i1 = std::min (ni-1, rect.right()/LABELS_CELL_PIX);
+	*j1 = std::min (nj-1, rect.bottom()/LABELS_CELL_PIX);
+	return true;
+}
+//-----------------------------------------------------------------------
+bool LabelPlacer::isFree (const QRect &rect) const
+{
+	int i0,j0, i1,j1;
+	if (! cellsRange (rect, &i0,&j0, &i1,&j1))
+		return true;
+	for (int j=j0; j <= j1; j++) {
+		for (int i=i0; i <= i1; i++) {
+			const std::vector <int> &cell = cells [j*ni+i];
+			for (size_t k=0; k < cell.size(); k++) {
+				if (rect.intersects (rects [cell[k]]))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+//-----------------------------------------------------------------------
+void LabelPlacer::occupy (const QRect &rect)
+{
+	int i0,j0, i1,j1;
+	if (! cellsRange (rect, &i0,&j0, &i1,&j1))
+		return;
+	int n = rects.size();
+	rects.push_back (rect);
+	for (int j=j0; j <= j1; j++)
+		for (int i=i0; i <= i1; i++)
+			cells [j*ni+i].push_back (n);
+}
+//-----------------------------------------------------------------------
+bool LabelPlacer::place (const QRect &rect)
+{
+	int i0,j0, i1,j1;
+	if (! cellsRange (rect, &i0,&j0, &i1,&j1))
+		return false;		// not visible
+	if (! isFree (rect))
+		return false;
+	occupy (rect);
+	return true;
+}
+//-----------------------------------------------------------------------
+QSize LabelPlacer::textSize (const QFont &font, const QString &text)
+{
+	if (currentSizes == NULL || font != currentFont) {
+		currentFont = font;
+		currentSizes = & textSizes [font.key()];
+	}
+	QHash <QString,QSize>::const_iterator it = currentSizes->constFind (text);
+	if (it != currentSizes->constEnd())
+		return it.value();
+	if (currentSizes->size() >= LABELS_MAX_TEXTS)
+		currentSizes->clear ();
+	QSize sz = QFontMetrics(font).boundingRect(text).size();
+	currentSizes->insert (text, sz);
+	return sz;
+}
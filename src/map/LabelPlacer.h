@@ -0,0 +1,64 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef LABELPLACER_H
+#define LABELPLACER_H
+
+#include <vector>
+
+#include <QRect>
+#include <QFont>
+#include <QHash>
+#include <QString>
+
+//==========================================================
+// Places the labels of one map frame without overlaps.
+// Occupied rectangles are indexed by a uniform grid of screen cells,
+// so placing n labels costs O(n). Labels are placed greedily :
+// callers submit them by decreasing priority.
+// Text sizes are cached between frames.
+//==========================================================
+class LabelPlacer
+{
+	public:
+		LabelPlacer ();
+
+		// Start a new frame (keeps the allocated memory and the text sizes)
+		void  reset (int W, int H);
+
+		bool  isFree (const QRect &rect) const;
+		void  occupy (const QRect &rect);
+		// Occupy rect if it is free and visible
+		bool  place  (const QRect &rect);
+
+		QSize textSize (const QFont &font, const QString &text);
+
+	private:
+		int   W, H;
+		int   ni, nj;
+		std::vector <QRect> rects;
+		std::vector < std::vector <int> > cells;	// indexes in rects
+
+		QHash <QString, QHash <QString,QSize> > textSizes;	// font key => text => size
+		QFont  currentFont;
+		QHash <QString,QSize> *currentSizes;
+
+		bool  cellsRange (const QRect &rect, int *i0, int *j0, int *i1, int *j1) const;
+};
+
+#endif
@@ -37,9 +37,10 @@ QList<POI*> GLOB_listSelectedPOI;
 //-------------------------------------------------------------------------------
 POI::POI (QString seralizedPOI_oldFormat)//
 				 // Projection *proj, QWidget *ownerSlotsPOI, QWidget *parentWindow)
-	: QWidget(NULL)
+	: QObject(NULL)
 {
 	valid = true;
+	parent = NULL;
 	isMovable = false;
 	showLabel = true;
 	QStringList  lst = seralizedPOI_oldFormat.split(";");
@@ -59,13 +60,13 @@ POI::POI (QString seralizedPOI_oldFormat)//
 	this->labelTextColor = Qt::black;
 	this->labelBgColor = Qt::white;
 	this->labelBgColor.setAlpha(200);
-    widgetFocus = NULL;
+	adjustGeometry();
 }
 
 //-------------------------------------------------------------------------------
 POI::POI(uint code, QString name, double lon, double lat,
-				 Projection *proj, QWidget *ownerSlotsPOI, QWidget *parentWindow)
-	: QWidget(parentWindow)
+				 QWidget *ownerSlotsPOI, QWidget *parentWindow)
+	: QObject(parentWindow)
 {
 	valid = true;
 	isMovable = false;
@@ -75,38 +76,35 @@ POI::POI(uint code, QString name, double lon, double lat,
 	this->lon = lon;
 	this->lat = lat;
 	this->parent = parentWindow;
-	setProjection (proj);
 	createWidget  (ownerSlotsPOI);
 	setDisplayParams (Qt::red, Font::getFont(FONT_POILabel), Qt::black,Qt::white);
 	adjustGeometry();
-    widgetFocus = NULL;
 }
 
 //-------------------------------------------------------------------------------
 // Read POI's params from native settings file
 POI::POI (uint codeFromOldSettings)
+	: QObject(NULL)
 {
 	valid = true;
 	code = codeFromOldSettings;
 	this->parent = NULL;
 	readSettings (codeFromOldSettings, true);
-    widgetFocus = NULL;
+	adjustGeometry();
 }
 
 //-------------------------------------------------------------------------------
 // Read POI's params from current (.ini) settings file
 POI::POI (uint code,
-			Projection *proj, QWidget *ownerSlotsPOI, QWidget *parentWindow)
-	: QWidget(parentWindow)
+			QWidget *ownerSlotsPOI, QWidget *parentWindow)
+	: QObject(parentWindow)
 {
 	valid = true;
 	this->code = code;
 	this->parent = parentWindow;
 	readSettings (code, false);
-	setProjection (proj);
 	createWidget  (ownerSlotsPOI);
 	adjustGeometry();
-    widgetFocus = NULL;
 }
 //-------------------------------------------------------------------------------
 void POI::setDisplayParams ( QColor markColor,
@@ -167,29 +165,25 @@ void POI::writeSettings ()
 //-------------------------------------------------------------------------------
 void POI::createWidget(QWidget *ownerSlotsPOI)
 {
-	connect(proj, SIGNAL(projectionUpdated()), this, SLOT(projectionUpdated()) );
     connect(this, SIGNAL(signalOpenMeteotablePOI(POI*)),
     						ownerSlotsPOI, SLOT(slotOpenMeteotablePOI(POI*)));
 	connect(this, SIGNAL(signalPOImoved(POI *)), ownerSlotsPOI, SLOT(slotPOImoved(POI *)));
+	// the map draws the POIs
+	connect(this, SIGNAL(signalPOIchanged(POI *)), parent, SLOT(slotMarkersChanged()));
 
 	countClick = 0;
-	
-	setAutoFillBackground (false);
 	moveInCourse = false;
-	adjustGeometry();
 }
 
+//-------------------------------------------------------------------------------
+// Size of the marker (mark and label)
 //-------------------------------------------------------------------------------
 void POI::adjustGeometry()
 {
-	if (proj == NULL)
-		return;
 	QFontMetrics fmet(labelFont);
 	QRect rect = fmet.boundingRect(name);
 	textHeight = fmet.ascent();
 	
-	bool ok = proj->map2screen_glob (lon, lat, &pi, &pj);
-
 	int hw = rect.height();
 	if (hw <= 5)
 		hw = 9;
@@ -199,17 +193,24 @@ void POI::adjustGeometry()
 
 	xLabel = 9;
 	
-	if (ok) {
-		if (showLabel)
-			setGeometry(pi-hpx, pj-hpy,  rect.width()+xLabel+hpx+5, hw);
-		else
-			setGeometry(pi-hpx, pj-hpy,  9,9);
+	if (showLabel) {
+		width  = rect.width()+xLabel+hpx+5;
+		height = hw;
 	}
 	else {
-		setGeometry(-1000,-1000,  rect.width()+14,  rect.height());  // not visible
+		width  = 9;
+		height = 9;
 	}
 }
-
+//-------------------------------------------------------------------------------
+bool POI::getScreenRect (Projection *proj, QRect *rect)
+{
+	int pi, pj;
+	if (proj==NULL || !proj->map2screen_glob (lon, lat, &pi, &pj))
+		return false;
+	rect->setRect (pi-hpx, pj-hpy, width, height);
+	return true;
+}
 //-------------------------------------------------------------------------------
 // serialized POI = "code;base64(name);lon;lat"
 QString POI::serialize()
@@ -230,143 +231,91 @@ QString POI::serialize()
 void POI::setName(QString name)
 {
 	this->name=name;
-	setToolTip(tr("Point of interest: ")+name);
 	adjustGeometry();
 }
-
 //-------------------------------------------------------------------------------
-void POI::setProjection( Projection *proj)
+void POI::update()
 {
-	this->proj = proj;
-	adjustGeometry();
-}
-
-//-------------------------------------------------------------------------------
-void POI::projectionUpdated()
-{
-	setProjection(proj);
+	emit signalPOIchanged(this);
 }
 
 //-------------------------------------------------------------------------------
-void  POI::drawContent(QPainter &pnt, Projection *proj, bool drawingInPixmap)
+void  POI::drawContent(QPainter &pnt, Projection *proj)
 {
+	QRect rect;
+	if (! getScreenRect (proj, &rect))
+		return;
 	pnt.save();
-	int dy = height()/2;
-	bool isPoiInMap = true;
-	if (drawingInPixmap)
+	pnt.translate(rect.x(), rect.y());
+	int dy = height/2;
+	QPen pen(markColor);
+	pen.setWidth(4);
+	pnt.setPen(pen);	
+	pnt.fillRect(0,dy-3,7,7, QBrush(markColor));
+
+	if (showLabel)
 	{
-		isPoiInMap = proj->map2screen_glob (lon, lat, &pi, &pj);
-		pnt.translate(pi-3, pj-dy);
-	}
-	if (isPoiInMap) {
-		QPen pen(markColor);
-		pen.setWidth(4);
+		pnt.fillRect(xLabel,0, width-xLabel-1,height-1, QBrush(labelBgColor));
+		int g = 60;
+		pen = QPen(QColor(g,g,g));
+		pen.setWidth(1);
 		pnt.setPen(pen);	
-		pnt.fillRect(0,dy-3,7,7, QBrush(markColor));
+		pnt.drawRect(xLabel,0,width-xLabel-1,height-1);
 
-		if (showLabel)
-		{
-			pnt.fillRect(xLabel,0, width()-xLabel-1,height()-1, QBrush(labelBgColor));
-			int g = 60;
-			pen = QPen(QColor(g,g,g));
-			pen.setWidth(1);
-			pnt.setPen(pen);	
-			pnt.drawRect(xLabel,0,width()-xLabel-1,height()-1);
-
-			pnt.setFont(labelFont);
-			pnt.setPen(labelTextColor);
-			pnt.drawText(xLabel+3,textHeight, name);
-		}	
-	}
+		pnt.setFont(labelFont);
+		pnt.setPen(labelTextColor);
+		pnt.drawText(xLabel+3,textHeight, name);
+	}	
 	pnt.restore();
 }
 
-//-------------------------------------------------------------------------------
-void  POI::paintEvent(QPaintEvent *)
-{    
-    QPainter pnt(this);
-    drawContent(pnt, proj, false);
-}
-
-//=========================================================================
-void  POI::enterEvent (QEvent *)
-{
-//printf("POI::enterEvent\n");
-    enterCursor = cursor();
-    setCursor (Qt::PointingHandCursor);
-
-    widgetFocus = QApplication::focusWidget();
-    this->setEnabled(true);
-    this->setFocus();
-}
-//-------------------------------------------------------------------------------
-void  POI::leaveEvent (QEvent *)
-{
-//printf("POI::leaveEvent\n");
-    setCursor(enterCursor);
-	if (QApplication::allWidgets().contains(widgetFocus)) {
-     	widgetFocus->setFocus();
-	}
-}
-
 //=========================================================================
-void  POI::keyPressEvent (QKeyEvent *e)
-{
-//printf("POI::keyPressEvent\n");
-	if (isMovable && e->modifiers()==Qt::ControlModifier) {
-		lastLon = lon;
-		lastLat = lat;
-    	setCursor(Qt::SizeAllCursor);
-	}
-}
-//-------------------------------------------------------------------------------
-void  POI::keyReleaseEvent (QKeyEvent *)
-{	
-    setCursor(Qt::PointingHandCursor);
-}
-//=========================================================================
-void POI::mouseMoveEvent (QMouseEvent * e) {
+void POI::mouseMove (QMouseEvent * e, Projection *proj) {
     if (moveInCourse)
     {
     	int i,j;	// position on screen
-    	i = x() + e->x() - xMouse + hpx;
-    	j = y() + e->y() - yMouse + hpy;
+    	i = e->x() - xMouse;
+    	j = e->y() - yMouse;
     	if (i>0 && j>0 && i+hpx<proj->getW() && j+hpy<proj->getH())
     	{
 			proj->screen2map(i, j, &lon, &lat);
 			emit signalPOImoved(this);
-			adjustGeometry();
-			// printf("%d %d   %f %f\n", e->x(), e->y(),  i,j, lon,lat);
+			update();
 		}
     }
 }
 //---------------------------------------------------------
-void  POI::mousePressEvent(QMouseEvent *e)
+void  POI::mousePress(QMouseEvent *e, Projection *proj)
 {
-	if (isMovable && e->modifiers()==Qt::ControlModifier) {
+	int pi, pj;
+	if (isMovable && e->modifiers()==Qt::ControlModifier
+			&& proj->map2screen_glob (lon, lat, &pi, &pj)) 
+	{
 		moveInCourse = true;		// Ctrl+Clic : move POI
-		xMouse = e->x();
-		yMouse = e->y();
+		lastLon = lon;
+		lastLat = lat;
+		xMouse = e->x() - pi;
+		yMouse = e->y() - pj;
 	} else if (e->modifiers()==Qt::ShiftModifier) { 
 	// add POI to global list, TH20100514
 		GLOB_listSelectedPOI.append( this );
 		this->labelBgColorMarkedPOI = this->labelBgColor;
 		this->labelBgColor = QColor(32, 32,0,127);
+		update();
 	}
 	else
 		moveInCourse = false;	
 	
 }
 //-------------------------------------------------------------------------------
-void  POI::mouseReleaseEvent(QMouseEvent *e)
+void  POI::mouseRelease(QMouseEvent *e, bool isOverPOI)
 {
-	if (e->x()<0 ||e->x()>width() ||e->y()<0 ||e->y()>height())
+	if (! moveInCourse && ! isOverPOI)
 		return;
 		
 	if (! moveInCourse && e->modifiers()==Qt::NoModifier) {
 		if (e->button() == Qt::LeftButton)
 		{
-			setCursor(Qt::BusyCursor);
 			if (countClick == 0) {
 				//QTimer::singleShot(qApp->doubleClickInterval(), this, SLOT(timerClickEvent()));
 				QTimer::singleShot(300, this, SLOT(timerClickEvent()));
@@ -387,7 +336,7 @@ void  POI::mouseReleaseEvent(QMouseEvent *e)
 	}
 	else {
 		// Need to exclude writeSettings for marking POI, TH20110103
-		if (e->button()!=Qt::LeftButton || e->modifiers()!=Qt::ShiftModifier) {
+		if (moveInCourse) {
 			// fin de déplacement du POI
 			if (lon!=lastLon || lat!=lastLat) {
 				this->writeSettings();		// save new position
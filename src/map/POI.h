@@ -34,7 +34,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Projection.h"
 
 //===================================================================
-class POI : public QWidget
+// Point of interest.
+// Not a widget : all the POIs are drawn and hit-tested by the map
+// (MarkersLayer), which forwards the mouse events of the POI under
+// the mouse.
+//===================================================================
+class POI : public QObject
 { Q_OBJECT
     public:
     	friend class POI_Editor;
@@ -45,21 +50,26 @@ class POI : public QWidget
         POI (uint code);    // read POI from old native settings
         
         POI (uint code,     // read POI from .ini settings
-				Projection *proj, QWidget *ownerSlotsPOI, QWidget *parentWindow);
+				QWidget *ownerSlotsPOI, QWidget *parentWindow);
 
         POI	(uint code, QString name, double lon, double lat,
-        			Projection *proj, QWidget *ownerSlotsPOI, QWidget *parentWindow);
+        			QWidget *ownerSlotsPOI, QWidget *parentWindow);
         
         void	writeSettings ();
         bool	isValid ()  {return valid;}
 		
-        void  	setProjection (Projection *proj);
-        void  	drawContent (QPainter &painter, Projection *proj, bool drawingInPixmap);
+        void  	drawContent (QPainter &painter, Projection *proj);
+		
+		// Rectangle of the mark and label on the screen (false if not visible)
+		bool    getScreenRect (Projection *proj, QRect *rect);
 
         uint     getCode ()      {return code;}
         QString  getName ()      {return name;}
         double   getLongitude () {return lon;}
         double   getLatitude ()  {return lat;}
+		QString  getToolTip ()   {return tr("Point of interest: ")+name;}
+		bool     canBeMoved ()   {return isMovable;}
+		bool     isMoving ()     {return moveInCourse;}
 
         void setName      (QString name);
         void setLongitude (double lon) {this->lon=lon;}
@@ -74,13 +84,20 @@ class POI : public QWidget
 		// Restore background color for all selected POIs, TH20110103
 		static void restoreBgOfSelectedPOIs( void );
 
+		// Mouse events forwarded by the map (position in map widget)
+		void  mousePress   (QMouseEvent *e, Projection *proj);
+		void  mouseMove    (QMouseEvent *e, Projection *proj);
+		void  mouseRelease (QMouseEvent *e, bool isOverPOI);
+
+		void  update ();	// ask the map to redraw the POI
+
 	public slots:
-		void projectionUpdated ();
 		void timerClickEvent ();
 	
 	signals:
 		void signalOpenMeteotablePOI (POI *poi);
 		void signalPOImoved (POI *poi);
+		void signalPOIchanged (POI *poi);
     
     private:
         void	readSettings (uint code, bool fromNativeOldSettings);
@@ -89,12 +106,10 @@ class POI : public QWidget
     	unsigned int code;
     	QString      name;
 		double       lon, lat;	 // Position in world map (degrees)
-		int       	 pi, pj;	 // Position in screen (pixels)
-		int			 hpx, hpy;	 // Hot point offset in widget (pixels)
+		int			 hpx, hpy;	 // Hot point offset in marker (pixels)
 		int			 xLabel;
+		int          width, height;	// Size of the marker (pixels)
 		
-		Projection   *proj;
-    	QCursor   enterCursor;
 		QWidget   *parent;
 		
 	    QColor    markColor;
@@ -102,26 +117,15 @@ class POI : public QWidget
 	    QFont 	  labelFont;
 	    
 	    int		  textHeight;
-	    QWidget	  *widgetFocus;
 	    
 	    bool	showLabel;
 	    bool	isMovable, moveInCourse;
-		int		xMouse, yMouse; 	// Relative mouse  position when moving
+		int		xMouse, yMouse; 	// Mouse position relative to the hot point when moving
 		double  lastLon, lastLat;	// old position when moving, for cancel move
 	    
 	    void  createWidget(QWidget *ownerSlotsPOI);
-	    
-	    void  paintEvent (QPaintEvent *event);
-		void  enterEvent (QEvent * e);
-		void  leaveEvent (QEvent * e);
 		
 		int   countClick;
-		void  mousePressEvent(QMouseEvent * e);
-		void  mouseReleaseEvent(QMouseEvent * e);
-		void  mouseMoveEvent(QMouseEvent * e);
-
-		void  keyPressEvent (QKeyEvent *e);
-		void  keyReleaseEvent (QKeyEvent *e);
 
 		void  adjustGeometry();
 };
@@ -29,13 +29,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // POI_Editor: Constructor for edit and create a new POI
 //-------------------------------------------------------
 POI_Editor::POI_Editor(uint code, double lon, double lat,
-				Projection *proj, QWidget *ownerMeteotable, QWidget *parentWindow)
+				QWidget *ownerMeteotable, QWidget *parentWindow)
 	: QDialog(parentWindow)
 {
 	setupUi(this);
 	modeCreation = true;
 	setWindowTitle(tr("New Point of interest"));
-	this->poi = new POI(code, tr("Point %1").arg(code), lon, lat, proj, ownerMeteotable, parentWindow);
+	this->poi = new POI(code, tr("Point %1").arg(code), lon, lat, ownerMeteotable, parentWindow);
 	assert(this->poi);
 	updateInterface();
 }
@@ -113,18 +113,14 @@ void POI_Editor::btOkClicked()
 							inputStyle->getTextColor(),
 							inputStyle->getBgColor()
 						);
-	poi->adjustGeometry();
 	
 	poi->isMovable = cbIsMovable->isChecked();
 	poi->showLabel = cbShowLabel->isChecked();
 
-	poi->projectionUpdated();
-	
+	poi->adjustGeometry();
 	poi->writeSettings();	// save new pamameters to settings
+	poi->update();			// redraw the map markers
 	
-	if (modeCreation) {
-		poi->show();
-	}
 	delete this;	
 }
 //---------------------------------------
@@ -50,7 +50,7 @@ Q_OBJECT
         
         // Constructor for edit and create a new POI
         POI_Editor(uint code, double lon, double lat,
-        			Projection *proj, QWidget *ownerMeteotable, QWidget *parentWindow);
+        			QWidget *ownerMeteotable, QWidget *parentWindow);
         
         ~POI_Editor();
     
@@ -0,0 +1,292 @@
+/*
+ *  checkMblue.cpp
+ *  zyGrib
+ *
+ *  Measurement of the MBZ loading: reading time of the data lines
+ *  (block reading against the former line by line reading)
+ *  memory used by the coordinates of the points, and interpolation
+ *  stencils (cached by thread) against the exact search.
+ *
+ *  Usage: checkMblue [mbzfile]
+ *  Without argument a sample file is written in the temp directory
+ *  (24 dates, 20000 points, 12 data codes).
+ *  Returns 0 when both readings give the same lines, the shared
+ *  coordinates are the ones of the file (and, for the sample file,
+ *  when all the dates share one block).
+ *
+ */
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include "MbzFile.h"
+#include "MbluePointIndex.h"
+#include "LongTaskProgress.h"
+
+#define	SAMPLE_DATES	24
+#define	SAMPLE_POINTS	20000
+#define	SAMPLE_DATA		12
+
+//------------------------------------------------------------------
+// Former reading: one object (with its own vector) by data line,
+// each value read by a zu_read call.
+//------------------------------------------------------------------
+class MbzLine
+{
+	public:
+		float x, y;
+		int   hour;
+		std::vector <float> data;
+};
+
+static bool oldReadLines (const char *fname, std::vector <MbzLine *> &vlines)
+{
+	ZUFILE *f = zu_open (fname, "rb");
+	if (!f)
+		return false;
+	char buf[16];
+	int  nbData, nbLines, v;
+	float fv;
+	bool ok = zu_read (f, buf, 8) == 8;
+	for (int i=0; ok && i<5; i++)			// version..href
+		ok = zu_read (f, buf, i==1 ? 2 : 1) == (i==1 ? 2 : 1);
+	ok = ok && MButil::readInt32 (f, &nbData) && MButil::readInt32 (f, &nbLines);
+	ok = ok && zu_read (f, buf, 16+2+4+4) == 26;		// extent, padding
+	for (int i=0; ok && i<nbData; i++)
+		ok = MButil::readInt32 (f, &v);
+	vlines.reserve (nbLines);
+	for (int j=0; ok && j<nbLines; j++) {
+		MbzLine *line = new MbzLine ();
+		ok = MButil::readInt16 (f, &(line->hour))
+				&& MButil::readFloat32 (f, &(line->x))
+				&& MButil::readFloat32 (f, &(line->y));
+		line->data.reserve (nbData);
+		for (int i=0; ok && i<nbData; i++) {
+			ok = MButil::readFloat32 (f, &fv);
+			line->data.push_back (fv);
+		}
+		vlines.push_back (line);
+	}
+	zu_close (f);
+	return ok;
+}
+
+//------------------------------------------------------------------
+static void writeInt (QFile &file, unsigned int v, int nbytes)
+{
+	for (int i=nbytes-1; i>=0; i--) {
+		char c = (char)((v >> (8*i)) & 255);
+		file.write (&c, 1);
+	}
+}
+//------------------------------------------------------------------
+static void writeFloat (QFile &file, float v)
+{
+	file.write ((const char *) &v, 4);
+}
+//------------------------------------------------------------------
+// Sample file: the same irregular points at each date
+//------------------------------------------------------------------
+static QString writeSampleMbz ()
+{
+	QString fileName = QDir::temp().filePath ("20240601_00_000.mbz");
+	QFile file (fileName);
+	if (! file.open (QIODevice::WriteOnly|QIODevice::Truncate))
+		return "";
+	file.write ("MBZYGRIB", 8);
+	writeInt (file, 1, 1);			// version
+	writeInt (file, 2024, 2);
+	writeInt (file, 6, 1);
+	writeInt (file, 1, 1);
+	writeInt (file, 0, 1);			// href
+	writeInt (file, SAMPLE_DATA, 4);
+	writeInt (file, SAMPLE_DATES*SAMPLE_POINTS, 4);
+	writeFloat (file, 3);
+	writeFloat (file, 14);
+	writeFloat (file, 44);
+	writeFloat (file, 50);
+	writeInt (file, 0, 2);
+	writeInt (file, 0, 4);
+	writeInt (file, 0, 4);
+	for (int i=0; i<SAMPLE_DATA; i++)
+		writeInt (file, DataCode(GRB_TEMP,LV_ISOBARIC,100*(i+1)).toInt32(), 4);
+	srand (1);
+	std::vector <float> vx (SAMPLE_POINTS), vy (SAMPLE_POINTS);
+	for (int k=0; k<SAMPLE_POINTS; k++) {
+		vx[k] = 3 + 11.0*rand()/RAND_MAX;
+		vy[k] = 44 + 6.0*rand()/RAND_MAX;
+	}
+	for (int d=0; d<SAMPLE_DATES; d++) {
+		for (int k=0; k<SAMPLE_POINTS; k++) {
+			writeInt (file, 3*d, 2);
+			writeFloat (file, vx[k]);
+			writeFloat (file, vy[k]);
+			for (int i=0; i<SAMPLE_DATA; i++)
+				writeFloat (file, 280 + i + 0.001*k);
+		}
+	}
+	file.close ();
+	return fileName;
+}
+
+//------------------------------------------------------------------
+// Stencils of a screen sampling grid asked several times (first pass
+// computed, the cache grows during the second one), compared to the
+// exact search.
+//------------------------------------------------------------------
+class StencilCheck : public QThread
+{
+	public:
+		StencilCheck (const MbluePointIndex *index, double x0, double x1,
+											   double y0, double y1)
+			{ this->index=index; this->x0=x0; this->x1=x1; this->y0=y0; this->y1=y1;
+			  nbBad = 0; tFirst = tSecond = 0; }
+		
+		void run ()
+		{
+			QElapsedTimer timer;
+			for (int pass=0; pass<4; pass++) {
+				timer.start ();
+				for (int j=0; j<300; j++)
+					for (int i=0; i<400; i++) {
+						double x = x0 + (x1-x0)*i/400;
+						double y = y0 + (y1-y0)*j/300;
+						MblueStencil st = index->getStencil (x, y);
+						if (pass == 3) {
+							MblueStencil ref;
+							index->findNeighbours (x, y, &ref);
+							if (memcmp (&st, &ref, sizeof(st)) != 0)
+								nbBad ++;
+						}
+					}
+				if (pass == 0)
+					tFirst = timer.nsecsElapsed ();
+				else if (pass == 2)
+					tSecond = timer.nsecsElapsed ();
+			}
+		}
+		
+		const MbluePointIndex *index;
+		double x0, x1, y0, y1;
+		long   nbBad;
+		qint64 tFirst, tSecond;
+};
+
+//==================================================================
+int main (int argc, char **argv)
+{
+	QApplication app (argc, argv);		// LongTaskProgress
+	QString fileName = (argc > 1) ? QString(argv[1]) : writeSampleMbz();
+	LongTaskProgress progress;
+	QElapsedTimer timer;
+
+	timer.start ();
+	MbzFile mbzfile (qPrintable(fileName), &progress);
+	qint64 tRead = timer.nsecsElapsed ();
+	if (! mbzfile.isOk()) {
+		fprintf (stderr, "can't read file: %s\n", qPrintable(fileName));
+		return 2;
+	}
+	int nblines = mbzfile.getNbLines ();
+	int nbdata  = mbzfile.vcodes.size ();
+	printf ("file: %s\n", qPrintable(fileName));
+	printf ("lines: %d, data codes: %d\n", nblines, nbdata);
+	printf ("read: %.1f ms (%.1f ns/line)\n", tRead/1e6, (double)tRead/nblines);
+
+	// same lines with the former reading
+	std::vector <MbzLine *> vlines;
+	timer.restart ();
+	bool oldok = oldReadLines (qPrintable(fileName), vlines);
+	qint64 tOldRead = timer.nsecsElapsed ();
+	long nbBadLines = 0;
+	for (int j=0; j<nblines && j<(int)vlines.size(); j++) {
+		const MbzLine *line = vlines[j];
+		bool same = line->hour==mbzfile.vhours[j]
+					&& line->x==mbzfile.vx[j] && line->y==mbzfile.vy[j];
+		for (int i=0; same && i<nbdata && i<(int)line->data.size(); i++)
+			same = line->data[i] == mbzfile.vdata[i][j];
+		if (!same)
+			nbBadLines ++;
+	}
+	printf ("former read: %.1f ms (%.1f ns/line)\n", tOldRead/1e6, (double)tOldRead/nblines);
+	printf ("lines different from the former read: %ld\n", nbBadLines);
+	int nbOldLines = vlines.size();
+	for (size_t j=0; j<vlines.size(); j++)
+		delete vlines[j];
+
+	// points of each date, as MblueRecord::addMbzLine
+	std::map <int, std::vector <float> > mapx, mapy;
+	for (int j=0; j<nblines; j++) {
+		mapx [mbzfile.vhours[j]].push_back (mbzfile.vx[j]);
+		mapy [mbzfile.vhours[j]].push_back (mbzfile.vy[j]);
+	}
+	// indexes shared by the dates with the same points, as MblueRecord::finalize
+	timer.restart ();
+	std::vector <MbluePointIndex *> listIndex;
+	MbluePointIndex *index = NULL;
+	size_t nbRecords = 0, nbPointsAll = 0;
+	std::map <int, std::vector <float> >::iterator it;
+	for (it=mapx.begin(); it!=mapx.end(); it++, nbRecords++) {
+		std::vector <float> &ptx = it->second;
+		std::vector <float> &pty = mapy [it->first];
+		nbPointsAll += ptx.size();
+		if (index==NULL || ! index->hasSamePoints (ptx, pty)) {
+			index = new MbluePointIndex (ptx,pty, mbzfile.xmin,mbzfile.xmax,
+												  mbzfile.ymin,mbzfile.ymax);
+			listIndex.push_back (index);
+		}
+		std::vector <float> ().swap (ptx);
+		std::vector <float> ().swap (pty);
+	}
+	qint64 tIndex = timer.nsecsElapsed ();
+
+	size_t nbStored = 0;
+	for (size_t n=0; n<listIndex.size(); n++)
+		nbStored += listIndex[n]->getNbPoints ();
+	// former layout: coordinates in each record plus a copy in the index
+	size_t bytesShared = nbStored * 2*sizeof(float);
+	size_t bytesFormer = nbPointsAll * 2*sizeof(float) + bytesShared;
+	size_t bytesData   = (size_t)nblines * nbdata * sizeof(float);
+	printf ("dates: %d, coordinate blocks: %d\n", (int)nbRecords, (int)listIndex.size());
+	printf ("index: %.1f ms\n", tIndex/1e6);
+	printf ("coordinates: %.2f MB (former layout %.2f MB), data columns %.2f MB\n",
+			bytesShared/1048576.0, bytesFormer/1048576.0, bytesData/1048576.0);
+
+	// the shared coordinates must be the ones of each line
+	long nbBad = 0;
+	index = listIndex.size()>0 ? listIndex[0] : NULL;
+	for (int j=0; index!=NULL && j<nblines && j<index->getNbPoints(); j++) {
+		if (index->getPointX(j) != mbzfile.vx[j] || index->getPointY(j) != mbzfile.vy[j])
+			nbBad ++;
+	}
+	printf ("coordinates different from the file: %ld\n", nbBad);
+
+	// stencils from 2 threads at the same time (one cache each)
+	long nbBadStencils = 0;
+	if (index != NULL) {
+		StencilCheck th1 (index, mbzfile.xmin,mbzfile.xmax, mbzfile.ymin,mbzfile.ymax);
+		StencilCheck th2 (index, mbzfile.xmin,mbzfile.xmax, mbzfile.ymin,mbzfile.ymax);
+		th1.start ();
+		th2.start ();
+		th1.wait ();
+		th2.wait ();
+		nbBadStencils = th1.nbBad + th2.nbBad;
+		printf ("stencils: first pass %.1f ns/position, cached %.1f ns/position\n",
+				th1.tFirst/120000.0, th1.tSecond/120000.0);
+		printf ("stencils different from the exact search: %ld\n", nbBadStencils);
+	}
+
+	bool ok = oldok && nbBadLines==0 && nbOldLines==nblines
+				&& nbBad==0 && nbBadStencils==0
+				&& (argc > 1 || listIndex.size()==1);
+	for (size_t n=0; n<listIndex.size(); n++)
+		delete listIndex[n];
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+# Measurement of the MBZ loading (reading time, coordinates memory).
+#   qmake checkMblue.pro && make && ./checkMblue [mbzfile]
+#   (QT_QPA_PLATFORM=offscreen without display)
+
+CONFIG += qt console release c++11
+CONFIG -= app_bundle
+QT += widgets
+
+TEMPLATE = app
+TARGET   = checkMblue
+
+INCLUDEPATH += .. ../util
+
+LIBS += -lbz2 -lz
+
+OBJECTS_DIR = objs
+
+HEADERS += ../LongTaskProgress.h
+
+SOURCES += checkMblue.cpp \
+           ../MbzFile.cpp \
+           ../MbluePointIndex.cpp \
+           ../LongTaskProgress.cpp \
+           ../util/zuFile.cpp
@@ -0,0 +1,325 @@
+/*
+ *  checkRecordCache.cpp
+ *  zyGrib
+ *
+ *  Check of the record cache (GribRecordCache) with 2 readers:
+ *  a file is loaded in a thread while the map thread draws the
+ *  records of an other reader.
+ *
+ *  Usage: checkRecordCache
+ *  A sample GRIB1 file is written in the temp directory (temperature
+ *  every 3 hours, pressure every 12 hours, 0.5° world grid).
+ *  The budget is smaller than the file: the records pinned by a reader
+ *  (its date, the neighbour dates and the records around it for each
+ *  data) must keep their values, the loading must not release any
+ *  record, and released values must be decoded again unchanged.
+ *  Returns 0 when every check passes.
+ *
+ */
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <QAtomicInt>
+
+#include "GribReader.h"
+#include "GribRecordCache.h"
+#include "LongTaskProgress.h"
+
+#define	SAMPLE_NI		720
+#define	SAMPLE_NJ		361
+#define	SAMPLE_HOURS	72
+#define	TEMP_STEP		3
+#define	PRES_STEP		12
+
+static const DataCode dtcTemp (GRB_TEMP, LV_ABOV_GND, 2);
+static const DataCode dtcPres (GRB_PRESSURE_MSL, LV_MSL, 0);
+
+//------------------------------------------------------------------
+static void writeInt (QFile &file, unsigned int v, int nbytes)
+{
+	for (int i=nbytes-1; i>=0; i--) {
+		char c = (char)((v >> (8*i)) & 255);
+		file.write (&c, 1);
+	}
+}
+//------------------------------------------------------------------
+// GRIB1 message (NOAA GFS header), values 200+(i+j+k)%100 packed
+// on 16 bits: they are decoded exactly.
+//------------------------------------------------------------------
+static void writeMessage (QFile &file, int param, int levelType, int hour, int k)
+{
+	int npts = SAMPLE_NI*SAMPLE_NJ;
+	int sizeBDS = 11 + 2*npts + 1;		// even size
+	writeInt (file, 'G', 1);
+	writeInt (file, 'R', 1);
+	writeInt (file, 'I', 1);
+	writeInt (file, 'B', 1);
+	writeInt (file, 8+28+32+sizeBDS+4, 3);
+	writeInt (file, 1, 1);				// edition
+	// PDS
+	writeInt (file, 28, 3);
+	writeInt (file, 2, 1);				// table version
+	writeInt (file, 7, 1);				// center
+	writeInt (file, 96, 1);				// model
+	writeInt (file, 4, 1);				// grid
+	writeInt (file, 0x80, 1);			// GDS, no BMS
+	writeInt (file, param, 1);
+	writeInt (file, levelType, 1);
+	writeInt (file, levelType==LV_ABOV_GND ? 2 : 0, 2);
+	writeInt (file, 24, 1);				// 2024-06-01 00:00
+	writeInt (file, 6, 1);
+	writeInt (file, 1, 1);
+	writeInt (file, 0, 1);
+	writeInt (file, 0, 1);
+	writeInt (file, 1, 1);				// hours
+	writeInt (file, hour, 1);			// P1
+	writeInt (file, 0, 1);				// P2
+	writeInt (file, 0, 1);				// time range
+	writeInt (file, 0, 3);
+	writeInt (file, 21, 1);				// century
+	writeInt (file, 0, 1);
+	writeInt (file, 0, 2);				// decimal factor
+	// GDS
+	writeInt (file, 32, 3);
+	writeInt (file, 0, 1);
+	writeInt (file, 255, 1);
+	writeInt (file, 0, 1);				// lat/lon grid
+	writeInt (file, SAMPLE_NI, 2);
+	writeInt (file, SAMPLE_NJ, 2);
+	writeInt (file, 0x800000|90000, 3);	// -90
+	writeInt (file, 0, 3);
+	writeInt (file, 0x80, 1);
+	writeInt (file, 90000, 3);
+	writeInt (file, 359500, 3);
+	writeInt (file, 500, 2);
+	writeInt (file, 500, 2);
+	writeInt (file, 0x40, 1);			// south to north
+	writeInt (file, 0, 4);
+	// BDS
+	writeInt (file, sizeBDS, 3);
+	writeInt (file, 8, 1);				// unused bits at the end
+	writeInt (file, 0, 2);				// E
+	writeInt (file, 0x42C80000, 4);		// R = 200 (IBM float)
+	writeInt (file, 16, 1);
+	std::vector <char> buf (2*npts+1, 0);
+	for (int j=0; j<SAMPLE_NJ; j++)
+		for (int i=0; i<SAMPLE_NI; i++) {
+			int n = j*SAMPLE_NI+i;
+			buf [2*n+1] = (char) ((i+j+k) % 100);
+		}
+	file.write (&buf[0], buf.size());
+	file.write ("7777", 4);
+}
+//------------------------------------------------------------------
+static QString writeSampleGrib ()
+{
+	QString fileName = QDir::temp().filePath ("checkRecordCache_sample.grb");
+	QFile file (fileName);
+	if (! file.open (QIODevice::WriteOnly|QIODevice::Truncate))
+		return "";
+	int k = 0;
+	for (int h=0; h<SAMPLE_HOURS; h+=TEMP_STEP) {
+		writeMessage (file, GRB_TEMP, LV_ABOV_GND, h, k++);
+		if (h % PRES_STEP == 0)
+			writeMessage (file, GRB_PRESSURE_MSL, LV_MSL, h, k++);
+	}
+	file.close ();
+	return fileName;
+}
+
+//------------------------------------------------------------------
+// Sum of the values (integers: exact)
+//------------------------------------------------------------------
+static double checksum (const GribRecord *rec)
+{
+	double sum = 0;
+	for (int j=0; j<rec->getNj(); j++)
+		for (int i=0; i<rec->getNi(); i++)
+			sum += rec->getValue (i, j);
+	return sum;
+}
+
+typedef std::map <std::pair<int,time_t>, double> MapChecksums;
+
+static double getChecksum (const MapChecksums &sums, const GribRecord *rec)
+{
+	MapChecksums::const_iterator it = sums.find (
+			std::make_pair ((int)rec->getDataType(), rec->getRecordCurrentDate()));
+	return it!=sums.end() ? it->second : -1;
+}
+
+static void addChecksums (GribReader *reader, const DataCode &dtc, MapChecksums &sums)
+{
+	std::vector<GribRecord *> *ls = reader->getListOfGribRecords (dtc);
+	for (size_t n=0; ls!=NULL && n<ls->size(); n++) {
+		GribRecord *rec = (*ls)[n];
+		sums [std::make_pair ((int)rec->getDataType(), rec->getRecordCurrentDate())]
+				= checksum (rec);
+	}
+}
+
+static long countBadChecksums (GribReader *reader, const DataCode &dtc,
+							   const MapChecksums &sums)
+{
+	long nbBad = 0;
+	std::vector<GribRecord *> *ls = reader->getListOfGribRecords (dtc);
+	for (size_t n=0; ls!=NULL && n<ls->size(); n++) {
+		GribRecord *rec = (*ls)[n];
+		if (checksum (rec) != getChecksum (sums, rec))
+			nbBad ++;
+	}
+	return nbBad;
+}
+
+//------------------------------------------------------------------
+// Map thread: reads the pinned records until stopped
+//------------------------------------------------------------------
+class DrawThread : public QThread
+{
+	public:
+		DrawThread (const std::vector <GribRecord *> &recs, const MapChecksums &sums)
+			: recs(recs), sums(sums)
+			{ nbPasses = nbReleased = nbBad = 0; }
+
+		void run ()
+		{
+			while (stopping.load() == 0) {
+				for (size_t n=0; n<recs.size(); n++) {
+					GribRecord *rec = recs[n];
+					if (! rec->isDataLoaded())
+						nbReleased ++;
+					if (checksum (rec) != getChecksum (sums, rec))
+						nbBad ++;
+				}
+				nbPasses ++;
+			}
+		}
+		void stop ()   {stopping.store (1);}
+
+		std::vector <GribRecord *> recs;
+		const MapChecksums &sums;
+		QAtomicInt stopping;
+		long nbPasses, nbReleased, nbBad;
+};
+
+//------------------------------------------------------------------
+// Loading thread, as Terrain: the records are not yet in the cache
+//------------------------------------------------------------------
+class LoadThread : public QThread
+{
+	public:
+		LoadThread (GribReader *reader, const QString &fileName,
+					LongTaskProgress *progress)
+			{ this->reader=reader; this->fileName=fileName; this->progress=progress; }
+
+		void run ()
+		{
+			reader->openFile (qPrintable(fileName), progress);
+			if (reader->isOk())
+				reader->pinRecordsAroundDate (reader->getRefDateForData (dtcTemp)
+										+ 3600*(SAMPLE_HOURS-TEMP_STEP));
+		}
+
+		GribReader *reader;
+		QString fileName;
+		LongTaskProgress *progress;
+};
+
+//------------------------------------------------------------------
+static long countReleased (const std::vector <GribRecord *> &recs)
+{
+	long nb = 0;
+	for (size_t n=0; n<recs.size(); n++)
+		if (! recs[n]->isDataLoaded())
+			nb ++;
+	return nb;
+}
+
+//==================================================================
+int main (int argc, char **argv)
+{
+	QApplication app (argc, argv);		// LongTaskProgress
+	QString fileName = writeSampleGrib ();
+	LongTaskProgress progressA, progressB;
+
+	GribRecordCache::setBudgetMB (16);
+	GribReader *readerA = new GribReader ();
+	readerA->openFile (qPrintable(fileName), &progressA);
+	if (! readerA->isOk()) {
+		fprintf (stderr, "can't read file: %s\n", qPrintable(fileName));
+		return 2;
+	}
+	MapChecksums sums;
+	addChecksums (readerA, dtcTemp, sums);
+	addChecksums (readerA, dtcPres, sums);
+	printf ("file: %s\n", qPrintable(fileName));
+	printf ("records: %d\n", readerA->getTotalNumberOfGribRecords());
+
+	// date between 2 temperatures: the pressures around it are not
+	// at the neighbour dates
+	time_t t0 = readerA->getRefDateForData (dtcTemp);
+	time_t tA = t0 + 3600*TEMP_STEP + 1800*TEMP_STEP;
+	std::vector <GribRecord *> pinnedA;
+	pinnedA.push_back (readerA->getRecord (dtcTemp, t0 + 3600*TEMP_STEP));
+	pinnedA.push_back (readerA->getRecord (dtcTemp, t0 + 3600*2*TEMP_STEP));
+	pinnedA.push_back (readerA->getRecord (dtcPres, t0));
+	pinnedA.push_back (readerA->getRecord (dtcPres, t0 + 3600*PRES_STEP));
+	for (size_t n=0; n<pinnedA.size(); n++)
+		if (pinnedA[n] == NULL) {
+			fprintf (stderr, "missing record in the sample file\n");
+			return 2;
+		}
+	readerA->enableRecordCache ();
+	readerA->pinRecordsAroundDate (tA);
+	GribRecordCache::trim ();
+	GribRecordCacheStats st = GribRecordCache::getStats ();
+	long nbReleasedPinned = countReleased (pinnedA);
+	printf ("first reader: %ld evictions, %ld pinned records released\n",
+			st.evictions, nbReleasedPinned);
+
+	// a file is loaded while the map thread draws the first reader
+	GribReader *readerB = new GribReader ();
+	DrawThread draw (pinnedA, sums);
+	LoadThread load (readerB, fileName, &progressB);
+	long evictionsBefore = GribRecordCache::getStats().evictions;
+	draw.start ();
+	load.start ();
+	load.wait ();
+	long evictionsLoad = GribRecordCache::getStats().evictions - evictionsBefore;
+	draw.stop ();		// as Terrain::lockData
+	draw.wait ();
+	printf ("loading: %ld evictions, drawing: %ld passes, %ld released, %ld bad values\n",
+			evictionsLoad, draw.nbPasses, draw.nbReleased, draw.nbBad);
+
+	// end of the loading (GUI thread, under lockData)
+	bool okB = readerB->isOk ();
+	if (okB) {
+		readerB->enableRecordCache ();
+		GribRecordCache::trim ();
+	}
+	st = GribRecordCache::getStats ();
+	long nbReleasedAfter = countReleased (pinnedA);
+	long nbBadB = okB ? countBadChecksums (readerB, dtcTemp, sums)
+					  + countBadChecksums (readerB, dtcPres, sums) : -1;
+	printf ("both readers: %ld evictions, %ld pinned records released\n",
+			st.evictions, nbReleasedAfter);
+	printf ("second reader: %ld records decoded again with other values\n", nbBadB);
+
+	st = GribRecordCache::getStats ();
+	printf ("cache: %ld records, %ld loaded (%.1f MB), %ld misses\n",
+			st.nbRecords, st.nbLoaded, st.loadedSize/1048576.0, st.misses);
+
+	bool ok = nbReleasedPinned==0 && evictionsLoad==0
+				&& draw.nbReleased==0 && draw.nbBad==0
+				&& nbReleasedAfter==0 && st.evictions>evictionsBefore
+				&& nbBadB==0;
+	delete readerB;
+	delete readerA;
+	printf ("%s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+# Record cache: file loaded in a thread while an other reader is drawn.
+#   qmake checkRecordCache.pro && make && ./checkRecordCache
+#   (QT_QPA_PLATFORM=offscreen without display, g2clib built before)
+
+CONFIG += qt console release c++11
+CONFIG -= app_bundle
+QT += widgets
+
+TEMPLATE = app
+TARGET   = checkRecordCache
+
+INCLUDEPATH += .. ../util ../g2clib
+
+LIBS += -L../g2clib -lg2c -lpng -lbz2 -lz
+
+OBJECTS_DIR = objs
+
+HEADERS += ../LongTaskProgress.h
+
+SOURCES += checkRecordCache.cpp \
+           ../GribReader.cpp \
+           ../GribRecord.cpp \
+           ../GribRecordCache.cpp \
+           ../GribSubset.cpp \
+           ../GribFramer.cpp \
+           ../Grib2Record.cpp \
+           ../GriddedReader.cpp \
+           ../GriddedRecord.cpp \
+           ../GridPyramid.cpp \
+           ../DataMeteoAbstract.cpp \
+           ../Therm.cpp \
+           ../LongTaskProgress.cpp \
+           ../util/zuFile.cpp
@@ -0,0 +1,149 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QSettings>
+#include <QStringList>
+#include <QCoreApplication>
+
+#include "POIStore.h"
+
+#define POISTORE_MAGIC    0x5a59504f		// "ZYPO"
+#define POISTORE_VERSION  1
+#define POISTORE_DELAY    2000				// ms before writing changes
+
+//---------------------------------------------------------------------
+POIStore::POIStore (const QString &fileName, QObject *parent)
+	: QObject (parent)
+{
+	this->fileName = fileName;
+	modified = false;
+	saveTimer.setSingleShot (true);
+	connect (&saveTimer, SIGNAL(timeout()), this, SLOT(flush()));
+	if (QCoreApplication::instance() != NULL)
+		connect (QCoreApplication::instance(), SIGNAL(aboutToQuit()),
+				 this, SLOT(flush()));
+}
+//---------------------------------------------------------------------
+POIStore::~POIStore ()
+{
+	flush ();
+}
+//---------------------------------------------------------------------
+bool POIStore::load ()
+{
+	QFile file (fileName);
+	if (! file.open (QIODevice::ReadOnly))
+		return false;
+	QDataStream in (&file);
+	quint32 magic, version;
+	in >> magic >> version;
+	if (magic != POISTORE_MAGIC || version > POISTORE_VERSION)
+		return false;
+	in.setVersion (QDataStream::Qt_5_0);
+	QMap <uint, QVariantMap> data;
+	in >> data;
+	if (in.status() != QDataStream::Ok)
+		return false;
+	pois = data;
+	modified = false;
+	return true;
+}
+//---------------------------------------------------------------------
+bool POIStore::save ()
+{
+	QSaveFile file (fileName);		// the old file stays valid until commit
+	if (! file.open (QIODevice::WriteOnly))
+		return false;
+	QDataStream out (&file);
+	out << (quint32) POISTORE_MAGIC << (quint32) POISTORE_VERSION;
+	out.setVersion (QDataStream::Qt_5_0);
+	out << pois;
+	return out.status() == QDataStream::Ok && file.commit ();
+}
+//---------------------------------------------------------------------
+void POIStore::flush ()
+{
+	saveTimer.stop ();
+	if (modified && save ())
+		modified = false;
+}
+//---------------------------------------------------------------------
+void POIStore::scheduleSave ()
+{
+	modified = true;
+	saveTimer.start (POISTORE_DELAY);
+}
+//---------------------------------------------------------------------
+bool POIStore::importIniFile (const QString &iniFileName)
+{
+	if (! QFile::exists (iniFileName))
+		return false;
+	QSettings ini (iniFileName, QSettings::IniFormat);
+	ini.beginGroup ("poi");
+	QStringList groups = ini.childGroups ();
+	for (int i=0; i < groups.size(); i++)
+	{
+		bool ok;
+		uint code = groups.at(i).toUInt (&ok);
+		if (ok && ! pois.contains (code)) {		// never replace a POI
+			QVariantMap &poi = pois [code];
+			ini.beginGroup (groups.at(i));
+			QStringList keys = ini.childKeys ();
+			for (int k=0; k < keys.size(); k++)
+				poi.insert (keys.at(k), ini.value (keys.at(k)));
+			ini.endGroup ();
+		}
+	}
+	ini.endGroup ();
+	modified = true;
+	flush ();
+	return true;
+}
+//---------------------------------------------------------------------
+QVariant POIStore::value (uint code, const QString &key,
+						  const QVariant &defaultValue) const
+{
+	QMap <uint, QVariantMap>::const_iterator it = pois.constFind (code);
+	if (it == pois.constEnd())
+		return defaultValue;
+	return it.value().value (key, defaultValue);
+}
+//---------------------------------------------------------------------
+void POIStore::setValue (uint code, const QString &key, const QVariant &value)
+{
+	QVariantMap &poi = pois [code];
+	QVariantMap::iterator it = poi.find (key);
+	if (it != poi.end() && it.value() == value)
+		return;
+	poi.insert (key, value);
+	scheduleSave ();
+}
+//---------------------------------------------------------------------
+void POIStore::remove (uint code)
+{
+	if (pois.remove (code) > 0)
+		scheduleSave ();
+}
+//---------------------------------------------------------------------
+uint POIStore::getMaxCode () const
+{
+	return pois.isEmpty() ? 0 : pois.lastKey();
+}
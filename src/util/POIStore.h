@@ -0,0 +1,65 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef POISTORE_H
+#define POISTORE_H
+
+#include <QObject>
+#include <QMap>
+#include <QVariant>
+#include <QTimer>
+
+//====================================================================
+// Settings of all the POI's, kept in memory and saved in one
+// binary file (read in one time at startup).
+// Changes are grouped: the file is written a short time after
+// the last change, or when the application quits.
+//====================================================================
+class POIStore : public QObject
+{ Q_OBJECT
+	public:
+		POIStore (const QString &fileName, QObject *parent=NULL);
+		~POIStore ();
+
+		bool  load ();
+		// One time conversion of the old .ini file (group "poi"),
+		// when there is no .dat file: POI's already in memory are kept
+		bool  importIniFile (const QString &iniFileName);
+
+		QVariant value (uint code, const QString &key,
+						const QVariant &defaultValue) const;
+		void  setValue (uint code, const QString &key, const QVariant &value);
+		void  remove   (uint code);
+
+		QList<uint> getAllCodes () const   {return pois.keys();}
+		uint  getMaxCode () const;
+
+	public slots:
+		void  flush ();		// write the file now, if modified
+
+	private:
+		QString fileName;
+		QMap <uint, QVariantMap> pois;
+		bool    modified;
+		QTimer  saveTimer;
+
+		void  scheduleSave ();
+		bool  save ();
+};
+
+#endif
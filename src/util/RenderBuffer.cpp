@@ -0,0 +1,49 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include "RenderBuffer.h"
+
+#ifdef DEBUG
+QAtomicInt RenderBuffer::nbAllocations;
+#endif
+
+//---------------------------------------------------------------------
+QImage & RenderBuffer::getImage (QImage &img, int W, int H)
+{
+	if (img.width() != W || img.height() != H
+			|| img.format() != QImage::Format_ARGB32)
+	{
+		img = QImage (W, H, QImage::Format_ARGB32);
+#ifdef DEBUG
+		nbAllocations.ref();
+#endif
+	}
+	img.fill (qRgba(0,0,0,0));
+	return img;
+}
+//---------------------------------------------------------------------
+QPoint * RenderBuffer::getPoints (std::vector <QPoint> &pts, size_t n)
+{
+	if (pts.size() < n) {
+		pts.resize (n);
+#ifdef DEBUG
+		nbAllocations.ref();
+#endif
+	}
+	return &pts[0];
+}
@@ -0,0 +1,54 @@
+/**********************************************************************
+zyGrib: meteorological GRIB file viewer
+Copyright (C) 2008-2012 - Jacques Zaninetti - http://www.zygrib.org
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef RENDERBUFFER_H
+#define RENDERBUFFER_H
+
+#include <vector>
+
+#include <QImage>
+#include <QPoint>
+#include <QAtomicInt>
+
+#include "Util.h"
+
+//====================================================================
+// Buffers kept by the drawing objects from one redraw to the next.
+// They are allocated again only when a bigger size is needed
+// (new size of the view, longer polygon), so a redraw of the
+// same view does not reallocate them.
+// Other allocations of a redraw (layer keys, labels, QPainter paths...)
+// are not handled here.
+// In debug builds, the allocations of these buffers are counted.
+//====================================================================
+class RenderBuffer
+{
+	public:
+		// Transparent image of size W x H
+		static QImage & getImage (QImage &img, int W, int H);
+		// Array of at least n points
+		static QPoint * getPoints (std::vector <QPoint> &pts, size_t n);
+
+#ifdef DEBUG
+		static int  getNbAllocations ()   {return nbAllocations.load();}
+	private:
+		static QAtomicInt nbAllocations;
+#endif
+};
+
+#endif
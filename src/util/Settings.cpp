@@ -17,12 +17,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include <QDir>
+#include <QFileInfo>
 #include <QStringList>
 #include <QMessageBox>
+#include <QCoreApplication>
 
 #include "Settings.h"
 #include "Util.h"
 
+#define SETTINGS_SYNC_DELAY  1000	// ms: changes written together
+
 //---------------------------------------------------------------------
 // Variables globales... yes I know, it's bad :)
 //---------------------------------------------------------------------
@@ -32,7 +36,7 @@ QString GLOB_SettingsFilename_POI;
 
 QSettings *GLOB_NatSettings;
 QSettings *GLOB_IniSettings;
-QSettings *GLOB_IniSettings_POI;
+POIStore  *GLOB_POIStore;
 
 //---------------------------------------------------------------------
 // Priorité :
@@ -99,14 +103,15 @@ void Settings::initializeSettingsDir ()
 		Settings::checkAndCopyDefaultIni(GLOB_SettingsFilename_POI, QDir::current().absolutePath() + "/" + Util::pathConfig() + "/zygrib_poi.ini");
 
 		GLOB_IniSettings     = new QSettings (GLOB_SettingsFilename, QSettings::IniFormat);
-		GLOB_IniSettings_POI = new QSettings (GLOB_SettingsFilename_POI, QSettings::IniFormat);
+		GLOB_POIStore = new POIStore (GLOB_SettingsDir + "/zygrib_poi.dat");
+		assert (GLOB_POIStore);
 	}
 	else {
 		GLOB_SettingsDir = "";
 		GLOB_SettingsFilename	  = "";
 		GLOB_SettingsFilename_POI = "";
 		GLOB_IniSettings     = NULL;
-		GLOB_IniSettings_POI = NULL;
+		GLOB_POIStore = NULL;
 	}
 	GLOB_NatSettings = new QSettings ("zyGrib");
 			
@@ -118,8 +123,28 @@ void Settings::initializeSettingsDir ()
 		Settings::copyOldNativeSettingsToIniFile ();
 	}
 
-	if (! QFile::exists (GLOB_SettingsFilename_POI)) {
-		Settings::copyOldNativeSettingsToIniFile_POI ();
+	//-----------------------------------------------------------------------
+	// POI's are in zygrib_poi.dat. The .ini file is imported only once,
+	// when there is no .dat file yet (first start of this version).
+	// An unreadable .dat is kept aside, never overwritten.
+	//-----------------------------------------------------------------------
+	if (GLOB_POIStore != NULL) {
+		QString datName = GLOB_SettingsDir + "/zygrib_poi.dat";
+		bool loaded = false;
+		if (QFile::exists (datName)) {
+			loaded = GLOB_POIStore->load ();
+			if (! loaded) {
+				fprintf (stderr, "Can't read POI file: %s (kept as .bad)\n",
+								qPrintable(datName));
+				QFile::remove (datName+".bad");
+				QFile::rename (datName, datName+".bad");
+			}
+		}
+		if (! loaded) {
+			if (! GLOB_POIStore->importIniFile (GLOB_SettingsFilename_POI)) {
+				Settings::copyOldNativeSettingsToIniFile_POI ();
+			}
+		}
 	}
 }
 
@@ -208,6 +233,40 @@ void Settings::copyOldNativeSettingsToIniFile_POI ()
 	natSettings.endGroup();
 }
 
+//---------------------------------------------------------------------
+SettingsNotifier::SettingsNotifier ()
+{
+	syncTimer.setSingleShot (true);
+	connect (&syncTimer, SIGNAL(timeout()), this, SLOT(sync()));
+	if (QCoreApplication::instance() != NULL)
+		connect (QCoreApplication::instance(), SIGNAL(aboutToQuit()),
+				 this, SLOT(sync()));
+}
+//---------------------------------------------------------------------
+void SettingsNotifier::scheduleSync ()
+{
+	if (! syncTimer.isActive())
+		syncTimer.start (SETTINGS_SYNC_DELAY);
+}
+//---------------------------------------------------------------------
+void SettingsNotifier::sync ()
+{
+	syncTimer.stop ();
+	if (GLOB_NatSettings != NULL)
+		GLOB_NatSettings->sync ();
+	if (GLOB_IniSettings != NULL)
+		GLOB_IniSettings->sync ();
+}
+//---------------------------------------------------------------------
+SettingsNotifier * Settings::getNotifier ()
+{
+	static SettingsNotifier *notifier = NULL;
+	if (notifier == NULL) {
+		notifier = new SettingsNotifier ();
+		assert (notifier);
+	}
+	return notifier;
+}
 //---------------------------------------------------------------------
 void Settings::setApplicationNativeSetting
 			(const QString &group, const QString &key, const QVariant &value)
@@ -217,7 +276,7 @@ void Settings::setApplicationNativeSetting
 		GLOB_NatSettings->beginGroup(group);
 		GLOB_NatSettings->setValue(key, value);
 		GLOB_NatSettings->endGroup();
-		GLOB_NatSettings->sync();
+		getNotifier()->scheduleSync();
 	}
 }
 //---------------------------------------------------------------------
@@ -230,7 +289,6 @@ QVariant Settings::getApplicationNativeSetting
 		GLOB_NatSettings->beginGroup (group);
 		val = GLOB_NatSettings->value (key, defaultValue);
 		GLOB_NatSettings->endGroup();
-		GLOB_NatSettings->sync();
 	}
 	return val;
 }
@@ -246,7 +304,7 @@ void Settings::setUserSetting (const QString &key, const QVariant &value)
 		GLOB_IniSettings->beginGroup("main");
 		GLOB_IniSettings->setValue(key, value);
 		GLOB_IniSettings->endGroup();
-		GLOB_IniSettings->sync();
+		getNotifier()->scheduleSync();
 	}
 }
 //---------------------------------------------------------------------
@@ -258,7 +316,6 @@ QVariant Settings::getUserSetting (const QString &key, const QVariant &defaultVa
 		GLOB_IniSettings->beginGroup("main");
 		val = GLOB_IniSettings->value(key, defaultValue);
 		GLOB_IniSettings->endGroup();
-		GLOB_IniSettings->sync();
 	}
 	// .ini file corrupted ? Try to read native settings.
 	if (! val.isValid()) {
@@ -301,6 +358,7 @@ void Settings::removeUserSetting (const QString &key)
 		GLOB_NatSettings->remove(key);
 		GLOB_NatSettings->endGroup();
 	}
+	getNotifier()->scheduleSync();
 }
 
 //======================================================================
@@ -314,14 +372,11 @@ QVariant Settings::getSettingPOI
 	QString poikey = QString::number(code)+"/"+key;
 	QVariant val;
 	if ( ! fromOldNativeSettings
-		&&  GLOB_IniSettings_POI != NULL)
+		&&  GLOB_POIStore != NULL)
 	{
-		GLOB_IniSettings_POI->beginGroup("poi");
-		val = GLOB_IniSettings_POI->value(poikey, defaultValue);
-		GLOB_IniSettings_POI->endGroup();
-		GLOB_IniSettings_POI->sync();
+		val = GLOB_POIStore->value(code, key, defaultValue);
 	}
-	// .ini file corrupted ? Try to read native settings.
+	// POI file corrupted ? Try to read native settings.
 	if (  fromOldNativeSettings
 		 ||  ! val.isValid()) {
 		val = getApplicationNativeSetting("poi", poikey, defaultValue);
@@ -334,35 +389,21 @@ void Settings::setSettingPOI
 {
 	QString poikey = QString::number(code)+"/"+key;
 	
-	// save 2 times the settings : native and in ini file
+	// save 2 times the settings : native and in POI file
 	Settings::setApplicationNativeSetting ("poi", poikey, value);
 	
-	if (GLOB_IniSettings_POI != NULL)
+	if (GLOB_POIStore != NULL)
 	{
-		GLOB_IniSettings_POI->beginGroup("poi");
-		GLOB_IniSettings_POI->setValue  (poikey, value);
-		GLOB_IniSettings_POI->endGroup();
-		GLOB_IniSettings_POI->sync();
+		GLOB_POIStore->setValue (code, key, value);
 	}
 }
 //---------------------------------------------------------------------
 QList<uint> Settings::getSettingAllCodesPOIs()
 {
 	QList<uint> reslist;
-	if (GLOB_SettingsDir != "")
+	if (GLOB_POIStore != NULL)
 	{
-		QSettings settings(GLOB_SettingsFilename_POI, QSettings::IniFormat);
-		settings.beginGroup("poi");
-		QString poicode;
-		QStringList slist = settings.childGroups();
-		for (int i=0; i<slist.size(); ++i) {
-			poicode = slist.at(i);
-			bool ok;
-			uint code = poicode.toUInt(&ok);
-			if (ok)
-				reslist.append (code);
-		}
-		settings.endGroup();
+		reslist = GLOB_POIStore->getAllCodes();
 	}
 	else
 	{	// try to load from native settings
@@ -396,20 +437,9 @@ void Settings::deleteSettingsPOI(uint code)
 			natSettings.remove (gr);
 		}
 	}
-	if (GLOB_SettingsDir != "")
+	if (GLOB_POIStore != NULL)
 	{
-		QSettings settings(GLOB_SettingsFilename_POI, QSettings::IniFormat);
-		settings.beginGroup("poi");
-		QStringList allgroups = settings.childGroups(); // pois are in groups
-		QStringListIterator it(allgroups);
-		while (it.hasNext()) {
-			bool ok;
-			QString gr = it.next();
-			uint codepoi = gr.toUInt(&ok);
-			if (ok && codepoi==code) {
-				settings.remove (gr);
-			}
-		}
+		GLOB_POIStore->remove (code);
 	}
 }
     
@@ -429,6 +459,8 @@ uint Settings::getNewCodePOI()
   			max = v;
 	}
 	settings.endGroup();
+	if (GLOB_POIStore != NULL && GLOB_POIStore->getMaxCode() > max)
+		max = GLOB_POIStore->getMaxCode();
 	return max+1;
 }
     
@@ -26,8 +26,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QString>
 #include <QSettings>
+#include <QTimer>
 
 #include "POI.h"
+#include "POIStore.h"
 
 extern QString GLOB_SettingsDir;
 extern QString GLOB_SettingsFilename;
@@ -35,7 +37,29 @@ extern QString GLOB_SettingsFilename_POI;
 
 extern QSettings *GLOB_NatSettings;
 extern QSettings *GLOB_IniSettings;
-extern QSettings *GLOB_IniSettings_POI;
+extern POIStore  *GLOB_POIStore;
+
+//----------------------------------------------------------------
+// Broadcasts the changes of the user settings, and writes the
+// settings files a short time after the changes (and when quitting)
+// instead of at each value.
+//----------------------------------------------------------------
+class SettingsNotifier : public QObject
+{ Q_OBJECT
+	public:
+		SettingsNotifier ();
+		void  notifyChange (const QString &key)  {emit settingChanged (key);}
+		void  scheduleSync ();
+
+	public slots:
+		void  sync ();
+
+	signals:
+		void  settingChanged (const QString &key);
+
+	private:
+		QTimer syncTimer;
+};
 
 class Settings
 {
@@ -64,6 +88,8 @@ public:
 	static QStringList getAllKeys();
     static void     removeUserSetting (const QString &key);
 
+	static SettingsNotifier * getNotifier ();
+
 	//--------------------------------
 	// POI's
 	//--------------------------------
@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <time.h>
 
 #include <QDir>
+#include <QFileInfo>
+#include <QSet>
 #include <QStringList>
 
 #include <QUrl>
@@ -27,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QNetworkProxyQuery>
 #include <QCryptographicHash>
 #include <QFileDialog>
+#include <QMutex>
 
 #include "Settings.h"
 #include "Util.h"
@@ -34,27 +37,95 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 //======================================================================
-QHash <QString, QVariant> GLOB_hashSettings;
+QHash <QString, QVariant> GLOB_hashSettings;	// stored values only
+QSet <QString>   GLOB_missingSettings;		// keys without stored value
+SettingsSnapshot GLOB_settingsSnapshot;
+bool             GLOB_settingsSnapshotValid = false;
+// The map is drawn in its own thread, which also reads the settings
+QMutex           GLOB_settingsMutex (QMutex::Recursive);
 
 void Util::setSetting (const QString &key, const QVariant &value)
 {
-	GLOB_hashSettings.insert (key, value);
-	Settings::setUserSetting (key, value);
+	{
+		QMutexLocker lock (&GLOB_settingsMutex);
+		QHash <QString, QVariant>::const_iterator it = GLOB_hashSettings.constFind (key);
+		if (it != GLOB_hashSettings.constEnd() && it.value() == value)
+			return;		// same as the stored value: nothing to write
+		GLOB_hashSettings.insert (key, value);
+		GLOB_missingSettings.remove (key);
+		Settings::setUserSetting (key, value);
+		if (SettingsSnapshot::isSnapshotKey (key))
+			GLOB_settingsSnapshotValid = false;
+	}
+	Settings::getNotifier()->notifyChange (key);
 }
 //---------------------------------------------------------------------
 QVariant Util::getSetting (const QString &key, const QVariant &defaultValue)
 {
-	if (GLOB_hashSettings.contains (key) )
+	QMutexLocker lock (&GLOB_settingsMutex);
+	QHash <QString, QVariant>::const_iterator it = GLOB_hashSettings.constFind (key);
+	if (it != GLOB_hashSettings.constEnd())
 	{
-		return GLOB_hashSettings.value (key);
+		return it.value();
+	}
+	else if (GLOB_missingSettings.contains (key))
+	{
+		return defaultValue;
 	}
 	else
 	{
-		QVariant v = Settings::getUserSetting (key, defaultValue);
+		// the default value is not cached: it is not stored in the file
+		QVariant v = Settings::getUserSetting (key, QVariant());
+		if (! v.isValid()) {
+			GLOB_missingSettings.insert (key);
+			return defaultValue;
+		}
 		GLOB_hashSettings.insert (key, v);
 		return v;
 	}
 }
+//---------------------------------------------------------------------
+SettingsSnapshot Util::getSettingsSnapshot ()
+{
+	QMutexLocker lock (&GLOB_settingsMutex);
+	if (! GLOB_settingsSnapshotValid) {
+		GLOB_settingsSnapshot.read ();
+		GLOB_settingsSnapshotValid = true;
+	}
+	return GLOB_settingsSnapshot;
+}
+//---------------------------------------------------------------------
+void SettingsSnapshot::read ()
+{
+	unitsTemp          = Util::getSetting("unitsTemp", Util::tr("°C")).toString();
+	unitsWindSpeed     = Util::getSetting("unitsWindSpeed", Util::tr("km/h")).toString();
+	unitsCurrentSpeed  = Util::getSetting("unitsCurrentSpeed", Util::tr("kts")).toString();
+	unitsDistance      = Util::getSetting("unitsDistance", Util::tr("km")).toString();
+	unitsPosition      = Util::getSetting("unitsPosition", "").toString();
+	geopotAltitudeUnit = Util::getSetting("geopotAltitudeUnit", "gpm").toString();
+	isotherm0Unit      = Util::getSetting("isotherm0Unit", "m").toString();
+	snowDepthUnit      = Util::getSetting("snowDepthUnit", Util::tr("m")).toString();
+	waveHeightUnit     = Util::getSetting("waveHeightUnit", Util::tr("m")).toString();
+	waveHeightPeriod   = Util::getSetting("waveHeightPeriod", Util::tr("s")).toString();
+	orderLatitudeLongitude = Util::getSetting("orderLatitudeLongitude", true).toBool();
+	longitudeDirection = Util::getSetting("longitudeDirection", "").toString();
+	latitudeDirection  = Util::getSetting("latitudeDirection", "").toString();
+	timeZone           = Util::getSetting("timeZone", "UTC").toString();
+	thinWindArrows     = Util::getSetting("thinWindArrows", false).toBool();
+	useJetStreamColorMap = Util::getSetting("useJetStreamColorMap", false).toBool();
+}
+//---------------------------------------------------------------------
+bool SettingsSnapshot::isSnapshotKey (const QString &key)
+{
+	static const QSet <QString> keys = QSet <QString> ()
+			<< "unitsTemp" << "unitsWindSpeed" << "unitsCurrentSpeed"
+			<< "unitsDistance" << "unitsPosition" << "geopotAltitudeUnit"
+			<< "isotherm0Unit" << "snowDepthUnit" << "waveHeightUnit"
+			<< "waveHeightPeriod" << "orderLatitudeLongitude"
+			<< "longitudeDirection" << "latitudeDirection" << "timeZone"
+			<< "thinWindArrows" << "useJetStreamColorMap";
+	return keys.contains (key);
+}
 //========================================================================
 QString Util::getSaveFileName (QWidget *parent, const QString &caption, 
 							const QString &dir, const QString &filter)
@@ -96,9 +167,42 @@ QString Util::getOpenFileName (QWidget *parent, const QString &caption,
 	return QFileDialog::getOpenFileName (parent, caption, dir, filter);
 }
 //------------------------------------------------------------
+QStringList Util::getOpenFileNames (QWidget *parent, const QString &caption, 
+							const QString &dir, const QString &filter)
+{
+	#ifdef Q_OS_MACX
+		if ( QSysInfo::MacintoshVersion > QSysInfo::MV_10_8 )
+		{   // fix Mac OS X 10.9 (mavericks) QFileDialog bug
+			int useNative = Util::getSetting("mac_useNativeFileDialog", 999).toInt();
+			if (useNative == 999) {
+				Util::setSetting("mac_useNativeFileDialog", 0);
+				useNative = 0;
+			}
+			if (useNative == 0) {
+				return QFileDialog::getOpenFileNames (parent, caption, dir, filter, 
+							0, QFileDialog::DontUseNativeDialog);
+			}
+		}
+	#endif
+	return QFileDialog::getOpenFileNames (parent, caption, dir, filter);
+}
+//------------------------------------------------------------
+QStringList Util::getMatchingFileNames (const QString &pattern)
+{
+	QStringList res;
+	QFileInfo finfo (pattern);
+	QDir dir = finfo.absoluteDir ();
+	QStringList names = dir.entryList (QStringList(finfo.fileName()),
+									   QDir::Files, QDir::Name);
+	for (int i=0; i<names.size(); i++)
+		res << dir.filePath (names[i]);
+	return res;
+}
+//------------------------------------------------------------
 QString Util::getServerName ()
 {
-	return "www.zygrib.org";
+	// may be changed in the settings file (local test server...)
+	return Util::getSetting("serverName", "www.zygrib.org").toString();
 }
 //------------------------------------------------------------
 void Util::setApplicationProxy ()
@@ -181,7 +285,7 @@ bool Util::isDirWritable (const QDir &dir)
 //======================================================================
 float Util::convertTemperature (float tempKelvin)
 {
-    QString unit = Util::getSetting("unitsTemp", QVariant(tr("°C"))).toString();
+    QString unit = Util::getSettingsSnapshot().unitsTemp;
     if (unit == tr("°K")) {
         return tempKelvin;
     }
@@ -195,7 +299,7 @@ float Util::convertTemperature (float tempKelvin)
 //-------------------------------------------------------
 QString Util::formatTemperature (float tempKelvin, bool withUnit)
 {
-    QString unit = Util::getSetting("unitsTemp", QVariant(tr("°C"))).toString();
+    QString unit = Util::getSettingsSnapshot().unitsTemp;
     QString r;
     if (unit == tr("°K")) {
         r.sprintf("%.1f", tempKelvin);
@@ -212,7 +316,7 @@ QString Util::formatTemperature (float tempKelvin, bool withUnit)
 //-------------------------------------------------------
 QString Util::formatTemperature_short(float tempKelvin, bool withUnit)
 {
-    QString unit = Util::getSetting("unitsTemp", tr("°C")).toString();
+    QString unit = Util::getSettingsSnapshot().unitsTemp;
     QString r;
     if (unit == tr("°K")) {
         r.sprintf("%d", qRound(tempKelvin) );
@@ -247,13 +351,13 @@ QString Util::formatSpeed (float meterspersecond, bool withUnit, QString unit)
 //----------------------------------------------------------------
 QString Util::formatSpeed_Wind (float meterspersecond, bool withUnit)
 {
-    QString unit = Util::getSetting("unitsWindSpeed", tr("km/h")).toString();
+    QString unit = Util::getSettingsSnapshot().unitsWindSpeed;
 	return Util::formatSpeed (meterspersecond, withUnit, unit);
 }
 //----------------------------------------------------------------
 QString Util::formatSpeed_Current (float meterspersecond, bool withUnit)
 {
-    QString unit = Util::getSetting("unitsCurrentSpeed", tr("kts")).toString();
+    QString unit = Util::getSettingsSnapshot().unitsCurrentSpeed;
 	return Util::formatSpeed (meterspersecond, withUnit, unit);
 }
 //----------------------------------------------------------------
@@ -267,7 +371,7 @@ QString Util::formatDirection (float angle, bool withUnit)
 //----------------------------------------------------------------
 QString Util::formatDistance (float mille, bool withUnit)
 {
-    QString unit = Util::getSetting("unitsDistance", tr("km")).toString();
+    QString unit = Util::getSettingsSnapshot().unitsDistance;
     QString r;
     float d;
     if (unit == tr("km")) {
@@ -333,9 +437,9 @@ QString Util::getDataUnit (const DataCode &dtc)
 	switch (dtc.dataType) {
 		case GRB_GEOPOT_HGT:
 			if (dtc.levelType == LV_ISOTHERM0)
-				unit = Util::getSetting("geopotAltitudeUnit", "gpm").toString();
+				unit = Util::getSettingsSnapshot().geopotAltitudeUnit;
 			else
-				unit = Util::getSetting("isotherm0Unit", "m").toString();
+				unit = Util::getSettingsSnapshot().isotherm0Unit;
 			if (unit == "dam")
 				return tr("dam");
 			else if (unit == "ft")
@@ -359,26 +463,26 @@ QString Util::getDataUnit (const DataCode &dtc)
 		case GRB_DEWPOINT     : 
 		case GRB_PRV_DIFF_TEMPDEW : 
 		case GRB_PRV_THETA_E      : 
-			return Util::getSetting("unitsTemp", tr("°C")).toString();
+			return Util::getSettingsSnapshot().unitsTemp;
 			break;
 		case GRB_WIND_VX    : 
 		case GRB_WIND_VY    : 
 		case GRB_WIND_SPEED : 
 		case GRB_PRV_WIND_XY2D : 
 		case GRB_PRV_WIND_JET  : 
-			return Util::getSetting("unitsWindSpeed", tr("km/h")).toString();
+			return Util::getSettingsSnapshot().unitsWindSpeed;
 			break;
 		case GRB_CUR_VX      : 
 		case GRB_CUR_VY      : 
 		case GRB_PRV_CUR_XY2D    : 
-			return Util::getSetting("unitsCurrentSpeed", tr("kts")).toString();
+			return Util::getSettingsSnapshot().unitsCurrentSpeed;
 			break;
 		case GRB_CAPE 		  : 
 		case GRB_CIN 		  : 
 			return tr("J/kg");
 			break;
 		case GRB_SNOW_DEPTH   : 
-			unit = Util::getSetting("snowDepthUnit", tr("m")).toString();
+			unit = Util::getSettingsSnapshot().snowDepthUnit;
 			if (unit == tr("m"))
 				unit = tr("cm");
 			return unit;
@@ -426,9 +530,9 @@ double Util::getDataCoef (const DataCode &dtc)
 	switch (dtc.dataType) {
 		case GRB_GEOPOT_HGT:
 			if (dtc.levelType == LV_ISOTHERM0)
-				unit = Util::getSetting("isotherm0Unit", "m").toString();
+				unit = Util::getSettingsSnapshot().isotherm0Unit;
 			else
-				unit = Util::getSetting("geopotAltitudeUnit", "gpm").toString();
+				unit = Util::getSettingsSnapshot().geopotAltitudeUnit;
 			if (unit == "gpdm" ||  unit == "dam")
 				return 0.1;
 			else if (unit == "gpft" ||  unit == "ft")
@@ -486,7 +590,7 @@ QString Util::formatCAPEsfc (float jkg, bool withUnit)
 //----------------------------------------------------------------
 QString Util::formatWaveHeight (float meter, bool withUnit)
 {
-    QString unit = Util::getSetting("waveHeightUnit", tr("m")).toString();
+    QString unit = Util::getSettingsSnapshot().waveHeightUnit;
     QString r, unite;
     float d;
     if (unit == tr("m")) {
@@ -506,7 +610,7 @@ QString Util::formatWaveHeight (float meter, bool withUnit)
 //----------------------------------------------------------------
 QString Util::formatWavePeriod (float second, bool withUnit)
 {
-    QString unit = Util::getSetting("waveHeightPeriod", tr("s")).toString();
+    QString unit = Util::getSettingsSnapshot().waveHeightPeriod;
     QString r;
 	r.sprintf("%.0f", second);
 	return (withUnit) ? r+" "+unit : r;
@@ -531,7 +635,7 @@ QString Util::formatWhiteCap (float prb, bool withUnit)
 //----------------------------------------------------------------
 QString Util::formatSnowDepth (float meter, bool withUnit)
 {
-    QString unit = Util::getSetting("snowDepthUnit", tr("m")).toString();
+    QString unit = Util::getSettingsSnapshot().snowDepthUnit;
     QString r, unite;
     float d;
     if (unit == tr("m")) {
@@ -553,7 +657,7 @@ QString Util::formatSnowDepth (float meter, bool withUnit)
 QString Util::formatDegres (float x, bool inf100)     // 123.4 -> 123°24.00'
 {
 	const char *cdeg = "°";
-    QString tunit = Util::getSetting("unitsPosition", "").toString();
+    QString tunit = Util::getSettingsSnapshot().unitsPosition;
     QString unit = (tunit=="") ? tr("dd°mm'ss\"") : tunit;
     
     QString r;
@@ -592,7 +696,7 @@ QString Util::formatDegres (float x, bool inf100)     // 123.4 -> 123°24.00'
 //---------------------------------------------------------------------
 QString Util::formatPosition(float x, float y)  // 123°24.00'W 45°67.89'N
 {
-    if ( Util::getSetting("orderLatitudeLongitude", true).toBool() )
+    if ( Util::getSettingsSnapshot().orderLatitudeLongitude )
 		return formatLatitude(y)+" "+formatLongitude(x);
 	else
 		return formatLongitude(x)+" "+formatLatitude(y);
@@ -600,7 +704,7 @@ QString Util::formatPosition(float x, float y)  // 123°24.00'W 45°67.89'N
 //---------------------------------------------------------------------
 QString Util::formatLongitude(float x)
 {
-    QString dir = Util::getSetting("longitudeDirection", "").toString();
+    QString dir = Util::getSettingsSnapshot().longitudeDirection;
 	while (x > 360)
 		x -= 360;
 	while (x < -360)
@@ -636,7 +740,7 @@ QString Util::formatLongitude(float x)
 //---------------------------------------------------------------------
 QString Util::formatLatitude(float y)
 {
-    QString dir = Util::getSetting("latitudeDirection", "").toString();
+    QString dir = Util::getSettingsSnapshot().latitudeDirection;
     if (dir == "South+")
 	    return formatDegres(-y, true)+"S";
 	else if (dir == "North+")
@@ -753,7 +857,7 @@ QDateTime Util::applyTimeZone (time_t t, QString *suffix)
     //dt.setTimeSpec(Qt::UTC);
 	dt = dt.toUTC();
 	
-	QString tmzone =  Util::getSetting("timeZone", "UTC").toString();
+	QString tmzone =  Util::getSettingsSnapshot().timeZone;
 	if (tmzone == "LOC") {
 		dt = dt.toLocalTime();
 		if (suffix != NULL)
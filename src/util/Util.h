@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QApplication>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QDateTime>
 #include <QSettings>
 #include <QNetworkRequest>
@@ -67,6 +68,35 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DBGQS(...)
 #endif
 
+//----------------------------------------------------------------
+// Settings read for each displayed value (units, formats, time zone),
+// kept in typed fields. Rebuilt when one of them is changed
+// with Util::setSetting.
+//----------------------------------------------------------------
+class SettingsSnapshot
+{
+	public:
+		QString unitsTemp;
+		QString unitsWindSpeed;
+		QString unitsCurrentSpeed;
+		QString unitsDistance;
+		QString unitsPosition;
+		QString geopotAltitudeUnit;
+		QString isotherm0Unit;
+		QString snowDepthUnit;
+		QString waveHeightUnit;
+		QString waveHeightPeriod;
+		bool    orderLatitudeLongitude;
+		QString longitudeDirection;
+		QString latitudeDirection;
+		QString timeZone;
+		bool    thinWindArrows;
+		bool    useJetStreamColorMap;
+		
+		void  read ();
+		static bool isSnapshotKey (const QString &key);
+};
+
 class Util : public QObject
 {
     Q_OBJECT
@@ -76,6 +106,11 @@ class Util : public QObject
 							const QString &dir, const QString &filter=QString());
 	static QString getOpenFileName (QWidget *parent, const QString &caption, 
 							const QString &dir, const QString &filter=QString());
+	static QStringList getOpenFileNames (QWidget *parent, const QString &caption, 
+							const QString &dir, const QString &filter=QString());
+	// Existing files matching a pattern (wildcards in the file name only),
+	// sorted by name
+	static QStringList getMatchingFileNames (const QString &pattern);
 		
 	static QString pathData ()   {return "./";};
 	static QString pathColors () {return pathData()+"data/colors/";}
@@ -91,6 +126,7 @@ class Util : public QObject
 
     static void     setSetting (const QString &key, const QVariant &value);
     static QVariant getSetting (const QString &key, const QVariant &defaultValue);
+    static SettingsSnapshot getSettingsSnapshot ();	// copy: read by the map thread
 	static bool     isDirWritable (const QDir &dir);
 	static void     setApplicationProxy ();
 	static QNetworkRequest makeNetworkRequest (QString url,double x0=0,double y0=0,double x1=0,double y1=0);
@@ -0,0 +1,136 @@
+/*
+ *  checkZuStream.cpp
+ *  zyGrib
+ *
+ *  Check of the decompression of data received by pieces (zu_stream_*)
+ *  and of the framing of the GRIB messages in push mode (GribFramer),
+ *  as during a download.
+ *
+ *  Usage: checkZuStream
+ *  Sample GRIB messages are sent uncompressed, gzip and bzip2
+ *  compressed, by pieces of 1, 2, 3, 5, 1000 and 65536 bytes.
+ *  Returns 0 when every piece size gives the original bytes
+ *  and all the messages.
+ *
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+#include <bzlib.h>
+
+#include "zuFile.h"
+#include "GribFramer.h"
+
+#define	SAMPLE_MESSAGES	20
+
+//------------------------------------------------------------------
+// GRIB1 messages of various sizes, with bytes between them
+//------------------------------------------------------------------
+static void makeSample (std::vector <unsigned char> &data)
+{
+	srand (1);
+	for (int m=0; m<SAMPLE_MESSAGES; m++) {
+		int size = 16 + 4 + rand()%20000;
+		size_t p = data.size();
+		data.resize (p+size);
+		unsigned char *b = &data[p];
+		memcpy (b, "GRIB", 4);
+		b[4] = (size>>16) & 255;
+		b[5] = (size>>8) & 255;
+		b[6] = size & 255;
+		b[7] = 1;
+		for (int k=8; k<size-4; k++)
+			b[k] = (unsigned char)(rand() & 255);
+		memcpy (b+size-4, "7777", 4);
+		for (int k=0; k<m%3; k++)
+			data.push_back ('x');
+	}
+}
+//------------------------------------------------------------------
+static bool gzipData (const std::vector <unsigned char> &in,
+					  std::vector <unsigned char> &out)
+{
+	z_stream z;
+	memset (&z, 0, sizeof(z));
+	if (deflateInit2 (&z, 6, Z_DEFLATED, 16+MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+	out.resize (deflateBound (&z, in.size()));
+	z.next_in = (Bytef *) &in[0];
+	z.avail_in = in.size();
+	z.next_out = &out[0];
+	z.avail_out = out.size();
+	int err = deflate (&z, Z_FINISH);
+	out.resize (z.total_out);
+	deflateEnd (&z);
+	return err == Z_STREAM_END;
+}
+//------------------------------------------------------------------
+static bool bzipData (const std::vector <unsigned char> &in,
+					  std::vector <unsigned char> &out)
+{
+	unsigned int size = in.size() + in.size()/100 + 600;
+	out.resize (size);
+	int err = BZ2_bzBuffToBuffCompress ((char *) &out[0], &size,
+						(char *) &in[0], in.size(), 9, 0, 0);
+	out.resize (size);
+	return err == BZ_OK;
+}
+//------------------------------------------------------------------
+// Data sent by pieces as FileLoaderGRIB does; false on any difference
+//------------------------------------------------------------------
+static bool checkPieces (const char *name,
+						 const std::vector <unsigned char> &sent,
+						 const std::vector <unsigned char> &original,
+						 size_t pieceSize)
+{
+	ZUSTREAM *stream = zu_stream_open ();
+	GribFramer framer;
+	std::vector <unsigned char> received;
+	std::vector <char> buf (4096);
+	int nbMessages = 0;
+	bool ok = stream != NULL;
+	for (size_t p=0; ok && p<sent.size(); p+=pieceSize)
+	{
+		size_t nb = std::min (pieceSize, sent.size()-p);
+		ok = zu_stream_write (stream, &sent[p], nb) == 0;
+		long n;
+		while (ok && (n = zu_stream_read (stream, &buf[0], buf.size())) > 0) {
+			received.insert (received.end(), buf.begin(), buf.begin()+n);
+			framer.addData ((const uint8_t *) &buf[0], n);
+			while (framer.nextMessage ())
+				nbMessages ++;
+		}
+		ok = ok && n == 0;
+	}
+	framer.setEndOfData ();
+	while (ok && framer.nextMessage ())
+		nbMessages ++;
+	if (stream)
+		zu_stream_close (stream);
+	ok = ok && received == original && nbMessages == SAMPLE_MESSAGES;
+	printf ("%-6s pieces of %6d bytes: %d messages, %s\n",
+				name, (int)pieceSize, nbMessages, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+//==================================================================
+int main ()
+{
+	std::vector <unsigned char> data, gz, bz;
+	makeSample (data);
+	if (! gzipData (data, gz) || ! bzipData (data, bz)) {
+		fprintf (stderr, "can't compress the sample\n");
+		return 2;
+	}
+	const size_t pieces[] = { 1, 2, 3, 5, 1000, 65536 };
+	int nbBad = 0;
+	for (unsigned int i=0; i<sizeof(pieces)/sizeof(size_t); i++) {
+		nbBad += ! checkPieces ("none", data, data, pieces[i]);
+		nbBad += ! checkPieces ("gzip", gz, data, pieces[i]);
+		nbBad += ! checkPieces ("bzip2", bz, data, pieces[i]);
+	}
+	printf ("%s\n", nbBad==0 ? "OK" : "FAILED");
+	return nbBad==0 ? 0 : 1;
+}
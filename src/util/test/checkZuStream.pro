@@ -0,0 +1,18 @@
+# Decompression and framing of GRIB data received by pieces.
+#   qmake checkZuStream.pro && make && ./checkZuStream
+
+CONFIG += console release c++11
+CONFIG -= qt app_bundle
+
+TEMPLATE = app
+TARGET   = checkZuStream
+
+INCLUDEPATH += .. ../..
+
+LIBS += -lbz2 -lz
+
+OBJECTS_DIR = objs
+
+SOURCES += checkZuStream.cpp \
+           ../zuFile.cpp \
+           ../../GribFramer.cpp
@@ -47,6 +47,7 @@ ZUFILE * zu_open(const char *fname, const char *mode, int type)
     f->ok = 1;
     f->pos = 0;
     f->fname = strdup(fname);
+    f->memsize = f->memoffset = 0;
 
 	if (type == ZU_COMPRESS_AUTO)
 	{
@@ -57,6 +58,9 @@ ZUFILE * zu_open(const char *fname, const char *mode, int type)
 		else
 			f->type = ZU_COMPRESS_NONE;
 	}
+	else {
+		f->type = type;
+	}
 	
     switch(f->type) {
         case ZU_COMPRESS_NONE :
@@ -136,6 +140,14 @@ int  zu_read(ZUFILE *f, void *buf, long len)
         case ZU_COMPRESS_BZIP :
             nb = BZ2_bzRead(&bzerror,(BZFILE*)(f->zfile), buf, len);
             break;
+        case ZU_MEMORY_BUFFER :
+            nb = f->memoffset+f->memsize - f->pos;
+            if (nb > len)
+                nb = len;
+            if (nb < 0)
+                nb = 0;
+            memcpy(buf, (const char*)(f->zfile) + (f->pos-f->memoffset), nb);
+            break;
     }
     f->pos += nb;
     return nb;
@@ -177,6 +189,19 @@ long   zu_tell(ZUFILE *f)
     return f->pos;
 }
 
+//----------------------------------------------------
+long   zu_rawtell(ZUFILE *f)
+{
+    switch(f->type) {
+        case ZU_COMPRESS_GZIP :
+            return gzoffset((gzFile)(f->zfile));
+        case ZU_COMPRESS_BZIP :
+            return ftell(f->faux);
+        default :
+            return f->pos;
+    }
+}
+
 //----------------------------------------------------
 long   zu_filesize(ZUFILE *f)
 {
@@ -223,6 +248,13 @@ int zu_seek(ZUFILE *f, long offset, int whence)
             if (res >= 0)
                 res = 0;
             break;
+        case ZU_MEMORY_BUFFER :
+            if (whence == SEEK_CUR)
+                offset += f->pos;
+            if (offset < f->memoffset || offset > f->memoffset+f->memsize)
+                return -1;
+            f->pos = offset;
+            break;
         case ZU_COMPRESS_BZIP :
             if (whence==SEEK_SET  &&  offset >= f->pos) {
                 res = zu_bzSeekForward(f, offset-f->pos);
@@ -297,9 +329,184 @@ char * zu_fgets(char *s, int size, ZUFILE *file)
 		return s;
 }
 
+//-----------------------------------------------------------------
+void   zu_init_memory (ZUFILE *f, const void *buf, long size, long offset)
+{
+    memset(f, 0, sizeof(ZUFILE));
+    f->type = ZU_MEMORY_BUFFER;
+    f->ok = 1;
+    f->zfile = (void *) buf;
+    f->memsize = size;
+    f->memoffset = offset;
+    f->pos = offset;
+}
 
+//-----------------------------------------------------------------
+ZUSTREAM * zu_stream_open ()
+{
+    ZUSTREAM *s = (ZUSTREAM *) malloc(sizeof(ZUSTREAM));
+    if (!s) {
+        return NULL;
+    }
+    memset(s, 0, sizeof(ZUSTREAM));
+    s->type = ZU_COMPRESS_AUTO;
+    s->ok = 1;
+    return s;
+}
 
+//-----------------------------------------------------------------
+void   zu_stream_close (ZUSTREAM *s)
+{
+    if (s) {
+        if (s->zstream) {
+            switch(s->type) {
+                case ZU_COMPRESS_GZIP :
+                    inflateEnd((z_stream *)(s->zstream));
+                    break;
+                case ZU_COMPRESS_BZIP :
+                    BZ2_bzDecompressEnd((bz_stream *)(s->zstream));
+                    break;
+            }
+            free(s->zstream);
+        }
+        free(s);
+    }
+}
 
+//-----------------------------------------------------------------
+static void zu_stream_input (ZUSTREAM *s, const void *buf, long len)
+{
+    switch(s->type) {
+        case ZU_COMPRESS_NONE :
+            s->in = (const char *) buf;
+            s->inlen = len;
+            break;
+        case ZU_COMPRESS_GZIP :
+            ((z_stream *)(s->zstream))->next_in = (Bytef *) buf;
+            ((z_stream *)(s->zstream))->avail_in = len;
+            break;
+        case ZU_COMPRESS_BZIP :
+            ((bz_stream *)(s->zstream))->next_in = (char *) buf;
+            ((bz_stream *)(s->zstream))->avail_in = len;
+            break;
+    }
+}
+//-----------------------------------------------------------------
+static long zu_stream_avail (ZUSTREAM *s)
+{
+    switch(s->type) {
+        case ZU_COMPRESS_NONE :
+            return s->inlen;
+        case ZU_COMPRESS_GZIP :
+            return ((z_stream *)(s->zstream))->avail_in;
+        case ZU_COMPRESS_BZIP :
+            return ((bz_stream *)(s->zstream))->avail_in;
+    }
+    return 0;
+}
+//-----------------------------------------------------------------
+int    zu_stream_write (ZUSTREAM *s, const void *buf, long len)
+{
+    const unsigned char *b = (const unsigned char *) buf;
+    if (!s->ok) {
+        return -1;
+    }
+    if (s->type == ZU_COMPRESS_AUTO)
+    {
+        while (s->headlen < 4 && len > 0) {
+            s->head[s->headlen++] = *b++;
+            len --;
+        }
+        if (s->headlen < 4) {
+            return 0;      // type not known yet: nothing to read
+        }
+        const unsigned char *h = s->head;
+        if (h[0]=='B' && h[1]=='Z' && h[2]=='h') {
+            bz_stream *bz = (bz_stream *) calloc(1, sizeof(bz_stream));
+            s->type = ZU_COMPRESS_BZIP;
+            s->zstream = bz;
+            if (!bz || BZ2_bzDecompressInit(bz, 0, 0) != BZ_OK)
+                s->ok = 0;
+        }
+        else if (h[0]==0x1f && h[1]==0x8b) {
+            z_stream *z = (z_stream *) calloc(1, sizeof(z_stream));
+            s->type = ZU_COMPRESS_GZIP;
+            s->zstream = z;
+            if (!z || inflateInit2(z, 16+MAX_WBITS) != Z_OK)
+                s->ok = 0;
+        }
+        else {
+            s->type = ZU_COMPRESS_NONE;
+        }
+        if (!s->ok) {
+            return -1;
+        }
+        // the 4 first bytes, then the rest of this piece
+        zu_stream_input(s, s->head, 4);
+        s->next = (const char *) b;
+        s->nextlen = len;
+        return 0;
+    }
+    zu_stream_input(s, buf, len);
+    return 0;
+}
 
-
-
+//-----------------------------------------------------------------
+long   zu_stream_read (ZUSTREAM *s, void *buf, long len)
+{
+    long nb = 0;
+    int  err;
+    if (!s->ok) {
+        return -1;
+    }
+    if (s->end || s->type == ZU_COMPRESS_AUTO) {
+        return 0;      // bytes after the end of the stream are ignored
+    }
+    while (nb == 0 && s->ok && !s->end)
+    {
+        if (zu_stream_avail(s) == 0) {
+            if (s->nextlen <= 0)
+                return 0;
+            zu_stream_input(s, s->next, s->nextlen);
+            s->nextlen = 0;
+        }
+        switch(s->type) {
+            case ZU_COMPRESS_NONE :
+                nb = s->inlen < len ? s->inlen : len;
+                memcpy(buf, s->in, nb);
+                s->in += nb;
+                s->inlen -= nb;
+                break;
+            case ZU_COMPRESS_GZIP :
+                {
+                    z_stream *z = (z_stream *)(s->zstream);
+                    z->next_out = (Bytef *) buf;
+                    z->avail_out = len;
+                    err = inflate(z, Z_NO_FLUSH);
+                    nb = len - z->avail_out;
+                    if (err == Z_STREAM_END)
+                        s->end = 1;
+                    else if (err != Z_OK && err != Z_BUF_ERROR)
+                        s->ok = 0;
+                }
+                break;
+            case ZU_COMPRESS_BZIP :
+                {
+                    bz_stream *bz = (bz_stream *)(s->zstream);
+                    bz->next_out = (char *) buf;
+                    bz->avail_out = len;
+                    err = BZ2_bzDecompress(bz);
+                    nb = len - bz->avail_out;
+                    if (err == BZ_STREAM_END)
+                        s->end = 1;
+                    else if (err != BZ_OK)
+                        s->ok = 0;
+                }
+                break;
+        }
+    }
+    if (!s->ok) {
+        return -1;
+    }
+    return nb;
+}
@@ -38,6 +38,7 @@ extern "C" {
 #define ZU_COMPRESS_NONE   0
 #define ZU_COMPRESS_GZIP   1
 #define ZU_COMPRESS_BZIP   2
+#define ZU_MEMORY_BUFFER   3    // bytes already in memory (zu_init_memory)
 
 #define ZU_BUFREADSIZE   256000
 
@@ -52,6 +53,9 @@ typedef struct
     void *zfile;   // exact file type depends of compress type
 
     FILE *faux;   // auxiliary file for bzip
+
+    long  memsize;     // ZU_MEMORY_BUFFER: size of the buffer (zfile)
+    long  memoffset;   //   and position of its first byte
 } ZUFILE;
 
 
@@ -63,6 +67,8 @@ int    zu_can_read_file (const char *fname);
 int    zu_read (ZUFILE *f, void *buf, long len);
 
 long   zu_tell (ZUFILE *f);
+// position in the file on disk (compressed data)
+long   zu_rawtell (ZUFILE *f);
 
 int    zu_seek (ZUFILE *f, long offset, int whence);        // TODO: whence=SEEK_END
 
@@ -77,6 +83,34 @@ bool zu_isGZIP (const char *fname);
 
 char * zu_fgets (char *s, int size, ZUFILE *file);
 
+// Read a memory buffer (not copied) as if it was at offset in a file.
+// No zu_close needed.
+void   zu_init_memory (ZUFILE *f, const void *buf, long size, long offset);
+
+// Decompression of data received by pieces (network...).
+// The type is detected from the first 4 bytes (pieces may be smaller).
+typedef struct
+{
+    int   type;
+    int   ok;
+    int   end;         // end of the compressed stream
+    void *zstream;     // z_stream or bz_stream
+    const char *in;    // input not yet used (ZU_COMPRESS_NONE)
+    long  inlen;
+    unsigned char head[4];   // first bytes, kept until the type is known
+    int   headlen;
+    const char *next;  // input given after head
+    long  nextlen;
+} ZUSTREAM;
+
+ZUSTREAM * zu_stream_open ();
+void   zu_stream_close (ZUSTREAM *s);
+// Give len new compressed bytes, which must stay valid
+// until zu_stream_read returns 0.
+int    zu_stream_write (ZUSTREAM *s, const void *buf, long len);
+// Uncompressed bytes (0 when all the input is used, -1 on error)
+long   zu_stream_read (ZUSTREAM *s, void *buf, long len);
+
 // for internal use :
 int zu_bzSeekForward (ZUFILE *f, unsigned long nbytes);
 
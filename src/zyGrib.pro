@@ -109,6 +109,7 @@ HEADERS += \
            DialogLoadIAC.h \
            DialogLoadMBLUE.h \
            DialogProxy.h \
+           DialogRecordCache.h \
            DialogSelectMetar.h \
            DialogServerStatus.h \
            DialogUnits.h \
@@ -120,15 +121,20 @@ HEADERS += \
            map/GshhsRangsReader.h \
            map/GshhsReader.h \
            map/GisReader.h \
+           map/LabelPlacer.h \
            GribAnimator.h \
+           GribFramer.h \
            GribPlot.h \
            Grib2Plot.h \
            GribReader.h \
            Grib2Reader.h \
            GribRecord.h \
+           GribRecordCache.h \
+           GribSubset.h \
            Grib2Record.h \
 		   GriddedPlotter.h \
 		   GriddedRecord.h \
+		   GridPyramid.h \
 		   GriddedReader.h \
            IacPlot.h \
            IacReader.h \
@@ -141,18 +147,23 @@ HEADERS += \
            MbluePlot.h \
            MblueReader.h \
            MblueRecord.h \
+           MbluePointIndex.h \
            Metar.h \
            MeteoTable.h \
            MeteoTableWidget.h \
            MeteotableOptionsDialog.h \
            MainWindow.h \
            MapDrawer.h \
+           MapRenderer.h \
+           MarkersLayer.h \
            MenuBar.h \
            util/Orthodromie.h \
            map/POI.h \
            map/POI_Editor.h \
            map/PositionEditor.h \
            map/Projection.h \
+           util/POIStore.h \
+           util/RenderBuffer.h \
            util/Settings.h \
            SkewT.h \
            util/SylkFile.h \
@@ -175,6 +186,7 @@ SOURCES += \
 		Astro.cpp \
         MbzFile.cpp \
 		MblueRecord.cpp \
+		MbluePointIndex.cpp \
 		MblueReader.cpp \
 		MbluePlot.cpp \
            BoardPanel.cpp \
@@ -192,6 +204,7 @@ SOURCES += \
            DialogLoadIAC.cpp \
            DialogLoadMBLUE.cpp \
            DialogProxy.cpp \
+           DialogRecordCache.cpp \
            DialogSelectMetar.cpp \
            DialogServerStatus.cpp \
            DialogUnits.cpp \
@@ -202,15 +215,20 @@ SOURCES += \
 		   GriddedPlotter.cpp \
 		   GriddedReader.cpp \
 		   GriddedRecord.cpp \
+		   GridPyramid.cpp \
            map/GshhsRangsReader.cpp \
            map/GshhsReader.cpp \
            GribAnimator.cpp \
+           GribFramer.cpp \
            GribPlot.cpp \
            Grib2Plot.cpp \
            map/GisReader.cpp \
+           map/LabelPlacer.cpp \
            GribReader.cpp \
            Grib2Reader.cpp \
            GribRecord.cpp \
+           GribRecordCache.cpp \
+           GribSubset.cpp \
            Grib2Record.cpp \
            IacPlot.cpp \
            IacReader.cpp \
@@ -223,6 +241,8 @@ SOURCES += \
            main.cpp \
            MainWindow.cpp \
            MapDrawer.cpp \
+           MapRenderer.cpp \
+           MarkersLayer.cpp \
            MenuBar.cpp \
            Metar.cpp \
            MeteoTable.cpp \
@@ -234,6 +254,8 @@ SOURCES += \
            map/PositionEditor.cpp \
            map/Projection.cpp \
            map/Projection_libproj.cpp \
+           util/POIStore.cpp \
+           util/RenderBuffer.cpp \
            util/Settings.cpp \
            SkewT.cpp \
            SkewTWindow.cpp \